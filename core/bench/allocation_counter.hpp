@@ -0,0 +1,36 @@
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+/**
+ * @namespace AllocationCounter
+ * @brief Counts heap allocations made through the global operator new.
+ *
+ * Linking allocation_counter.cpp into an executable replaces the global
+ * allocation functions, so every new/delete in the process is counted.
+ */
+namespace AllocationCounter {
+
+/**
+ * @brief Get the number of allocations since the last reset
+ *
+ * @return std::size_t Allocation count
+ */
+std::size_t count();
+
+/**
+ * @brief Get the number of bytes allocated since the last reset
+ *
+ * @return std::size_t Allocated bytes
+ */
+std::size_t bytes();
+
+/**
+ * @brief Reset the allocation and byte counters to zero
+ */
+void reset();
+
+}  // namespace AllocationCounter
+
+#endif  // ALLOCATION_COUNTER_HPP
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "common.hpp"
+#include "frame_clock.hpp"
+#include "frame_source.hpp"
+
+namespace {
+
+constexpr std::size_t DEFAULT_FRAMES = 600;
+
+using Clock = std::chrono::steady_clock;
+
+double percentile(const std::vector<int64_t>& sorted, const double p) {
+    if (sorted.empty()) return 0;
+    const auto index = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return sorted[index] / 1000.0;
+}
+
+void print(const char* name, std::vector<int64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    std::cout << name << " in us: p50 " << percentile(samples, 0.50)
+              << "  p90 " << percentile(samples, 0.90) << "  p99 "
+              << percentile(samples, 0.99) << "  max "
+              << percentile(samples, 1.0) << "\n";
+}
+
+}  // namespace
+
+/**
+ * Captures --frames frames from a source paced by a FrameClock at --fps,
+ * and reports how long each capture took and how late the clock woke up.
+ * Defaults to the test pattern, so it runs headless; pass --capture native
+ * (under Xvfb if need be) or --capture-file to measure the other sources,
+ * and --spin-margin 0 to see the scheduler's wake-up slack.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        CaptureSettings settings = CaptureSettings::from_options(options);
+        if (options.count("capture") == 0 &&
+            options.count("capture-file") == 0) {
+            settings.backend = CaptureBackend::TEST_PATTERN;
+        }
+
+        std::size_t frames = DEFAULT_FRAMES;
+        if (const auto it = options.find("frames"); it != options.end()) {
+            frames = std::stoul(it->second);
+        }
+        int fps = DEFAULT_FRAME_RATE;
+        if (const auto it = options.find("fps"); it != options.end()) {
+            fps = std::stoi(it->second);
+        }
+        auto spin_margin = DEFAULT_SPIN_MARGIN;
+        if (const auto it = options.find("spin-margin"); it != options.end()) {
+            spin_margin = std::chrono::microseconds(std::stoi(it->second));
+        }
+        if (frames == 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        auto source = FrameSource::create(settings);
+        const FrameLayout& layout = source->layout();
+        FrameClock clock(fps, spin_margin);
+
+        std::vector<int64_t> capture_times;
+        std::vector<int64_t> lateness;
+        capture_times.reserve(frames);
+        lateness.reserve(frames);
+        for (std::size_t i = 0; i < frames; ++i) {
+            const Clock::time_point deadline = clock.wait();
+            const Clock::time_point start = Clock::now();
+            const FrameRef frame = source->capture();
+            const Clock::time_point end = Clock::now();
+            if (!frame) {
+                throw std::runtime_error("Frame pool exhausted");
+            }
+            lateness.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(start -
+                                                                     deadline)
+                    .count());
+            capture_times.push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end -
+                                                                     start)
+                    .count());
+        }
+
+        std::cout << frames << " frames of " << layout.width << "x"
+                  << layout.height
+                  << (layout.format == PixelFormat::BGRA ? " BGRA" : " I420")
+                  << " at " << fps << " fps, " << clock.missed()
+                  << " deadlines missed\n";
+        print("Capture", capture_times);
+        print("Clock lateness", lateness);
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
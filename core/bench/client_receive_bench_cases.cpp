@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+
+#include "metrics.hpp"
+#include "udp_client.hpp"
+
+namespace {
+
+constexpr unsigned short SERVER_PORT = 47120;
+constexpr unsigned short CLIENT_PORT = 47121;
+
+/**
+ * Receive, validate and dispatch one server datagram per iteration, with
+ * the server side played by a plain loopback socket and the client's
+ * io_context driven inline until the datagram is handled. The payload is
+ * not a pong: a pong writes the RTT to stdout, which would corrupt the JSON
+ * report.
+ */
+void BM_ClientReceiveResponse(benchmark::State& state) {
+    boost::asio::io_context io_context;
+    udp::socket server(io_context, udp::endpoint(udp::v4(), SERVER_PORT));
+    UdpClient client(io_context, CLIENT_PORT, "127.0.0.1",
+                     std::to_string(SERVER_PORT));
+
+    const udp::endpoint client_endpoint(
+        boost::asio::ip::address_v4::loopback(), CLIENT_PORT);
+    const std::string message = "ack";
+
+    const Metrics::Counter& dropped = Metrics::counter("drops.parse_error");
+    for (auto _ : state) {
+        const uint64_t expected = dropped.value() + 1;
+        server.send_to(boost::asio::buffer(message), client_endpoint);
+        while (dropped.value() != expected) io_context.run_one();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ClientReceiveResponse);
+
+}  // namespace
@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include "common.hpp"
+#include "input_messages.hpp"
+#include "sfml_to_windows_key_map.hpp"
+#include "stun_constants.hpp"
+#include "stun_message.hpp"
+#include "stun_response_validator.hpp"
+
+namespace {
+
+const InputMessages::Message KEY_MESSAGE(InputMessages::KEY_PRESSED, 22);
+const InputMessages::Message AXIS_MESSAGE(InputMessages::JOYSTICK_MOVED, 1, 3,
+                                          -57.25f);
+
+void BM_MessageToString(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(AXIS_MESSAGE.to_string());
+    }
+}
+BENCHMARK(BM_MessageToString);
+
+void BM_MessageSerialize(benchmark::State& state) {
+    std::array<char, InputMessages::Message::MAX_SERIALIZED_SIZE> buffer;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            AXIS_MESSAGE.serialize(buffer.data(), buffer.size()));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_MessageSerialize);
+
+void BM_MessageFromString(benchmark::State& state) {
+    const std::string text = AXIS_MESSAGE.to_string();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(InputMessages::Message::from_string(text));
+    }
+}
+BENCHMARK(BM_MessageFromString);
+
+void BM_MessageParse(benchmark::State& state) {
+    const std::string text = AXIS_MESSAGE.to_string();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(InputMessages::Message::parse(text));
+    }
+}
+BENCHMARK(BM_MessageParse);
+
+void BM_MessageParseKey(benchmark::State& state) {
+    const std::string text = KEY_MESSAGE.to_string();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(InputMessages::Message::parse(text));
+    }
+}
+BENCHMARK(BM_MessageParseKey);
+
+void BM_ValidateIp(benchmark::State& state) {
+    const std::string ip = state.range(0) ? "192.168.10.254" : "192.168.1";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Common::validate_ip(ip));
+    }
+}
+BENCHMARK(BM_ValidateIp)->ArgName("valid")->Arg(1)->Arg(0);
+
+void BM_ValidateSocketString(benchmark::State& state) {
+    const std::string socket =
+        state.range(0) ? "192.168.10.254:50000" : "192.168.10.254:70000";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Common::validate_socket_string(socket));
+    }
+}
+BENCHMARK(BM_ValidateSocketString)->ArgName("valid")->Arg(1)->Arg(0);
+
+void BM_StunBuildBindingRequest(benchmark::State& state) {
+    std::array<unsigned char, StunMessage::HEADER_SIZE> buffer;
+    StunMessage::TransactionId transaction_id = {};
+    for (auto _ : state) {
+        ++transaction_id[0];
+        StunMessage::build_binding_request(buffer, transaction_id);
+        benchmark::DoNotOptimize(buffer.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_StunBuildBindingRequest);
+
+void BM_StunValidateResponse(benchmark::State& state) {
+    using namespace StunConstants;
+
+    const StunMessage::TransactionId transaction_id = {1, 2, 3, 4,  5,  6,
+                                                       7, 8, 9, 10, 11, 12};
+    std::array<unsigned char, 1024> response = {};
+    response[0] = (BINDING_RESPONSE >> 8) & 0xFF;
+    response[1] = BINDING_RESPONSE & 0xFF;
+    response[3] = 12;  // One XOR-MAPPED-ADDRESS attribute
+    response[4] = (MAGIC_COOKIE >> 24) & 0xFF;
+    response[5] = (MAGIC_COOKIE >> 16) & 0xFF;
+    response[6] = (MAGIC_COOKIE >> 8) & 0xFF;
+    response[7] = MAGIC_COOKIE & 0xFF;
+    std::copy(transaction_id.begin(), transaction_id.end(),
+              response.begin() + 8);
+    response[21] = XOR_MAPPED_ADDRESS;
+    response[23] = 8;
+    response[25] = 0x01;  // IPv4
+
+    const StunResponseValidator validator(response, transaction_id);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validator.validate_stun_response(32));
+    }
+}
+BENCHMARK(BM_StunValidateResponse);
+
+void BM_KeyMapLookup(benchmark::State& state) {
+    std::vector<sf::Keyboard::Key> keys;
+    for (const auto& [key, code] : SFML_TO_WINDOWS_KEY_MAP) {
+        keys.push_back(key);
+    }
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto it = SFML_TO_WINDOWS_KEY_MAP.find(keys[i]);
+        benchmark::DoNotOptimize(it->second);
+        i = i + 1 == keys.size() ? 0 : i + 1;
+    }
+}
+BENCHMARK(BM_KeyMapLookup);
+
+}  // namespace
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "color_convert.hpp"
+#include "common.hpp"
+
+namespace {
+
+constexpr int BENCH_WIDTH = 1920;
+constexpr int BENCH_HEIGHT = 1080;
+constexpr int DEFAULT_ITERATIONS = 100;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr ColorConvert::Kernel KERNELS[] = {ColorConvert::Kernel::SCALAR,
+                                            ColorConvert::Kernel::SSE2,
+                                            ColorConvert::Kernel::AVX2};
+
+/**
+ * @brief Fill a buffer with the same pseudo-random bytes on every run
+ */
+void fill(unsigned char* data, const std::size_t size, uint32_t seed) {
+    for (std::size_t i = 0; i < size; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = static_cast<unsigned char>(seed >> 24);
+    }
+}
+
+/**
+ * @class I420Image
+ * @brief Destination planes, with stride padding that kernels must not
+ * write over
+ */
+class I420Image {
+   public:
+    I420Image(const int width, const int height)
+        : width_(width),
+          height_(height),
+          y_stride_(width + 7),
+          c_stride_(width / 2 + 5),
+          data_(static_cast<std::size_t>(y_stride_) * height +
+                    2 * static_cast<std::size_t>(c_stride_) * (height / 2),
+                0xa5) {}
+
+    ColorConvert::Planes planes() {
+        ColorConvert::Planes planes;
+        planes.y = data_.data();
+        planes.y_stride = y_stride_;
+        planes.u = planes.y + static_cast<std::size_t>(y_stride_) * height_;
+        planes.u_stride = c_stride_;
+        planes.v =
+            planes.u + static_cast<std::size_t>(c_stride_) * (height_ / 2);
+        planes.v_stride = c_stride_;
+        return planes;
+    }
+
+    bool operator==(const I420Image& other) const {
+        return data_ == other.data_;
+    }
+
+   private:
+    int width_;
+    int height_;
+    int y_stride_;
+    int c_stride_;
+    std::vector<unsigned char> data_;
+};
+
+/**
+ * @brief Compare every supported kernel and the threaded converter with the
+ * scalar reference
+ *
+ * @return true if all outputs match exactly, false otherwise.
+ */
+bool check_exactness() {
+    const int sizes[][2] = {{2, 2},   {14, 4},  {16, 2},    {30, 6},
+                            {34, 8},  {48, 2},  {62, 12},   {96, 20},
+                            {100, 4}, {322, 6}, {1280, 72}, {1924, 36}};
+    bool exact = true;
+    for (const auto& size : sizes) {
+        const int width = size[0];
+        const int height = size[1];
+        const int stride = width * 4 + 12;
+        std::vector<unsigned char> bgra(static_cast<std::size_t>(stride) *
+                                        height);
+        fill(bgra.data(), bgra.size(), width * 31 + height);
+
+        I420Image reference(width, height);
+        ColorConvert::bgra_to_i420(bgra.data(), stride, width, height,
+                                   reference.planes(),
+                                   ColorConvert::Kernel::SCALAR);
+
+        std::vector<unsigned char> downscaled_reference(
+            static_cast<std::size_t>(width / 2) * (height / 2));
+        ColorConvert::downscale_half(
+            bgra.data(), stride, width / 2, height / 2,
+            downscaled_reference.data(), width / 2,
+            ColorConvert::Kernel::SCALAR);
+
+        for (const ColorConvert::Kernel kernel : KERNELS) {
+            if (!ColorConvert::supported(kernel)) continue;
+
+            I420Image output(width, height);
+            ColorConvert::bgra_to_i420(bgra.data(), stride, width, height,
+                                       output.planes(), kernel);
+            std::vector<unsigned char> downscaled(downscaled_reference.size());
+            ColorConvert::downscale_half(bgra.data(), stride, width / 2,
+                                         height / 2, downscaled.data(),
+                                         width / 2, kernel);
+            if (!(output == reference) || downscaled != downscaled_reference) {
+                std::cout << "MISMATCH: " << ColorConvert::name(kernel)
+                          << " at " << width << "x" << height << "\n";
+                exact = false;
+            }
+        }
+    }
+
+    // Threaded bands, and half size against convert then downscale
+    const int width = 640;
+    const int height = 360;
+    FramePool pool(FrameLayout::aligned(PixelFormat::BGRA, width, height), 1);
+    FrameRef frame = pool.acquire();
+    fill(frame->data(), frame->layout().size(), 7);
+
+    I420Image reference(width, height);
+    ColorConvert::Planes full = reference.planes();
+    ColorConvert::bgra_to_i420(frame->data(), frame->stride(), width, height,
+                               full, ColorConvert::Kernel::SCALAR);
+    I420Image half_reference(width / 2, height / 2);
+    ColorConvert::Planes half = half_reference.planes();
+    ColorConvert::downscale_half(full.y, full.y_stride, width / 2, height / 2,
+                                 half.y, half.y_stride,
+                                 ColorConvert::Kernel::SCALAR);
+    ColorConvert::downscale_half(full.u, full.u_stride, width / 4, height / 4,
+                                 half.u, half.u_stride,
+                                 ColorConvert::Kernel::SCALAR);
+    ColorConvert::downscale_half(full.v, full.v_stride, width / 4, height / 4,
+                                 half.v, half.v_stride,
+                                 ColorConvert::Kernel::SCALAR);
+
+    for (const int threads : {1, 3, 4}) {
+        ColorConverter converter(threads);
+        I420Image output(width, height);
+        converter.convert(*frame, output.planes());
+        I420Image half_output(width / 2, height / 2);
+        converter.convert_half(*frame, half_output.planes());
+        if (!(output == reference) || !(half_output == half_reference)) {
+            std::cout << "MISMATCH: converter with " << threads
+                      << " threads\n";
+            exact = false;
+        }
+    }
+    return exact;
+}
+
+template <typename Convert>
+double milliseconds_per_frame(const int iterations, Convert convert) {
+    convert();  // Warm up caches and workers
+    const Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) convert();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+               .count() /
+           iterations;
+}
+
+void report(const std::string& name, const double milliseconds) {
+    const double pixels = static_cast<double>(BENCH_WIDTH) * BENCH_HEIGHT;
+    std::cout << "  " << name << ": " << milliseconds << " ms/frame, "
+              << pixels / milliseconds / 1000.0 << " Mpixel/s\n";
+}
+
+}  // namespace
+
+/**
+ * Checks every kernel the CPU supports against the scalar reference, then
+ * measures 1080p BGRA to I420 conversion per kernel and across threads.
+ * Exits non-zero if any output differs from the reference.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        int iterations = DEFAULT_ITERATIONS;
+        if (const auto it = options.find("iterations"); it != options.end()) {
+            iterations = std::stoi(it->second);
+        }
+        int max_threads =
+            static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        if (const auto it = options.find("threads"); it != options.end()) {
+            max_threads = std::stoi(it->second);
+        }
+        if (iterations <= 0 || max_threads <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        if (!check_exactness()) return 1;
+        std::cout << "All kernels match the scalar reference; best is "
+                  << ColorConvert::name(ColorConvert::best_kernel()) << "\n";
+
+        FramePool pool(FrameLayout::aligned(PixelFormat::BGRA, BENCH_WIDTH,
+                                            BENCH_HEIGHT),
+                       1);
+        FrameRef frame = pool.acquire();
+        fill(frame->data(), frame->layout().size(), 1);
+        I420Image output(BENCH_WIDTH, BENCH_HEIGHT);
+        const ColorConvert::Planes planes = output.planes();
+        I420Image half_output(BENCH_WIDTH / 2, BENCH_HEIGHT / 2);
+        const ColorConvert::Planes half_planes = half_output.planes();
+
+        std::cout << BENCH_WIDTH << "x" << BENCH_HEIGHT
+                  << " BGRA to I420, one thread:\n";
+        for (const ColorConvert::Kernel kernel : KERNELS) {
+            if (!ColorConvert::supported(kernel)) continue;
+            report(ColorConvert::name(kernel),
+                   milliseconds_per_frame(iterations, [&]() {
+                       ColorConvert::bgra_to_i420(
+                           frame->data(), frame->stride(), BENCH_WIDTH,
+                           BENCH_HEIGHT, planes, kernel);
+                   }));
+        }
+
+        std::cout << "Best kernel across threads:\n";
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            ColorConverter converter(threads);
+            report(std::to_string(threads) + " thread(s)",
+                   milliseconds_per_frame(iterations, [&]() {
+                       converter.convert(*frame, planes);
+                   }));
+            report(std::to_string(threads) + " thread(s), half size",
+                   milliseconds_per_frame(iterations, [&]() {
+                       converter.convert_half(*frame, half_planes);
+                   }));
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
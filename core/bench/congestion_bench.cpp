@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "arrival_recorder.hpp"
+#include "common.hpp"
+#include "congestion_controller.hpp"
+#include "fec_encoder.hpp"
+#include "impairment_model.hpp"
+#include "path_mtu.hpp"
+#include "rtcp_feedback.hpp"
+#include "rtp_packet.hpp"
+#include "vp8_packetizer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int FRAME_RATE = 60;
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / FRAME_RATE;
+constexpr std::chrono::milliseconds ONE_WAY_DELAY{20};
+constexpr std::chrono::milliseconds QUEUE_LIMIT{200};
+constexpr std::chrono::seconds DEFAULT_PHASE{20};
+constexpr std::chrono::seconds SETTLE{2};  // Left out of each phase's stats
+constexpr uint64_t CAPACITIES[] = {4000000, 1500000, 6000000};  // bits/s
+constexpr double LOSS_RATES[] = {0.0, 0.01};
+constexpr double DEFAULT_TARGET_MS = 50;  // p95 queueing delay
+constexpr std::chrono::microseconds TICK{250};
+
+struct Datagram {
+    Clock::time_point arrival;
+    uint64_t order;  // Sent, to keep ties in order
+    Clock::time_point sent;
+    std::vector<unsigned char> data;
+
+    bool operator>(const Datagram& other) const {
+        return arrival > other.arrival ||
+               (arrival == other.arrival && order > other.order);
+    }
+};
+
+using Queue = std::priority_queue<Datagram, std::vector<Datagram>,
+                                  std::greater<Datagram>>;
+
+struct Phase {
+    uint64_t capacity = 0;
+    uint64_t delivered_bytes = 0;
+    uint64_t sent_packets = 0;
+    uint64_t lost_packets = 0;
+    double target_sum = 0;  // bits/s, summed per frame
+    uint64_t frames = 0;
+    std::vector<double> queueing_ms;
+};
+
+/**
+ * @brief A direction of the path: the proxy's impairment model in virtual
+ * time, with the datagrams it lets through waiting for their departure
+ */
+class Link {
+   public:
+    explicit Link(const ImpairmentConfig& config) : model_(config) {}
+
+    bool send(const Clock::time_point now, std::vector<unsigned char> data) {
+        const ImpairmentModel::Verdict verdict =
+            model_.process(data.size(), now);
+        for (std::size_t i = 0; i < verdict.copies; ++i) {
+            in_flight_.push({verdict.departures[i], sent_++, now, data});
+        }
+        return verdict.copies > 0;
+    }
+
+    bool receive(const Clock::time_point now, Datagram& datagram) {
+        if (in_flight_.empty() || in_flight_.top().arrival > now) {
+            return false;
+        }
+        datagram = in_flight_.top();
+        in_flight_.pop();
+        return true;
+    }
+
+    void set_rate(const uint64_t rate_bps) { model_.set_rate(rate_bps); }
+
+   private:
+    ImpairmentModel model_;
+    uint64_t sent_ = 0;
+    Queue in_flight_;
+};
+
+double percentile(std::vector<double> samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+/**
+ * @brief Stream 60 fps video through a bottleneck whose capacity steps
+ * every phase, in virtual time. With congestion control the encoder
+ * produces the controller's target, fed back from the receiver's transport
+ * feedback every TRANSPORT_FEEDBACK_INTERVAL; without it, a fixed
+ * DEFAULT_START_BITRATE.
+ */
+std::vector<Phase> run(const bool controlled, const double loss,
+                       const std::chrono::seconds phase_length) {
+    ImpairmentConfig down_config;
+    down_config.seed = 11;
+    down_config.loss = loss;
+    down_config.delay = ONE_WAY_DELAY;
+    down_config.rate_bps = CAPACITIES[0];
+    down_config.queue_limit = QUEUE_LIMIT;
+    ImpairmentConfig up_config;
+    up_config.seed = 12;
+    up_config.delay = ONE_WAY_DELAY;
+    Link down(down_config);
+    Link up(up_config);
+
+    CongestionController controller;
+    Vp8Packetizer packetizer(1, PathMtu::BASE_PLPMTU - Fec::OVERHEAD -
+                                    Rtp::TRANSPORT_EXTENSION_SIZE);
+    const std::vector<unsigned char> frame(
+        static_cast<std::size_t>(DEFAULT_MAX_BITRATE / 8 / FRAME_RATE), 0x01);
+    ArrivalRecorder recorder;
+    int64_t arrivals[RtcpFeedback::MAX_FEEDBACK_PACKETS];
+    unsigned char feedback[RtcpFeedback::MAX_TRANSPORT_FEEDBACK_SIZE];
+
+    std::vector<Phase> phases(std::size(CAPACITIES));
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+        phases[i].capacity = CAPACITIES[i];
+    }
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + phase_length * phases.size();
+    const auto phase_of = [&](const Clock::time_point time) {
+        return std::min<std::size_t>((time - start) / phase_length,
+                                     phases.size() - 1);
+    };
+    const auto settled = [&](const Clock::time_point time) {
+        return (time - start) % phase_length >= SETTLE;
+    };
+
+    std::size_t frames = 0;
+    Clock::time_point last_feedback = start;
+    Datagram datagram;
+    for (Clock::time_point now = start; now < end; now += TICK) {
+        const std::size_t phase = phase_of(now);
+        down.set_rate(phases[phase].capacity);
+
+        // Sender: one frame of the target's size, all its packets at once
+        for (; start + std::chrono::microseconds(1000000 * frames /
+                                                 FRAME_RATE) <=
+               now;
+             ++frames) {
+            const int64_t bitrate = controlled ? controller.target_bitrate()
+                                               : DEFAULT_START_BITRATE;
+            if (settled(now)) {
+                phases[phase].target_sum += static_cast<double>(bitrate);
+                ++phases[phase].frames;
+            }
+            Vp8FrameInfo info;
+            info.timestamp = static_cast<uint32_t>(frames * FRAME_DURATION);
+            const std::size_t size = std::min<std::size_t>(
+                static_cast<std::size_t>(bitrate / 8 / FRAME_RATE),
+                frame.size());
+            for (const GatherDatagram& packet :
+                 packetizer.packetize(frame.data(), size, info)) {
+                std::vector<unsigned char> data(packet.size() +
+                                                Rtp::TRANSPORT_EXTENSION_SIZE);
+                const uint16_t sequence =
+                    controller.on_packet_sent(data.size(), now);
+                const auto* header =
+                    static_cast<const unsigned char*>(packet.header.data());
+                std::size_t offset =
+                    Rtp::write_transport_header(header, sequence, data.data());
+                std::memcpy(data.data() + offset, header + Rtp::HEADER_SIZE,
+                            packet.header.size() - Rtp::HEADER_SIZE);
+                offset += packet.header.size() - Rtp::HEADER_SIZE;
+                std::memcpy(data.data() + offset, packet.payload.data(),
+                            packet.payload.size());
+                if (settled(now)) ++phases[phase].sent_packets;
+                if (!down.send(now, std::move(data)) && settled(now)) {
+                    ++phases[phase].lost_packets;
+                }
+            }
+        }
+
+        // Receiver: stamps arrivals at their exact departure from the link
+        while (down.receive(now, datagram)) {
+            uint16_t sequence = 0;
+            if (!Rtp::read_transport_sequence(datagram.data.data(),
+                                              datagram.data.size(),
+                                              sequence)) {
+                continue;
+            }
+            recorder.on_packet(sequence, datagram.arrival);
+            if (!settled(datagram.sent)) continue;
+            Phase& sent_in = phases[phase_of(datagram.sent)];
+            sent_in.delivered_bytes += datagram.data.size();
+            sent_in.queueing_ms.push_back(
+                std::chrono::duration<double, std::milli>(
+                    datagram.arrival - datagram.sent - ONE_WAY_DELAY)
+                    .count());
+        }
+        if (now - last_feedback >= TRANSPORT_FEEDBACK_INTERVAL) {
+            last_feedback = now;
+            for (std::size_t size = 0;
+                 (size = recorder.write_feedback(2, 1, feedback)) > 0;) {
+                up.send(now, std::vector<unsigned char>(feedback,
+                                                        feedback + size));
+            }
+        }
+
+        while (up.receive(now, datagram)) {
+            uint16_t base_sequence = 0;
+            std::size_t count = 0;
+            if (RtcpFeedback::read_transport_feedback(
+                    datagram.data.data(), datagram.data.size(), base_sequence,
+                    arrivals, std::size(arrivals), count)) {
+                controller.on_feedback(base_sequence, arrivals, count, now);
+            }
+        }
+    }
+    return phases;
+}
+
+}  // namespace
+
+/**
+ * Streams 60 fps video from a sender to a receiver through the netem
+ * proxy's impairment model in virtual time: a 40 ms round trip and a
+ * bottleneck with a 200 ms tail-drop queue whose capacity steps from 4 to
+ * 1.5 to 6 Mbit/s, without and with 1% random loss. Compares a fixed
+ * 2.5 Mbit/s stream with one whose bitrate follows the congestion
+ * controller, and reports per capacity phase the queueing delay of the
+ * packets, the share of the capacity used, the loss and the mean target.
+ * Exits non-zero if the controlled stream's 95th percentile queueing
+ * delay goes over --target milliseconds in any phase.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        std::chrono::seconds phase_length = DEFAULT_PHASE;
+        if (const auto it = options.find("phase"); it != options.end()) {
+            phase_length = std::chrono::seconds(std::stoi(it->second));
+        }
+        double target_ms = DEFAULT_TARGET_MS;
+        if (const auto it = options.find("target"); it != options.end()) {
+            target_ms = std::stod(it->second);
+        }
+        if (phase_length <= SETTLE || target_ms <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        std::cout << "Phases of " << phase_length.count()
+                  << " s, round trip " << 2 * ONE_WAY_DELAY.count()
+                  << " ms, queue limit " << QUEUE_LIMIT.count()
+                  << " ms, target p95 queueing delay " << target_ms
+                  << " ms\n";
+        bool held = true;
+        for (const double loss : LOSS_RATES) {
+            for (const bool controlled : {false, true}) {
+                for (const Phase& phase :
+                     run(controlled, loss, phase_length)) {
+                    const double seconds =
+                        static_cast<double>((phase_length - SETTLE).count());
+                    const double p95 = percentile(phase.queueing_ms, 0.95);
+                    held = held && (!controlled || p95 <= target_ms);
+                    std::cout
+                        << "loss " << loss * 100 << "% "
+                        << (controlled ? "controlled" : "fixed     ") << " "
+                        << phase.capacity / 1000 << " kbit/s: queueing p50 "
+                        << percentile(phase.queueing_ms, 0.5) << " p95 "
+                        << p95 << " p99 "
+                        << percentile(phase.queueing_ms, 0.99)
+                        << " ms, utilization "
+                        << 100.0 * static_cast<double>(phase.delivered_bytes) *
+                               8 / seconds /
+                               static_cast<double>(phase.capacity)
+                        << "%, lost "
+                        << 100.0 * static_cast<double>(phase.lost_packets) /
+                               static_cast<double>(
+                                   std::max<uint64_t>(phase.sent_packets, 1))
+                        << "%, mean target "
+                        << (phase.frames > 0
+                                ? phase.target_sum /
+                                      static_cast<double>(phase.frames) / 1000
+                                : 0)
+                        << " kbit/s\n";
+                }
+            }
+        }
+        if (!held) {
+            std::cout << "Queueing delay over the target\n";
+            return 1;
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
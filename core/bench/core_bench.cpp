@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Entry point of core_bench. The benchmarks themselves are registered by
+ * the *_bench_cases.cpp files linked into the same executable.
+ *
+ * Output defaults to JSON so that runs can be stored and compared across
+ * commits; pass --benchmark_format=console for a human-readable table.
+ */
+int main(int argc, char* argv[]) {
+    std::vector<char*> args(argv, argv + argc);
+    std::string json_format = "--benchmark_format=json";
+
+    const bool has_format = std::any_of(
+        args.begin() + 1, args.end(), [](const char* arg) {
+            return std::strncmp(arg, "--benchmark_format",
+                                std::strlen("--benchmark_format")) == 0;
+        });
+    if (!has_format) args.push_back(json_format.data());
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+#include "fec_decoder.hpp"
+#include "fec_encoder.hpp"
+#include "galois_field.hpp"
+#include "jitter_buffer.hpp"
+#include "loss_estimator.hpp"
+#include "nack_tracker.hpp"
+#include "packet_history.hpp"
+#include "rtcp_feedback.hpp"
+#include "vp8_depacketizer.hpp"
+#include "vp8_packetizer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr GaloisField::Kernel KERNELS[] = {GaloisField::Kernel::SCALAR,
+                                           GaloisField::Kernel::SSSE3,
+                                           GaloisField::Kernel::AVX2};
+
+// Throughput: keyframe-sized groups, losing as many packets as they repair
+constexpr std::size_t GROUP_PACKETS = 34;
+constexpr std::size_t PACKET_SIZE = 1200;
+constexpr double THROUGHPUT_LOSS = 0.03;  // Three parities per group
+constexpr int DEFAULT_ITERATIONS = 2000;
+constexpr std::size_t STREAM_GROUPS = 256;  // Decoded per fresh decoder
+
+// Streaming: 60 fps video over a long path, where NACK is slow
+constexpr std::size_t DEFAULT_FRAMES = 3600;  // 60 s at 60 fps
+constexpr int FRAME_RATE = 60;
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / FRAME_RATE;
+constexpr std::size_t DELTA_FRAME_SIZE = 5000;  // 2.5 Mbit/s at 60 fps
+constexpr std::size_t KEYFRAME_SIZE = 40000;
+constexpr std::size_t KEYFRAME_INTERVAL = 600;
+constexpr std::chrono::milliseconds ONE_WAY_DELAY{40};
+constexpr double JITTER_MS = 1.0;  // Mean of the exponential extra delay
+constexpr double MEAN_BURST = 2.0;  // packets lost in a row
+constexpr std::chrono::microseconds TICK{250};
+constexpr double LOSS_RATES[] = {0.01, 0.03, 0.05};
+
+/**
+ * @brief Fill a buffer with the same pseudo-random bytes on every run
+ */
+void fill(unsigned char* data, const std::size_t size, uint32_t seed) {
+    for (std::size_t i = 0; i < size; ++i) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = static_cast<unsigned char>(seed >> 24);
+    }
+}
+
+/**
+ * @brief Compare every supported kernel with the scalar reference
+ *
+ * @return true if all outputs match exactly, false otherwise.
+ */
+bool check_exactness() {
+    const std::size_t sizes[] = {0, 1, 15, 16, 17, 31, 32, 33, 100, 1200, 1202};
+    bool exact = true;
+    for (const std::size_t size : sizes) {
+        std::vector<unsigned char> source(size);
+        std::vector<unsigned char> initial(size);
+        fill(source.data(), size, static_cast<uint32_t>(size));
+        fill(initial.data(), size, static_cast<uint32_t>(size) + 1);
+        for (unsigned coefficient = 0; coefficient < 256; ++coefficient) {
+            std::vector<unsigned char> reference = initial;
+            GaloisField::multiply_add(source.data(), reference.data(), size,
+                                      static_cast<uint8_t>(coefficient),
+                                      GaloisField::Kernel::SCALAR);
+            for (const GaloisField::Kernel kernel : KERNELS) {
+                if (!GaloisField::supported(kernel)) continue;
+                std::vector<unsigned char> output = initial;
+                GaloisField::multiply_add(source.data(), output.data(), size,
+                                          static_cast<uint8_t>(coefficient),
+                                          kernel);
+                if (output != reference) {
+                    std::cout << "MISMATCH: " << GaloisField::name(kernel)
+                              << " at " << size << " bytes, coefficient "
+                              << coefficient << "\n";
+                    exact = false;
+                }
+            }
+        }
+    }
+    return exact;
+}
+
+/**
+ * @brief Copy a packet into one contiguous datagram
+ */
+std::vector<unsigned char> flatten(const GatherDatagram& packet) {
+    std::vector<unsigned char> datagram(packet.size());
+    std::memcpy(datagram.data(), packet.header.data(), packet.header.size());
+    std::memcpy(datagram.data() + packet.header.size(), packet.payload.data(),
+                packet.payload.size());
+    return datagram;
+}
+
+/**
+ * @brief Measure encoding and repairing groups with one code and kernel,
+ * in megabits of video per second
+ */
+void measure_codec(const Fec::Scheme scheme, const GaloisField::Kernel kernel,
+                   const int iterations) {
+    std::vector<unsigned char> frame(GROUP_PACKETS * PACKET_SIZE);
+    fill(frame.data(), frame.size(), 3);
+    Vp8Packetizer packetizer(1, PACKET_SIZE);
+    const std::vector<GatherDatagram> packets =
+        packetizer.packetize(frame.data(), frame.size(), Vp8FrameInfo{});
+    std::size_t media_bytes = 0;
+    for (const GatherDatagram& packet : packets) media_bytes += packet.size();
+
+    FecEncoder encoder(2, scheme, kernel);
+    encoder.set_loss(THROUGHPUT_LOSS, 1);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < iterations; ++i) encoder.protect(packets);
+    const double encode_seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    // A stream of distinct groups, since rebuilt packets are checked
+    // against their sequence numbers. Each loses one packet per parity,
+    // the most XOR and Reed-Solomon repair.
+    const std::size_t parities = encoder.protect(packets).size();
+    std::vector<std::vector<unsigned char>> stream;
+    std::vector<bool> is_parity;
+    for (std::size_t group = 0; group < STREAM_GROUPS; ++group) {
+        const std::vector<GatherDatagram>& media =
+            packetizer.packetize(frame.data(), frame.size(), Vp8FrameInfo{});
+        for (std::size_t p = parities; p < media.size(); ++p) {
+            stream.push_back(flatten(media[p]));
+            is_parity.push_back(false);
+        }
+        for (const GatherDatagram& packet : encoder.protect(media)) {
+            stream.push_back(flatten(packet));
+            is_parity.push_back(true);
+        }
+    }
+
+    double decode_seconds = 0;
+    std::size_t rebuilt = 0;
+    for (int done = 0; done < iterations;
+         done += static_cast<int>(STREAM_GROUPS)) {
+        FecDecoder decoder(kernel);
+        start = Clock::now();
+        for (std::size_t i = 0; i < stream.size(); ++i) {
+            const std::vector<unsigned char>& datagram = stream[i];
+            rebuilt += is_parity[i] ? decoder
+                                          .push_parity(datagram.data(),
+                                                       datagram.size())
+                                          .size()
+                                    : decoder
+                                          .push_media(datagram.data(),
+                                                      datagram.size())
+                                          .size();
+        }
+        decode_seconds +=
+            std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    const int groups = (iterations + static_cast<int>(STREAM_GROUPS) - 1) /
+                       static_cast<int>(STREAM_GROUPS) *
+                       static_cast<int>(STREAM_GROUPS);
+
+    const double bits = 8.0 * media_bytes;
+    std::cout << "  " << (scheme == Fec::Scheme::XOR ? "XOR" : "RS ") << " "
+              << GaloisField::name(kernel) << ": " << parities
+              << " parities per " << packets.size() << " packets, encode "
+              << bits * iterations / encode_seconds / 1e6
+              << " Mbit/s, repair " << bits * groups / decode_seconds / 1e6
+              << " Mbit/s (" << static_cast<double>(rebuilt) / groups
+              << " rebuilt per group)\n";
+}
+
+struct Datagram {
+    Clock::time_point arrival;
+    uint64_t order;  // Sent, to keep ties in order
+    bool to_sender;
+    std::vector<unsigned char> data;
+
+    bool operator>(const Datagram& other) const {
+        return arrival > other.arrival ||
+               (arrival == other.arrival && order > other.order);
+    }
+};
+
+struct Result {
+    std::size_t played = 0;
+    std::size_t dropped = 0;
+    std::size_t keyframes = 0;
+    uint64_t bytes = 0;
+    uint64_t parity = 0;
+    uint64_t rebuilt = 0;
+    uint64_t retransmitted = 0;
+    std::vector<double> delay_ms;
+};
+
+/**
+ * @class GilbertElliott
+ * @brief Losses in bursts: every packet is lost in the bad state, which is
+ * left after MEAN_BURST packets on average
+ */
+class GilbertElliott {
+   public:
+    GilbertElliott(const double loss)
+        : enter_(loss / MEAN_BURST / (1 - loss)), leave_(1 / MEAN_BURST) {}
+
+    bool lost(std::mt19937& random) {
+        bad_ = bad_ ? !leave_(random) : enter_(random);
+        return bad_;
+    }
+
+   private:
+    std::bernoulli_distribution enter_;
+    std::bernoulli_distribution leave_;
+    bool bad_ = false;
+};
+
+/**
+ * @brief A path with a fixed delay, exponential jitter and bursty losses,
+ * in both directions. Each direction is a queue: jitter delays packets but
+ * does not reorder them.
+ */
+class Network {
+   public:
+    Network(const double loss, const uint32_t seed)
+        : random_(seed), jitter_(1.0 / JITTER_MS), down_(loss), up_(loss) {}
+
+    void send(const Clock::time_point now, const bool to_sender,
+              const unsigned char* data, const std::size_t size) {
+        if ((to_sender ? up_ : down_).lost(random_)) return;
+        const auto extra = std::chrono::microseconds(
+            static_cast<int64_t>(jitter_(random_) * 1000));
+        Clock::time_point& last = to_sender ? last_up_ : last_down_;
+        last = std::max(last, now + ONE_WAY_DELAY + extra);
+        in_flight_.push({last, sent_++, to_sender,
+                         std::vector<unsigned char>(data, data + size)});
+    }
+
+    void send(const Clock::time_point now, const GatherDatagram& packet) {
+        const std::vector<unsigned char> datagram = flatten(packet);
+        send(now, false, datagram.data(), datagram.size());
+    }
+
+    bool receive(const Clock::time_point now, Datagram& datagram) {
+        if (in_flight_.empty() || in_flight_.top().arrival > now) {
+            return false;
+        }
+        datagram = in_flight_.top();
+        in_flight_.pop();
+        return true;
+    }
+
+    bool empty() const { return in_flight_.empty(); }
+
+   private:
+    std::mt19937 random_;
+    std::exponential_distribution<double> jitter_;
+    GilbertElliott down_;
+    GilbertElliott up_;
+    Clock::time_point last_down_;
+    Clock::time_point last_up_;
+    uint64_t sent_ = 0;
+    std::priority_queue<Datagram, std::vector<Datagram>,
+                        std::greater<Datagram>>
+        in_flight_;
+};
+
+/**
+ * @brief Stream frames from a sender with a packet history and optionally
+ * an FEC encoder to a receiver with a jitter buffer, in virtual time. The
+ * receiver repairs what it can from parity, asks for the rest with NACK
+ * and for keyframes with PLI, and reports its loss to the sender.
+ */
+Result run(const std::size_t frames, const double loss, const bool fec,
+           const Fec::Scheme scheme,
+           const std::chrono::milliseconds max_latency) {
+    Result result;
+    Network network(loss, 7);
+    const std::vector<unsigned char> delta(DELTA_FRAME_SIZE, 0x01);
+    const std::vector<unsigned char> keyframe(KEYFRAME_SIZE, 0x00);
+    const std::chrono::microseconds rtt = 2 * ONE_WAY_DELAY;
+
+    Vp8Packetizer packetizer(1, PathMtu::BASE_PLPMTU - Fec::OVERHEAD);
+    PacketHistory history;
+    FecEncoder encoder(3, scheme);
+    bool keyframe_requested = false;
+
+    Vp8Depacketizer depacketizer;
+    JitterBuffer buffer(max_latency);
+    NackTracker tracker;
+    FecDecoder decoder;
+    LossEstimator estimator;
+    const auto loss_wait = rtt + DEFAULT_REORDER_GRACE;
+    buffer.set_loss_wait(loss_wait <= max_latency
+                             ? loss_wait
+                             : std::chrono::microseconds(0));
+    uint16_t nack_sequences[RtcpFeedback::MAX_NACK_ITEMS];
+    uint16_t received_sequences[RtcpFeedback::MAX_NACK_ITEMS *
+                                RtcpFeedback::NACK_ITEM_SPAN];
+    unsigned char feedback[RtcpFeedback::MAX_NACK_SIZE];
+
+    const Clock::time_point start = Clock::now();
+    const auto sent_at = [start](const std::size_t index) {
+        return start + std::chrono::microseconds(1000000 * index / FRAME_RATE);
+    };
+    Clock::time_point last_report = start;
+    std::size_t sent = 0;
+    Datagram datagram;
+    ReceivedFrame frame;
+    const auto receive_media = [&](const unsigned char* data,
+                                   const std::size_t size,
+                                   const Clock::time_point now) {
+        Rtp::Header header;
+        std::size_t payload_offset = 0;
+        std::size_t payload_size = 0;
+        const bool retransmitted =
+            Rtp::read_header(data, size, header, payload_offset,
+                             payload_size) &&
+            tracker.on_packet(header, now);
+        if (depacketizer.push(data, size, frame)) {
+            buffer.insert(frame, now, retransmitted);
+        }
+        return retransmitted;
+    };
+    for (Clock::time_point now = start;
+         sent < frames || !network.empty() || buffer.size() > 0;
+         now += TICK) {
+        // Sender
+        for (; sent < frames && sent_at(sent) <= now; ++sent) {
+            const bool key =
+                sent % KEYFRAME_INTERVAL == 0 || keyframe_requested;
+            keyframe_requested = false;
+            result.keyframes += key ? 1 : 0;
+            const std::vector<unsigned char>& data = key ? keyframe : delta;
+            Vp8FrameInfo info;
+            info.timestamp = static_cast<uint32_t>(sent * FRAME_DURATION);
+            const std::vector<GatherDatagram>& packets =
+                packetizer.packetize(data.data(), data.size(), info);
+            for (const GatherDatagram& packet : packets) {
+                history.store(packet);
+                network.send(now, packet);
+                result.bytes += packet.size();
+            }
+            if (!fec) continue;
+            for (const GatherDatagram& packet : encoder.protect(packets)) {
+                network.send(now, packet);
+                result.bytes += packet.size();
+                ++result.parity;
+            }
+        }
+
+        while (network.receive(now, datagram)) {
+            const unsigned char* data = datagram.data.data();
+            const std::size_t size = datagram.data.size();
+            uint32_t ssrc = 0;
+            std::size_t count = 0;
+            double loss_rate = 0;
+            double mean_burst = 0;
+            if (datagram.to_sender) {
+                if (RtcpFeedback::read_pli(data, size, ssrc)) {
+                    keyframe_requested = true;
+                } else if (RtcpFeedback::read_loss_report(
+                               data, size, loss_rate, mean_burst)) {
+                    encoder.set_loss(loss_rate, mean_burst);
+                } else if (RtcpFeedback::read_nack(
+                               data, size, ssrc, received_sequences,
+                               std::size(received_sequences), count)) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        boost::asio::const_buffer packet;
+                        if (!history.resend(received_sequences[i], now,
+                                            packet)) {
+                            continue;
+                        }
+                        network.send(
+                            now, false,
+                            static_cast<const unsigned char*>(packet.data()),
+                            packet.size());
+                        result.bytes += packet.size();
+                    }
+                }
+                continue;
+            }
+
+            const std::vector<boost::asio::const_buffer>* rebuilt = nullptr;
+            if ((data[1] & 0x7F) == Fec::PAYLOAD_TYPE) {
+                rebuilt = &decoder.push_parity(data, size);
+            } else {
+                if (!receive_media(data, size, now)) {
+                    estimator.on_packet(
+                        static_cast<uint16_t>(data[2] << 8 | data[3]));
+                }
+                rebuilt = &decoder.push_media(data, size);
+            }
+            for (const boost::asio::const_buffer& packet : *rebuilt) {
+                receive_media(static_cast<const unsigned char*>(packet.data()),
+                              packet.size(), now);
+            }
+        }
+
+        // Receiver
+        while (buffer.pop(now, frame)) {
+            result.delay_ms.push_back(
+                std::chrono::duration<double, std::milli>(
+                    now - sent_at(frame.timestamp / FRAME_DURATION))
+                    .count());
+        }
+        if (buffer.take_keyframe_request(now)) {
+            network.send(now, true, feedback,
+                         RtcpFeedback::write_pli(2, 1, feedback));
+        }
+        const std::size_t count = tracker.poll(
+            now, rtt, buffer, nack_sequences, std::size(nack_sequences));
+        std::size_t written = 0;
+        if (count > 0) {
+            network.send(now, true, feedback,
+                         RtcpFeedback::write_nack(2, 1, nack_sequences, count,
+                                                  feedback, written));
+        }
+        double loss_rate = 0;
+        double mean_burst = 1;
+        if (now - last_report >= LOSS_REPORT_INTERVAL) {
+            last_report = now;
+            if (estimator.report(loss_rate, mean_burst)) {
+                network.send(now, true, feedback,
+                             RtcpFeedback::write_loss_report(
+                                 2, loss_rate, mean_burst, feedback));
+            }
+        }
+    }
+
+    result.played = buffer.delivered();
+    result.dropped = buffer.dropped();
+    result.rebuilt = decoder.rebuilt();
+    result.retransmitted = history.resent();
+    return result;
+}
+
+double percentile(std::vector<double>& samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+}  // namespace
+
+/**
+ * Checks every GF(2^8) kernel the CPU supports against the scalar
+ * reference, and measures encoding and repairing keyframe-sized groups
+ * per code and kernel. Then streams 60 fps video over a simulated path
+ * with an 80 ms round trip, 1 ms of mean jitter and bursty losses both
+ * ways, in virtual time, and compares recovering with NACK alone against
+ * NACK behind loss-adaptive FEC. Reports frames played and dropped,
+ * keyframes sent, bytes and parity packets sent, packets rebuilt and
+ * retransmitted, and the end-to-end delay of played frames. Exits
+ * non-zero if any kernel differs from the reference.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        int iterations = DEFAULT_ITERATIONS;
+        if (const auto it = options.find("iterations"); it != options.end()) {
+            iterations = std::stoi(it->second);
+        }
+        std::size_t frames = DEFAULT_FRAMES;
+        if (const auto it = options.find("frames"); it != options.end()) {
+            frames = std::stoul(it->second);
+        }
+        std::chrono::milliseconds max_latency{100};
+        if (const auto it = options.find("latency"); it != options.end()) {
+            max_latency = std::chrono::milliseconds(std::stoi(it->second));
+        }
+        if (iterations <= 0 || frames == 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        if (!check_exactness()) return 1;
+        std::cout << "All kernels match the scalar reference; best is "
+                  << GaloisField::name(GaloisField::best_kernel()) << "\n";
+        std::cout << "Groups of " << GROUP_PACKETS * PACKET_SIZE
+                  << " bytes in " << PACKET_SIZE << " byte packets:\n";
+        for (const Fec::Scheme scheme :
+             {Fec::Scheme::XOR, Fec::Scheme::REED_SOLOMON}) {
+            for (const GaloisField::Kernel kernel : KERNELS) {
+                if (!GaloisField::supported(kernel)) continue;
+                measure_codec(scheme, kernel, iterations);
+            }
+        }
+
+        std::cout << frames << " frames, latency cap " << max_latency.count()
+                  << " ms, round trip " << 2 * ONE_WAY_DELAY.count()
+                  << " ms, mean loss burst " << MEAN_BURST << "\n";
+        for (const double loss : LOSS_RATES) {
+            for (const int mode : {0, 1, 2}) {
+                const Fec::Scheme scheme =
+                    mode == 1 ? Fec::Scheme::XOR : Fec::Scheme::REED_SOLOMON;
+                Result result =
+                    run(frames, loss, mode != 0, scheme, max_latency);
+                std::cout << "loss " << loss * 100 << "% "
+                          << (mode == 0   ? "NACK    "
+                              : mode == 1 ? "NACK+XOR"
+                                          : "NACK+RS ")
+                          << ": " << result.played << " played, "
+                          << result.dropped << " dropped, "
+                          << result.keyframes << " keyframes, "
+                          << result.bytes / 1000 << " kB sent, "
+                          << result.parity << " parity, " << result.rebuilt
+                          << " rebuilt, " << result.retransmitted
+                          << " retransmitted, delay p50 "
+                          << percentile(result.delay_ms, 0.5) << " p99 "
+                          << percentile(result.delay_ms, 0.99) << " ms\n";
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <iostream>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "input_messages.hpp"
+#include "input_simulator_recording.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "udp_server.hpp"
+
+namespace {
+
+constexpr unsigned short SERVER_PORT = 47100;
+constexpr unsigned short CLIENT_PORT = 47101;
+constexpr std::size_t DEFAULT_CLIENTS = 200;
+constexpr double DEFAULT_RATE = 100.0;  // events/s per client
+constexpr double DEFAULT_DURATION = 5.0;  // seconds
+constexpr std::chrono::milliseconds DRAIN_TIME{500};
+constexpr std::chrono::microseconds SPIN_THRESHOLD{200};
+
+// Each simulated client cycles through this pattern of events
+constexpr InputMessages::EventType EVENT_CYCLE[] = {
+    InputMessages::KEY_PRESSED, InputMessages::KEY_RELEASED,
+    InputMessages::JOYSTICK_BUTTON_PRESSED,
+    InputMessages::JOYSTICK_BUTTON_RELEASED, InputMessages::JOYSTICK_MOVED};
+constexpr std::size_t CYCLE_LENGTH = std::size(EVENT_CYCLE);
+
+struct Config {
+    std::size_t clients = DEFAULT_CLIENTS;
+    double rate = DEFAULT_RATE;
+    double duration = DEFAULT_DURATION;
+};
+
+struct Client {
+    std::chrono::steady_clock::time_point next_send;
+    std::size_t index;
+    std::size_t step;
+
+    bool operator>(const Client& other) const {
+        return next_send > other.next_send;
+    }
+};
+
+Config parse_config(const int argc, char* argv[]) {
+    const auto options = Common::parse_options(argc, argv, 1);
+    Config config;
+    if (const auto it = options.find("clients"); it != options.end()) {
+        config.clients = std::stoul(it->second);
+    }
+    if (const auto it = options.find("rate"); it != options.end()) {
+        config.rate = std::stod(it->second);
+    }
+    if (const auto it = options.find("duration"); it != options.end()) {
+        config.duration = std::stod(it->second);
+    }
+    if (config.clients == 0 || config.duration <= 0) {
+        throw std::invalid_argument("Invalid --clients or --duration");
+    }
+    return config;
+}
+
+/**
+ * @brief Build the next message for a client. Key events carry a global
+ * sequence number as key code, so injections can be matched to sends.
+ */
+InputMessages::Message next_message(Client& client, const int sequence) {
+    const InputMessages::EventType type = EVENT_CYCLE[client.step];
+    client.step = (client.step + 1) % CYCLE_LENGTH;
+
+    const int joystick = static_cast<int>(client.index % 8);
+    switch (type) {
+        case InputMessages::KEY_PRESSED:
+        case InputMessages::KEY_RELEASED:
+            return InputMessages::Message(type, sequence);
+        case InputMessages::JOYSTICK_MOVED:
+            return InputMessages::Message(type, joystick, 0,
+                                          static_cast<float>(sequence % 200) -
+                                              100.0f);
+        default:
+            return InputMessages::Message(type, joystick,
+                                          static_cast<int>(client.index % 16));
+    }
+}
+
+void wait_until(const std::chrono::steady_clock::time_point deadline) {
+    if (std::chrono::steady_clock::now() < deadline - SPIN_THRESHOLD) {
+        std::this_thread::sleep_until(deadline - SPIN_THRESHOLD);
+    }
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+void print_latency(const char* name, const Metrics::HistogramSnapshot& s) {
+    std::cout << name << " latency (us): p50 " << s.p50 / 1000.0 << ", p90 "
+              << s.p90 / 1000.0 << ", p99 " << s.p99 / 1000.0 << ", max "
+              << s.max / 1000.0 << " over " << s.count << " key events\n";
+}
+
+}  // namespace
+
+/**
+ * Runs UDPServer in process with a recording input simulator and drives it
+ * with many simulated clients. UDPServer accepts a single client endpoint,
+ * so the clients are multiplexed over one socket bound to that endpoint;
+ * each keeps its own schedule and event sequence. Pass --rate 0 to send as
+ * fast as possible and find the saturation point of the io thread.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const Config config = parse_config(argc, argv);
+        const bool paced = config.rate > 0;
+
+        // UDPServer warns on every joystick event it cannot inject yet
+        Logger::set_level(Logger::LEVEL_ERROR);
+
+        auto recording = std::make_unique<InputSimulatorRecording>();
+        const InputSimulatorRecording& keyboard = *recording;
+
+        boost::asio::io_context server_context;
+        UDPServer server(server_context, SERVER_PORT, "127.0.0.1",
+                         std::to_string(CLIENT_PORT), std::move(recording));
+        std::thread server_thread([&server_context]() {
+            server_context.run();
+        });
+
+        boost::asio::io_context client_context;
+        udp::socket socket(client_context,
+                           udp::endpoint(udp::v4(), CLIENT_PORT));
+        const udp::endpoint server_endpoint(
+            boost::asio::ip::address_v4::loopback(), SERVER_PORT);
+
+        const auto interval = std::chrono::duration_cast<
+            std::chrono::steady_clock::duration>(std::chrono::duration<double>(
+            paced ? 1.0 / config.rate : 0.0));
+        const auto start = std::chrono::steady_clock::now();
+        const auto end = start + std::chrono::duration_cast<
+                                     std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double>(
+                                         config.duration));
+
+        // Spread the clients' first events evenly over one interval
+        std::priority_queue<Client, std::vector<Client>, std::greater<>>
+            schedule;
+        for (std::size_t i = 0; i < config.clients; ++i) {
+            schedule.push({start + interval * i / config.clients, i,
+                           i % CYCLE_LENGTH});
+        }
+
+        std::vector<std::chrono::steady_clock::time_point> send_times;
+        send_times.reserve(RECORDING_CAPACITY);
+        std::size_t sent = 0;
+        std::array<char, InputMessages::Message::MAX_SERIALIZED_SIZE> buffer;
+
+        while (true) {
+            Client client = schedule.top();
+            schedule.pop();
+            if (client.next_send >= end) break;
+            if (!paced && std::chrono::steady_clock::now() >= end) break;
+            if (paced) wait_until(client.next_send);
+
+            const auto message =
+                next_message(client, static_cast<int>(send_times.size()));
+            const std::size_t size =
+                message.serialize(buffer.data(), buffer.size());
+            if (message.type == InputMessages::KEY_PRESSED ||
+                message.type == InputMessages::KEY_RELEASED) {
+                send_times.push_back(std::chrono::steady_clock::now());
+            }
+
+            boost::system::error_code ec;
+            socket.send_to(boost::asio::buffer(buffer.data(), size),
+                           server_endpoint, 0, ec);
+            if (!ec) ++sent;
+
+            client.next_send += interval;
+            schedule.push(client);
+        }
+        const double send_seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                          start)
+                .count();
+
+        std::this_thread::sleep_for(DRAIN_TIME);
+        server_context.stop();
+        server_thread.join();
+
+        const uint64_t received = Metrics::counter("input.packets_in").value();
+        const uint64_t dropped = Metrics::counter("drops.unknown_endpoint")
+                                     .value() +
+                                 Metrics::counter("drops.bad_size").value() +
+                                 Metrics::counter("drops.parse_error").value();
+
+        Metrics::Histogram& end_to_end =
+            Metrics::histogram("bench.end_to_end_ns");
+        for (const auto& event : keyboard.events()) {
+            if (event.key_code < 0 ||
+                static_cast<std::size_t>(event.key_code) >= send_times.size()) {
+                continue;
+            }
+            end_to_end.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    event.time - send_times[event.key_code])
+                    .count()));
+        }
+
+        std::cout << config.clients << " clients at "
+                  << (paced ? std::to_string(config.rate) + " events/s each"
+                            : std::string("full speed"))
+                  << "\n";
+        std::cout << "Sent " << sent << " events (" << sent / send_seconds
+                  << " events/s)\n";
+        std::cout << "Server received " << received << " ("
+                  << received / send_seconds << " events/s), injected "
+                  << keyboard.events().size() + keyboard.overflowed()
+                  << " key events (joystick events are not injected)\n";
+        std::cout << "Dropped: " << sent - std::min<uint64_t>(sent, received)
+                  << " in the socket, " << dropped << " by validation\n";
+        print_latency("Server processing",
+                      Metrics::histogram("input.injection_latency_ns")
+                          .snapshot());
+        print_latency("Send to injection", end_to_end.snapshot());
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
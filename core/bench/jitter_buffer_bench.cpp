@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+#include "jitter_buffer.hpp"
+
+namespace {
+
+constexpr std::size_t DEFAULT_FRAMES = 6000;  // 100 s at 60 fps
+constexpr int FRAME_RATE = 60;
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / FRAME_RATE;
+constexpr uint16_t PACKETS_PER_FRAME = 3;
+constexpr std::size_t KEYFRAME_INTERVAL = 600;
+constexpr std::chrono::milliseconds BASE_DELAY{20};
+constexpr std::chrono::microseconds TICK{500};
+
+using Clock = JitterBuffer::Clock;
+
+struct Scenario {
+    const char* name;
+    double jitter_ms;  // Mean of the exponential extra delay
+    double loss;       // Probability a frame never completes
+};
+
+constexpr Scenario SCENARIOS[] = {
+    {"wired", 0.5, 0.0},
+    {"wifi", 4.0, 0.002},
+    {"congested", 12.0, 0.01},
+    {"bursty", 30.0, 0.02},
+};
+
+struct Arrival {
+    Clock::time_point arrival;
+    std::size_t index;
+    bool keyframe;
+
+    bool operator>(const Arrival& other) const {
+        return arrival > other.arrival;
+    }
+};
+
+double percentile(std::vector<double>& samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+ReceivedFrame make_frame(const Arrival& arrival) {
+    static const unsigned char payload[64] = {};
+    ReceivedFrame frame;
+    frame.data = payload;
+    frame.size = sizeof(payload);
+    frame.timestamp = static_cast<uint32_t>(arrival.index * FRAME_DURATION);
+    frame.first_sequence =
+        static_cast<uint16_t>(arrival.index * PACKETS_PER_FRAME);
+    frame.last_sequence =
+        static_cast<uint16_t>(frame.first_sequence + PACKETS_PER_FRAME - 1);
+    frame.picture_id =
+        static_cast<int>(arrival.index) & Vp8Payload::PICTURE_ID_MASK;
+    frame.keyframe = arrival.keyframe;
+    return frame;
+}
+
+}  // namespace
+
+/**
+ * Plays a simulated 60 fps stream through the jitter buffer in virtual
+ * time, over paths with a fixed delay, exponential jitter and whole-frame
+ * losses, from wired to bursty. The sender answers keyframe requests with
+ * the first frame it sends a path delay later. Reports the playout delay
+ * the buffer settled on, the delay it added to each frame, the end-to-end
+ * delay, and how many frames were late, dropped or concealed. --latency
+ * sets the cap in milliseconds.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        std::size_t frames = DEFAULT_FRAMES;
+        if (const auto it = options.find("frames"); it != options.end()) {
+            frames = std::stoul(it->second);
+        }
+        std::chrono::milliseconds max_latency = DEFAULT_MAX_LATENCY;
+        if (const auto it = options.find("latency"); it != options.end()) {
+            max_latency = std::chrono::milliseconds(std::stoi(it->second));
+        }
+        if (frames == 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        std::cout << "Latency cap " << max_latency.count() << " ms, "
+                  << frames << " frames, " << BASE_DELAY.count()
+                  << " ms path delay\n";
+        for (const Scenario& scenario : SCENARIOS) {
+            std::mt19937 random(42);
+            std::exponential_distribution<double> jitter(1.0 /
+                                                         scenario.jitter_ms);
+            std::bernoulli_distribution lost(scenario.loss);
+
+            const Clock::time_point start = Clock::now();
+            const auto sent_at = [start](const std::size_t index) {
+                return start +
+                       std::chrono::microseconds(1000000 * index / FRAME_RATE);
+            };
+            std::priority_queue<Arrival, std::vector<Arrival>,
+                                std::greater<Arrival>>
+                network;
+            std::vector<Clock::time_point> arrived(frames);
+            std::size_t sent = 0;
+            std::size_t keyframes = 0;
+            Clock::time_point keyframe_due = Clock::time_point::max();
+
+            JitterBuffer buffer(max_latency);
+            std::vector<double> added_ms;
+            std::vector<double> total_ms;
+            ReceivedFrame frame;
+            for (Clock::time_point now = start;
+                 sent < frames || !network.empty() || buffer.size() > 0;
+                 now += TICK) {
+                for (; sent < frames && sent_at(sent) <= now; ++sent) {
+                    const bool keyframe = sent % KEYFRAME_INTERVAL == 0 ||
+                                          sent_at(sent) >= keyframe_due;
+                    if (keyframe) {
+                        keyframe_due = Clock::time_point::max();
+                        ++keyframes;
+                    }
+                    const double extra_ms = jitter(random);
+                    if (lost(random)) continue;
+                    const Clock::time_point arrival =
+                        sent_at(sent) + BASE_DELAY +
+                        std::chrono::microseconds(
+                            static_cast<int64_t>(extra_ms * 1000));
+                    network.push({arrival, sent, keyframe});
+                    arrived[sent] = arrival;
+                }
+                while (!network.empty() && network.top().arrival <= now) {
+                    buffer.insert(make_frame(network.top()),
+                                  network.top().arrival);
+                    network.pop();
+                }
+                while (buffer.pop(now, frame)) {
+                    const std::size_t index = frame.timestamp / FRAME_DURATION;
+                    added_ms.push_back(
+                        std::chrono::duration<double, std::milli>(
+                            now - arrived[index])
+                            .count());
+                    total_ms.push_back(
+                        std::chrono::duration<double, std::milli>(
+                            now - sent_at(index))
+                            .count());
+                }
+                if (buffer.take_keyframe_request(now)) {
+                    keyframe_due = std::min(keyframe_due, now + BASE_DELAY);
+                }
+            }
+
+            std::cout << scenario.name << " (jitter " << scenario.jitter_ms
+                      << " ms, loss " << scenario.loss * 100 << "%): "
+                      << "playout delay "
+                      << buffer.target_delay().count() / 1000.0
+                      << " ms, added p50 " << percentile(added_ms, 0.5)
+                      << " p99 " << percentile(added_ms, 0.99)
+                      << " ms, end-to-end p50 " << percentile(total_ms, 0.5)
+                      << " p99 " << percentile(total_ms, 0.99) << " ms, "
+                      << buffer.delivered() << " played, " << buffer.late()
+                      << " late, " << buffer.dropped() << " dropped, "
+                      << buffer.concealed() << " concealed, " << keyframes
+                      << " keyframes\n";
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "common.hpp"
+#include "jitter_buffer.hpp"
+#include "nack_tracker.hpp"
+#include "packet_history.hpp"
+#include "rtcp_feedback.hpp"
+#include "vp8_depacketizer.hpp"
+#include "vp8_packetizer.hpp"
+
+namespace {
+
+constexpr std::size_t DEFAULT_FRAMES = 3600;  // 60 s at 60 fps
+constexpr int FRAME_RATE = 60;
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / FRAME_RATE;
+constexpr std::size_t DELTA_FRAME_SIZE = 5000;  // 2.5 Mbit/s at 60 fps
+constexpr std::size_t KEYFRAME_SIZE = 40000;
+constexpr std::size_t KEYFRAME_INTERVAL = 600;
+constexpr std::chrono::milliseconds ONE_WAY_DELAY{20};
+constexpr double JITTER_MS = 1.0;  // Mean of the exponential extra delay
+constexpr std::chrono::microseconds TICK{250};
+constexpr double LOSS_RATES[] = {0.001, 0.01, 0.03};
+
+using Clock = std::chrono::steady_clock;
+
+struct Datagram {
+    Clock::time_point arrival;
+    bool to_sender;
+    std::vector<unsigned char> data;
+
+    bool operator>(const Datagram& other) const {
+        return arrival > other.arrival;
+    }
+};
+
+struct Result {
+    std::size_t played = 0;
+    std::size_t dropped = 0;
+    std::size_t keyframes = 0;
+    uint64_t bytes = 0;
+    uint64_t requested = 0;
+    uint64_t retransmitted = 0;
+    uint64_t recovered = 0;
+    std::vector<double> delay_ms;
+};
+
+/**
+ * @brief A path with a fixed delay, exponential jitter and independent
+ * losses, in both directions
+ */
+class Network {
+   public:
+    Network(const double loss, const uint32_t seed)
+        : random_(seed), jitter_(1.0 / JITTER_MS), lost_(loss) {}
+
+    void send(const Clock::time_point now, const bool to_sender,
+              const unsigned char* data, const std::size_t size) {
+        if (lost_(random_)) return;
+        const auto extra = std::chrono::microseconds(
+            static_cast<int64_t>(jitter_(random_) * 1000));
+        in_flight_.push({now + ONE_WAY_DELAY + extra, to_sender,
+                         std::vector<unsigned char>(data, data + size)});
+    }
+
+    bool receive(const Clock::time_point now, Datagram& datagram) {
+        if (in_flight_.empty() || in_flight_.top().arrival > now) {
+            return false;
+        }
+        datagram = in_flight_.top();
+        in_flight_.pop();
+        return true;
+    }
+
+    bool empty() const { return in_flight_.empty(); }
+
+   private:
+    std::mt19937 random_;
+    std::exponential_distribution<double> jitter_;
+    std::bernoulli_distribution lost_;
+    std::priority_queue<Datagram, std::vector<Datagram>,
+                        std::greater<Datagram>>
+        in_flight_;
+};
+
+/**
+ * @brief Stream frames from a sender holding a packet history to a receiver
+ * with a jitter buffer, in virtual time. The receiver asks for keyframes
+ * with PLI, and for lost packets with NACK if nack is set.
+ */
+Result run(const std::size_t frames, const double loss, const bool nack,
+           const std::chrono::milliseconds max_latency) {
+    Result result;
+    Network network(loss, 7);
+    const std::vector<unsigned char> delta(DELTA_FRAME_SIZE, 0x01);
+    const std::vector<unsigned char> keyframe(KEYFRAME_SIZE, 0x00);
+    const std::chrono::microseconds rtt = 2 * ONE_WAY_DELAY;
+
+    Vp8Packetizer packetizer(1);
+    PacketHistory history;
+    bool keyframe_requested = false;
+
+    Vp8Depacketizer depacketizer;
+    JitterBuffer buffer(max_latency);
+    NackTracker tracker;
+    if (nack) buffer.set_loss_wait(rtt + DEFAULT_REORDER_GRACE);
+    uint16_t nack_sequences[RtcpFeedback::MAX_NACK_ITEMS];
+    uint16_t received_sequences[RtcpFeedback::MAX_NACK_ITEMS *
+                                RtcpFeedback::NACK_ITEM_SPAN];
+    unsigned char feedback[RtcpFeedback::MAX_NACK_SIZE];
+
+    const Clock::time_point start = Clock::now();
+    const auto sent_at = [start](const std::size_t index) {
+        return start + std::chrono::microseconds(1000000 * index / FRAME_RATE);
+    };
+    std::size_t sent = 0;
+    Datagram datagram;
+    ReceivedFrame frame;
+    for (Clock::time_point now = start;
+         sent < frames || !network.empty() || buffer.size() > 0;
+         now += TICK) {
+        // Sender
+        for (; sent < frames && sent_at(sent) <= now; ++sent) {
+            const bool key =
+                sent % KEYFRAME_INTERVAL == 0 || keyframe_requested;
+            keyframe_requested = false;
+            result.keyframes += key ? 1 : 0;
+            const std::vector<unsigned char>& data = key ? keyframe : delta;
+            Vp8FrameInfo info;
+            info.timestamp = static_cast<uint32_t>(sent * FRAME_DURATION);
+            for (const GatherDatagram& packet :
+                 packetizer.packetize(data.data(), data.size(), info)) {
+                history.store(packet);
+                std::vector<unsigned char> bytes(packet.size());
+                std::memcpy(bytes.data(), packet.header.data(),
+                            packet.header.size());
+                std::memcpy(bytes.data() + packet.header.size(),
+                            packet.payload.data(), packet.payload.size());
+                network.send(now, false, bytes.data(), bytes.size());
+                result.bytes += bytes.size();
+            }
+        }
+
+        while (network.receive(now, datagram)) {
+            const unsigned char* data = datagram.data.data();
+            const std::size_t size = datagram.data.size();
+            uint32_t ssrc = 0;
+            std::size_t count = 0;
+            if (datagram.to_sender) {
+                if (RtcpFeedback::read_pli(data, size, ssrc)) {
+                    keyframe_requested = true;
+                } else if (RtcpFeedback::read_nack(
+                               data, size, ssrc, received_sequences,
+                               std::size(received_sequences), count)) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        boost::asio::const_buffer packet;
+                        if (!history.resend(received_sequences[i], now,
+                                            packet)) {
+                            continue;
+                        }
+                        network.send(
+                            now, false,
+                            static_cast<const unsigned char*>(packet.data()),
+                            packet.size());
+                        result.bytes += packet.size();
+                    }
+                }
+                continue;
+            }
+
+            Rtp::Header header;
+            std::size_t payload_offset = 0;
+            std::size_t payload_size = 0;
+            const bool retransmitted =
+                Rtp::read_header(data, size, header, payload_offset,
+                                 payload_size) &&
+                tracker.on_packet(header, now);
+            if (depacketizer.push(data, size, frame)) {
+                buffer.insert(frame, now, retransmitted);
+            }
+        }
+
+        // Receiver
+        while (buffer.pop(now, frame)) {
+            result.delay_ms.push_back(
+                std::chrono::duration<double, std::milli>(
+                    now - sent_at(frame.timestamp / FRAME_DURATION))
+                    .count());
+        }
+        if (buffer.take_keyframe_request(now)) {
+            network.send(now, true, feedback,
+                         RtcpFeedback::write_pli(2, 1, feedback));
+        }
+        if (nack) {
+            const std::size_t count =
+                tracker.poll(now, rtt, buffer, nack_sequences,
+                             std::size(nack_sequences));
+            std::size_t written = 0;
+            if (count > 0) {
+                network.send(now, true, feedback,
+                             RtcpFeedback::write_nack(2, 1, nack_sequences,
+                                                      count, feedback,
+                                                      written));
+            }
+        }
+    }
+
+    result.played = buffer.delivered();
+    result.dropped = buffer.dropped();
+    result.requested = tracker.requested();
+    result.retransmitted = history.resent();
+    result.recovered = tracker.recovered();
+    return result;
+}
+
+double percentile(std::vector<double>& samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+}  // namespace
+
+/**
+ * Streams 60 fps video over a simulated path with a 40 ms round trip,
+ * 1 ms of mean jitter and random losses both ways, in virtual time, and
+ * compares recovering from losses with keyframes only (PLI) against
+ * retransmitting lost packets first (NACK). Reports frames played and
+ * dropped, keyframes sent, bytes sent, packets requested, retransmitted
+ * and recovered, and the end-to-end delay of played frames. --latency sets
+ * the jitter buffer's cap in milliseconds.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        std::size_t frames = DEFAULT_FRAMES;
+        if (const auto it = options.find("frames"); it != options.end()) {
+            frames = std::stoul(it->second);
+        }
+        std::chrono::milliseconds max_latency{100};
+        if (const auto it = options.find("latency"); it != options.end()) {
+            max_latency = std::chrono::milliseconds(std::stoi(it->second));
+        }
+        if (frames == 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        std::cout << frames << " frames, latency cap " << max_latency.count()
+                  << " ms, round trip " << 2 * ONE_WAY_DELAY.count()
+                  << " ms\n";
+        for (const double loss : LOSS_RATES) {
+            for (const bool nack : {false, true}) {
+                Result result = run(frames, loss, nack, max_latency);
+                std::cout << "loss " << loss * 100 << "% "
+                          << (nack ? "NACK" : "PLI ") << ": "
+                          << result.played << " played, " << result.dropped
+                          << " dropped, " << result.keyframes
+                          << " keyframes, " << result.bytes / 1000
+                          << " kB sent, " << result.requested
+                          << " requested, " << result.retransmitted
+                          << " retransmitted, " << result.recovered
+                          << " recovered, delay p50 "
+                          << percentile(result.delay_ms, 0.5) << " p99 "
+                          << percentile(result.delay_ms, 0.99) << " ms\n";
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
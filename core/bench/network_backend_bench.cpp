@@ -0,0 +1,109 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "common.hpp"
+#include "network_backend.hpp"
+
+namespace {
+
+constexpr std::size_t PACKETS = 1000000;
+constexpr std::size_t PACKET_SIZE = 64;  // Input-sized datagrams
+constexpr std::size_t BATCH = 32;
+
+const char* backend_name(const BackendType type) {
+    return type == BackendType::IO_URING ? "io_uring" : "asio";
+}
+
+double cpu_seconds() {
+#ifdef __linux__
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#else
+    return 0.0;
+#endif
+}
+
+void run(const BackendType type) {
+    const udp::endpoint loopback(boost::asio::ip::address_v4::loopback(), 0);
+
+    boost::asio::io_context receiver_context;
+    auto receiver = NetworkBackend::create(type, receiver_context, loopback);
+    boost::asio::io_context sender_context;
+    auto sender = NetworkBackend::create(type, sender_context, loopback);
+
+    std::atomic<std::size_t> packets_recvd = 0;
+    receiver->start_receive([&packets_recvd](const unsigned char*,
+                                             const std::size_t,
+                                             const udp::endpoint&) {
+        packets_recvd.fetch_add(1, std::memory_order_relaxed);
+    });
+    std::thread receiver_thread([&receiver]() { receiver->run(); });
+
+    const std::array<unsigned char, PACKET_SIZE> packet = {};
+    const udp::endpoint destination = receiver->local_endpoint();
+    const double cpu_start = cpu_seconds();
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < PACKETS; ++i) {
+        sender->send_to(boost::asio::buffer(packet), destination);
+        if (i % BATCH == BATCH - 1) sender->flush();
+    }
+    sender->flush();
+
+    // Let the receiver drain what the socket buffer still holds
+    std::size_t last = 0;
+    do {
+        last = packets_recvd;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    } while (packets_recvd != last);
+
+    const auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+    const double cpu = cpu_seconds() - cpu_start;
+    receiver->stop();
+    receiver_thread.join();
+
+    std::cout << backend_name(receiver->type()) << ": received "
+              << packets_recvd << "/" << PACKETS << " packets, "
+              << packets_recvd / elapsed.count() << " packets/s, "
+              << cpu * 1e9 / std::max<std::size_t>(packets_recvd, 1)
+              << " CPU ns/packet" << std::endl;
+}
+
+}  // namespace
+
+/**
+ * Sends a million input-sized datagrams over loopback from one backend to
+ * another of the same type and reports throughput and CPU time per packet.
+ * Runs both backends unless --backend <asio|io_uring> picks one.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        const auto it = options.find("backend");
+        if (it == options.end()) {
+            run(BackendType::ASIO);
+            run(BackendType::IO_URING);
+        } else if (it->second == "asio") {
+            run(BackendType::ASIO);
+        } else if (it->second == "io_uring") {
+            run(BackendType::IO_URING);
+        } else {
+            throw std::invalid_argument(
+                "Invalid --backend, expected asio or io_uring");
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+#include "common.hpp"
+#include "impairment_model.hpp"
+#include "pacer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t PACKET_SIZE = 1200;
+constexpr std::size_t CONTROL_SIZE = 20;
+constexpr int DEFAULT_ITERATIONS = 1000000;
+
+// Streaming: 60 fps at the target with a keyframe a second, and a ping
+// every 10 ms, through a bottleneck twice the target
+constexpr int64_t TARGET_BITRATE = 2500000;  // bits/s
+constexpr uint64_t CAPACITY = 5000000;       // bits/s
+constexpr int FRAME_RATE = 60;
+constexpr std::size_t KEYFRAME_SIZE = 40000;
+constexpr std::size_t KEYFRAME_INTERVAL = 60;
+constexpr std::chrono::milliseconds CONTROL_INTERVAL{10};
+constexpr std::chrono::milliseconds ONE_WAY_DELAY{20};
+constexpr std::chrono::seconds DEFAULT_DURATION{60};
+constexpr std::chrono::microseconds TICK{250};
+constexpr double PACING_FACTORS[] = {0, 1.5, 2.5};  // 0 for unpaced
+
+struct Arrival {
+    Clock::time_point time;
+    uint64_t order;
+    Clock::time_point sent;  // Handed to the sender
+    bool control;
+    std::size_t frame;
+
+    bool operator>(const Arrival& other) const {
+        return time > other.time ||
+               (time == other.time && order > other.order);
+    }
+};
+
+struct Result {
+    std::vector<double> control_ms;   // Queueing delay, sender and path
+    std::vector<double> keyframe_ms;  // First packet handed over to last in
+    uint64_t lost = 0;
+};
+
+double percentile(std::vector<double> samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+double milliseconds(const Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+ * @brief Time queueing and popping a mix of classes through the pacer,
+ * with the budget never in the way
+ */
+void measure_throughput(const int iterations) {
+    Pacer pacer(TARGET_BITRATE, DEFAULT_PACING_FACTOR);
+    const std::vector<unsigned char> data(PACKET_SIZE, 0x01);
+    const boost::asio::const_buffer header(data.data(), 12);
+    const boost::asio::const_buffer payload(data.data() + 12,
+                                            data.size() - 12);
+    Clock::time_point now = Clock::now();
+    TrafficClass traffic_class = TrafficClass::VIDEO;
+    PacketRef packet;
+    std::size_t popped = 0;
+
+    const auto start = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        pacer.enqueue(
+            i % 8 == 0 ? TrafficClass::CONTROL : TrafficClass::VIDEO, header,
+            payload);
+        now += std::chrono::seconds(1);
+        while (pacer.pop(now, traffic_class, packet)) ++popped;
+    }
+    const auto elapsed = Clock::now() - start;
+    std::cout << "Queue and pop: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     iterations
+              << " ns per " << PACKET_SIZE << " byte datagram (" << popped
+              << " popped)\n";
+}
+
+/**
+ * @brief Send video and pings through the bottleneck for a while in
+ * virtual time, straight to the link or through a pacer
+ */
+Result run(const double pacing_factor, const std::chrono::seconds duration) {
+    ImpairmentConfig config;
+    config.delay = ONE_WAY_DELAY;
+    config.rate_bps = CAPACITY;
+    ImpairmentModel link(config);
+    const bool paced = pacing_factor > 0;
+    Pacer pacer(TARGET_BITRATE, paced ? pacing_factor : 1);
+
+    Result result;
+    std::priority_queue<Arrival, std::vector<Arrival>, std::greater<Arrival>>
+        in_flight;
+    uint64_t order = 0;
+    const auto frame_count =
+        static_cast<std::size_t>(duration.count() * FRAME_RATE);
+    std::vector<Clock::time_point> frame_sent(frame_count);
+    std::vector<Clock::time_point> frame_done(frame_count);  // Last packet in
+    const auto send = [&](const Clock::time_point now, const std::size_t size,
+                          const Clock::time_point sent, const bool control,
+                          const std::size_t frame) {
+        const ImpairmentModel::Verdict verdict = link.process(size, now);
+        if (verdict.copies == 0) ++result.lost;
+        for (std::size_t i = 0; i < verdict.copies; ++i) {
+            in_flight.push({verdict.departures[i], order++, sent, control,
+                            frame});
+        }
+    };
+
+    // The pacer does not carry send times, so they travel in the payload
+    const auto encode = [](unsigned char* out, const Clock::time_point sent,
+                           const std::size_t frame) {
+        const auto ticks = sent.time_since_epoch().count();
+        std::memcpy(out, &ticks, sizeof(ticks));
+        std::memcpy(out + sizeof(ticks), &frame, sizeof(frame));
+    };
+    std::vector<unsigned char> packet_data(PACKET_SIZE, 0x01);
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + duration;
+    std::size_t frames = 0;
+    Clock::time_point next_control = start;
+    Clock::time_point wakeup = start;
+    bool queued = false;
+    TrafficClass traffic_class = TrafficClass::VIDEO;
+    PacketRef packet;
+    for (Clock::time_point now = start; now < end || !in_flight.empty();
+         now += TICK) {
+        for (; now < end &&
+               start + std::chrono::microseconds(1000000 * frames /
+                                                 FRAME_RATE) <=
+                   now;
+             ++frames) {
+            const std::size_t size =
+                frames % KEYFRAME_INTERVAL == 0
+                    ? KEYFRAME_SIZE
+                    : static_cast<std::size_t>(TARGET_BITRATE / 8 /
+                                               FRAME_RATE);
+            frame_sent[frames] = now;
+            for (std::size_t offset = 0; offset < size;
+                 offset += PACKET_SIZE) {
+                const std::size_t packet_size =
+                    std::min(PACKET_SIZE, size - offset);
+                if (!paced) {
+                    send(now, packet_size, now, false, frames);
+                    continue;
+                }
+                encode(packet_data.data(), now, frames);
+                queued = pacer.enqueue(TrafficClass::VIDEO,
+                                       boost::asio::buffer(packet_data.data(),
+                                                           packet_size),
+                                       boost::asio::const_buffer());
+            }
+        }
+        for (; now < end && next_control <= now;
+             next_control += CONTROL_INTERVAL) {
+            if (!paced) {
+                send(now, CONTROL_SIZE, now, true, 0);
+                continue;
+            }
+            encode(packet_data.data(), now, 0);
+            queued = pacer.enqueue(
+                TrafficClass::CONTROL,
+                boost::asio::buffer(packet_data.data(), CONTROL_SIZE),
+                boost::asio::const_buffer());
+        }
+
+        // As UDPServer: on queueing, and on a timer no more often than
+        // PACER_INTERVAL
+        if (paced && (queued || wakeup <= now)) {
+            queued = false;
+            while (pacer.pop(now, traffic_class, packet)) {
+                Clock::rep ticks = 0;
+                std::size_t frame = 0;
+                std::memcpy(&ticks, packet->data(), sizeof(ticks));
+                std::memcpy(&frame, packet->data() + sizeof(ticks),
+                            sizeof(frame));
+                send(now, packet->size(),
+                     Clock::time_point(Clock::duration(ticks)),
+                     traffic_class == TrafficClass::CONTROL, frame);
+            }
+            Clock::time_point due = Clock::time_point::max();
+            if (pacer.next_send(due)) due = std::max(due, now + PACER_INTERVAL);
+            wakeup = due;
+        }
+
+        while (!in_flight.empty() && in_flight.top().time <= now) {
+            const Arrival& arrival = in_flight.top();
+            if (arrival.control) {
+                result.control_ms.push_back(milliseconds(
+                    arrival.time - arrival.sent - ONE_WAY_DELAY));
+            } else {
+                frame_done[arrival.frame] =
+                    std::max(frame_done[arrival.frame], arrival.time);
+            }
+            in_flight.pop();
+        }
+    }
+
+    for (std::size_t i = 0; i < frames; i += KEYFRAME_INTERVAL) {
+        result.keyframe_ms.push_back(
+            milliseconds(frame_done[i] - frame_sent[i]));
+    }
+    return result;
+}
+
+}  // namespace
+
+/**
+ * Measures queueing and popping datagrams through the pacer, then sends
+ * 60 fps video at 2.5 Mbit/s with a 40 kB keyframe every second and a
+ * 20 byte ping every 10 ms through a 5 Mbit/s bottleneck, in virtual time
+ * with the netem proxy's impairment model. Compares sending each frame at
+ * once with pacing it at 1.5 and 2.5 times the target, and reports how
+ * long pings queue and how long keyframes take to arrive.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        int iterations = DEFAULT_ITERATIONS;
+        if (const auto it = options.find("iterations"); it != options.end()) {
+            iterations = std::stoi(it->second);
+        }
+        std::chrono::seconds duration = DEFAULT_DURATION;
+        if (const auto it = options.find("duration"); it != options.end()) {
+            duration = std::chrono::seconds(std::stoi(it->second));
+        }
+        if (iterations <= 0 || duration.count() <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        measure_throughput(iterations);
+        std::cout << duration.count() << " s at " << TARGET_BITRATE / 1000
+                  << " kbit/s through " << CAPACITY / 1000
+                  << " kbit/s, keyframes of " << KEYFRAME_SIZE
+                  << " bytes every " << KEYFRAME_INTERVAL << " frames\n";
+        for (const double pacing_factor : PACING_FACTORS) {
+            const Result result = run(pacing_factor, duration);
+            if (pacing_factor > 0) {
+                std::cout << "paced x" << pacing_factor << ": ";
+            } else {
+                std::cout << "unpaced  : ";
+            }
+            std::cout << "ping queueing p50 "
+                      << percentile(result.control_ms, 0.5) << " p99 "
+                      << percentile(result.control_ms, 0.99) << " max "
+                      << percentile(result.control_ms, 1)
+                      << " ms, keyframe delivery p50 "
+                      << percentile(result.keyframe_ms, 0.5) << " max "
+                      << percentile(result.keyframe_ms, 1) << " ms, "
+                      << result.lost << " lost\n";
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
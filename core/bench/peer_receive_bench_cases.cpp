@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <iostream>
+
+#include "stream_messages.hpp"
+#include "udp_connection.hpp"
+
+namespace {
+
+constexpr unsigned short REMOTE_PORT = 47130;
+constexpr unsigned short PEER_PORT = 47131;
+
+/**
+ * Receive a ping, validate it and answer with a pong, once per iteration.
+ * The remote peer is a plain loopback socket and the peer's io_context is
+ * driven inline until the pong is back.
+ */
+void BM_PeerReceivePing(benchmark::State& state) {
+    // UdpPeer reads signals from stdin on a thread it joins on destruction
+    std::cin.setstate(std::ios::eofbit);
+
+    const int message = StreamMessages::PING;
+    int response = 0;
+
+    boost::asio::io_context io_context;
+    udp::socket remote(io_context, udp::endpoint(udp::v4(), REMOTE_PORT));
+    UdpPeer peer(io_context, PEER_PORT, "127.0.0.1",
+                 std::to_string(REMOTE_PORT));
+    remote.receive(boost::asio::buffer(&response, sizeof(response)));
+
+    const udp::endpoint peer_endpoint(boost::asio::ip::address_v4::loopback(),
+                                      PEER_PORT);
+
+    for (auto _ : state) {
+        remote.send_to(boost::asio::buffer(&message, sizeof(message)),
+                       peer_endpoint);
+        while (remote.available() == 0) io_context.run_one();
+        remote.receive(boost::asio::buffer(&response, sizeof(response)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PeerReceivePing);
+
+}  // namespace
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.hpp"
+#include "common.hpp"
+#include "frame_clock.hpp"
+#include "frame_pool.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t DEFAULT_ITERATIONS = 1000000;
+constexpr std::size_t HANDOFF_POOL_SIZE = 8;  // frames
+constexpr std::size_t QUEUE_SIZE = 2;         // frames, as MediaPipeline
+constexpr int FRAME_RATE = 60;
+constexpr std::chrono::milliseconds ENCODE_TIME{20};  // Over the interval
+constexpr std::chrono::seconds DEFAULT_DURATION{5};
+constexpr std::chrono::microseconds POLL_INTERVAL{100};
+
+enum class Policy { UNBOUNDED, DROP_NEWEST, DROP_OLDEST };
+
+struct Result {
+    std::vector<double> latency_ms;  // Capture to encoded
+    std::size_t captured = 0;
+    std::size_t dropped = 0;
+    std::size_t left = 0;  // Still queued when capture stopped
+};
+
+double percentile(std::vector<double> samples, const double p) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<std::size_t>(p * (samples.size() - 1))];
+}
+
+/**
+ * @brief Time handing pooled frames from one thread to another through a
+ * queue the size of a pipeline stage's
+ */
+void measure_handoff(const std::size_t iterations) {
+    FramePool pool(FrameLayout::aligned(PixelFormat::I420, 64, 64),
+                   HANDOFF_POOL_SIZE);
+    BoundedQueue<FrameRef> queue(QUEUE_SIZE);
+    std::atomic<bool> done{false};
+    std::size_t received = 0;
+
+    const auto start = Clock::now();
+    std::thread consumer([&]() {
+        FrameRef frame;
+        while (true) {
+            if (queue.pop(frame)) {
+                ++received;
+                frame = FrameRef();
+            } else if (done.load(std::memory_order_acquire)) {
+                if (queue.empty()) break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (std::size_t i = 0; i < iterations; ++i) {
+        FrameRef frame;
+        while (!(frame = pool.acquire())) {
+            std::this_thread::yield();
+        }
+        frame->set_capture(Clock::now(), i);
+        while (!queue.push(std::move(frame))) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    const auto elapsed = Clock::now() - start;
+
+    std::cout << "Frame handoff: "
+              << std::chrono::duration<double, std::nano>(elapsed).count() /
+                     static_cast<double>(iterations)
+              << " ns per frame between threads (" << received
+              << " received)\n";
+}
+
+/**
+ * @brief Capture at FRAME_RATE and encode on another thread that takes
+ * ENCODE_TIME per frame, with frames queued under the given policy
+ */
+Result run(const Policy policy, const std::chrono::seconds duration) {
+    Result result;
+    std::mutex mutex;  // Guards the unbounded queue only
+    std::deque<Clock::time_point> unbounded;
+    BoundedQueue<Clock::time_point> bounded(QUEUE_SIZE);
+    std::atomic<bool> done{false};
+
+    std::thread encoder([&]() {
+        while (true) {
+            Clock::time_point captured;
+            bool taken = false;
+            if (policy == Policy::UNBOUNDED) {
+                const std::lock_guard<std::mutex> lock(mutex);
+                if (!unbounded.empty()) {
+                    captured = unbounded.front();
+                    unbounded.pop_front();
+                    taken = true;
+                }
+            } else {
+                taken = bounded.pop(captured);
+            }
+            if (!taken) {
+                if (done.load(std::memory_order_acquire)) break;
+                std::this_thread::sleep_for(POLL_INTERVAL);
+                continue;
+            }
+            std::this_thread::sleep_for(ENCODE_TIME);
+            result.latency_ms.push_back(
+                std::chrono::duration<double, std::milli>(Clock::now() -
+                                                          captured)
+                    .count());
+        }
+    });
+
+    FrameClock clock(FRAME_RATE);
+    const Clock::time_point end = Clock::now() + duration;
+    while (Clock::now() < end) {
+        Clock::time_point captured = clock.wait();
+        ++result.captured;
+        if (policy == Policy::UNBOUNDED) {
+            const std::lock_guard<std::mutex> lock(mutex);
+            unbounded.push_back(captured);
+        } else if (policy == Policy::DROP_NEWEST) {
+            if (!bounded.push(std::move(captured))) ++result.dropped;
+        } else {
+            Clock::time_point dropped;
+            if (bounded.push_dropping_oldest(std::move(captured), dropped)) {
+                ++result.dropped;
+            }
+        }
+    }
+
+    // Frames still queued when capture stops are not waited for
+    if (policy == Policy::UNBOUNDED) {
+        const std::lock_guard<std::mutex> lock(mutex);
+        result.left = unbounded.size();
+        unbounded.clear();
+    } else {
+        Clock::time_point captured;
+        while (bounded.pop(captured)) ++result.left;
+    }
+    done.store(true, std::memory_order_release);
+    encoder.join();
+    return result;
+}
+
+}  // namespace
+
+/**
+ * Measures handing pooled frames between two threads through a bounded
+ * queue, then captures at 60 fps into an encoder stage that needs 20 ms a
+ * frame, and compares an unbounded queue with a bounded one that drops
+ * the newest frame and one that drops the oldest, as MediaPipeline does.
+ * Reports how old frames are when encoded, and how many were dropped.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        std::size_t iterations = DEFAULT_ITERATIONS;
+        if (const auto it = options.find("iterations"); it != options.end()) {
+            iterations = std::stoul(it->second);
+        }
+        std::chrono::seconds duration = DEFAULT_DURATION;
+        if (const auto it = options.find("duration"); it != options.end()) {
+            duration = std::chrono::seconds(std::stoi(it->second));
+        }
+        if (iterations == 0 || duration.count() <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        measure_handoff(iterations);
+        std::cout << duration.count() << " s at " << FRAME_RATE
+                  << " fps into an encoder taking " << ENCODE_TIME.count()
+                  << " ms a frame, queue of " << QUEUE_SIZE << "\n";
+        const std::pair<Policy, const char*> policies[] = {
+            {Policy::UNBOUNDED, "unbounded  "},
+            {Policy::DROP_NEWEST, "drop newest"},
+            {Policy::DROP_OLDEST, "drop oldest"}};
+        for (const auto& [policy, name] : policies) {
+            const Result result = run(policy, duration);
+            std::cout << name << ": frame age at encode p50 "
+                      << percentile(result.latency_ms, 0.5) << " p99 "
+                      << percentile(result.latency_ms, 0.99) << " max "
+                      << percentile(result.latency_ms, 1) << " ms, "
+                      << result.latency_ms.size() << " of "
+                      << result.captured << " encoded, " << result.dropped
+                      << " dropped, " << result.left << " left queued\n";
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "relay_protocol.hpp"
+#include "relay_server.hpp"
+#include "udp_segmentation.hpp"
+
+namespace {
+
+constexpr unsigned short CONTROL_PORT = 47200;
+constexpr uint16_t RELAY_PORT_MIN = 47210;
+constexpr std::size_t DEFAULT_SESSIONS = 16;
+constexpr std::size_t DEFAULT_SENDERS = 1;
+constexpr std::size_t DEFAULT_PAYLOAD = 256;  // bytes
+constexpr double DEFAULT_DURATION = 5.0;      // seconds
+constexpr std::chrono::milliseconds HANDSHAKE_TIMEOUT{1000};
+
+struct Config {
+    std::size_t threads = 0;
+    std::size_t sessions = DEFAULT_SESSIONS;
+    std::size_t senders = DEFAULT_SENDERS;
+    std::size_t payload = DEFAULT_PAYLOAD;
+    double duration = DEFAULT_DURATION;
+};
+
+struct Session {
+    udp::socket side_a;
+    udp::socket side_b;
+    udp::endpoint relay_endpoint;
+};
+
+Config parse_config(const int argc, char* argv[]) {
+    const auto options = Common::parse_options(argc, argv, 1);
+    Config config;
+    if (const auto it = options.find("threads"); it != options.end()) {
+        config.threads = std::stoul(it->second);
+    }
+    if (const auto it = options.find("sessions"); it != options.end()) {
+        config.sessions = std::stoul(it->second);
+    }
+    if (const auto it = options.find("senders"); it != options.end()) {
+        config.senders = std::stoul(it->second);
+    }
+    if (const auto it = options.find("payload"); it != options.end()) {
+        config.payload = std::stoul(it->second);
+    }
+    if (const auto it = options.find("duration"); it != options.end()) {
+        config.duration = std::stod(it->second);
+    }
+    if (config.sessions == 0 || config.senders == 0 || config.duration <= 0 ||
+        config.payload == 0 || config.payload > PacketBuffer::CAPACITY) {
+        throw std::invalid_argument("Invalid benchmark options");
+    }
+    return config;
+}
+
+double process_cpu_seconds() {
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+double thread_cpu_seconds() {
+    timespec time = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+using Reply = std::array<unsigned char, RelayProtocol::MAX_MESSAGE_SIZE>;
+
+/**
+ * @brief Send a relay request and wait for the reply of the given type
+ */
+bool request(udp::socket& socket, const unsigned char* message,
+             const std::size_t size, const udp::endpoint& destination,
+             const RelayProtocol::MessageType expected, Reply& reply) {
+    socket.send_to(boost::asio::buffer(message, size), destination);
+
+    const auto deadline = std::chrono::steady_clock::now() + HANDSHAKE_TIMEOUT;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (socket.available() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        udp::endpoint sender;
+        const std::size_t received =
+            socket.receive_from(boost::asio::buffer(reply), sender);
+        return RelayProtocol::is_message(reply.data(), received, expected);
+    }
+    return false;
+}
+
+/**
+ * @brief Allocate a session and bind both sides to it
+ */
+void open_session(Session& session, const RelayToken& token) {
+    using namespace RelayProtocol;
+
+    const auto loopback = boost::asio::ip::address_v4::loopback();
+    std::array<unsigned char, REQUEST_SIZE> message;
+    Reply reply;
+
+    build_request(ALLOCATE_REQUEST, token, message.data());
+    if (!request(session.side_a, message.data(), message.size(),
+                 udp::endpoint(loopback, CONTROL_PORT), ALLOCATE_RESPONSE,
+                 reply)) {
+        throw std::runtime_error("Relay allocation failed");
+    }
+    session.relay_endpoint =
+        udp::endpoint(loopback, allocated_port(reply.data()));
+
+    build_request(BIND_REQUEST, token, message.data());
+    for (udp::socket* side : {&session.side_a, &session.side_b}) {
+        if (!request(*side, message.data(), message.size(),
+                     session.relay_endpoint, BIND_RESPONSE, reply)) {
+            throw std::runtime_error("Relay bind failed");
+        }
+    }
+}
+
+}  // namespace
+
+/**
+ * Runs RelayServer in process on loopback and floods its sessions from one
+ * side with sendmmsg batches, to size relay hosts. The relay's own CPU time
+ * is the process CPU time minus that of the sender threads, so the
+ * per-core rate holds even when senders and workers share cores.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const Config config = parse_config(argc, argv);
+        Logger::set_level(Logger::LEVEL_WARNING);
+
+        RelayConfig relay_config;
+        relay_config.control_port = CONTROL_PORT;
+        relay_config.port_min = RELAY_PORT_MIN;
+        relay_config.port_max =
+            static_cast<uint16_t>(RELAY_PORT_MIN + config.sessions - 1);
+        relay_config.threads = config.threads;
+        relay_config.secret = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                               15, 16};
+
+        RelayServer relay(relay_config);
+        std::thread relay_thread([&relay]() { relay.run(); });
+
+        boost::asio::io_context io_context;
+        const udp::endpoint loopback(boost::asio::ip::address_v4::loopback(),
+                                     0);
+        const uint32_t expiry =
+            static_cast<uint32_t>(std::time(nullptr)) + 3600;
+        std::vector<Session> sessions;
+        sessions.reserve(config.sessions);
+        for (std::size_t i = 0; i < config.sessions; ++i) {
+            sessions.push_back({udp::socket(io_context, loopback),
+                                udp::socket(io_context, loopback), {}});
+            open_session(sessions.back(),
+                         RelayToken::issue(relay_config.secret, i + 1, expiry));
+        }
+
+        const std::vector<unsigned char> payload(config.payload, 0x5A);
+        const std::vector<boost::asio::const_buffer> batch(
+            UdpSegmentation::MAX_SEGMENTS,
+            boost::asio::buffer(payload.data(), payload.size()));
+
+        Metrics::Counter& forwarded =
+            Metrics::counter("relay.packets_forwarded");
+        const uint64_t forwarded_start = forwarded.value();
+        const double cpu_start = process_cpu_seconds();
+        const auto start = std::chrono::steady_clock::now();
+        const auto end =
+            start + std::chrono::duration_cast<
+                        std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(config.duration));
+
+        std::atomic<uint64_t> sent = 0;
+        std::atomic<double> sender_cpu = 0.0;
+        std::vector<std::thread> senders;
+        for (std::size_t s = 0; s < config.senders; ++s) {
+            senders.emplace_back([&, s]() {
+                const double thread_start = thread_cpu_seconds();
+                std::vector<UdpSegmentSender> batch_senders;
+                for (std::size_t i = s; i < sessions.size();
+                     i += config.senders) {
+                    batch_senders.emplace_back(sessions[i].side_a, false);
+                }
+
+                uint64_t count = 0;
+                while (std::chrono::steady_clock::now() < end) {
+                    std::size_t index = s;
+                    for (auto& batch_sender : batch_senders) {
+                        count += batch_sender.send_batch(
+                            batch, sessions[index].relay_endpoint);
+                        index += config.senders;
+                    }
+                }
+                sent += count;
+
+                const double used = thread_cpu_seconds() - thread_start;
+                double total = sender_cpu.load();
+                while (!sender_cpu.compare_exchange_weak(total, total + used)) {
+                }
+            });
+        }
+        for (auto& sender : senders) sender.join();
+
+        // Let the workers drain what is still queued
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        const double seconds = std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count();
+        const double relay_cpu =
+            process_cpu_seconds() - cpu_start - sender_cpu.load();
+        const uint64_t relayed = forwarded.value() - forwarded_start;
+
+        relay.stop();
+        relay_thread.join();
+
+        std::cout << relay.threads() << " relay threads, " << config.sessions
+                  << " sessions, " << config.senders << " senders, "
+                  << config.payload << " byte payloads\n";
+        std::cout << "Sent " << sent.load() << " packets ("
+                  << sent.load() / seconds << " pps)\n";
+        std::cout << "Forwarded " << relayed << " packets ("
+                  << relayed / seconds << " pps, "
+                  << relayed / seconds / relay.threads()
+                  << " pps per thread)\n";
+        std::cout << "Relay CPU " << relay_cpu << " s: "
+                  << (relay_cpu > 0 ? relayed / relay_cpu : 0.0)
+                  << " packets per core-second\n";
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "common.hpp"
+#include "vp8_depacketizer.hpp"
+#include "vp8_packetizer.hpp"
+
+namespace {
+
+constexpr int DEFAULT_ITERATIONS = 2000;
+constexpr std::size_t STREAM_FRAMES = 64;
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / 60;
+
+// Typical delta frame at 2.5 Mbit/s and 60 fps, and a keyframe
+constexpr std::size_t FRAME_SIZES[] = {5000, 60000};
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Fill a frame with the same pseudo-random bytes on every run
+ */
+std::vector<unsigned char> make_frame(const std::size_t size, uint32_t seed) {
+    std::vector<unsigned char> frame(size);
+    for (unsigned char& byte : frame) {
+        seed = seed * 1664525 + 1013904223;
+        byte = static_cast<unsigned char>(seed >> 24);
+    }
+    return frame;
+}
+
+/**
+ * @brief Packetize a stream of frames into contiguous datagrams, as the
+ * receiver sees them
+ */
+std::vector<std::vector<unsigned char>> make_stream(
+    const std::vector<std::vector<unsigned char>>& frames,
+    const std::size_t max_packet_size) {
+    Vp8Packetizer packetizer(1, max_packet_size);
+    std::vector<std::vector<unsigned char>> datagrams;
+    Vp8FrameInfo info;
+    for (const std::vector<unsigned char>& frame : frames) {
+        for (const GatherDatagram& packet :
+             packetizer.packetize(frame.data(), frame.size(), info)) {
+            std::vector<unsigned char> datagram(packet.size());
+            std::memcpy(datagram.data(), packet.header.data(),
+                        packet.header.size());
+            std::memcpy(datagram.data() + packet.header.size(),
+                        packet.payload.data(), packet.payload.size());
+            datagrams.push_back(std::move(datagram));
+        }
+        info.timestamp += FRAME_DURATION;
+    }
+    return datagrams;
+}
+
+/**
+ * @brief Reorder a stream the way a multipath network might: swap every
+ * other pair of packets and deliver every eighth packet twice
+ */
+std::vector<std::vector<unsigned char>> disorder(
+    std::vector<std::vector<unsigned char>> datagrams) {
+    for (std::size_t i = 0; i + 1 < datagrams.size(); i += 4) {
+        std::swap(datagrams[i], datagrams[i + 1]);
+    }
+    std::vector<std::vector<unsigned char>> disordered;
+    for (std::size_t i = 0; i < datagrams.size(); ++i) {
+        disordered.push_back(datagrams[i]);
+        if (i % 8 == 7) disordered.push_back(datagrams[i]);
+    }
+    return disordered;
+}
+
+/**
+ * @brief Depacketize a stream and check that every frame comes out intact
+ *
+ * @return std::size_t Number of frames delivered
+ */
+std::size_t depacketize(Vp8Depacketizer& depacketizer,
+                        const std::vector<std::vector<unsigned char>>& stream,
+                        const std::vector<std::vector<unsigned char>>& frames,
+                        bool& exact) {
+    std::size_t delivered = 0;
+    ReceivedFrame frame;
+    for (const std::vector<unsigned char>& datagram : stream) {
+        if (!depacketizer.push(datagram.data(), datagram.size(), frame)) {
+            continue;
+        }
+        const std::vector<unsigned char>& sent =
+            frames[frame.timestamp / FRAME_DURATION % frames.size()];
+        exact = exact && frame.size == sent.size() &&
+                std::equal(sent.begin(), sent.end(), frame.data);
+        ++delivered;
+    }
+    return delivered;
+}
+
+void report(const char* name, const std::size_t packets,
+            const Clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    std::cout << "  " << name << ": " << packets / seconds / 1e6
+              << " Mpackets/s, " << seconds * 1e9 / packets
+              << " ns/packet\n";
+}
+
+}  // namespace
+
+/**
+ * Measures VP8 RTP packetization and reassembly in packets per second, for
+ * delta-sized and keyframe-sized frames at the base path MTU. Reassembly is
+ * measured in order and with reordered and duplicated packets, and every
+ * frame is checked against what was sent; exits non-zero on a mismatch.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        int iterations = DEFAULT_ITERATIONS;
+        if (const auto it = options.find("iterations"); it != options.end()) {
+            iterations = std::stoi(it->second);
+        }
+        std::size_t max_packet_size = PathMtu::BASE_PLPMTU;
+        if (const auto it = options.find("packet-size"); it != options.end()) {
+            max_packet_size = std::stoul(it->second);
+        }
+        if (iterations <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        for (const std::size_t frame_size : FRAME_SIZES) {
+            std::vector<std::vector<unsigned char>> frames;
+            for (std::size_t i = 0; i < STREAM_FRAMES; ++i) {
+                frames.push_back(make_frame(frame_size, i + 1));
+            }
+            std::cout << frame_size << " byte frames, " << max_packet_size
+                      << " byte packets:\n";
+
+            Vp8Packetizer packetizer(1, max_packet_size);
+            Vp8FrameInfo info;
+            std::size_t packets = 0;
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < iterations; ++i) {
+                const std::vector<unsigned char>& frame =
+                    frames[i % frames.size()];
+                packets +=
+                    packetizer.packetize(frame.data(), frame.size(), info)
+                        .size();
+                info.timestamp += FRAME_DURATION;
+            }
+            report("packetize", packets, Clock::now() - start);
+
+            const auto in_order = make_stream(frames, max_packet_size);
+            const auto reordered = disorder(in_order);
+            const int rounds =
+                std::max(1, iterations / static_cast<int>(frames.size()));
+            for (const auto* stream : {&in_order, &reordered}) {
+                // The same stream replayed is old news to a depacketizer,
+                // so each round gets a new one
+                bool exact = true;
+                std::size_t delivered = 0;
+                Clock::duration elapsed{};
+                for (int round = 0; round < rounds; ++round) {
+                    Vp8Depacketizer depacketizer;
+                    start = Clock::now();
+                    delivered +=
+                        depacketize(depacketizer, *stream, frames, exact);
+                    elapsed += Clock::now() - start;
+                }
+                if (!exact || delivered != frames.size() * rounds) {
+                    std::cout << "MISMATCH: " << delivered << " of "
+                              << frames.size() * rounds
+                              << " frames delivered intact\n";
+                    return 1;
+                }
+                report(stream == &in_order ? "depacketize in order"
+                                           : "depacketize reordered",
+                       stream->size() * rounds, elapsed);
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <benchmark/benchmark.h>
+
+#include "input_messages.hpp"
+#include "input_simulator.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "udp_server.hpp"
+
+namespace {
+
+constexpr unsigned short SERVER_PORT = 47110;
+constexpr unsigned short CLIENT_PORT = 47111;
+
+/**
+ * Receive, validate, parse and inject one input message per iteration. The
+ * client side is a plain loopback socket bound to the endpoint UDPServer
+ * accepts, and the server's io_context is driven inline until the server
+ * has counted the datagram.
+ */
+void BM_ServerReceiveInput(benchmark::State& state) {
+    boost::asio::io_context io_context;
+    UDPServer server(io_context, SERVER_PORT, "127.0.0.1",
+                     std::to_string(CLIENT_PORT),
+                     InputSimulator::create(SimulatorBackend::NULL_SINK));
+
+    udp::socket client(io_context, udp::endpoint(udp::v4(), CLIENT_PORT));
+    const udp::endpoint server_endpoint(
+        boost::asio::ip::address_v4::loopback(), SERVER_PORT);
+    std::array<char, InputMessages::Message::MAX_SERIALIZED_SIZE> buffer;
+    const std::size_t size =
+        InputMessages::Message(InputMessages::KEY_PRESSED, 22)
+            .serialize(buffer.data(), buffer.size());
+
+    const Metrics::Counter& received = Metrics::counter("input.packets_in");
+    for (auto _ : state) {
+        const uint64_t expected = received.value() + 1;
+        client.send_to(boost::asio::buffer(buffer.data(), size),
+                       server_endpoint);
+        while (received.value() != expected) io_context.run_one();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ServerReceiveInput);
+
+/**
+ * Same path for a datagram from an endpoint other than the client, which
+ * UDPServer drops during validation.
+ */
+void BM_ServerReceiveUnknownEndpoint(benchmark::State& state) {
+    Logger::set_level(Logger::LEVEL_ERROR);
+
+    boost::asio::io_context io_context;
+    UDPServer server(io_context, SERVER_PORT, "127.0.0.1",
+                     std::to_string(CLIENT_PORT),
+                     InputSimulator::create(SimulatorBackend::NULL_SINK));
+
+    udp::socket stranger(io_context, udp::endpoint(udp::v4(), 0));
+    const udp::endpoint server_endpoint(
+        boost::asio::ip::address_v4::loopback(), SERVER_PORT);
+    const std::string message = "1:22:0:0";
+
+    const Metrics::Counter& dropped =
+        Metrics::counter("drops.unknown_endpoint");
+    for (auto _ : state) {
+        const uint64_t expected = dropped.value() + 1;
+        stranger.send_to(boost::asio::buffer(message), server_endpoint);
+        while (dropped.value() != expected) io_context.run_one();
+    }
+    state.SetItemsProcessed(state.iterations());
+    Logger::set_level(Logger::LEVEL_INFO);
+}
+BENCHMARK(BM_ServerReceiveUnknownEndpoint);
+
+}  // namespace
@@ -0,0 +1,315 @@
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "handler_pool.hpp"
+#include "input_messages.hpp"
+#include "input_simulator_null.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "socket_address.hpp"
+#include "udp_client.hpp"
+#include "udp_server.hpp"
+#include "vp8_packetizer.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr unsigned short SERVER_PORT = 47110;
+constexpr unsigned short CLIENT_PORT = 47111;
+constexpr unsigned short RELAY_CLIENT_PORT = 47112;  // The client's server
+constexpr unsigned short RELAY_SERVER_PORT = 47113;  // The server's client
+constexpr std::chrono::seconds WARMUP_TIME{2};
+constexpr std::chrono::seconds MEASURED_TIME{3};
+constexpr std::size_t MAX_IN_FLIGHT = 32;
+
+// Video: 60 fps, a keyframe every second, lossy enough for parity
+constexpr int FRAME_RATE = 60;
+constexpr std::chrono::microseconds FRAME_INTERVAL{1000000 / FRAME_RATE};
+constexpr uint32_t FRAME_DURATION = Rtp::VIDEO_CLOCK_RATE / FRAME_RATE;
+constexpr std::size_t DELTA_FRAME_SIZE = 5000;
+constexpr std::size_t KEYFRAME_SIZE = 40000;
+constexpr std::size_t KEYFRAME_INTERVAL = 60;  // frames
+constexpr uint32_t VIDEO_SSRC = 1;
+constexpr double DOWNSTREAM_LOSS = 0.05;
+constexpr uint32_t LOSS_SEED = 7;
+
+/**
+ * @brief Video and input the server and client have handled so far, from
+ * the metrics both register
+ */
+struct Counts {
+    uint64_t inputs = 0;
+    int64_t played = 0;
+    uint64_t parity = 0;
+    int64_t rebuilt = 0;
+    uint64_t nacked = 0;
+    uint64_t retransmitted = 0;
+};
+
+/**
+ * @class Progress
+ * @brief Reads Counts without allocating, once the metrics are registered
+ */
+class Progress {
+   public:
+    Progress()
+        : inputs_(Metrics::counter("input.packets_in")),
+          played_(Metrics::gauge("video.played_frames")),
+          parity_(Metrics::counter("video.parity_packets")),
+          rebuilt_(Metrics::gauge("video.fec_rebuilt_packets")),
+          nacked_(Metrics::counter("video.nacked_packets")),
+          retransmitted_(Metrics::counter("video.retransmitted_packets")) {}
+
+    uint64_t inputs() const { return inputs_.value(); }
+
+    Counts counts() const {
+        Counts counts;
+        counts.inputs = inputs_.value();
+        counts.played = played_.value();
+        counts.parity = parity_.value();
+        counts.rebuilt = rebuilt_.value();
+        counts.nacked = nacked_.value();
+        counts.retransmitted = retransmitted_.value();
+        return counts;
+    }
+
+   private:
+    const Metrics::Counter& inputs_;
+    const Metrics::Gauge& played_;
+    const Metrics::Counter& parity_;
+    const Metrics::Gauge& rebuilt_;
+    const Metrics::Counter& nacked_;
+    const Metrics::Counter& retransmitted_;
+};
+
+/**
+ * @class LossyRelay
+ * @brief Forwards datagrams between the client and the server, dropping a
+ * seeded share of the server's. Unlike NetemProxy, whose timer wheel grows
+ * its slots as they are first used, it does not allocate once running.
+ */
+class LossyRelay {
+   public:
+    LossyRelay(boost::asio::io_context& io_context, const udp::endpoint& server,
+               const double loss)
+        : client_socket_(io_context,
+                         udp::endpoint(server.address(), RELAY_CLIENT_PORT)),
+          server_socket_(io_context,
+                         udp::endpoint(server.address(), RELAY_SERVER_PORT)),
+          server_(server),
+          random_(LOSS_SEED),
+          lost_(loss) {
+        receive_from_client();
+        receive_from_server();
+    }
+
+   private:
+    void receive_from_client() {
+        client_socket_.async_receive_from(
+            boost::asio::buffer(upstream_), client_,
+            pooled([this](const boost::system::error_code& ec,
+                          const std::size_t size) {
+                if (ec) return;
+                boost::system::error_code send_ec;
+                server_socket_.send_to(
+                    boost::asio::buffer(upstream_.data(), size), server_, 0,
+                    send_ec);
+                receive_from_client();
+            }));
+    }
+
+    void receive_from_server() {
+        server_socket_.async_receive_from(
+            boost::asio::buffer(downstream_), sender_,
+            pooled([this](const boost::system::error_code& ec,
+                          const std::size_t size) {
+                if (ec) return;
+                if (!lost_(random_)) {
+                    boost::system::error_code send_ec;
+                    client_socket_.send_to(
+                        boost::asio::buffer(downstream_.data(), size),
+                        client_, 0, send_ec);
+                }
+                receive_from_server();
+            }));
+    }
+
+    udp::socket client_socket_;
+    udp::socket server_socket_;
+    udp::endpoint server_;
+    udp::endpoint client_;  // Last seen
+    udp::endpoint sender_;
+    std::array<unsigned char, PacketBuffer::CAPACITY> upstream_;
+    std::array<unsigned char, PacketBuffer::CAPACITY> downstream_;
+    std::mt19937 random_;
+    std::bernoulli_distribution lost_;
+};
+
+/**
+ * @class VideoSource
+ * @brief Stands in for the media pipeline on the server's io_context:
+ * packetizes a frame every FRAME_INTERVAL and sends it, a keyframe every
+ * KEYFRAME_INTERVAL frames or when the client asks for one. Packets are
+ * sized for the base path MTU, so the first keyframe is the largest
+ * packetization whatever path MTU discovery finds.
+ */
+class VideoSource {
+   public:
+    VideoSource(boost::asio::io_context& io_context, UDPServer& server)
+        : server_(server),
+          timer_(io_context),
+          packetizer_(VIDEO_SSRC, PathMtu::BASE_PLPMTU - Fec::OVERHEAD -
+                                      Rtp::TRANSPORT_EXTENSION_SIZE),
+          keyframe_(KEYFRAME_SIZE, 0x00),  // VP8 keyframe bit clear
+          delta_(DELTA_FRAME_SIZE, 0x01),
+          frames_(0) {
+        timer_.expires_after(FRAME_INTERVAL);
+        wait();
+    }
+
+   private:
+    void wait() {
+        timer_.async_wait(pooled([this](const boost::system::error_code& ec) {
+            if (!ec) send_frame();
+        }));
+    }
+
+    void send_frame() {
+        const bool key = server_.take_keyframe_request() ||
+                         frames_ % KEYFRAME_INTERVAL == 0;
+        const std::vector<unsigned char>& frame = key ? keyframe_ : delta_;
+        Vp8FrameInfo info;
+        info.timestamp = static_cast<uint32_t>(frames_ * FRAME_DURATION);
+        server_.send_video(
+            packetizer_.packetize(frame.data(), frame.size(), info));
+        ++frames_;
+
+        timer_.expires_at(timer_.expiry() + FRAME_INTERVAL);
+        wait();
+    }
+
+    UDPServer& server_;
+    boost::asio::steady_timer timer_;
+    Vp8Packetizer packetizer_;
+    std::vector<unsigned char> keyframe_;
+    std::vector<unsigned char> delta_;
+    std::size_t frames_;
+};
+
+/**
+ * @brief Send input messages for the given time, and wait until the server
+ * has handled every input. The client pings on its own: another ping would
+ * be timed from the client's last one and inflate the round trip that
+ * decides whether a NACK can still help.
+ *
+ * @return std::size_t Input messages sent
+ */
+std::size_t send_for(UdpClient& client, const Progress& progress,
+                     const Clock::duration duration) {
+    const uint64_t inputs = progress.inputs();
+    const auto deadline = Clock::now() + duration;
+    std::size_t sent = 0;
+    while (Clock::now() < deadline) {
+        client.send_message(InputMessages::Message(
+            InputMessages::KEY_PRESSED, static_cast<int>(sent % 100)));
+        ++sent;
+
+        // Keep the socket buffer from overflowing on small machines
+        while (sent - (progress.inputs() - inputs) > MAX_IN_FLIGHT) {
+            std::this_thread::yield();
+        }
+    }
+    while (progress.inputs() - inputs < sent) std::this_thread::yield();
+    return sent;
+}
+
+}  // namespace
+
+/**
+ * Runs UDPServer, injecting into InputSimulatorNull, and UdpClient in
+ * process over loopback, each on its own io_context thread as in the
+ * executables, with a relay between them dropping DOWNSTREAM_LOSS of the
+ * server's datagrams. The server streams 60 fps video through its pacer,
+ * FEC encoder and packet history; the client reassembles it through its
+ * FEC decoder and jitter buffer, NACKs what is still missing and reports
+ * loss and arrivals back. After a warm-up, counts every heap allocation
+ * while the client also sends input. Fails if the steady state
+ * allocates at all, or if no parity, rebuilt packet or retransmission
+ * shows that the video paths ran, so it runs as a test.
+ */
+int main() {
+    try {
+        const auto loopback = boost::asio::ip::address_v4::loopback();
+
+        boost::asio::io_context relay_context;
+        LossyRelay relay(relay_context, udp::endpoint(loopback, SERVER_PORT),
+                         DOWNSTREAM_LOSS);
+        boost::asio::io_context server_context;
+        UDPServer server(server_context, SERVER_PORT,
+                         SocketAddress::from_endpoint(
+                             udp::endpoint(loopback, RELAY_SERVER_PORT)),
+                         std::make_unique<InputSimulatorNull>());
+        VideoSource video(server_context, server);
+        boost::asio::io_context client_context;
+        UdpClient client(client_context, CLIENT_PORT,
+                         SocketAddress::from_endpoint(
+                             udp::endpoint(loopback, RELAY_CLIENT_PORT)));
+        const Progress progress;
+
+        std::thread relay_thread([&relay_context]() { relay_context.run(); });
+        std::thread server_thread([&server_context]() {
+            server_context.run();
+        });
+        std::thread client_thread([&client_context]() {
+            client_context.run();
+        });
+
+        send_for(client, progress, WARMUP_TIME);
+        Logger::flush();  // Sizes the log writer's buffers too
+        const Counts before = progress.counts();
+        AllocationCounter::reset();
+        const std::size_t inputs = send_for(client, progress, MEASURED_TIME);
+        const std::size_t allocations = AllocationCounter::count();
+        const std::size_t bytes = AllocationCounter::bytes();
+        const Counts after = progress.counts();
+
+        client_context.stop();
+        server_context.stop();
+        relay_context.stop();
+        client_thread.join();
+        server_thread.join();
+        relay_thread.join();
+
+        std::cout << inputs << " input packets, "
+                  << after.played - before.played << " frames played, "
+                  << after.parity - before.parity << " parity packets, "
+                  << after.rebuilt - before.rebuilt << " rebuilt, "
+                  << after.nacked - before.nacked << " NACKed, "
+                  << after.retransmitted - before.retransmitted
+                  << " retransmitted, " << allocations << " allocations ("
+                  << bytes << " bytes) in steady state" << std::endl;
+
+        if (allocations != 0) {
+            std::cerr << "Steady-state path allocated per packet" << std::endl;
+            return 1;
+        }
+        if (after.played == before.played || after.parity == before.parity ||
+            after.rebuilt == before.rebuilt ||
+            after.retransmitted == before.retransmitted) {
+            std::cerr << "Video did not exercise FEC and NACK" << std::endl;
+            return 1;
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/resource.h>
+#endif
+
+#include "udp_segmentation.hpp"
+
+namespace {
+
+constexpr std::size_t FRAME_SIZE = 60 * 1024;  // One keyframe
+constexpr std::size_t PACKET_SIZE = 1200;
+constexpr std::size_t FRAMES = 5000;
+constexpr int POLL_TIMEOUT_MS = 10;
+constexpr std::chrono::milliseconds DRAIN_TIME{100};
+
+enum class Mode { SEND_TO, SENDMMSG, GSO };
+
+const char* mode_name(const Mode mode) {
+    switch (mode) {
+        case Mode::SEND_TO:
+            return "send_to";
+        case Mode::SENDMMSG:
+            return "sendmmsg";
+        case Mode::GSO:
+            return "gso";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief CPU time of the calling thread, so the receiver is not counted
+ */
+double cpu_seconds() {
+#ifdef __linux__
+    rusage usage = {};
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#else
+    return 0.0;
+#endif
+}
+
+/**
+ * @brief Block until the socket is readable or a short timeout passes, so
+ * the receiver sleeps instead of spinning while the sender runs
+ */
+void wait_readable(udp::socket& socket) {
+#ifdef __linux__
+    pollfd fd = {socket.native_handle(), POLLIN, 0};
+    poll(&fd, 1, POLL_TIMEOUT_MS);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(POLL_TIMEOUT_MS));
+    (void)socket;
+#endif
+}
+
+void run(const Mode mode) {
+    boost::asio::io_context io_context;
+    const udp::endpoint loopback(boost::asio::ip::address_v4::loopback(), 0);
+    udp::socket receiver(io_context, loopback);
+    udp::socket sender(io_context, loopback);
+    receiver.set_option(udp::socket::receive_buffer_size(8 * 1024 * 1024));
+
+    const std::vector<unsigned char> frame(FRAME_SIZE, 0xAB);
+    std::vector<boost::asio::const_buffer> packets;
+    for (std::size_t offset = 0; offset < FRAME_SIZE; offset += PACKET_SIZE) {
+        packets.emplace_back(frame.data() + offset,
+                             std::min(PACKET_SIZE, FRAME_SIZE - offset));
+    }
+
+    UdpSegmentSender batch_sender(sender, mode == Mode::GSO);
+    UdpGroReceiver gro_receiver(receiver);
+
+    std::atomic<bool> done = false;
+    std::atomic<std::size_t> packets_recvd = 0;
+    std::atomic<std::size_t> bytes_recvd = 0;
+    std::atomic<std::chrono::steady_clock::time_point> last_recvd;
+    const auto start = std::chrono::steady_clock::now();
+    last_recvd = start;
+    std::thread receiver_thread([&]() {
+        while (!done) {
+            wait_readable(receiver);
+            const std::size_t delivered = gro_receiver.receive(
+                [&](const unsigned char*, const std::size_t size,
+                    const udp::endpoint&) {
+                    packets_recvd.fetch_add(1, std::memory_order_relaxed);
+                    bytes_recvd.fetch_add(size, std::memory_order_relaxed);
+                });
+            if (delivered > 0) last_recvd = std::chrono::steady_clock::now();
+        }
+    });
+
+    const udp::endpoint destination = receiver.local_endpoint();
+    const double cpu_start = cpu_seconds();
+
+    std::size_t packets_sent = 0;
+    for (std::size_t i = 0; i < FRAMES; ++i) {
+        if (mode == Mode::SEND_TO) {
+            for (const auto& packet : packets) {
+                sender.send_to(packet, destination);
+            }
+            packets_sent += packets.size();
+        } else {
+            packets_sent += batch_sender.send_batch(packets, destination);
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start);
+    const double cpu = cpu_seconds() - cpu_start;
+    std::this_thread::sleep_for(DRAIN_TIME);
+    done = true;
+    receiver_thread.join();
+    const auto receive_elapsed = std::chrono::duration<double>(
+        last_recvd.load() - start);
+
+    // Sender CPU per Gbit handed to the kernel, whether or not it arrived
+    const double gigabits_sent = static_cast<double>(packets_sent) *
+                                 FRAME_SIZE / packets.size() * 8 / 1e9;
+    const double loss =
+        packets_sent > 0
+            ? 100.0 * (1.0 - static_cast<double>(packets_recvd) /
+                                 static_cast<double>(packets_sent))
+            : 0.0;
+    std::cout << mode_name(mode)
+              << (mode == Mode::GSO && !batch_sender.gso_enabled()
+                      ? " (fell back to sendmmsg)"
+                      : "")
+              << ": sent " << packets_sent << " packets, "
+              << packets_sent / elapsed.count() << " packets/s, received "
+              << packets_recvd << ", "
+              << (receive_elapsed.count() > 0
+                      ? packets_recvd / receive_elapsed.count()
+                      : 0.0)
+              << " packets/s (gro "
+              << (gro_receiver.gro_enabled() ? "on" : "off") << "), "
+              << loss << "% lost, sender "
+              << (gigabits_sent > 0 ? cpu / gigabits_sent : 0.0)
+              << " CPU s/Gbit" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    try {
+        run(Mode::SEND_TO);
+        run(Mode::SENDMMSG);
+        run(Mode::GSO);
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
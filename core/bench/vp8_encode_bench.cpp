@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "common.hpp"
+#include "frame_source.hpp"
+#include "vp8_encoder.hpp"
+
+namespace {
+
+constexpr std::size_t DEFAULT_FRAMES = 300;
+constexpr int FRAME_RATE = 60;
+constexpr int SIZES[][2] = {{1280, 720}, {1920, 1080}};
+constexpr int BITRATES[] = {1000, 2500, 6000};  // kbit/s
+
+using Clock = std::chrono::steady_clock;
+
+double percentile(const std::vector<double>& sorted, const double p) {
+    if (sorted.empty()) return 0;
+    return sorted[static_cast<std::size_t>(p * (sorted.size() - 1))];
+}
+
+}  // namespace
+
+/**
+ * Encodes --frames frames of a synthetic source (the moving test pattern,
+ * or --capture-file) at 720p and 1080p and a few bitrates, stamped as if
+ * captured at 60 fps, and reports encode time per frame, the bitrate
+ * reached, keyframes and frames dropped by rate control.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        std::size_t frames = DEFAULT_FRAMES;
+        if (const auto it = options.find("frames"); it != options.end()) {
+            frames = std::stoul(it->second);
+        }
+        int threads = DEFAULT_ENCODE_THREADS;
+        if (const auto it = options.find("threads"); it != options.end()) {
+            threads = std::stoi(it->second);
+        }
+        if (frames == 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        for (const auto& size : SIZES) {
+            CaptureSettings capture = CaptureSettings::from_options(options);
+            if (capture.backend == CaptureBackend::NATIVE) {
+                capture.backend = CaptureBackend::TEST_PATTERN;
+            }
+            capture.width = size[0];
+            capture.height = size[1];
+            capture.format = PixelFormat::I420;
+            auto source = FrameSource::create(capture);
+
+            for (const int bitrate : BITRATES) {
+                EncoderSettings settings;
+                settings.width = size[0];
+                settings.height = size[1];
+                settings.frame_rate = FRAME_RATE;
+                settings.bitrate = bitrate;
+                settings.threads = threads;
+                Vp8Encoder encoder(settings);
+
+                std::vector<double> encode_times;
+                encode_times.reserve(frames);
+                std::size_t bytes = 0;
+                std::size_t keyframes = 0;
+                std::size_t dropped = 0;
+                const Clock::time_point start = Clock::now();
+                for (std::size_t i = 0; i < frames; ++i) {
+                    FrameRef frame = source->capture();
+                    frame->set_capture(
+                        start + std::chrono::microseconds(1000000 * i /
+                                                          FRAME_RATE),
+                        i);
+
+                    EncodedFrame encoded;
+                    const Clock::time_point before = Clock::now();
+                    const bool produced = encoder.encode(*frame, encoded);
+                    encode_times.push_back(
+                        std::chrono::duration<double, std::milli>(
+                            Clock::now() - before)
+                            .count());
+                    if (!produced) {
+                        ++dropped;
+                        continue;
+                    }
+                    bytes += encoded.size;
+                    keyframes += encoded.keyframe ? 1 : 0;
+                }
+
+                std::sort(encode_times.begin(), encode_times.end());
+                const double seconds =
+                    static_cast<double>(frames) / FRAME_RATE;
+                std::cout << size[0] << "x" << size[1] << " at " << bitrate
+                          << " kbit/s: encode p50 "
+                          << percentile(encode_times, 0.50) << " ms, p99 "
+                          << percentile(encode_times, 0.99) << " ms, reached "
+                          << bytes * 8 / seconds / 1000 << " kbit/s, "
+                          << keyframes << " keyframes, " << dropped
+                          << " dropped\n";
+            }
+        }
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
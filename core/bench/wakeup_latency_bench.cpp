@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "datagram_receiver.hpp"
+#include "latency_profile.hpp"
+#include "metrics.hpp"
+
+namespace {
+
+constexpr unsigned short RECEIVER_PORT = 47400;
+constexpr std::size_t DEFAULT_COUNT = 10000;
+constexpr int DEFAULT_INTERVAL = 1000;  // microseconds
+
+using Clock = std::chrono::steady_clock;
+
+int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @class WakeupReceiver
+ * @brief Receives timestamped datagrams the way UDPServer does and records
+ * how long each took from send to handler.
+ */
+class WakeupReceiver {
+   public:
+    WakeupReceiver(boost::asio::io_context& io_context,
+                   const LatencyProfile& profile, const std::size_t count)
+        : socket_(io_context,
+                  udp::endpoint(boost::asio::ip::address_v4::loopback(),
+                                RECEIVER_PORT)),
+          receiver_(socket_) {
+        profile.apply(socket_);
+        samples_.reserve(count);
+        start_receive();
+    }
+
+    void poll_receive() {
+        for (;;) {
+            boost::system::error_code ec;
+            const std::size_t size = receiver_.receive(
+                boost::asio::buffer(buffer_), remote_endpoint_, ec);
+            if (ec) return;
+
+            const int64_t received = now_ns();
+            if (size != sizeof(int64_t)) continue;
+            int64_t sent = 0;
+            std::memcpy(&sent, buffer_.data(), sizeof(sent));
+            if (samples_.size() < samples_.capacity()) {
+                samples_.push_back(received - sent);
+            }
+        }
+    }
+
+    std::vector<int64_t>& samples() { return samples_; }
+
+   private:
+    void start_receive() {
+        socket_.async_wait(udp::socket::wait_read,
+                           [this](const boost::system::error_code& ec) {
+                               if (ec) return;
+                               poll_receive();
+                               start_receive();
+                           });
+    }
+
+    udp::socket socket_;
+    DatagramReceiver receiver_;
+    udp::endpoint remote_endpoint_;
+    std::array<unsigned char, 64> buffer_;
+    std::vector<int64_t> samples_;
+};
+
+double percentile(const std::vector<int64_t>& sorted, const double p) {
+    if (sorted.empty()) return 0;
+    const auto index = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return sorted[index] / 1000.0;
+}
+
+}  // namespace
+
+/**
+ * Measures wake-up latency: the time from a send on loopback to the
+ * receiving io thread's handler. Datagrams are spaced --interval apart so
+ * the receiver is idle, sleeping or spinning, when each one arrives.
+ *
+ * Run once plain and once with --latency-profile (plus --cpu and
+ * --rt-priority, as for udp_server) to compare.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+        const auto profile = LatencyProfile::from_options(options);
+
+        std::size_t count = DEFAULT_COUNT;
+        if (const auto it = options.find("count"); it != options.end()) {
+            count = std::stoul(it->second);
+        }
+        int interval = DEFAULT_INTERVAL;
+        if (const auto it = options.find("interval"); it != options.end()) {
+            interval = std::stoi(it->second);
+        }
+        if (count == 0 || interval <= 0) {
+            throw std::invalid_argument("Invalid benchmark options");
+        }
+
+        boost::asio::io_context io_context;
+        WakeupReceiver receiver(io_context, profile, count);
+        std::thread receiver_thread([&]() {
+            profile.run(io_context, [&receiver]() { receiver.poll_receive(); });
+        });
+
+        udp::socket sender(io_context, udp::endpoint(udp::v4(), 0));
+        const udp::endpoint destination(
+            boost::asio::ip::address_v4::loopback(), RECEIVER_PORT);
+        auto next = Clock::now();
+        for (std::size_t i = 0; i < count; ++i) {
+            next += std::chrono::microseconds(interval);
+            std::this_thread::sleep_until(next);
+            const int64_t sent = now_ns();
+            sender.send_to(boost::asio::buffer(&sent, sizeof(sent)),
+                           destination);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        io_context.stop();
+        receiver_thread.join();
+
+        std::vector<int64_t>& samples = receiver.samples();
+        std::sort(samples.begin(), samples.end());
+        std::cout << (profile.enabled ? "Latency profile" : "Default")
+                  << ": " << samples.size() << " of " << count
+                  << " datagrams, wake-up latency in us:\n"
+                  << "  p50 " << percentile(samples, 0.50) << "  p90 "
+                  << percentile(samples, 0.90) << "  p99 "
+                  << percentile(samples, 0.99) << "  p99.9 "
+                  << percentile(samples, 0.999) << "  max "
+                  << percentile(samples, 1.0) << "\n"
+                  << "Kernel drops: "
+                  << Metrics::counter("drops.rx_queue_overflow").value()
+                  << "\n";
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
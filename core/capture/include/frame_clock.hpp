@@ -0,0 +1,74 @@
+#ifndef FRAME_CLOCK_HPP
+#define FRAME_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+
+constexpr int DEFAULT_FRAME_RATE = 60;                          // frames/s
+constexpr std::chrono::microseconds DEFAULT_SPIN_MARGIN{200};  // see below
+
+/**
+ * @class FrameClock
+ * @brief Paces capture at a fixed frame rate against absolute deadlines.
+ *
+ * Deadlines are start + n * interval, so time spent capturing and encoding
+ * does not accumulate as drift the way sleeping for an interval does. The
+ * thread sleeps until shortly before each deadline (clock_nanosleep with
+ * TIMER_ABSTIME on Linux) and spins through the remaining spin margin,
+ * which absorbs the scheduler's wake-up slack. A caller running late skips
+ * the deadlines it missed instead of bursting to catch up.
+ */
+class FrameClock {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new FrameClock object. The first deadline is one
+     * interval from now.
+     *
+     * @param frame_rate Frames per second
+     * @param spin_margin Time before each deadline to spin rather than
+     * sleep, 0 to only sleep
+     *
+     * @throws std::invalid_argument If the frame rate is not positive.
+     */
+    explicit FrameClock(const int frame_rate = DEFAULT_FRAME_RATE,
+                        const std::chrono::microseconds spin_margin =
+                            DEFAULT_SPIN_MARGIN);
+
+    /**
+     * @brief Block until the next deadline
+     *
+     * @return Clock::time_point The deadline waited for, the nominal capture
+     * time of the frame
+     */
+    Clock::time_point wait();
+
+    /**
+     * @brief Restart the deadlines from now, e.g. after a pause
+     */
+    void reset();
+
+    Clock::duration interval() const { return interval_; }
+    Clock::time_point next_deadline() const { return next_; }
+
+    /**
+     * @brief Get the number of deadlines skipped because the caller was late
+     *
+     * @return uint64_t Missed deadlines since construction
+     */
+    uint64_t missed() const { return missed_; }
+
+   private:
+    Clock::time_point deadline(const uint64_t tick) const;
+
+    int frame_rate_;
+    Clock::duration interval_;
+    Clock::duration spin_margin_;
+    Clock::time_point start_;
+    uint64_t ticks_;
+    Clock::time_point next_;
+    uint64_t missed_;
+};
+
+#endif  // FRAME_CLOCK_HPP
@@ -0,0 +1,258 @@
+#ifndef FRAME_POOL_HPP
+#define FRAME_POOL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class FramePool;
+
+/**
+ * @enum PixelFormat
+ * @brief Enumerates the pixel layouts frames are stored in.
+ */
+enum class PixelFormat {
+    BGRA,  // 4 bytes per pixel, one plane, as captured from X11 and Windows
+    I420   // 8-bit Y plane then quarter-size U and V planes
+};
+
+/**
+ * @struct FrameLayout
+ * @brief Dimensions and memory layout shared by every frame of a pool.
+ */
+struct FrameLayout {
+    PixelFormat format = PixelFormat::BGRA;
+    int width = 0;
+    int height = 0;
+    int stride = 0;  // Bytes per row of the first plane
+
+    /**
+     * @brief Create a layout with rows padded to ROW_ALIGNMENT bytes
+     *
+     * @param format Pixel format
+     * @param width Width in pixels
+     * @param height Height in pixels
+     * @return FrameLayout The layout
+     *
+     * @throws std::invalid_argument If a dimension is not positive, or odd
+     * for I420.
+     */
+    static FrameLayout aligned(const PixelFormat format, const int width,
+                               const int height);
+
+    /**
+     * @brief Get the number of planes
+     *
+     * @return int 1 for BGRA, 3 for I420
+     */
+    int planes() const { return format == PixelFormat::I420 ? 3 : 1; }
+
+    /**
+     * @brief Get the bytes per row of a plane
+     *
+     * @param plane Plane index
+     * @return int Stride in bytes
+     */
+    int plane_stride(const int plane) const {
+        return plane == 0 ? stride : stride / 2;
+    }
+
+    /**
+     * @brief Get the offset of a plane from the start of the frame
+     *
+     * @param plane Plane index
+     * @return std::size_t Offset in bytes
+     */
+    std::size_t plane_offset(const int plane) const;
+
+    /**
+     * @brief Get the number of bytes a frame occupies
+     *
+     * @return std::size_t Frame size in bytes
+     */
+    std::size_t size() const { return plane_offset(planes()); }
+
+    static constexpr int ROW_ALIGNMENT = 64;  // bytes, a cache line
+};
+
+/**
+ * @class FrameBuffer
+ * @brief Frame of video owned by a FramePool. Reference counted intrusively
+ * like PacketBuffer, so frames move between threads without copying.
+ */
+class FrameBuffer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    unsigned char* data() { return data_; }
+    const unsigned char* data() const { return data_; }
+    const FrameLayout& layout() const { return *layout_; }
+    int width() const { return layout_->width; }
+    int height() const { return layout_->height; }
+    int stride() const { return layout_->stride; }
+    PixelFormat format() const { return layout_->format; }
+
+    /**
+     * @brief Get a plane of the frame
+     *
+     * @param plane Plane index
+     * @return unsigned char* First byte of the plane
+     */
+    unsigned char* plane(const int plane) {
+        return data_ + layout_->plane_offset(plane);
+    }
+    const unsigned char* plane(const int plane) const {
+        return data_ + layout_->plane_offset(plane);
+    }
+
+    /**
+     * @brief Get the position of the frame's memory in its pool, for
+     * sources that attach per-frame resources
+     *
+     * @return uint32_t Index from 0 to the pool size
+     */
+    uint32_t index() const { return index_; }
+
+    Clock::time_point capture_time() const { return capture_time_; }
+    uint64_t sequence() const { return sequence_; }
+
+    /**
+     * @brief Stamp the frame when its contents are captured
+     *
+     * @param capture_time When the contents were taken
+     * @param sequence Frame number from the source
+     */
+    void set_capture(const Clock::time_point capture_time,
+                     const uint64_t sequence) {
+        capture_time_ = capture_time;
+        sequence_ = sequence;
+    }
+
+   private:
+    friend class FramePool;
+    friend class FrameRef;
+
+    std::atomic<uint32_t> ref_count_{0};
+    FramePool* pool_ = nullptr;
+    const FrameLayout* layout_ = nullptr;
+    unsigned char* data_ = nullptr;
+    uint32_t index_ = 0;
+    Clock::time_point capture_time_;
+    uint64_t sequence_ = 0;
+};
+
+/**
+ * @class FrameRef
+ * @brief Intrusive reference to a pooled FrameBuffer. The frame returns to
+ * its pool when the last reference is dropped.
+ */
+class FrameRef {
+   public:
+    FrameRef() = default;
+    FrameRef(const FrameRef& other) : buffer_(other.buffer_) { retain(); }
+    FrameRef(FrameRef&& other) noexcept : buffer_(other.buffer_) {
+        other.buffer_ = nullptr;
+    }
+    ~FrameRef() { release(); }
+
+    FrameRef& operator=(FrameRef other) noexcept {
+        std::swap(buffer_, other.buffer_);
+        return *this;
+    }
+
+    explicit operator bool() const { return buffer_ != nullptr; }
+    FrameBuffer* operator->() const { return buffer_; }
+    FrameBuffer& operator*() const { return *buffer_; }
+
+   private:
+    friend class FramePool;
+
+    explicit FrameRef(FrameBuffer* buffer) : buffer_(buffer) {}
+
+    void retain() {
+        if (buffer_) {
+            buffer_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release();
+
+    FrameBuffer* buffer_ = nullptr;
+};
+
+/**
+ * @class FramePool
+ * @brief Fixed set of frames of one layout, allocated once up front.
+ *
+ * Frames are few and taken at frame rate, so the free list is guarded by a
+ * mutex rather than being lock-free like PacketPool's. Acquire and release
+ * are safe from any thread and do not allocate.
+ */
+class FramePool {
+   public:
+    /**
+     * @brief Construct a new FramePool object owning its memory. Each frame
+     * starts on a ROW_ALIGNMENT boundary.
+     *
+     * @param layout Layout of every frame
+     * @param count Number of frames to preallocate
+     */
+    FramePool(const FrameLayout& layout, const std::size_t count);
+
+    /**
+     * @brief Construct a new FramePool object over memory owned by the
+     * caller, e.g. shared memory segments, which must outlive the pool
+     *
+     * @param layout Layout of every frame
+     * @param memory One block of at least layout.size() bytes per frame
+     */
+    FramePool(const FrameLayout& layout,
+              const std::vector<unsigned char*>& memory);
+
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    /**
+     * @brief Take a frame from the pool. Its contents are whatever was last
+     * written to it.
+     *
+     * @return FrameRef Reference to a frame, or a null reference if the pool
+     * is exhausted
+     */
+    FrameRef acquire();
+
+    /**
+     * @brief Get the number of frames currently available
+     *
+     * @return std::size_t Free frame count
+     */
+    std::size_t available() const;
+
+    const FrameLayout& layout() const { return layout_; }
+    std::size_t size() const { return count_; }
+
+   private:
+    friend class FrameRef;
+
+    void init(const std::vector<unsigned char*>& memory);
+    void give_back(FrameBuffer* buffer);
+
+    FrameLayout layout_;
+    std::size_t count_;
+    std::unique_ptr<unsigned char[]> memory_;
+    std::unique_ptr<FrameBuffer[]> buffers_;
+    mutable std::mutex mutex_;
+    std::vector<uint32_t> free_;
+};
+
+inline void FrameRef::release() {
+    if (buffer_ &&
+        buffer_->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        buffer_->pool_->give_back(buffer_);
+    }
+    buffer_ = nullptr;
+}
+
+#endif  // FRAME_POOL_HPP
@@ -0,0 +1,103 @@
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "frame_pool.hpp"
+
+constexpr std::size_t FRAME_POOL_SIZE = 4;  // frames in flight per source
+constexpr int DEFAULT_CAPTURE_WIDTH = 1280;
+constexpr int DEFAULT_CAPTURE_HEIGHT = 720;
+
+/**
+ * @enum CaptureBackend
+ * @brief Enumerates the available frame source implementations.
+ */
+enum class CaptureBackend {
+    NATIVE,        // Captures the screen or a window (X11 MIT-SHM on Linux)
+    TEST_PATTERN,  // Generates a moving test pattern
+    RAW_FILE       // Plays back headerless frames from a file
+};
+
+/**
+ * @struct CaptureSettings
+ * @brief What a frame source captures. Dimensions and format are ignored
+ * by native capture, which takes them from the window.
+ */
+struct CaptureSettings {
+    CaptureBackend backend = CaptureBackend::NATIVE;
+    int width = DEFAULT_CAPTURE_WIDTH;
+    int height = DEFAULT_CAPTURE_HEIGHT;
+    PixelFormat format = PixelFormat::BGRA;
+    std::string display;  // X display, empty for $DISPLAY
+    unsigned long window = 0;  // Window to capture, 0 for the whole screen
+    std::string path;          // Raw file to play back
+    std::size_t pool_size = FRAME_POOL_SIZE;
+
+    /**
+     * @brief Read the settings from command line options: --capture
+     * <native|test|file>, --capture-size <WxH>, --capture-format
+     * <bgra|i420>, --capture-file <path>, --display <name> and
+     * --window <id>.
+     *
+     * @param options Options as parsed by Common::parse_options
+     * @return CaptureSettings The settings, native capture by default.
+     *
+     * @throws std::invalid_argument If a value is invalid.
+     */
+    static CaptureSettings from_options(
+        const std::unordered_map<std::string, std::string>& options);
+};
+
+/**
+ * @class FrameSource
+ * @brief Interface for capturing video frames. To be implemented by
+ * platform-specific and synthetic sources.
+ *
+ * Frames come from the source's own FramePool and are handed out by
+ * reference, so a frame stays valid, and is not reused for capture, until
+ * every reference to it is dropped. Sources are not thread-safe: capture
+ * from one thread, typically paced by a FrameClock.
+ */
+class FrameSource {
+   public:
+    /**
+     * @brief Destroy the FrameSource object
+     */
+    virtual ~FrameSource() = default;
+
+    /**
+     * @brief Create a new FrameSource object with the given settings.
+     * Non-native backends run headless on every platform.
+     *
+     * @param settings What to capture
+     * @return std::unique_ptr<FrameSource> Pointer to the created object.
+     *
+     * @throws std::runtime_error If the source cannot be opened, or the
+     * platform has no native capture.
+     */
+    static std::unique_ptr<FrameSource> create(
+        const CaptureSettings& settings);
+
+    /**
+     * @brief Capture the next frame
+     *
+     * @return FrameRef The frame, stamped with its capture time and
+     * sequence number, or a null reference if every pooled frame is still
+     * in use downstream
+     *
+     * @throws std::runtime_error If capture fails.
+     */
+    virtual FrameRef capture() = 0;
+
+    /**
+     * @brief Get the layout of the frames this source produces
+     *
+     * @return const FrameLayout& Frame layout
+     */
+    virtual const FrameLayout& layout() const = 0;
+};
+
+#endif  // FRAME_SOURCE_HPP
@@ -0,0 +1,46 @@
+#ifndef FRAME_SOURCE_RAW_FILE_HPP
+#define FRAME_SOURCE_RAW_FILE_HPP
+
+#include <fstream>
+
+#include "frame_source.hpp"
+
+/**
+ * @class FrameSourceRawFile
+ * @brief Plays back a file of headerless frames, tightly packed in the
+ * configured size and format (as written by ffmpeg -f rawvideo), looping at
+ * the end.
+ */
+class FrameSourceRawFile : public FrameSource {
+   public:
+    /**
+     * @brief Construct a new FrameSourceRawFile object
+     *
+     * @param settings File path, frame dimensions, format and pool size
+     *
+     * @throws std::invalid_argument If the dimensions are invalid.
+     * @throws std::runtime_error If the file cannot be opened or holds less
+     * than one frame.
+     */
+    explicit FrameSourceRawFile(const CaptureSettings& settings);
+    ~FrameSourceRawFile() override = default;
+
+    FrameRef capture() override;
+    const FrameLayout& layout() const override { return pool_.layout(); }
+
+    /**
+     * @brief Get the number of whole frames in the file
+     *
+     * @return uint64_t Frames per loop
+     */
+    uint64_t frames() const { return frames_; }
+
+   private:
+    FramePool pool_;
+    std::ifstream file_;
+    std::size_t packed_size_;  // Bytes per frame in the file
+    uint64_t frames_;
+    uint64_t sequence_;
+};
+
+#endif  // FRAME_SOURCE_RAW_FILE_HPP
@@ -0,0 +1,41 @@
+#ifndef FRAME_SOURCE_TEST_PATTERN_HPP
+#define FRAME_SOURCE_TEST_PATTERN_HPP
+
+#include <vector>
+
+#include "frame_source.hpp"
+
+/**
+ * @class FrameSourceTestPattern
+ * @brief Generates colour bars with a box bouncing across them. Frame n is
+ * the same on every run, so the pipeline can be benchmarked headless and
+ * its output compared.
+ */
+class FrameSourceTestPattern : public FrameSource {
+   public:
+    /**
+     * @brief Construct a new FrameSourceTestPattern object
+     *
+     * @param settings Frame dimensions, format and pool size
+     *
+     * @throws std::invalid_argument If the dimensions are invalid.
+     */
+    explicit FrameSourceTestPattern(const CaptureSettings& settings);
+    ~FrameSourceTestPattern() override = default;
+
+    FrameRef capture() override;
+    const FrameLayout& layout() const override { return pool_.layout(); }
+
+    static constexpr int BOX_SIZE = 64;  // pixels
+
+   private:
+    void draw_bgra(FrameBuffer& frame) const;
+    void draw_i420(FrameBuffer& frame) const;
+    void box_position(int& x, int& y) const;
+
+    FramePool pool_;
+    std::vector<unsigned char> bars_;  // One row of each plane
+    uint64_t sequence_;
+};
+
+#endif  // FRAME_SOURCE_TEST_PATTERN_HPP
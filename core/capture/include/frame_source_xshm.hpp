@@ -0,0 +1,60 @@
+#ifndef FRAME_SOURCE_XSHM_HPP
+#define FRAME_SOURCE_XSHM_HPP
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include <memory>
+#include <vector>
+
+#include "frame_source.hpp"
+
+/**
+ * @class FrameSourceXShm
+ * @brief Captures an X11 window, or the whole screen, through the MIT-SHM
+ * extension.
+ *
+ * Every pooled frame is a shared memory segment attached to the X server,
+ * which copies the window contents straight into it: frames are handed out
+ * without a copy on our side. Works under Xvfb for headless testing.
+ */
+class FrameSourceXShm : public FrameSource {
+   public:
+    /**
+     * @brief Construct a new FrameSourceXShm object
+     *
+     * @param settings Display, window and pool size
+     *
+     * @throws std::runtime_error If the display cannot be opened, lacks
+     * MIT-SHM, or the window is not 24 or 32-bit TrueColor.
+     */
+    explicit FrameSourceXShm(const CaptureSettings& settings);
+    ~FrameSourceXShm() override;
+
+    FrameRef capture() override;
+    const FrameLayout& layout() const override { return pool_->layout(); }
+
+   private:
+    /**
+     * @struct Segment
+     * @brief Shared memory image backing one pooled frame
+     */
+    struct Segment {
+        XShmSegmentInfo info = {};
+        XImage* image = nullptr;
+        bool attached = false;
+    };
+
+    void attach_segments(FrameLayout layout, const std::size_t count,
+                         Visual* visual, const int depth);
+    void release();
+
+    Display* display_;
+    Window window_;
+    std::vector<Segment> segments_;
+    std::unique_ptr<FramePool> pool_;  // Destroyed before the segments
+    uint64_t sequence_;
+};
+
+#endif  // FRAME_SOURCE_XSHM_HPP
@@ -0,0 +1,79 @@
+#include "frame_clock.hpp"
+
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <time.h>
+
+#include <cerrno>
+#endif
+
+namespace {
+
+/**
+ * @brief Sleep until an absolute time on the steady clock
+ */
+void sleep_until(const FrameClock::Clock::time_point deadline) {
+#ifdef __linux__
+    // steady_clock is CLOCK_MONOTONIC on Linux
+    const auto since_epoch =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            deadline.time_since_epoch());
+    timespec time = {};
+    time.tv_sec = static_cast<time_t>(since_epoch.count() / 1000000000);
+    time.tv_nsec = static_cast<long>(since_epoch.count() % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) ==
+           EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
+
+}  // namespace
+
+FrameClock::FrameClock(const int frame_rate,
+                       const std::chrono::microseconds spin_margin)
+    : frame_rate_(frame_rate), spin_margin_(spin_margin), ticks_(0),
+      missed_(0) {
+    if (frame_rate <= 0) {
+        throw std::invalid_argument("Frame rate must be positive");
+    }
+    interval_ = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::nanoseconds(1000000000 / frame_rate));
+    reset();
+}
+
+void FrameClock::reset() {
+    start_ = Clock::now();
+    ticks_ = 1;
+    next_ = deadline(ticks_);
+}
+
+FrameClock::Clock::time_point FrameClock::deadline(const uint64_t tick) const {
+    // Exact for rates that do not divide a second, e.g. 60 frames/s
+    return start_ + std::chrono::duration_cast<Clock::duration>(
+                        std::chrono::nanoseconds(static_cast<int64_t>(
+                            tick * 1000000000 / frame_rate_)));
+}
+
+FrameClock::Clock::time_point FrameClock::wait() {
+    Clock::time_point now = Clock::now();
+    if (now >= next_ + interval_) {
+        // Late by at least a whole frame: drop to the latest deadline passed
+        const auto behind = static_cast<uint64_t>((now - next_) / interval_);
+        missed_ += behind;
+        ticks_ += behind;
+        next_ = deadline(ticks_);
+    }
+
+    if (next_ - now > spin_margin_) sleep_until(next_ - spin_margin_);
+    while (Clock::now() < next_) {
+    }
+
+    const Clock::time_point due = next_;
+    ++ticks_;
+    next_ = deadline(ticks_);
+    return due;
+}
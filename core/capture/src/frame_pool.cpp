@@ -0,0 +1,101 @@
+#include "frame_pool.hpp"
+
+#include <stdexcept>
+
+namespace {
+
+std::size_t round_up(const std::size_t value, const std::size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+FrameLayout FrameLayout::aligned(const PixelFormat format, const int width,
+                                 const int height) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Frame dimensions must be positive");
+    }
+    if (format == PixelFormat::I420 && (width % 2 != 0 || height % 2 != 0)) {
+        throw std::invalid_argument("I420 frame dimensions must be even");
+    }
+
+    FrameLayout layout;
+    layout.format = format;
+    layout.width = width;
+    layout.height = height;
+    const int row = format == PixelFormat::BGRA ? width * 4 : width;
+    // I420 chroma rows are half as long and must stay aligned too
+    const int alignment =
+        format == PixelFormat::I420 ? 2 * ROW_ALIGNMENT : ROW_ALIGNMENT;
+    layout.stride = static_cast<int>(round_up(row, alignment));
+    return layout;
+}
+
+std::size_t FrameLayout::plane_offset(const int plane) const {
+    const std::size_t luma = static_cast<std::size_t>(stride) * height;
+    if (plane == 0) return 0;
+    if (format != PixelFormat::I420 || plane == 1) return luma;
+
+    const std::size_t chroma =
+        static_cast<std::size_t>(stride / 2) * (height / 2);
+    return luma + chroma * (plane - 1);
+}
+
+FramePool::FramePool(const FrameLayout& layout, const std::size_t count)
+    : layout_(layout), count_(count) {
+    const std::size_t frame_size =
+        round_up(layout_.size(), FrameLayout::ROW_ALIGNMENT);
+    memory_ = std::make_unique<unsigned char[]>(
+        frame_size * count + FrameLayout::ROW_ALIGNMENT);
+
+    // new[] only guarantees fundamental alignment
+    const auto address = reinterpret_cast<std::uintptr_t>(memory_.get());
+    unsigned char* base =
+        memory_.get() + (round_up(address, FrameLayout::ROW_ALIGNMENT) -
+                         address);
+
+    std::vector<unsigned char*> memory(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        memory[i] = base + i * frame_size;
+    }
+    init(memory);
+}
+
+FramePool::FramePool(const FrameLayout& layout,
+                     const std::vector<unsigned char*>& memory)
+    : layout_(layout), count_(memory.size()) {
+    init(memory);
+}
+
+void FramePool::init(const std::vector<unsigned char*>& memory) {
+    buffers_ = std::make_unique<FrameBuffer[]>(count_);
+    free_.reserve(count_);
+    for (std::size_t i = 0; i < count_; ++i) {
+        buffers_[i].pool_ = this;
+        buffers_[i].layout_ = &layout_;
+        buffers_[i].data_ = memory[i];
+        buffers_[i].index_ = static_cast<uint32_t>(i);
+        // Handed out lowest index first
+        free_.push_back(static_cast<uint32_t>(count_ - 1 - i));
+    }
+}
+
+FrameRef FramePool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (free_.empty()) return FrameRef();
+
+    FrameBuffer& buffer = buffers_[free_.back()];
+    free_.pop_back();
+    buffer.ref_count_.store(1, std::memory_order_relaxed);
+    return FrameRef(&buffer);
+}
+
+std::size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return free_.size();
+}
+
+void FramePool::give_back(FrameBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(buffer->index_);
+}
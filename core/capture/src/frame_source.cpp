@@ -0,0 +1,106 @@
+#include "frame_source.hpp"
+
+#include <stdexcept>
+
+#include "frame_source_raw_file.hpp"
+#include "frame_source_test_pattern.hpp"
+
+#ifdef CAPTURE_XSHM
+#include "frame_source_xshm.hpp"
+#endif
+
+namespace {
+
+constexpr int MAX_DIMENSION = 16384;  // pixels
+
+void parse_size(const std::string& value, int& width, int& height) {
+    const std::size_t separator = value.find('x');
+    std::size_t width_end = 0;
+    std::size_t height_end = 0;
+    try {
+        if (separator == std::string::npos) throw std::invalid_argument("");
+        width = std::stoi(value.substr(0, separator), &width_end);
+        height = std::stoi(value.substr(separator + 1), &height_end);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid value for --capture-size");
+    }
+    if (width_end != separator ||
+        height_end != value.size() - separator - 1 || width <= 0 ||
+        height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) {
+        throw std::invalid_argument("Invalid value for --capture-size");
+    }
+}
+
+}  // namespace
+
+CaptureSettings CaptureSettings::from_options(
+    const std::unordered_map<std::string, std::string>& options) {
+    CaptureSettings settings;
+
+    if (const auto it = options.find("capture-file"); it != options.end()) {
+        settings.backend = CaptureBackend::RAW_FILE;
+        settings.path = it->second;
+    }
+    if (const auto it = options.find("capture"); it != options.end()) {
+        if (it->second == "native") {
+            settings.backend = CaptureBackend::NATIVE;
+        } else if (it->second == "test") {
+            settings.backend = CaptureBackend::TEST_PATTERN;
+        } else if (it->second == "file") {
+            settings.backend = CaptureBackend::RAW_FILE;
+        } else {
+            throw std::invalid_argument("Invalid capture backend");
+        }
+    }
+    if (settings.backend == CaptureBackend::RAW_FILE && settings.path.empty()) {
+        throw std::invalid_argument("--capture file needs --capture-file");
+    }
+
+    if (const auto it = options.find("capture-size"); it != options.end()) {
+        parse_size(it->second, settings.width, settings.height);
+    }
+    if (const auto it = options.find("capture-format"); it != options.end()) {
+        if (it->second == "bgra") {
+            settings.format = PixelFormat::BGRA;
+        } else if (it->second == "i420") {
+            settings.format = PixelFormat::I420;
+        } else {
+            throw std::invalid_argument("Invalid capture format");
+        }
+    }
+    if (const auto it = options.find("display"); it != options.end()) {
+        settings.display = it->second;
+    }
+    if (const auto it = options.find("window"); it != options.end()) {
+        std::size_t end = 0;
+        try {
+            // Decimal or 0x-prefixed hexadecimal, as xwininfo prints it
+            settings.window = std::stoul(it->second, &end, 0);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != it->second.size()) {
+            throw std::invalid_argument("Invalid value for --window");
+        }
+    }
+    return settings;
+}
+
+std::unique_ptr<FrameSource> FrameSource::create(
+    const CaptureSettings& settings) {
+    switch (settings.backend) {
+        case CaptureBackend::TEST_PATTERN:
+            return std::make_unique<FrameSourceTestPattern>(settings);
+        case CaptureBackend::RAW_FILE:
+            return std::make_unique<FrameSourceRawFile>(settings);
+        case CaptureBackend::NATIVE:
+            break;
+    }
+
+#ifdef CAPTURE_XSHM
+    return std::make_unique<FrameSourceXShm>(settings);
+#else
+    // Windows and macOS implementations are not written yet
+    throw std::runtime_error("No native frame capture for this platform");
+#endif
+}
@@ -0,0 +1,60 @@
+#include "frame_source_raw_file.hpp"
+
+#include <stdexcept>
+
+FrameSourceRawFile::FrameSourceRawFile(const CaptureSettings& settings)
+    : pool_(FrameLayout::aligned(settings.format, settings.width,
+                                 settings.height),
+            settings.pool_size),
+      file_(settings.path, std::ios::binary),
+      sequence_(0) {
+    if (!file_) {
+        throw std::runtime_error("Cannot open raw video file: " +
+                                 settings.path);
+    }
+
+    const FrameLayout& layout = pool_.layout();
+    const std::size_t pixels =
+        static_cast<std::size_t>(layout.width) * layout.height;
+    packed_size_ =
+        layout.format == PixelFormat::BGRA ? pixels * 4 : pixels * 3 / 2;
+
+    file_.seekg(0, std::ios::end);
+    frames_ = static_cast<uint64_t>(file_.tellg()) / packed_size_;
+    file_.seekg(0, std::ios::beg);
+    if (frames_ == 0) {
+        throw std::runtime_error("Raw video file holds no whole frame: " +
+                                 settings.path);
+    }
+}
+
+FrameRef FrameSourceRawFile::capture() {
+    FrameRef frame = pool_.acquire();
+    if (!frame) return frame;
+
+    if (sequence_ % frames_ == 0) file_.seekg(0, std::ios::beg);
+
+    // Rows are packed in the file and padded to the stride in frames
+    const FrameLayout& layout = frame->layout();
+    for (int plane = 0; plane < layout.planes(); ++plane) {
+        const int rows = plane == 0 ? layout.height : layout.height / 2;
+        const std::size_t row_size =
+            plane == 0 ? (layout.format == PixelFormat::BGRA
+                              ? static_cast<std::size_t>(layout.width) * 4
+                              : static_cast<std::size_t>(layout.width))
+                       : static_cast<std::size_t>(layout.width) / 2;
+        const int stride = layout.plane_stride(plane);
+        unsigned char* data = frame->plane(plane);
+        for (int y = 0; y < rows; ++y) {
+            file_.read(reinterpret_cast<char*>(data) +
+                           static_cast<std::size_t>(y) * stride,
+                       static_cast<std::streamsize>(row_size));
+        }
+    }
+    if (!file_) {
+        throw std::runtime_error("Error reading raw video file");
+    }
+
+    frame->set_capture(FrameBuffer::Clock::now(), sequence_++);
+    return frame;
+}
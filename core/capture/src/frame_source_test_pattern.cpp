@@ -0,0 +1,166 @@
+#include "frame_source_test_pattern.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr int BAR_COUNT = 8;
+constexpr int BOX_STEP_X = 4;  // pixels per frame
+constexpr int BOX_STEP_Y = 2;
+
+// White, yellow, cyan, green, magenta, red, blue, black as BGR
+constexpr std::array<std::array<int, 3>, BAR_COUNT> BARS = {{
+    {255, 255, 255},
+    {0, 255, 255},
+    {255, 255, 0},
+    {0, 255, 0},
+    {255, 0, 255},
+    {0, 0, 255},
+    {255, 0, 0},
+    {0, 0, 0},
+}};
+
+/**
+ * @brief Convert a colour to BT.601 limited-range YUV
+ */
+std::array<unsigned char, 3> to_yuv(const std::array<int, 3>& bgr) {
+    const int b = bgr[0];
+    const int g = bgr[1];
+    const int r = bgr[2];
+    return {static_cast<unsigned char>(
+                ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16),
+            static_cast<unsigned char>(
+                ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128),
+            static_cast<unsigned char>(
+                ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128)};
+}
+
+/**
+ * @brief Position along one axis of a box bouncing between 0 and range
+ */
+int bounce(const uint64_t distance, const int range) {
+    if (range <= 0) return 0;
+    const uint64_t period = 2 * static_cast<uint64_t>(range);
+    const auto position = static_cast<int>(distance % period);
+    return position <= range ? position : static_cast<int>(period) - position;
+}
+
+}  // namespace
+
+FrameSourceTestPattern::FrameSourceTestPattern(const CaptureSettings& settings)
+    : pool_(FrameLayout::aligned(settings.format, settings.width,
+                                 settings.height),
+            settings.pool_size),
+      sequence_(0) {
+    const FrameLayout& layout = pool_.layout();
+    if (layout.format == PixelFormat::BGRA) {
+        bars_.resize(static_cast<std::size_t>(layout.width) * 4);
+        for (int x = 0; x < layout.width; ++x) {
+            const auto& bar = BARS[x * BAR_COUNT / layout.width];
+            unsigned char* pixel = &bars_[static_cast<std::size_t>(x) * 4];
+            pixel[0] = static_cast<unsigned char>(bar[0]);
+            pixel[1] = static_cast<unsigned char>(bar[1]);
+            pixel[2] = static_cast<unsigned char>(bar[2]);
+            pixel[3] = 255;
+        }
+        return;
+    }
+
+    // I420: a Y row followed by a U row and a V row of half the width
+    const int chroma_width = layout.width / 2;
+    bars_.resize(static_cast<std::size_t>(layout.width) + 2 * chroma_width);
+    for (int x = 0; x < layout.width; ++x) {
+        bars_[x] = to_yuv(BARS[x * BAR_COUNT / layout.width])[0];
+    }
+    for (int x = 0; x < chroma_width; ++x) {
+        const auto yuv = to_yuv(BARS[2 * x * BAR_COUNT / layout.width]);
+        bars_[layout.width + x] = yuv[1];
+        bars_[layout.width + chroma_width + x] = yuv[2];
+    }
+}
+
+FrameRef FrameSourceTestPattern::capture() {
+    FrameRef frame = pool_.acquire();
+    if (!frame) return frame;
+
+    if (frame->format() == PixelFormat::BGRA) {
+        draw_bgra(*frame);
+    } else {
+        draw_i420(*frame);
+    }
+    frame->set_capture(FrameBuffer::Clock::now(), sequence_++);
+    return frame;
+}
+
+void FrameSourceTestPattern::box_position(int& x, int& y) const {
+    const FrameLayout& layout = pool_.layout();
+    // Even, so the box covers whole I420 chroma samples
+    x = bounce(sequence_ * BOX_STEP_X,
+               std::max(0, layout.width - BOX_SIZE)) & ~1;
+    y = bounce(sequence_ * BOX_STEP_Y,
+               std::max(0, layout.height - BOX_SIZE)) & ~1;
+}
+
+void FrameSourceTestPattern::draw_bgra(FrameBuffer& frame) const {
+    const std::size_t row_size = bars_.size();
+    for (int y = 0; y < frame.height(); ++y) {
+        std::memcpy(frame.data() + static_cast<std::size_t>(y) * frame.stride(),
+                    bars_.data(), row_size);
+    }
+
+    int box_x = 0;
+    int box_y = 0;
+    box_position(box_x, box_y);
+    const int box_width = std::min(BOX_SIZE, frame.width() - box_x);
+    const int box_height = std::min(BOX_SIZE, frame.height() - box_y);
+    for (int y = box_y; y < box_y + box_height; ++y) {
+        unsigned char* row = frame.data() +
+                             static_cast<std::size_t>(y) * frame.stride() +
+                             static_cast<std::size_t>(box_x) * 4;
+        // Grey, which stands out against every bar
+        std::memset(row, 128, static_cast<std::size_t>(box_width) * 4);
+    }
+}
+
+void FrameSourceTestPattern::draw_i420(FrameBuffer& frame) const {
+    const int width = frame.width();
+    const int chroma_width = width / 2;
+    const FrameLayout& layout = frame.layout();
+    for (int y = 0; y < frame.height(); ++y) {
+        std::memcpy(frame.plane(0) + static_cast<std::size_t>(y) *
+                                         layout.plane_stride(0),
+                    bars_.data(), width);
+    }
+    for (int plane = 1; plane <= 2; ++plane) {
+        const unsigned char* bars =
+            bars_.data() + width + (plane - 1) * chroma_width;
+        for (int y = 0; y < frame.height() / 2; ++y) {
+            std::memcpy(frame.plane(plane) + static_cast<std::size_t>(y) *
+                                                 layout.plane_stride(plane),
+                        bars, chroma_width);
+        }
+    }
+
+    int box_x = 0;
+    int box_y = 0;
+    box_position(box_x, box_y);
+    const int box_width = std::min(BOX_SIZE, width - box_x);
+    const int box_height = std::min(BOX_SIZE, frame.height() - box_y);
+    for (int y = box_y; y < box_y + box_height; ++y) {
+        std::memset(frame.plane(0) +
+                        static_cast<std::size_t>(y) * layout.plane_stride(0) +
+                        box_x,
+                    128, box_width);
+    }
+    for (int plane = 1; plane <= 2; ++plane) {
+        for (int y = box_y / 2; y < (box_y + box_height) / 2; ++y) {
+            std::memset(frame.plane(plane) +
+                            static_cast<std::size_t>(y) *
+                                layout.plane_stride(plane) +
+                            box_x / 2,
+                        128, box_width / 2);
+        }
+    }
+}
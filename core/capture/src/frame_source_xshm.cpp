@@ -0,0 +1,172 @@
+#include "frame_source_xshm.hpp"
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+#include <stdexcept>
+
+namespace {
+
+int trapped_error = 0;
+
+int trap_error(Display* /* display */, XErrorEvent* event) {
+    trapped_error = event->error_code;
+    return 0;
+}
+
+/**
+ * @class ErrorTrap
+ * @brief Records X errors raised while in scope instead of letting the
+ * default handler exit the process
+ */
+class ErrorTrap {
+   public:
+    explicit ErrorTrap(Display* display) : display_(display) {
+        trapped_error = 0;
+        previous_ = XSetErrorHandler(trap_error);
+    }
+    ~ErrorTrap() { XSetErrorHandler(previous_); }
+
+    /**
+     * @brief Wait for the server to process every request sent so far
+     *
+     * @return true if any of them failed, false otherwise.
+     */
+    bool failed() {
+        XSync(display_, False);
+        return trapped_error != 0;
+    }
+
+   private:
+    Display* display_;
+    XErrorHandler previous_;
+};
+
+}  // namespace
+
+FrameSourceXShm::FrameSourceXShm(const CaptureSettings& settings)
+    : display_(XOpenDisplay(settings.display.empty()
+                                ? nullptr
+                                : settings.display.c_str())),
+      window_(0),
+      sequence_(0) {
+    if (display_ == nullptr) {
+        throw std::runtime_error("Cannot open X display");
+    }
+
+    try {
+        if (!XShmQueryExtension(display_)) {
+            throw std::runtime_error("X display does not support MIT-SHM");
+        }
+
+        window_ = settings.window != 0 ? settings.window
+                                       : DefaultRootWindow(display_);
+        XWindowAttributes attributes = {};
+        {
+            ErrorTrap trap(display_);
+            if (!XGetWindowAttributes(display_, window_, &attributes) ||
+                trap.failed()) {
+                throw std::runtime_error("Cannot find the window to capture");
+            }
+        }
+
+        // Little-endian 32-bit pixels with red in the third byte are BGRA
+        const Visual* visual = attributes.visual;
+        if ((attributes.depth != 24 && attributes.depth != 32) ||
+            visual->c_class != TrueColor || visual->red_mask != 0xff0000 ||
+            visual->blue_mask != 0xff) {
+            throw std::runtime_error("Window is not 24 or 32-bit TrueColor");
+        }
+
+        FrameLayout layout;
+        layout.format = PixelFormat::BGRA;
+        layout.width = attributes.width;
+        layout.height = attributes.height;
+        attach_segments(layout, settings.pool_size, attributes.visual,
+                        attributes.depth);
+    } catch (...) {
+        release();
+        throw;
+    }
+}
+
+FrameSourceXShm::~FrameSourceXShm() { release(); }
+
+void FrameSourceXShm::attach_segments(FrameLayout layout,
+                                      const std::size_t count, Visual* visual,
+                                      const int depth) {
+    std::vector<unsigned char*> memory;
+    segments_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        segments_.emplace_back();
+        Segment& segment = segments_.back();
+        segment.image =
+            XShmCreateImage(display_, visual, static_cast<unsigned>(depth),
+                            ZPixmap, nullptr, &segment.info, layout.width,
+                            layout.height);
+        if (segment.image == nullptr || segment.image->bits_per_pixel != 32) {
+            throw std::runtime_error("Cannot create a 32-bit shared image");
+        }
+
+        const std::size_t size =
+            static_cast<std::size_t>(segment.image->bytes_per_line) *
+            segment.image->height;
+        segment.info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+        if (segment.info.shmid < 0) {
+            throw std::runtime_error("Cannot create a shared memory segment");
+        }
+        void* address = shmat(segment.info.shmid, nullptr, 0);
+        // Marked for removal now, so it is freed even if we crash; it lives
+        // on until the last process detaches
+        shmctl(segment.info.shmid, IPC_RMID, nullptr);
+        if (address == reinterpret_cast<void*>(-1)) {
+            throw std::runtime_error("Cannot map a shared memory segment");
+        }
+        segment.info.shmaddr = segment.image->data =
+            static_cast<char*>(address);
+        segment.info.readOnly = False;
+
+        ErrorTrap trap(display_);
+        if (!XShmAttach(display_, &segment.info) || trap.failed()) {
+            throw std::runtime_error(
+                "X server cannot attach shared memory; is it remote?");
+        }
+        segment.attached = true;
+        memory.push_back(reinterpret_cast<unsigned char*>(address));
+    }
+
+    layout.stride = segments_.front().image->bytes_per_line;
+    pool_ = std::make_unique<FramePool>(layout, memory);
+}
+
+void FrameSourceXShm::release() {
+    pool_.reset();
+    for (Segment& segment : segments_) {
+        if (segment.attached) XShmDetach(display_, &segment.info);
+    }
+    if (!segments_.empty()) XSync(display_, False);
+    for (Segment& segment : segments_) {
+        if (segment.image != nullptr) XDestroyImage(segment.image);
+        if (segment.info.shmaddr != nullptr) shmdt(segment.info.shmaddr);
+    }
+    segments_.clear();
+    XCloseDisplay(display_);
+}
+
+FrameRef FrameSourceXShm::capture() {
+    FrameRef frame = pool_->acquire();
+    if (!frame) return frame;
+
+    // GetImage waits for the reply, so the frame is complete on return
+    const auto capture_time = FrameBuffer::Clock::now();
+    ErrorTrap trap(display_);
+    if (!XShmGetImage(display_, window_, segments_[frame->index()].image, 0,
+                      0, AllPlanes) ||
+        trapped_error != 0) {
+        throw std::runtime_error(
+            "Window capture failed; was it resized or unmapped?");
+    }
+
+    frame->set_capture(capture_time, sequence_++);
+    return frame;
+}
@@ -0,0 +1,156 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+/**
+ * @class BoundedQueue
+ * @brief Fixed-capacity lock-free queue for handing values between threads,
+ * e.g. pooled frame references between pipeline stages.
+ *
+ * Each cell carries a sequence number saying whether it is free to write or
+ * ready to read at the current lap (D. Vyukov's bounded MPMC queue), so
+ * producers and consumers only contend on their own position and a value
+ * is moved in and out exactly once. Storage is allocated up front; push and
+ * pop never allocate or block.
+ *
+ * @tparam T Default-constructible, movable value type
+ */
+template <typename T>
+class BoundedQueue {
+   public:
+    /**
+     * @brief Construct a new BoundedQueue object
+     *
+     * @param capacity Most values queued at once
+     *
+     * @throws std::invalid_argument If the capacity is 0.
+     */
+    explicit BoundedQueue(const std::size_t capacity)
+        : capacity_(capacity), push_position_(0), pop_position_(0) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive");
+        }
+        cells_ = std::make_unique<Cell[]>(capacity);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Add a value at the back
+     *
+     * @param value Value, moved from only if queued
+     * @return true if queued, false if the queue is full.
+     */
+    bool push(T&& value) {
+        std::size_t position = push_position_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position % capacity_];
+            const std::size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const auto lap = static_cast<std::ptrdiff_t>(sequence - position);
+            if (lap == 0) {
+                if (push_position_.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;  // The cell still holds last lap's value
+            } else {
+                position = push_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Add a value at the back, dropping the value at the front if
+     * the queue is full, so a slow consumer always gets the newest values.
+     * For a single producer; consumers may pop concurrently.
+     *
+     * @param value Value to queue
+     * @param dropped Receives the value dropped, if any
+     * @return true if a value was dropped to make room, false otherwise.
+     */
+    bool push_dropping_oldest(T&& value, T& dropped) {
+        bool has_dropped = false;
+        while (!push(std::move(value))) {
+            // A consumer may be between claiming a cell and releasing it,
+            // in which case room appears without dropping more
+            if (!has_dropped && pop(dropped)) {
+                has_dropped = true;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        return has_dropped;
+    }
+
+    /**
+     * @brief Take the value at the front
+     *
+     * @param value Receives the value
+     * @return true if a value was taken, false if the queue is empty.
+     */
+    bool pop(T& value) {
+        std::size_t position = pop_position_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position % capacity_];
+            const std::size_t sequence =
+                cell.sequence.load(std::memory_order_acquire);
+            const auto lap =
+                static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (lap == 0) {
+                if (pop_position_.compare_exchange_weak(
+                        position, position + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T();
+                    cell.sequence.store(position + capacity_,
+                                        std::memory_order_release);
+                    return true;
+                }
+            } else if (lap < 0) {
+                return false;  // Nothing written to the cell yet this lap
+            } else {
+                position = pop_position_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Check whether the queue is empty. Only a hint while other
+     * threads push or pop.
+     *
+     * @return true if nothing is queued, false otherwise.
+     */
+    bool empty() const {
+        return push_position_.load(std::memory_order_acquire) ==
+               pop_position_.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const { return capacity_; }
+
+   private:
+    struct alignas(64) Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t capacity_;
+    alignas(64) std::atomic<std::size_t> push_position_;
+    alignas(64) std::atomic<std::size_t> pop_position_;
+};
+
+#endif  // BOUNDED_QUEUE_HPP
@@ -2,6 +2,7 @@
 #define COMMON_HPP
 
 #include <string>
+#include <unordered_map>
 
 #include "input_messages.hpp"
 #include "stream_messages.hpp"
@@ -14,7 +15,7 @@
 namespace Common {
 
 /**
- * @brief Validates an IP address.
+ * @brief Validates an IPv4 or IPv6 address. Does not allocate.
  *
  * @param ip The IP address to validate.
  * @return true if the IP address is valid, false otherwise.
@@ -30,7 +31,7 @@ bool validate_ip(const std::string& ip);
 bool validate_port(const int port);
 
 /**
- * @brief Validates a port number given as a string.
+ * @brief Validates a port number given as a string. Does not allocate.
  *
  * @param port_str The port number as a string to validate.
  * @return true if the port number is valid, false otherwise.
@@ -38,7 +39,8 @@ bool validate_port(const int port);
 bool validate_port(const std::string& port_str);
 
 /**
- * @brief Validates a socket string in the format "IP:port".
+ * @brief Validates a socket string in the format "IP:port" or
+ * "[IPv6]:port". Does not allocate.
  *
  * @param socket_str The socket string to validate.
  * @return true if the socket string is valid, false otherwise.
@@ -47,13 +49,33 @@ bool validate_socket_string(const std::string& socket_str);
 
 /**
  * @brief Extracts the IP address and port number from a socket string.
+ * Prefer SocketAddress::parse, which keeps the address typed.
  *
- * @param socket_str The socket string in the format "IP:port".
+ * @param socket_str The socket string in the format "IP:port" or
+ * "[IPv6]:port".
  * @return A tuple containing the IP address and port number.
  */
 std::tuple<std::string, std::string> extract_ip_port(
     const std::string& socket_str);
 
+/**
+ * @brief Optional command line arguments, mapped from "name" to value.
+ * Flags without a value map to an empty string.
+ */
+using Options = std::unordered_map<std::string, std::string>;
+
+/**
+ * @brief Parses optional arguments of the form "--name value" or "--flag".
+ *
+ * @param argc Argument count
+ * @param argv Argument values
+ * @param first Index of the first optional argument
+ * @return Options The parsed options.
+ *
+ * @throws std::invalid_argument If an argument does not start with "--".
+ */
+Options parse_options(const int argc, char* argv[], const int first);
+
 }  // namespace Common
 
 #endif  // COMMON_HPP
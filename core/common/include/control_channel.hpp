@@ -0,0 +1,34 @@
+#ifndef CONTROL_CHANNEL_HPP
+#define CONTROL_CHANNEL_HPP
+
+#include <string_view>
+
+/**
+ * @namespace ControlChannel
+ * @brief Line-oriented process-control output read by the GUI.
+ *
+ * Every line written here goes to stdout and is flushed right away, since the
+ * GUI waits on it. Diagnostics must use the Logger instead, so that stdout
+ * stays machine-parseable.
+ */
+namespace ControlChannel {
+
+/**
+ * @brief Write one line to the GUI and flush it. Safe to call from any
+ * thread.
+ *
+ * @param line Line to write, without the trailing newline
+ */
+void send(std::string_view line);
+
+/**
+ * @brief Write an integer as one line to the GUI and flush it. Safe to call
+ * from any thread.
+ *
+ * @param value Value to write
+ */
+void send(const long long value);
+
+}  // namespace ControlChannel
+
+#endif  // CONTROL_CHANNEL_HPP
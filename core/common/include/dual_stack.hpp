@@ -0,0 +1,33 @@
+#ifndef DUAL_STACK_HPP
+#define DUAL_STACK_HPP
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+
+/**
+ * @namespace DualStack
+ * @brief Helpers for sockets that serve IPv4 and IPv6 peers at once.
+ *
+ * A dual-stack socket is an IPv6 socket with IPV6_V6ONLY disabled. IPv4
+ * peers show up on it as IPv4-mapped IPv6 addresses (::ffff:a.b.c.d), so
+ * endpoints compared against received ones must be converted with
+ * SocketAddress::to_endpoint(socket.local_endpoint().protocol()).
+ */
+namespace DualStack {
+
+/**
+ * @brief Open a UDP socket bound to the port on all IPv4 and IPv6
+ * addresses. Falls back to an IPv4 only socket if the host has no IPv6.
+ *
+ * @param io_context Boost ASIO context
+ * @param port Local port to bind, 0 for an ephemeral port
+ * @return boost::asio::ip::udp::socket The bound socket.
+ *
+ * @throws boost::system::system_error If the socket cannot be bound.
+ */
+boost::asio::ip::udp::socket open_socket(boost::asio::io_context& io_context,
+                                         const unsigned short port);
+
+}  // namespace DualStack
+
+#endif  // DUAL_STACK_HPP
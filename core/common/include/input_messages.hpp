@@ -2,7 +2,9 @@
 #define INPUT_MESSAGES_HPP
 
 #include <SFML/Window.hpp>
+#include <charconv>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 
 /**
@@ -43,6 +45,8 @@ inline const std::unordered_map<sf::Event::EventType, EventType>
  * @brief Represents a message containing input event information.
  */
 struct Message {
+    static constexpr std::size_t MAX_SERIALIZED_SIZE = 64;
+
     EventType type;
     int id;               // Joystick ID or key code
     int button_id;        // Can be axis or button ID
@@ -86,7 +90,33 @@ struct Message {
     }
 
     /**
-     * @brief Create a Message object from a string representation.
+     * @brief Write the string representation into a caller-owned buffer
+     * without allocating.
+     *
+     * @param buffer Destination buffer
+     * @param size Size of the destination buffer
+     * @return std::size_t Number of bytes written, 0 if the buffer is too
+     * small
+     */
+    std::size_t serialize(char* buffer, const std::size_t size) const {
+        char* const end = buffer + size;
+        char* out = buffer;
+
+        for (const int field : {static_cast<int>(type), id, button_id}) {
+            const auto result = std::to_chars(out, end, field);
+            if (result.ec != std::errc() || result.ptr == end) return 0;
+            out = result.ptr;
+            *out++ = ':';
+        }
+
+        const auto result = std::to_chars(out, end, axis_position);
+        if (result.ec != std::errc()) return 0;
+        return static_cast<std::size_t>(result.ptr - buffer);
+    }
+
+    /**
+     * @brief Create a Message object from a string representation without
+     * allocating.
      *
      * @param str String representation of the Message object.
      * @return Message The created Message object.
@@ -94,26 +124,47 @@ struct Message {
      * @throws std::invalid_argument If the input string format is invalid.
      * @throws std::out_of_range If the EventType value is out of range.
      */
-    static Message from_string(const std::string& str) {
-        std::istringstream iss(str);
-        int type_int, id, button_id, axis_position;
-        char colon;
-
-        if (!(iss >> type_int >> colon >> id >> colon >> button_id >> colon >>
-              axis_position) ||
-            colon != ':') {
+    static Message parse(std::string_view str) {
+        const char* it = str.data();
+        const char* const end = str.data() + str.size();
+        int fields[3];
+
+        for (int& field : fields) {
+            const auto result = std::from_chars(it, end, field);
+            if (result.ec != std::errc() || result.ptr == end ||
+                *result.ptr != ':') {
+                throw std::invalid_argument(
+                    "Invalid input string format for Message::parse");
+            }
+            it = result.ptr + 1;
+        }
+
+        float axis_position = 0;
+        const auto result = std::from_chars(it, end, axis_position);
+        if (result.ec != std::errc() || result.ptr != end) {
             throw std::invalid_argument(
-                "Invalid input string format for Message::from_string");
+                "Invalid input string format for Message::parse");
         }
 
-        if (type_int < KEY_PRESSED || type_int > JOYSTICK_DISCONNECTED) {
+        if (fields[0] < KEY_PRESSED || fields[0] > JOYSTICK_DISCONNECTED) {
             throw std::out_of_range(
-                "Invalid EventType value in Message::from_string");
+                "Invalid EventType value in Message::parse");
         }
 
-        EventType type = static_cast<EventType>(type_int);
-        return Message(type, id, button_id, axis_position);
+        return Message(static_cast<EventType>(fields[0]), fields[1], fields[2],
+                       axis_position);
     }
+
+    /**
+     * @brief Create a Message object from a string representation.
+     *
+     * @param str String representation of the Message object.
+     * @return Message The created Message object.
+     *
+     * @throws std::invalid_argument If the input string format is invalid.
+     * @throws std::out_of_range If the EventType value is out of range.
+     */
+    static Message from_string(const std::string& str) { return parse(str); }
 };
 
 }  // namespace InputMessages
@@ -0,0 +1,151 @@
+#ifndef INPUT_TRACE_HPP
+#define INPUT_TRACE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "input_messages.hpp"
+
+/**
+ * @namespace InputTrace
+ * @brief Compact binary traces of captured input for deterministic replay.
+ *
+ * A trace is a fixed header followed by fixed-size records in capture
+ * order. Records are stored in host byte order, so traces move between
+ * little-endian machines only.
+ */
+namespace InputTrace {
+
+constexpr char MAGIC[8] = {'R', 'P', 'T', 'R', 'A', 'C', 'E', '\0'};
+constexpr uint32_t VERSION = 1;
+constexpr std::size_t WRITE_BATCH = 256;  // records
+
+/**
+ * @struct Header
+ * @brief File header identifying a trace and its record layout.
+ */
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+};
+
+/**
+ * @struct Record
+ * @brief One captured input message with its capture time.
+ */
+struct Record {
+    uint64_t timestamp_ns;  // Monotonic, relative to the start of the trace
+    int32_t type;
+    int32_t id;
+    int32_t button_id;
+    float axis_position;
+
+    InputMessages::Message message() const {
+        return InputMessages::Message(
+            static_cast<InputMessages::EventType>(type), id, button_id,
+            axis_position);
+    }
+};
+
+static_assert(sizeof(Header) == 16, "Trace header layout changed");
+static_assert(sizeof(Record) == 24, "Trace record layout changed");
+
+}  // namespace InputTrace
+
+/**
+ * @class InputTraceWriter
+ * @brief Appends timestamped input messages to a trace file. Records are
+ * batched in memory, so recording does not allocate or hit the disk on
+ * every event. Not thread safe.
+ */
+class InputTraceWriter {
+   public:
+    /**
+     * @brief Create the trace file and write its header
+     *
+     * @param path Path of the trace file, truncated if it exists
+     *
+     * @throws std::runtime_error If the file cannot be created.
+     */
+    explicit InputTraceWriter(const std::string& path);
+
+    /**
+     * @brief Flush pending records and close the trace
+     */
+    ~InputTraceWriter();
+
+    InputTraceWriter(const InputTraceWriter&) = delete;
+    InputTraceWriter& operator=(const InputTraceWriter&) = delete;
+
+    /**
+     * @brief Record a message with the current time
+     *
+     * @param message Message to record
+     */
+    void record(const InputMessages::Message& message);
+
+    /**
+     * @brief Write pending records to the file
+     */
+    void flush();
+
+   private:
+    std::FILE* file_;
+    std::chrono::steady_clock::time_point start_;
+    std::array<InputTrace::Record, InputTrace::WRITE_BATCH> pending_;
+    std::size_t pending_count_;
+};
+
+/**
+ * @class InputTraceReader
+ * @brief Read-only view of a trace file. The file is memory-mapped where
+ * supported and read into memory elsewhere.
+ */
+class InputTraceReader {
+   public:
+    /**
+     * @brief Open and validate a trace file
+     *
+     * @param path Path of the trace file
+     *
+     * @throws std::runtime_error If the file cannot be read or is not a
+     * trace.
+     */
+    explicit InputTraceReader(const std::string& path);
+
+    /**
+     * @brief Unmap the trace
+     */
+    ~InputTraceReader();
+
+    InputTraceReader(const InputTraceReader&) = delete;
+    InputTraceReader& operator=(const InputTraceReader&) = delete;
+
+    const InputTrace::Record* begin() const { return records_; }
+    const InputTrace::Record* end() const { return records_ + size_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /**
+     * @brief Time between the first and last record
+     *
+     * @return std::chrono::nanoseconds Trace duration
+     */
+    std::chrono::nanoseconds duration() const;
+
+   private:
+    void unmap();
+
+    void* mapping_;
+    std::size_t mapping_size_;
+    std::vector<unsigned char> contents_;
+    const InputTrace::Record* records_;
+    std::size_t size_;
+};
+
+#endif  // INPUT_TRACE_HPP
@@ -0,0 +1,205 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * @namespace Logger
+ * @brief Asynchronous, rate-limited diagnostic logger.
+ *
+ * Log statements format into a fixed-size record on the stack and push it
+ * into a ring buffer owned by the calling thread; no lock is taken and
+ * nothing is flushed on the hot path. A background thread drains all rings
+ * and writes to stderr. Every call site is rate limited on its own, so a
+ * flood of stray packets cannot stall the io thread. Diagnostics never go
+ * to stdout, which is reserved for the ControlChannel.
+ *
+ * LOG_DEBUG statements compile to nothing unless LOG_ENABLE_DEBUG is
+ * defined.
+ */
+namespace Logger {
+
+/**
+ * @enum Level
+ * @brief Enumerates the log levels, in increasing severity.
+ */
+enum Level { LEVEL_DEBUG = 0, LEVEL_INFO, LEVEL_WARNING, LEVEL_ERROR };
+
+constexpr std::size_t RECORD_SIZE = 256;      // bytes, longer text is cut
+constexpr std::size_t RING_CAPACITY = 256;    // records per thread
+constexpr uint32_t RATE_LIMIT_PER_SECOND = 10;
+constexpr uint32_t RATE_LIMIT_BURST = 20;
+
+/**
+ * @struct Record
+ * @brief A single formatted log line.
+ */
+struct Record {
+    int64_t time_us;  // steady clock, microseconds
+    Level level;
+    uint16_t length;
+    std::array<char, RECORD_SIZE> text;
+};
+
+/**
+ * @brief Set the minimum level that is logged.
+ *
+ * @param level Minimum level
+ */
+void set_level(const Level level);
+
+/**
+ * @brief Check whether a level is currently logged.
+ *
+ * @param level Level to check
+ * @return true if records of this level are logged, false otherwise
+ */
+bool enabled(const Level level);
+
+/**
+ * @brief Get the current steady clock time.
+ *
+ * @return int64_t Microseconds since an unspecified epoch
+ */
+int64_t now_us();
+
+/**
+ * @brief Queue a formatted record for the background writer.
+ *
+ * @param record Record to queue
+ */
+void submit(const Record& record);
+
+/**
+ * @brief Block until every queued record has been written.
+ */
+void flush();
+
+/**
+ * @class RateLimiter
+ * @brief Token bucket guarding a single log call site.
+ */
+class RateLimiter {
+   public:
+    /**
+     * @brief Try to take a token.
+     *
+     * @return true if the statement may log, false if it is suppressed
+     */
+    bool allow();
+
+    /**
+     * @brief Get and reset the number of suppressed statements.
+     *
+     * @return uint32_t Statements suppressed since the last call
+     */
+    uint32_t take_suppressed() {
+        return suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<int64_t> last_refill_{0};  // steady clock, milliseconds
+    std::atomic<uint32_t> tokens_{RATE_LIMIT_BURST};
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+/**
+ * @class RecordWriter
+ * @brief Appends values to a Record without allocating for common types.
+ */
+class RecordWriter {
+   public:
+    explicit RecordWriter(Record& record) : record_(record) {
+        record_.length = 0;
+    }
+
+    void append(std::string_view text) {
+        const std::size_t room = RECORD_SIZE - record_.length;
+        const std::size_t size = text.size() < room ? text.size() : room;
+        text.copy(record_.text.data() + record_.length, size);
+        record_.length = static_cast<uint16_t>(record_.length + size);
+    }
+
+    void append(const char* text) { append(std::string_view(text)); }
+    void append(const std::string& text) { append(std::string_view(text)); }
+    void append(char* text) { append(std::string_view(text)); }
+    void append(const char c) { append(std::string_view(&c, 1)); }
+    void append(const bool value) { append(value ? "true" : "false"); }
+
+    template <typename T>
+    void append(const T& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            char* begin = record_.text.data() + record_.length;
+            char* end = record_.text.data() + RECORD_SIZE;
+            const auto result = std::to_chars(begin, end, value);
+            if (result.ec == std::errc()) {
+                record_.length = static_cast<uint16_t>(
+                    result.ptr - record_.text.data());
+            }
+        } else if constexpr (std::is_enum_v<T>) {
+            append(static_cast<std::underlying_type_t<T>>(value));
+        } else {
+            // Slow path for types that only know how to stream themselves
+            std::ostringstream oss;
+            oss << value;
+            append(oss.str());
+        }
+    }
+
+   private:
+    Record& record_;
+};
+
+/**
+ * @brief Format the arguments into a record and queue it.
+ *
+ * @param level Record level
+ * @param suppressed Statements suppressed at this call site before this one
+ * @param args Values to concatenate
+ */
+template <typename... Args>
+void log(const Level level, const uint32_t suppressed, const Args&... args) {
+    Record record;
+    record.time_us = now_us();
+    record.level = level;
+    RecordWriter writer(record);
+    (writer.append(args), ...);
+    if (suppressed > 0) {
+        writer.append(" (");
+        writer.append(suppressed);
+        writer.append(" similar messages suppressed)");
+    }
+    submit(record);
+}
+
+}  // namespace Logger
+
+#define LOG_AT_LEVEL(level, ...)                                          \
+    do {                                                                  \
+        static Logger::RateLimiter log_rate_limiter;                      \
+        if (Logger::enabled(level) && log_rate_limiter.allow()) {         \
+            Logger::log(level, log_rate_limiter.take_suppressed(),        \
+                        __VA_ARGS__);                                     \
+        }                                                                 \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT_LEVEL(Logger::LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT_LEVEL(Logger::LEVEL_WARNING, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT_LEVEL(Logger::LEVEL_INFO, __VA_ARGS__)
+
+#ifdef LOG_ENABLE_DEBUG
+#define LOG_DEBUG(...) LOG_AT_LEVEL(Logger::LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) \
+    do {               \
+    } while (0)
+#endif
+
+#endif  // LOGGER_HPP
@@ -0,0 +1,214 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @namespace Metrics
+ * @brief Low-overhead counters, gauges and histograms with a periodic JSON
+ * exporter.
+ *
+ * Metrics are registered once by name and then updated through references.
+ * Counters and histograms are sharded per thread, so an update is a single
+ * uncontended relaxed atomic add; shards are only summed when a snapshot is
+ * taken.
+ */
+namespace Metrics {
+
+constexpr std::size_t SHARD_COUNT = 8;
+constexpr std::size_t HISTOGRAM_BUCKETS = 64;  // One per power of two
+
+/**
+ * @brief Get the shard used by the calling thread.
+ *
+ * @return std::size_t Shard index
+ */
+std::size_t this_thread_shard();
+
+/**
+ * @class Counter
+ * @brief Monotonic counter.
+ */
+class Counter {
+   public:
+    void add(const uint64_t value = 1) {
+        shards_[this_thread_shard()].value.fetch_add(
+            value, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+   private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+/**
+ * @class Gauge
+ * @brief Value that can go up and down, such as a queue depth.
+ */
+class Gauge {
+   public:
+    void set(const int64_t value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    void add(const int64_t value) {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @struct HistogramSnapshot
+ * @brief Aggregated view of a histogram. Percentiles are bucket upper bounds.
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * @class Histogram
+ * @brief Histogram with power-of-two buckets, for latencies and sizes.
+ */
+class Histogram {
+   public:
+    void record(const uint64_t value);
+    HistogramSnapshot snapshot() const;
+
+   private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> max{0};
+    };
+
+    std::array<Shard, SHARD_COUNT> shards_;
+};
+
+/**
+ * @brief Get or create a counter. Not meant for the hot path; keep the
+ * returned reference.
+ *
+ * @param name Metric name
+ * @return Counter& Counter registered under the name
+ */
+Counter& counter(std::string_view name);
+
+/**
+ * @brief Get or create a gauge. Not meant for the hot path; keep the
+ * returned reference.
+ *
+ * @param name Metric name
+ * @return Gauge& Gauge registered under the name
+ */
+Gauge& gauge(std::string_view name);
+
+/**
+ * @brief Get or create a histogram. Not meant for the hot path; keep the
+ * returned reference.
+ *
+ * @param name Metric name
+ * @return Histogram& Histogram registered under the name
+ */
+Histogram& histogram(std::string_view name);
+
+/**
+ * @brief Render every registered metric as one line of JSON.
+ *
+ * @return std::string JSON object without a trailing newline
+ */
+std::string snapshot_json();
+
+/**
+ * @struct ChannelCounters
+ * @brief Packet and byte counters for one traffic channel.
+ */
+struct ChannelCounters {
+    explicit ChannelCounters(std::string_view channel);
+
+    void received(const std::size_t bytes) {
+        packets_in.add();
+        bytes_in.add(bytes);
+    }
+    void sent(const std::size_t bytes) {
+        packets_out.add();
+        bytes_out.add(bytes);
+    }
+
+    Counter& packets_in;
+    Counter& bytes_in;
+    Counter& packets_out;
+    Counter& bytes_out;
+};
+
+/**
+ * @struct DropCounters
+ * @brief Counters for datagrams rejected by validation, by reason.
+ */
+struct DropCounters {
+    DropCounters();
+
+    Counter& unknown_endpoint;
+    Counter& bad_size;
+    Counter& parse_error;
+};
+
+/**
+ * @class StatsExporter
+ * @brief Background thread that emits a metrics snapshot at a fixed
+ * interval.
+ *
+ * Snapshots go to stderr as single JSON lines, or as datagrams to a local
+ * unix socket when a path is given. Stdout is left to the ControlChannel.
+ */
+class StatsExporter {
+   public:
+    /**
+     * @brief Construct a new StatsExporter object and start exporting
+     *
+     * @param interval Time between snapshots
+     * @param socket_path Unix datagram socket to send to (default: stderr)
+     */
+    explicit StatsExporter(const std::chrono::milliseconds interval,
+                           const std::string& socket_path = "");
+
+    /**
+     * @brief Stop exporting after one final snapshot
+     */
+    ~StatsExporter();
+
+   private:
+    void run();
+    void emit(const std::string& line);
+
+    std::chrono::milliseconds interval_;
+    std::string socket_path_;
+    int socket_fd_;
+    std::mutex mutex_;
+    bool stopping_;
+    std::condition_variable wake_;
+    std::thread thread_;
+};
+
+}  // namespace Metrics
+
+#endif  // METRICS_HPP
@@ -0,0 +1,67 @@
+#ifndef PING_MESSAGES_HPP
+#define PING_MESSAGES_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @namespace PingMessages
+ * @brief Keepalive exchange between UdpClient and UDPServer.
+ *
+ * The pong carries the server's receive and send times of the ping
+ * (CLOCK_REALTIME nanoseconds, big-endian), so the client can take the
+ * server's own delay out of the round trip and follow the one-way delays.
+ */
+namespace PingMessages {
+
+constexpr std::string_view PING = "ping";
+constexpr std::string_view PONG = "pong";
+constexpr std::size_t PONG_SIZE = 20;  // "pong", receive time, send time
+
+/**
+ * @brief Write a pong
+ *
+ * @param receive_ns When the ping was received
+ * @param send_ns When the pong is sent
+ * @param buffer Destination of at least PONG_SIZE bytes
+ */
+inline void write_pong(const int64_t receive_ns, const int64_t send_ns,
+                       unsigned char* buffer) {
+    std::memcpy(buffer, PONG.data(), PONG.size());
+    for (int i = 0; i < 8; ++i) {
+        buffer[4 + i] = static_cast<unsigned char>(
+            static_cast<uint64_t>(receive_ns) >> (56 - 8 * i));
+        buffer[12 + i] = static_cast<unsigned char>(
+            static_cast<uint64_t>(send_ns) >> (56 - 8 * i));
+    }
+}
+
+/**
+ * @brief Read a pong. Does not allocate.
+ *
+ * @param message Received message
+ * @param receive_ns Receives when the server received the ping
+ * @param send_ns Receives when the server sent the pong
+ * @return true if the message is a pong, false otherwise.
+ */
+inline bool read_pong(std::string_view message, int64_t& receive_ns,
+                      int64_t& send_ns) {
+    if (message.size() != PONG_SIZE || message.substr(0, 4) != PONG) {
+        return false;
+    }
+
+    uint64_t receive = 0;
+    uint64_t send = 0;
+    for (int i = 0; i < 8; ++i) {
+        receive = receive << 8 | static_cast<unsigned char>(message[4 + i]);
+        send = send << 8 | static_cast<unsigned char>(message[12 + i]);
+    }
+    receive_ns = static_cast<int64_t>(receive);
+    send_ns = static_cast<int64_t>(send);
+    return true;
+}
+
+}  // namespace PingMessages
+
+#endif  // PING_MESSAGES_HPP
@@ -0,0 +1,241 @@
+#ifndef SOCKET_ADDRESS_HPP
+#define SOCKET_ADDRESS_HPP
+
+#include <array>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class SocketAddress
+ * @brief IPv4 or IPv6 address with a port, parsed from and formatted to
+ * text without allocating.
+ *
+ * Accepted forms are "a.b.c.d:port" and "[v6]:port", where v6 is any RFC
+ * 4291 text form, including "::" compression and an embedded IPv4 tail.
+ * Zone identifiers are not supported.
+ */
+class SocketAddress {
+   public:
+    enum Family : uint8_t { IPV4, IPV6 };
+
+    // "[ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255]:65535" fits
+    static constexpr std::size_t MAX_STRING_SIZE = 56;
+
+    using V4Bytes = std::array<uint8_t, 4>;
+    using V6Bytes = std::array<uint8_t, 16>;
+
+    /**
+     * @brief Construct the IPv4 any address with port 0
+     */
+    SocketAddress() = default;
+
+    /**
+     * @brief Construct an IPv4 socket address
+     *
+     * @param address Address in network byte order
+     * @param port Port number
+     */
+    SocketAddress(const V4Bytes& address, const uint16_t port);
+
+    /**
+     * @brief Construct an IPv6 socket address
+     *
+     * @param address Address in network byte order
+     * @param port Port number
+     */
+    SocketAddress(const V6Bytes& address, const uint16_t port);
+
+    /**
+     * @brief Parse "IP:port" or "[IPv6]:port" without allocating
+     *
+     * @param text Text to parse
+     * @param address Receives the parsed address on success
+     * @return true if the text is a valid socket address, false otherwise.
+     */
+    static bool try_parse(std::string_view text, SocketAddress& address);
+
+    /**
+     * @brief Parse a bare IPv4 or IPv6 address without allocating
+     *
+     * @param text Text to parse, without brackets or port
+     * @param port Port of the resulting socket address
+     * @param address Receives the parsed address on success
+     * @return true if the text is a valid IP address, false otherwise.
+     */
+    static bool try_parse_ip(std::string_view text, const uint16_t port,
+                             SocketAddress& address);
+
+    /**
+     * @brief Parse a decimal port number without allocating
+     *
+     * @param text Text to parse
+     * @param port Receives the parsed port on success
+     * @return true if the text is a port in [0, 65535], false otherwise.
+     */
+    static bool try_parse_port(std::string_view text, uint16_t& port);
+
+    /**
+     * @brief Parse "IP:port" or "[IPv6]:port"
+     *
+     * @param text Text to parse
+     * @return SocketAddress The parsed address.
+     *
+     * @throws std::invalid_argument If the text is not a socket address.
+     */
+    static SocketAddress parse(std::string_view text);
+
+    /**
+     * @brief Convert an asio endpoint. IPv4-mapped IPv6 addresses, as seen on
+     * dual-stack sockets, are converted back to IPv4.
+     *
+     * @param endpoint Endpoint to convert
+     * @return SocketAddress The same address and port.
+     */
+    static SocketAddress from_endpoint(
+        const boost::asio::ip::udp::endpoint& endpoint);
+
+    /**
+     * @brief Get an endpoint for a host and port, usable on a socket of the
+     * given protocol (see to_endpoint). Numeric hosts are converted
+     * directly; only names go through a synchronous resolver.
+     *
+     * @param io_context Boost ASIO context used for name resolution
+     * @param host Name or IP address
+     * @param port Port number
+     * @param protocol Protocol of the socket the endpoint will be used with
+     * @return boost::asio::ip::udp::endpoint The first usable endpoint.
+     *
+     * @throws boost::system::system_error If the host cannot be resolved to
+     * an address usable with the protocol.
+     */
+    static boost::asio::ip::udp::endpoint resolve(
+        boost::asio::io_context& io_context, const std::string& host,
+        const std::string& port, const boost::asio::ip::udp& protocol);
+
+    /**
+     * @brief Get the address of a host and port. Numeric hosts are parsed
+     * directly; names go through a synchronous resolver and take its first
+     * answer (RFC 6724 order).
+     *
+     * @param io_context Boost ASIO context used for name resolution
+     * @param host Name or IP address
+     * @param port Port number
+     * @return SocketAddress The address.
+     *
+     * @throws boost::system::system_error If the host cannot be resolved.
+     */
+    static SocketAddress resolve_address(boost::asio::io_context& io_context,
+                                         const std::string& host,
+                                         const std::string& port);
+
+    /**
+     * @brief Get all endpoints for a host and port usable on a socket of the
+     * given protocol, in resolver preference order (RFC 6724).
+     *
+     * @param io_context Boost ASIO context used for name resolution
+     * @param host Name or IP address
+     * @param port Port number
+     * @param protocol Protocol of the socket the endpoints will be used with
+     * @return std::vector<boost::asio::ip::udp::endpoint> Usable endpoints,
+     * empty if there are none.
+     *
+     * @throws boost::system::system_error If a name cannot be resolved.
+     */
+    static std::vector<boost::asio::ip::udp::endpoint> resolve_all(
+        boost::asio::io_context& io_context, const std::string& host,
+        const std::string& port, const boost::asio::ip::udp& protocol);
+
+    Family family() const { return family_; }
+    bool is_v4() const { return family_ == IPV4; }
+    bool is_v6() const { return family_ == IPV6; }
+    uint16_t port() const { return port_; }
+
+    /**
+     * @brief Get the address bytes in network byte order. IPv4 addresses
+     * use the first four bytes.
+     *
+     * @return const V6Bytes& Address bytes
+     */
+    const V6Bytes& bytes() const { return bytes_; }
+
+    /**
+     * @brief Convert to an asio endpoint
+     *
+     * @return boost::asio::ip::udp::endpoint The same address and port.
+     */
+    boost::asio::ip::udp::endpoint to_endpoint() const;
+
+    /**
+     * @brief Convert to an asio endpoint for a socket of the given protocol.
+     * IPv4 addresses are IPv4-mapped for IPv6 (dual-stack) sockets.
+     *
+     * @param protocol Protocol of the socket the endpoint will be used with
+     * @return boost::asio::ip::udp::endpoint The converted endpoint.
+     */
+    boost::asio::ip::udp::endpoint to_endpoint(
+        const boost::asio::ip::udp& protocol) const;
+
+    /**
+     * @brief Convert to an asio endpoint for a socket of the given protocol,
+     * failing like resolve does if the socket cannot reach the address
+     *
+     * @param protocol Protocol of the socket the endpoint will be used with
+     * @return boost::asio::ip::udp::endpoint The converted endpoint.
+     *
+     * @throws boost::system::system_error If the address is IPv6 and the
+     * socket IPv4.
+     */
+    boost::asio::ip::udp::endpoint endpoint_for(
+        const boost::asio::ip::udp& protocol) const;
+
+    /**
+     * @brief Check whether the address can be reached through a socket of
+     * the given protocol. IPv6 addresses need an IPv6 socket.
+     *
+     * @param protocol Socket protocol
+     * @return true if to_endpoint(protocol) is usable, false otherwise.
+     */
+    bool usable_with(const boost::asio::ip::udp& protocol) const {
+        return is_v4() || protocol == boost::asio::ip::udp::v6();
+    }
+
+    /**
+     * @brief Write the address without the port, IPv6 in RFC 5952 form
+     *
+     * @param buffer Destination buffer
+     * @param size Size of the destination buffer
+     * @return std::size_t Bytes written, 0 if the buffer is too small
+     */
+    std::size_t format_ip(char* buffer, const std::size_t size) const;
+
+    /**
+     * @brief Write "IP:port", or "[IPv6]:port"
+     *
+     * @param buffer Destination buffer
+     * @param size Size of the destination buffer
+     * @return std::size_t Bytes written, 0 if the buffer is too small
+     */
+    std::size_t format(char* buffer, const std::size_t size) const;
+
+    std::string ip_string() const;
+    std::string to_string() const;
+
+    bool operator==(const SocketAddress& other) const {
+        return family_ == other.family_ && port_ == other.port_ &&
+               bytes_ == other.bytes_;
+    }
+    bool operator!=(const SocketAddress& other) const {
+        return !(*this == other);
+    }
+
+   private:
+    V6Bytes bytes_ = {};
+    uint16_t port_ = 0;
+    Family family_ = IPV4;
+};
+
+#endif  // SOCKET_ADDRESS_HPP
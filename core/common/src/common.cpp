@@ -1,60 +1,53 @@
 #include "common.hpp"
 
-#include <regex>
+#include "socket_address.hpp"
 
 namespace Common {
 
 bool validate_ip(const std::string& ip) {
-    std::regex pattern(R"(^(?:\d{1,3}\.){3}\d{1,3}$)");
-    if (!std::regex_match(ip, pattern)) {
-        return false;
-    }
-
-    std::stringstream ss(ip);
-    std::string segment;
-    while (std::getline(ss, segment, '.')) {
-        int num = std::stoi(segment);
-        if (num < 0 || num > 255) {
-            return false;
-        }
-    }
-    return true;
+    SocketAddress address;
+    return SocketAddress::try_parse_ip(ip, 0, address);
 }
 
 bool validate_port(const int port) { return port >= 0 && port <= 65535; }
 
 bool validate_port(const std::string& port_str) {
-    try {
-        return validate_port(std::stoi(port_str));
-    } catch (const std::invalid_argument& e) {
-        return false;
-    } catch (const std::out_of_range& e) {
-        return false;
-    }
+    uint16_t port = 0;
+    return SocketAddress::try_parse_port(port_str, port);
 }
 
 bool validate_socket_string(const std::string& socket_str) {
-    std::regex pattern(R"(^(?:\d{1,3}\.){3}\d{1,3}:\d{1,5}$)");
-    if (!std::regex_match(socket_str, pattern)) {
-        return false;
-    }
+    SocketAddress address;
+    return SocketAddress::try_parse(socket_str, address);
+}
 
-    auto [ip, port] = extract_ip_port(socket_str);
-    if (!validate_ip(ip) || !validate_port(port)) {
-        return false;
+std::tuple<std::string, std::string> extract_ip_port(
+    const std::string& socket_str) {
+    SocketAddress address;
+    if (SocketAddress::try_parse(socket_str, address)) {
+        return std::make_tuple(address.ip_string(),
+                               std::to_string(address.port()));
     }
 
-    return true;
+    const std::size_t colon = socket_str.rfind(':');
+    if (colon == std::string::npos) return std::make_tuple(socket_str, "");
+    return std::make_tuple(socket_str.substr(0, colon),
+                           socket_str.substr(colon + 1));
 }
 
-std::tuple<std::string, std::string> extract_ip_port(
-    const std::string& socket_str) {
-    std::string ip;
-    std::string port;
-    std::stringstream ss(socket_str);
-    std::getline(ss, ip, ':');
-    ss >> port;
-    return std::make_tuple(ip, port);
+Options parse_options(const int argc, char* argv[], const int first) {
+    Options options;
+    for (int i = first; i < argc; ++i) {
+        const std::string name = argv[i];
+        if (name.rfind("--", 0) != 0) {
+            throw std::invalid_argument("Invalid option: " + name);
+        }
+
+        const bool has_value = i + 1 < argc &&
+                               std::string(argv[i + 1]).rfind("--", 0) != 0;
+        options[name.substr(2)] = has_value ? argv[++i] : "";
+    }
+    return options;
 }
 
 }  // namespace Common
@@ -0,0 +1,29 @@
+#include "control_channel.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <mutex>
+
+namespace ControlChannel {
+
+namespace {
+
+std::mutex output_mutex;
+
+}  // namespace
+
+void send(std::string_view line) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+    std::cout.put('\n');
+    std::cout.flush();
+}
+
+void send(const long long value) {
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    send(std::string_view(buffer,
+                          static_cast<std::size_t>(result.ptr - buffer)));
+}
+
+}  // namespace ControlChannel
@@ -0,0 +1,30 @@
+#include "dual_stack.hpp"
+
+#include <boost/asio/ip/v6_only.hpp>
+
+#include "logger.hpp"
+
+using boost::asio::ip::udp;
+
+namespace DualStack {
+
+udp::socket open_socket(boost::asio::io_context& io_context,
+                        const unsigned short port) {
+    udp::socket socket(io_context);
+
+    boost::system::error_code ec;
+    socket.open(udp::v6(), ec);
+    if (!ec) socket.set_option(boost::asio::ip::v6_only(false), ec);
+    if (!ec) {
+        socket.bind(udp::endpoint(udp::v6(), port));
+        return socket;
+    }
+
+    LOG_INFO("IPv6 unavailable (", ec.message(), "), using IPv4 only.");
+    if (socket.is_open()) socket.close();
+    socket.open(udp::v4());
+    socket.bind(udp::endpoint(udp::v4(), port));
+    return socket;
+}
+
+}  // namespace DualStack
@@ -0,0 +1,131 @@
+#include "input_trace.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "logger.hpp"
+
+using namespace InputTrace;
+
+InputTraceWriter::InputTraceWriter(const std::string& path)
+    : file_(std::fopen(path.c_str(), "wb")),
+      start_(std::chrono::steady_clock::now()),
+      pending_count_(0) {
+    if (file_ == nullptr) {
+        throw std::runtime_error("Failed to create trace file: " + path);
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.record_size = sizeof(Record);
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+        std::fclose(file_);
+        throw std::runtime_error("Failed to write trace header: " + path);
+    }
+}
+
+InputTraceWriter::~InputTraceWriter() {
+    flush();
+    std::fclose(file_);
+}
+
+void InputTraceWriter::record(const InputMessages::Message& message) {
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+
+    Record& record = pending_[pending_count_++];
+    record.timestamp_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    record.type = static_cast<int32_t>(message.type);
+    record.id = message.id;
+    record.button_id = message.button_id;
+    record.axis_position = message.axis_position;
+
+    if (pending_count_ == pending_.size()) flush();
+}
+
+void InputTraceWriter::flush() {
+    if (pending_count_ != 0 &&
+        std::fwrite(pending_.data(), sizeof(Record), pending_count_, file_) !=
+            pending_count_) {
+        LOG_ERROR("Failed to write input trace records.");
+    }
+    pending_count_ = 0;
+    std::fflush(file_);
+}
+
+InputTraceReader::InputTraceReader(const std::string& path)
+    : mapping_(nullptr), mapping_size_(0), records_(nullptr), size_(0) {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Failed to open trace: " + path);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat trace: " + path);
+    }
+
+    size = static_cast<std::size_t>(info.st_size);
+    if (size != 0) {
+        mapping_ = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            close(fd);
+            throw std::runtime_error("Failed to map trace: " + path);
+        }
+        mapping_size_ = size;
+        data = static_cast<const unsigned char*>(mapping_);
+    }
+    close(fd);
+#else
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open trace: " + path);
+    contents_.assign(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+    data = contents_.data();
+    size = contents_.size();
+#endif
+
+    Header header = {};
+    if (size < sizeof(header)) {
+        unmap();
+        throw std::runtime_error("Trace is truncated: " + path);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version != VERSION || header.record_size != sizeof(Record)) {
+        unmap();
+        throw std::runtime_error("Not a supported input trace: " + path);
+    }
+
+    // A trailing partial record is left over from an interrupted capture
+    records_ = reinterpret_cast<const Record*>(data + sizeof(header));
+    size_ = (size - sizeof(header)) / sizeof(Record);
+}
+
+InputTraceReader::~InputTraceReader() { unmap(); }
+
+void InputTraceReader::unmap() {
+#ifndef _WIN32
+    if (mapping_ != nullptr) munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+#endif
+}
+
+std::chrono::nanoseconds InputTraceReader::duration() const {
+    if (empty()) return std::chrono::nanoseconds(0);
+    return std::chrono::nanoseconds(records_[size_ - 1].timestamp_ns -
+                                    records_[0].timestamp_ns);
+}
@@ -0,0 +1,216 @@
+#include "logger.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Logger {
+
+namespace {
+
+constexpr auto WRITE_INTERVAL = std::chrono::milliseconds(10);
+
+constexpr const char* level_name(const Level level) {
+    switch (level) {
+        case LEVEL_DEBUG:
+            return "DEBUG";
+        case LEVEL_INFO:
+            return "INFO";
+        case LEVEL_WARNING:
+            return "WARNING";
+        case LEVEL_ERROR:
+            return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+std::atomic<int> min_level = LEVEL_INFO;
+const int64_t process_start_us = now_us();
+
+/**
+ * @brief Single-producer, single-consumer ring owned by one thread.
+ */
+struct ThreadRing {
+    std::array<Record, RING_CAPACITY> records;
+    std::atomic<std::size_t> head{0};  // Next record to write out
+    std::atomic<std::size_t> tail{0};  // Next free slot
+    std::atomic<uint32_t> dropped{0};
+    std::atomic<bool> retired{false};
+};
+
+/**
+ * @brief Owns the per-thread rings and the background writer thread.
+ */
+class Writer {
+   public:
+    static Writer& instance() {
+        static Writer writer;
+        return writer;
+    }
+
+    void add(const std::shared_ptr<ThreadRing>& ring) {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+
+        // Copied into a vector kept across drains, so the writer does not
+        // allocate once the set of threads settles
+        {
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            draining_ = rings_;
+        }
+
+        bool wrote = false;
+        for (const auto& ring : draining_) wrote |= drain_ring(*ring);
+        if (wrote) std::fflush(stderr);
+        draining_.clear();
+
+        // Forget rings whose thread has exited once they are empty
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();) {
+            const bool empty = (*it)->head.load(std::memory_order_acquire) ==
+                               (*it)->tail.load(std::memory_order_acquire);
+            if ((*it)->retired.load(std::memory_order_acquire) && empty) {
+                it = rings_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+   private:
+    Writer() : stopping_(false) {
+        thread_ = std::thread([this]() {
+            while (!stopping_.load(std::memory_order_acquire)) {
+                std::this_thread::sleep_for(WRITE_INTERVAL);
+                drain();
+            }
+        });
+    }
+
+    ~Writer() {
+        stopping_.store(true, std::memory_order_release);
+        if (thread_.joinable()) thread_.join();
+        drain();
+    }
+
+    bool drain_ring(ThreadRing& ring) {
+        std::size_t head = ring.head.load(std::memory_order_relaxed);
+        const std::size_t tail = ring.tail.load(std::memory_order_acquire);
+        if (head == tail && ring.dropped.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+
+        for (; head != tail; ++head) {
+            const Record& record = ring.records[head % RING_CAPACITY];
+            const double seconds = (record.time_us - process_start_us) / 1e6;
+            std::fprintf(stderr, "[%.6f] [%s] %.*s\n", seconds,
+                         level_name(record.level),
+                         static_cast<int>(record.length), record.text.data());
+        }
+        ring.head.store(head, std::memory_order_release);
+
+        const uint32_t dropped = ring.dropped.exchange(0);
+        if (dropped > 0) {
+            const double seconds = (now_us() - process_start_us) / 1e6;
+            std::fprintf(stderr, "[%.6f] [%s] %u log records dropped\n",
+                         seconds, level_name(LEVEL_WARNING), dropped);
+        }
+        return true;
+    }
+
+    std::mutex rings_mutex_;
+    std::mutex drain_mutex_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+    std::vector<std::shared_ptr<ThreadRing>> draining_;  // Under drain_mutex_
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Registers the calling thread's ring on first use and retires it
+ * when the thread exits.
+ */
+struct ThreadRingHandle {
+    ThreadRingHandle() : ring(std::make_shared<ThreadRing>()) {
+        Writer::instance().add(ring);
+    }
+    ~ThreadRingHandle() {
+        ring->retired.store(true, std::memory_order_release);
+    }
+
+    std::shared_ptr<ThreadRing> ring;
+};
+
+ThreadRing& this_thread_ring() {
+    thread_local ThreadRingHandle handle;
+    return *handle.ring;
+}
+
+}  // namespace
+
+void set_level(const Level level) {
+    min_level.store(level, std::memory_order_relaxed);
+}
+
+bool enabled(const Level level) {
+    return level >= min_level.load(std::memory_order_relaxed);
+}
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void submit(const Record& record) {
+    ThreadRing& ring = this_thread_ring();
+    const std::size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring.records[tail % RING_CAPACITY] = record;
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+void flush() { Writer::instance().drain(); }
+
+bool RateLimiter::allow() {
+    const int64_t now_ms = now_us() / 1000;
+    int64_t last = last_refill_.load(std::memory_order_relaxed);
+    const int64_t elapsed = now_ms - last;
+
+    if (elapsed >= 1000 / RATE_LIMIT_PER_SECOND &&
+        last_refill_.compare_exchange_strong(last, now_ms,
+                                             std::memory_order_relaxed)) {
+        const uint32_t refill = static_cast<uint32_t>(
+            std::min<int64_t>(elapsed * RATE_LIMIT_PER_SECOND / 1000,
+                              RATE_LIMIT_BURST));
+        uint32_t tokens = tokens_.load(std::memory_order_relaxed);
+        while (!tokens_.compare_exchange_weak(
+            tokens, std::min(tokens + refill, RATE_LIMIT_BURST),
+            std::memory_order_relaxed)) {
+        }
+    }
+
+    uint32_t tokens = tokens_.load(std::memory_order_relaxed);
+    while (tokens > 0) {
+        if (tokens_.compare_exchange_weak(tokens, tokens - 1,
+                                          std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+}  // namespace Logger
@@ -0,0 +1,250 @@
+#include "metrics.hpp"
+
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "logger.hpp"
+
+namespace Metrics {
+
+namespace {
+
+/**
+ * @brief Owns every registered metric. Deques keep references stable.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::deque<Counter> counters;
+    std::deque<Gauge> gauges;
+    std::deque<Histogram> histograms;
+    std::map<std::string, Counter*, std::less<>> counter_names;
+    std::map<std::string, Gauge*, std::less<>> gauge_names;
+    std::map<std::string, Histogram*, std::less<>> histogram_names;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+template <typename T>
+T& get_or_create(std::deque<T>& storage,
+                 std::map<std::string, T*, std::less<>>& names,
+                 std::string_view name) {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    auto it = names.find(name);
+    if (it != names.end()) return *it->second;
+
+    T& metric = storage.emplace_back();
+    names.emplace(std::string(name), &metric);
+    return metric;
+}
+
+std::size_t bucket_of(const uint64_t value) {
+    std::size_t bucket = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) ++bucket;
+    return value == 0 ? 0 : std::min(bucket + 1, HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t bucket_upper_bound(const std::size_t bucket) {
+    if (bucket == 0) return 0;
+    if (bucket >= HISTOGRAM_BUCKETS - 1) return UINT64_MAX;
+    return (uint64_t{1} << bucket) - 1;
+}
+
+}  // namespace
+
+std::size_t this_thread_shard() {
+    static std::atomic<std::size_t> next_shard = 0;
+    thread_local const std::size_t shard =
+        next_shard.fetch_add(1, std::memory_order_relaxed) % SHARD_COUNT;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Histogram::record(const uint64_t value) {
+    Shard& shard = shards_[this_thread_shard()];
+    shard.buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = shard.max.load(std::memory_order_relaxed);
+    while (value > max && !shard.max.compare_exchange_weak(
+                              max, value, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot Histogram::snapshot() const {
+    std::array<uint64_t, HISTOGRAM_BUCKETS> buckets = {};
+    HistogramSnapshot result;
+
+    for (const auto& shard : shards_) {
+        for (std::size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            const uint64_t count =
+                shard.buckets[i].load(std::memory_order_relaxed);
+            buckets[i] += count;
+            result.count += count;
+        }
+        result.sum += shard.sum.load(std::memory_order_relaxed);
+        result.max =
+            std::max(result.max, shard.max.load(std::memory_order_relaxed));
+    }
+
+    const auto percentile = [&buckets, &result](const double fraction) {
+        const uint64_t rank =
+            static_cast<uint64_t>(fraction * static_cast<double>(result.count));
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            seen += buckets[i];
+            if (seen > rank) {
+                return std::min(bucket_upper_bound(i), result.max);
+            }
+        }
+        return result.max;
+    };
+
+    if (result.count > 0) {
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+    }
+    return result;
+}
+
+Counter& counter(std::string_view name) {
+    return get_or_create(registry().counters, registry().counter_names, name);
+}
+
+Gauge& gauge(std::string_view name) {
+    return get_or_create(registry().gauges, registry().gauge_names, name);
+}
+
+Histogram& histogram(std::string_view name) {
+    return get_or_create(registry().histograms, registry().histogram_names,
+                         name);
+}
+
+std::string snapshot_json() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch());
+
+    std::ostringstream json;
+    json << "{\"timestamp_ms\":" << now.count() << ",\"counters\":{";
+
+    const char* separator = "";
+    for (const auto& [name, metric] : reg.counter_names) {
+        json << separator << '"' << name << "\":" << metric->value();
+        separator = ",";
+    }
+
+    json << "},\"gauges\":{";
+    separator = "";
+    for (const auto& [name, metric] : reg.gauge_names) {
+        json << separator << '"' << name << "\":" << metric->value();
+        separator = ",";
+    }
+
+    json << "},\"histograms\":{";
+    separator = "";
+    for (const auto& [name, metric] : reg.histogram_names) {
+        const HistogramSnapshot snapshot = metric->snapshot();
+        json << separator << '"' << name << "\":{\"count\":" << snapshot.count
+             << ",\"sum\":" << snapshot.sum << ",\"p50\":" << snapshot.p50
+             << ",\"p90\":" << snapshot.p90 << ",\"p99\":" << snapshot.p99
+             << ",\"max\":" << snapshot.max << "}";
+        separator = ",";
+    }
+
+    json << "}}";
+    return json.str();
+}
+
+ChannelCounters::ChannelCounters(std::string_view channel)
+    : packets_in(counter(std::string(channel) + ".packets_in")),
+      bytes_in(counter(std::string(channel) + ".bytes_in")),
+      packets_out(counter(std::string(channel) + ".packets_out")),
+      bytes_out(counter(std::string(channel) + ".bytes_out")) {}
+
+DropCounters::DropCounters()
+    : unknown_endpoint(counter("drops.unknown_endpoint")),
+      bad_size(counter("drops.bad_size")),
+      parse_error(counter("drops.parse_error")) {}
+
+StatsExporter::StatsExporter(const std::chrono::milliseconds interval,
+                             const std::string& socket_path)
+    : interval_(interval),
+      socket_path_(socket_path),
+      socket_fd_(-1),
+      stopping_(false) {
+    if (!socket_path_.empty()) {
+#ifndef _WIN32
+        socket_fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (socket_fd_ < 0) {
+            LOG_WARNING("Failed to open stats socket, using stderr");
+        }
+#else
+        LOG_WARNING("Unix sockets are not supported, using stderr for stats");
+#endif
+    }
+
+    thread_ = std::thread([this]() { run(); });
+}
+
+StatsExporter::~StatsExporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) thread_.join();
+
+#ifndef _WIN32
+    if (socket_fd_ >= 0) close(socket_fd_);
+#endif
+}
+
+void StatsExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, interval_, [this]() { return stopping_; });
+
+        lock.unlock();
+        emit(snapshot_json());
+        lock.lock();
+    }
+}
+
+void StatsExporter::emit(const std::string& line) {
+#ifndef _WIN32
+    if (socket_fd_ >= 0) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        socket_path_.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        // The reader may not be listening yet; stats are best effort
+        sendto(socket_fd_, line.data(), line.size(), 0,
+               reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+        return;
+    }
+#endif
+    std::fprintf(stderr, "%s\n", line.c_str());
+    std::fflush(stderr);
+}
+
+}  // namespace Metrics
@@ -0,0 +1,384 @@
+#include "socket_address.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+bool parse_ipv4(std::string_view text, SocketAddress::V4Bytes& bytes) {
+    const char* it = text.data();
+    const char* const end = text.data() + text.size();
+
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        if (i != 0) {
+            if (it == end || *it != '.') return false;
+            ++it;
+        }
+
+        unsigned int octet = 0;
+        const auto result = std::from_chars(it, end, octet);
+        if (result.ec != std::errc() || result.ptr - it > 3 || octet > 255) {
+            return false;
+        }
+        bytes[i] = static_cast<uint8_t>(octet);
+        it = result.ptr;
+    }
+    return it == end;
+}
+
+bool parse_ipv6(std::string_view text, SocketAddress::V6Bytes& bytes) {
+    std::array<uint16_t, 8> groups = {};
+    std::size_t count = 0;
+    std::size_t gap = groups.size() + 1;  // Position of "::", if any
+    std::size_t i = 0;
+
+    if (text.size() >= 2 && text[0] == ':' && text[1] == ':') {
+        gap = 0;
+        i = 2;
+    }
+
+    while (i < text.size()) {
+        const std::size_t token_end = std::min(text.find(':', i), text.size());
+        const std::string_view token = text.substr(i, token_end - i);
+
+        if (token.find('.') != std::string_view::npos) {
+            // Embedded IPv4 tail, only valid as the last two groups
+            SocketAddress::V4Bytes v4;
+            if (token_end != text.size() || count > groups.size() - 2 ||
+                !parse_ipv4(token, v4)) {
+                return false;
+            }
+            groups[count++] = static_cast<uint16_t>(v4[0] << 8 | v4[1]);
+            groups[count++] = static_cast<uint16_t>(v4[2] << 8 | v4[3]);
+            i = token_end;
+            break;
+        }
+
+        uint16_t group = 0;
+        const auto result = std::from_chars(
+            token.data(), token.data() + token.size(), group, 16);
+        if (token.empty() || token.size() > 4 || result.ec != std::errc() ||
+            result.ptr != token.data() + token.size() ||
+            count == groups.size()) {
+            return false;
+        }
+        groups[count++] = group;
+
+        i = token_end;
+        if (i == text.size()) break;
+
+        ++i;  // ':'
+        if (i < text.size() && text[i] == ':') {
+            if (gap <= groups.size()) return false;  // Second "::"
+            gap = count;
+            ++i;
+        } else if (i == text.size()) {
+            return false;  // Trailing single ':'
+        }
+    }
+
+    if (gap > groups.size()) {
+        if (count != groups.size()) return false;
+    } else {
+        if (count == groups.size()) return false;
+        // Move the groups after "::" to the end, zero filling the gap
+        const std::size_t tail = count - gap;
+        std::copy_backward(groups.begin() + gap, groups.begin() + count,
+                           groups.end());
+        std::fill(groups.begin() + gap, groups.end() - tail, 0);
+    }
+
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        bytes[2 * g] = static_cast<uint8_t>(groups[g] >> 8);
+        bytes[2 * g + 1] = static_cast<uint8_t>(groups[g] & 0xFF);
+    }
+    return true;
+}
+
+/**
+ * @brief Appends text to a bounded buffer, tracking overflow.
+ */
+struct Writer {
+    char* out;
+    char* const end;
+    bool overflow = false;
+
+    void put(const char c) {
+        if (out == end) {
+            overflow = true;
+            return;
+        }
+        *out++ = c;
+    }
+
+    template <typename T>
+    void number(const T value, const int base = 10) {
+        const auto result = std::to_chars(out, end, value, base);
+        if (result.ec != std::errc()) {
+            overflow = true;
+            return;
+        }
+        out = result.ptr;
+    }
+};
+
+void format_ipv6(const SocketAddress::V6Bytes& bytes, Writer& writer) {
+    std::array<uint16_t, 8> groups;
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        groups[g] = static_cast<uint16_t>(bytes[2 * g] << 8 | bytes[2 * g + 1]);
+    }
+
+    // RFC 5952: compress the longest run of two or more zero groups
+    std::size_t best_start = groups.size();
+    std::size_t best_length = 1;
+    for (std::size_t g = 0; g < groups.size();) {
+        if (groups[g] != 0) {
+            ++g;
+            continue;
+        }
+        std::size_t length = 0;
+        while (g + length < groups.size() && groups[g + length] == 0) {
+            ++length;
+        }
+        if (length > best_length) {
+            best_start = g;
+            best_length = length;
+        }
+        g += length;
+    }
+
+    for (std::size_t g = 0; g < groups.size(); ++g) {
+        if (g == best_start) {
+            writer.put(':');
+            writer.put(':');
+            g += best_length - 1;
+            continue;
+        }
+        if (g != 0 && g != best_start + best_length) writer.put(':');
+        writer.number(groups[g], 16);
+    }
+}
+
+}  // namespace
+
+SocketAddress::SocketAddress(const V4Bytes& address, const uint16_t port)
+    : port_(port), family_(IPV4) {
+    std::copy(address.begin(), address.end(), bytes_.begin());
+}
+
+SocketAddress::SocketAddress(const V6Bytes& address, const uint16_t port)
+    : bytes_(address), port_(port), family_(IPV6) {}
+
+bool SocketAddress::try_parse(std::string_view text, SocketAddress& address) {
+    std::string_view ip;
+    std::string_view port;
+
+    if (!text.empty() && text.front() == '[') {
+        const std::size_t close = text.find(']');
+        if (close == std::string_view::npos || close + 1 >= text.size() ||
+            text[close + 1] != ':') {
+            return false;
+        }
+        ip = text.substr(1, close - 1);
+        port = text.substr(close + 2);
+        if (ip.find(':') == std::string_view::npos) return false;  // IPv6 only
+    } else {
+        const std::size_t colon = text.rfind(':');
+        if (colon == std::string_view::npos) return false;
+        ip = text.substr(0, colon);
+        port = text.substr(colon + 1);
+        if (ip.find(':') != std::string_view::npos) return false;  // No []
+    }
+
+    uint16_t port_number = 0;
+    if (!try_parse_port(port, port_number)) return false;
+    return try_parse_ip(ip, port_number, address);
+}
+
+bool SocketAddress::try_parse_ip(std::string_view text, const uint16_t port,
+                                 SocketAddress& address) {
+    if (text.find(':') == std::string_view::npos) {
+        V4Bytes bytes;
+        if (!parse_ipv4(text, bytes)) return false;
+        address = SocketAddress(bytes, port);
+        return true;
+    }
+
+    V6Bytes bytes;
+    if (!parse_ipv6(text, bytes)) return false;
+    address = SocketAddress(bytes, port);
+    return true;
+}
+
+bool SocketAddress::try_parse_port(std::string_view text, uint16_t& port) {
+    const char* const end = text.data() + text.size();
+    unsigned int value = 0;
+    const auto result = std::from_chars(text.data(), end, value);
+    if (text.empty() || result.ec != std::errc() || result.ptr != end ||
+        value > 65535) {
+        return false;
+    }
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+SocketAddress SocketAddress::parse(std::string_view text) {
+    SocketAddress address;
+    if (!try_parse(text, address)) {
+        throw std::invalid_argument("Invalid socket address: " +
+                                    std::string(text));
+    }
+    return address;
+}
+
+SocketAddress SocketAddress::from_endpoint(
+    const boost::asio::ip::udp::endpoint& endpoint) {
+    const auto address = endpoint.address();
+    if (address.is_v4()) {
+        return SocketAddress(address.to_v4().to_bytes(), endpoint.port());
+    }
+
+    const auto v6 = address.to_v6();
+    if (v6.is_v4_mapped()) {
+        return SocketAddress(
+            boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, v6)
+                .to_bytes(),
+            endpoint.port());
+    }
+    return SocketAddress(v6.to_bytes(), endpoint.port());
+}
+
+boost::asio::ip::udp::endpoint SocketAddress::resolve(
+    boost::asio::io_context& io_context, const std::string& host,
+    const std::string& port, const boost::asio::ip::udp& protocol) {
+    SocketAddress address;
+    uint16_t port_number = 0;
+    if (try_parse_port(port, port_number) &&
+        try_parse_ip(host, port_number, address)) {
+        return address.endpoint_for(protocol);
+    }
+
+    const auto endpoints = resolve_all(io_context, host, port, protocol);
+    if (endpoints.empty()) {
+        throw boost::system::system_error(
+            boost::asio::error::address_family_not_supported, host);
+    }
+    return endpoints.front();
+}
+
+SocketAddress SocketAddress::resolve_address(
+    boost::asio::io_context& io_context, const std::string& host,
+    const std::string& port) {
+    SocketAddress address;
+    uint16_t port_number = 0;
+    if (try_parse_port(port, port_number) &&
+        try_parse_ip(host, port_number, address)) {
+        return address;
+    }
+
+    const auto entries =
+        boost::asio::ip::udp::resolver(io_context).resolve(host, port);
+    if (entries.empty()) {
+        throw boost::system::system_error(boost::asio::error::host_not_found,
+                                          host);
+    }
+    return from_endpoint(entries.begin()->endpoint());
+}
+
+std::vector<boost::asio::ip::udp::endpoint> SocketAddress::resolve_all(
+    boost::asio::io_context& io_context, const std::string& host,
+    const std::string& port, const boost::asio::ip::udp& protocol) {
+    std::vector<boost::asio::ip::udp::endpoint> endpoints;
+
+    SocketAddress address;
+    uint16_t port_number = 0;
+    if (try_parse_port(port, port_number) &&
+        try_parse_ip(host, port_number, address)) {
+        if (address.usable_with(protocol)) {
+            endpoints.push_back(address.to_endpoint(protocol));
+        }
+        return endpoints;
+    }
+
+    for (const auto& entry :
+         boost::asio::ip::udp::resolver(io_context).resolve(host, port)) {
+        address = from_endpoint(entry.endpoint());
+        if (!address.usable_with(protocol)) continue;
+
+        const auto endpoint = address.to_endpoint(protocol);
+        if (std::find(endpoints.begin(), endpoints.end(), endpoint) ==
+            endpoints.end()) {
+            endpoints.push_back(endpoint);
+        }
+    }
+    return endpoints;
+}
+
+boost::asio::ip::udp::endpoint SocketAddress::to_endpoint() const {
+    if (is_v4()) {
+        const boost::asio::ip::address_v4::bytes_type v4 = {
+            bytes_[0], bytes_[1], bytes_[2], bytes_[3]};
+        return {boost::asio::ip::address_v4(v4), port_};
+    }
+    return {boost::asio::ip::address_v6(bytes_), port_};
+}
+
+boost::asio::ip::udp::endpoint SocketAddress::endpoint_for(
+    const boost::asio::ip::udp& protocol) const {
+    if (!usable_with(protocol)) {
+        throw boost::system::system_error(
+            boost::asio::error::address_family_not_supported, to_string());
+    }
+    return to_endpoint(protocol);
+}
+
+boost::asio::ip::udp::endpoint SocketAddress::to_endpoint(
+    const boost::asio::ip::udp& protocol) const {
+    if (is_v4() && protocol == boost::asio::ip::udp::v6()) {
+        const boost::asio::ip::address_v4::bytes_type v4 = {
+            bytes_[0], bytes_[1], bytes_[2], bytes_[3]};
+        return {boost::asio::ip::make_address_v6(
+                    boost::asio::ip::v4_mapped,
+                    boost::asio::ip::address_v4(v4)),
+                port_};
+    }
+    return to_endpoint();
+}
+
+std::size_t SocketAddress::format_ip(char* buffer,
+                                     const std::size_t size) const {
+    Writer writer{buffer, buffer + size};
+    if (is_v4()) {
+        for (std::size_t i = 0; i < 4; ++i) {
+            if (i != 0) writer.put('.');
+            writer.number(bytes_[i]);
+        }
+    } else {
+        format_ipv6(bytes_, writer);
+    }
+    return writer.overflow ? 0 : static_cast<std::size_t>(writer.out - buffer);
+}
+
+std::size_t SocketAddress::format(char* buffer, const std::size_t size) const {
+    Writer writer{buffer, buffer + size};
+    if (is_v6()) writer.put('[');
+    const auto remaining = static_cast<std::size_t>(writer.end - writer.out);
+    const std::size_t ip_size = format_ip(writer.out, remaining);
+    if (writer.overflow || ip_size == 0) return 0;
+    writer.out += ip_size;
+    if (is_v6()) writer.put(']');
+    writer.put(':');
+    writer.number(port_);
+    return writer.overflow ? 0 : static_cast<std::size_t>(writer.out - buffer);
+}
+
+std::string SocketAddress::ip_string() const {
+    std::array<char, MAX_STRING_SIZE> buffer;
+    return std::string(buffer.data(), format_ip(buffer.data(), buffer.size()));
+}
+
+std::string SocketAddress::to_string() const {
+    std::array<char, MAX_STRING_SIZE> buffer;
+    return std::string(buffer.data(), format(buffer.data(), buffer.size()));
+}
@@ -0,0 +1,72 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "common.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+constexpr std::size_t DEFAULT_RUNS = 100000;
+constexpr std::size_t DEFAULT_MAX_SIZE = 4096;
+
+}  // namespace
+
+/**
+ * Stand-in for libFuzzer where it is not available. Replays --input if
+ * given, otherwise runs the target on --runs random inputs of up to
+ * --max-size bytes from --seed, so crashes reproduce.
+ */
+int main(int argc, char* argv[]) {
+    try {
+        const auto options = Common::parse_options(argc, argv, 1);
+
+        if (const auto it = options.find("input"); it != options.end()) {
+            std::ifstream file(it->second, std::ios::binary);
+            if (!file) throw std::runtime_error("Cannot open " + it->second);
+            const std::vector<uint8_t> input(
+                (std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            std::cout << "Replayed " << input.size() << " bytes\n";
+            return 0;
+        }
+
+        std::size_t runs = DEFAULT_RUNS;
+        std::size_t max_size = DEFAULT_MAX_SIZE;
+        uint32_t seed = 1;
+        if (const auto it = options.find("runs"); it != options.end()) {
+            runs = std::stoul(it->second);
+        }
+        if (const auto it = options.find("max-size"); it != options.end()) {
+            max_size = std::stoul(it->second);
+        }
+        if (const auto it = options.find("seed"); it != options.end()) {
+            seed = static_cast<uint32_t>(std::stoul(it->second));
+        }
+
+        std::vector<uint8_t> input;
+        for (std::size_t run = 0; run < runs; ++run) {
+            seed = seed * 1664525 + 1013904223;
+            input.resize(seed % (max_size + 1));
+            for (uint8_t& byte : input) {
+                seed = seed * 1664525 + 1013904223;
+                byte = static_cast<uint8_t>(seed >> 24);
+            }
+            // Often start like an RTP packet so parsing gets past the header
+            if (!input.empty() && run % 2 == 0) {
+                input[0] = static_cast<uint8_t>(0x80 | (input[0] & 0x3F));
+            }
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+        std::cout << "Ran " << runs << " inputs\n";
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
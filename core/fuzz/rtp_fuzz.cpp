@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "fec_decoder.hpp"
+#include "fec_encoder.hpp"
+#include "rtcp_feedback.hpp"
+#include "rtp_packet.hpp"
+#include "vp8_depacketizer.hpp"
+#include "vp8_packetizer.hpp"
+#include "vp8_payload.hpp"
+
+namespace {
+
+constexpr std::size_t FUZZ_WINDOW = 64;  // packets
+
+/**
+ * @brief Parse the input as one datagram, and check that a fixed header
+ * without padding or CSRCs numbered with write_transport_header gives its
+ * number back
+ */
+void parse_datagram(const uint8_t* data, const std::size_t size) {
+    uint16_t transport_sequence = 0;
+    Rtp::read_transport_sequence(data, size, transport_sequence);
+    if (Rtp::extension_size(data, size) > size) std::abort();
+
+    Rtp::Header header;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+    if (!Rtp::read_header(data, size, header, payload_offset, payload_size)) {
+        return;
+    }
+    if (payload_offset + payload_size > size) std::abort();
+
+    Vp8Payload::Descriptor descriptor;
+    std::size_t descriptor_size = 0;
+    if (Vp8Payload::read_descriptor(data + payload_offset, payload_size,
+                                    descriptor, descriptor_size) &&
+        descriptor_size >= payload_size) {
+        std::abort();
+    }
+
+    if ((data[0] & 0x2F) != 0) return;
+    unsigned char stamped[Rtp::HEADER_SIZE + Rtp::TRANSPORT_EXTENSION_SIZE];
+    const auto number = static_cast<uint16_t>(header.sequence * 31);
+    const std::size_t stamped_size =
+        Rtp::write_transport_header(data, number, stamped);
+    if (stamped_size != sizeof(stamped) ||
+        !Rtp::read_transport_sequence(stamped, stamped_size,
+                                      transport_sequence) ||
+        transport_sequence != number ||
+        Rtp::extension_size(stamped, stamped_size) !=
+            Rtp::TRANSPORT_EXTENSION_SIZE) {
+        std::abort();
+    }
+}
+
+/**
+ * @brief Parse the input as a transport feedback and check that one
+ * written from the arrival times read gives them back, give or take the
+ * wrap of the reference time
+ */
+void parse_transport_feedback(const uint8_t* data, const std::size_t size) {
+    uint16_t base_sequence = 0;
+    int64_t arrivals[RtcpFeedback::MAX_FEEDBACK_PACKETS];
+    std::size_t count = 0;
+    if (!RtcpFeedback::read_transport_feedback(data, size, base_sequence,
+                                               arrivals, std::size(arrivals),
+                                               count)) {
+        return;
+    }
+
+    unsigned char feedback[RtcpFeedback::MAX_TRANSPORT_FEEDBACK_SIZE];
+    std::size_t written = 0;
+    const std::size_t feedback_size = RtcpFeedback::write_transport_feedback(
+        1, 2, base_sequence, arrivals, count, 0, feedback, written);
+    if (written == 0) return;
+
+    uint16_t round_trip_base = 0;
+    int64_t round_trip[std::size(arrivals)];
+    std::size_t round_trip_count = 0;
+    if (!RtcpFeedback::read_transport_feedback(
+            feedback, feedback_size, round_trip_base, round_trip,
+            std::size(round_trip), round_trip_count) ||
+        round_trip_base != base_sequence || round_trip_count != written) {
+        std::abort();
+    }
+    for (std::size_t i = 0; i < written; ++i) {
+        if ((arrivals[i] == RtcpFeedback::NOT_RECEIVED) !=
+            (round_trip[i] == RtcpFeedback::NOT_RECEIVED)) {
+            std::abort();
+        }
+        if (arrivals[i] != RtcpFeedback::NOT_RECEIVED &&
+            (arrivals[i] - round_trip[i]) %
+                    RtcpFeedback::TRANSPORT_FEEDBACK_WRAP !=
+                0) {
+            std::abort();
+        }
+    }
+}
+
+/**
+ * @brief Parse the input as RTCP feedback and check that a NACK written
+ * from the sequence numbers read gives them back
+ */
+void parse_feedback(const uint8_t* data, const std::size_t size) {
+    uint32_t media_ssrc = 0;
+    RtcpFeedback::read_pli(data, size, media_ssrc);
+
+    double loss_rate = 0;
+    double mean_burst = 0;
+    if (RtcpFeedback::read_loss_report(data, size, loss_rate, mean_burst) &&
+        (loss_rate < 0 || loss_rate > 1 || mean_burst < 1)) {
+        std::abort();
+    }
+
+    uint16_t sequences[RtcpFeedback::MAX_NACK_ITEMS *
+                       RtcpFeedback::NACK_ITEM_SPAN];
+    std::size_t count = 0;
+    if (!RtcpFeedback::read_nack(data, size, media_ssrc, sequences,
+                                 std::size(sequences), count)) {
+        return;
+    }
+
+    // Items may overlap or go backwards; write only an increasing run
+    std::size_t increasing = count > 0 ? 1 : 0;
+    while (increasing < count &&
+           Rtp::is_newer(sequences[increasing], sequences[increasing - 1])) {
+        ++increasing;
+    }
+    unsigned char nack[RtcpFeedback::MAX_NACK_SIZE];
+    std::size_t written = 0;
+    const std::size_t nack_size = RtcpFeedback::write_nack(
+        1, media_ssrc, sequences, increasing, nack, written);
+
+    uint16_t round_trip[std::size(sequences)];
+    std::size_t round_trip_count = 0;
+    uint32_t round_trip_ssrc = 0;
+    if (written == 0) return;
+    if (!RtcpFeedback::read_nack(nack, nack_size, round_trip_ssrc,
+                                 round_trip, std::size(round_trip),
+                                 round_trip_count) ||
+        round_trip_ssrc != media_ssrc || round_trip_count != written ||
+        !std::equal(sequences, sequences + written, round_trip)) {
+        std::abort();
+    }
+}
+
+/**
+ * @brief Split the input into length-prefixed datagrams and reassemble
+ * whatever frames they make up
+ */
+void depacketize_datagrams(const uint8_t* data, const std::size_t size) {
+    Vp8Depacketizer depacketizer(FUZZ_WINDOW);
+    ReceivedFrame frame;
+    std::size_t offset = 0;
+    while (offset < size) {
+        const std::size_t length =
+            std::min<std::size_t>(data[offset], size - offset - 1);
+        ++offset;
+        if (depacketizer.push(data + offset, length, frame) &&
+            frame.size == 0) {
+            std::abort();
+        }
+        offset += length;
+    }
+}
+
+/**
+ * @brief Split the input into length-prefixed datagrams and feed them to
+ * the FEC decoder as video or parity packets
+ */
+void decode_datagrams(const uint8_t* data, const std::size_t size) {
+    FecDecoder decoder(GaloisField::Kernel::SCALAR);
+    std::size_t offset = 0;
+    while (offset < size) {
+        const std::size_t length =
+            std::min<std::size_t>(data[offset], size - offset - 1);
+        ++offset;
+        const unsigned char* datagram = data + offset;
+        const bool parity =
+            length > 1 && (datagram[1] & 0x7F) == Fec::PAYLOAD_TYPE;
+        for (const boost::asio::const_buffer& packet :
+             parity ? decoder.push_parity(datagram, length)
+                    : decoder.push_media(datagram, length)) {
+            if (packet.size() < Rtp::HEADER_SIZE ||
+                packet.size() > PacketBuffer::CAPACITY) {
+                std::abort();
+            }
+        }
+        offset += length;
+    }
+}
+
+/**
+ * @brief Copy a packet into one contiguous datagram
+ */
+std::vector<unsigned char> flatten(const GatherDatagram& packet) {
+    std::vector<unsigned char> datagram(packet.size());
+    std::memcpy(datagram.data(), packet.header.data(), packet.header.size());
+    std::memcpy(datagram.data() + packet.header.size(), packet.payload.data(),
+                packet.payload.size());
+    return datagram;
+}
+
+/**
+ * @brief Packetize the input as frames until the encoder protects them
+ * with either code, lose a burst of as many packets as the parity can
+ * rebuild, and check that each comes back exactly as sent, whichever
+ * kernel computes it
+ */
+void fec_round_trip(const uint8_t* data, const std::size_t size) {
+    if (size < 3) return;
+
+    const auto scheme =
+        data[0] & 1 ? Fec::Scheme::XOR : Fec::Scheme::REED_SOLOMON;
+    const GaloisField::Kernel kernels[] = {GaloisField::Kernel::SCALAR,
+                                           GaloisField::best_kernel()};
+    Vp8Packetizer packetizer(1, Vp8Packetizer::MAX_HEADER_SIZE + 64 +
+                                    data[1]);
+    Vp8FrameInfo info;
+    FecEncoder encoder(2, scheme, kernels[data[0] >> 1 & 1]);
+    encoder.set_loss(0.05 + data[0] / 512.0, 1 + (data[0] >> 4));
+
+    // Small frames are held back and protected with the next ones, in one
+    // group while they fit
+    std::vector<std::vector<unsigned char>> datagrams;
+    const std::vector<GatherDatagram>* parity = nullptr;
+    for (std::size_t frame = 0; frame < MAX_GROUP_FRAMES; ++frame) {
+        const std::vector<GatherDatagram>& packets =
+            packetizer.packetize(data + 2, size - 2, info);
+        if (datagrams.size() + packets.size() > Fec::MAX_SOURCES) return;
+        for (const GatherDatagram& packet : packets) {
+            datagrams.push_back(flatten(packet));
+        }
+        parity = &encoder.protect(packets);
+        if (!parity->empty()) break;
+    }
+    const std::size_t sources = datagrams.size();
+    const std::size_t parities = parity->size();
+    if (parities == 0) return;
+
+    // A burst as long as the parity, which XOR also rebuilds
+    const std::size_t first = data[1] % sources;
+    std::vector<std::size_t> lost;
+    for (std::size_t i = first; i < std::min(first + parities, sources); ++i) {
+        lost.push_back(i);
+    }
+    for (const GatherDatagram& packet : *parity) {
+        datagrams.push_back(flatten(packet));
+    }
+
+    FecDecoder decoder(kernels[data[0] >> 2 & 1]);
+    std::size_t rebuilt = 0;
+    for (std::size_t i = 0; i < datagrams.size(); ++i) {
+        const bool is_lost =
+            std::find(lost.begin(), lost.end(), i) != lost.end();
+        if (is_lost) continue;
+        const std::vector<unsigned char>& datagram = datagrams[i];
+        for (const boost::asio::const_buffer& packet :
+             i < sources
+                 ? decoder.push_media(datagram.data(), datagram.size())
+                 : decoder.push_parity(datagram.data(), datagram.size())) {
+            const auto* bytes =
+                static_cast<const unsigned char*>(packet.data());
+            const std::size_t index = static_cast<uint16_t>(
+                (bytes[2] << 8 | bytes[3]) - packetizer.next_sequence() +
+                sources);
+            if (index >= sources || datagrams[index].size() != packet.size() ||
+                std::memcmp(datagrams[index].data(), bytes, packet.size()) !=
+                    0) {
+                std::abort();
+            }
+            ++rebuilt;
+        }
+    }
+    if (rebuilt != lost.size()) std::abort();
+}
+
+/**
+ * @brief Packetize the input as a frame, deliver the packets shuffled and
+ * with a duplicate, and check that exactly the same frame comes out
+ */
+void round_trip(const uint8_t* data, const std::size_t size) {
+    if (size < 3) return;
+
+    const std::size_t max_packet_size =
+        Vp8Packetizer::MAX_HEADER_SIZE + 64 + data[0];
+    Vp8FrameInfo info;
+    info.timestamp = data[1] * 3000u;
+    info.temporal_layer = data[1] % 4 - 1;
+    const unsigned char* frame_data = data + 2;
+    const std::size_t frame_size = size - 2;
+
+    Vp8Packetizer packetizer(data[1], max_packet_size);
+    const std::vector<GatherDatagram>& packets =
+        packetizer.packetize(frame_data, frame_size, info);
+    if (packets.size() > FUZZ_WINDOW) return;
+
+    std::vector<std::vector<unsigned char>> datagrams;
+    for (const GatherDatagram& packet : packets) {
+        if (packet.size() > max_packet_size) std::abort();
+        datagrams.push_back(flatten(packet));
+    }
+
+    uint32_t seed = data[0] << 8 | data[1];
+    for (std::size_t i = datagrams.size(); i > 1; --i) {
+        seed = seed * 1664525 + 1013904223;
+        std::swap(datagrams[i - 1], datagrams[seed % i]);
+    }
+    datagrams.push_back(datagrams.front());
+
+    Vp8Depacketizer depacketizer(FUZZ_WINDOW);
+    ReceivedFrame frame;
+    std::size_t frames = 0;
+    for (const std::vector<unsigned char>& datagram : datagrams) {
+        if (!depacketizer.push(datagram.data(), datagram.size(), frame)) {
+            continue;
+        }
+        ++frames;
+        if (frame.size != frame_size ||
+            std::memcmp(frame.data, frame_data, frame_size) != 0 ||
+            frame.timestamp != info.timestamp ||
+            frame.temporal_layer != info.temporal_layer) {
+            std::abort();
+        }
+    }
+    if (frames != 1 || depacketizer.duplicates() != 1) std::abort();
+}
+
+}  // namespace
+
+/**
+ * Fuzz target for the RTP, RTCP feedback, FEC and VP8 payload parsers,
+ * the depacketizer and the FEC codes. Built for libFuzzer with Clang, or
+ * with fuzz_driver.cpp otherwise.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    parse_datagram(data, size);
+    parse_feedback(data, size);
+    parse_transport_feedback(data, size);
+    depacketize_datagrams(data, size);
+    decode_datagrams(data, size);
+    round_trip(data, size);
+    fec_round_trip(data, size);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef INPUT_REPLAYER_HPP
+#define INPUT_REPLAYER_HPP
+
+#include <boost/asio.hpp>
+
+#include "input_trace.hpp"
+#include "metrics.hpp"
+#include "socket_address.hpp"
+
+using boost::asio::ip::udp;
+
+// Sleep until this close to a deadline, then spin for precise timing
+constexpr std::chrono::microseconds SPIN_THRESHOLD{200};
+
+/**
+ * @struct ReplaySummary
+ * @brief Outcome of a replay run.
+ */
+struct ReplaySummary {
+    std::size_t sent = 0;
+    std::size_t failed = 0;
+    std::chrono::nanoseconds elapsed{0};
+    Metrics::HistogramSnapshot lateness_ns;  // Empty when not paced
+};
+
+/**
+ * @class InputReplayer
+ * @brief Streams a recorded input trace to a server, preserving the
+ * recorded inter-message timing scaled by a speed factor.
+ */
+class InputReplayer {
+   public:
+    /**
+     * @brief Construct a new InputReplayer object
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param server Server name or IP address
+     * @param server_port Server port number
+     * @param speed Playback speed factor, 0 or less to send as fast as
+     * possible
+     */
+    InputReplayer(boost::asio::io_context& io_context,
+                  const unsigned short local_port, const std::string& server,
+                  const std::string& server_port, const double speed);
+
+    /**
+     * @brief Construct a new InputReplayer object for a server address
+     * already parsed
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param server Server address and port
+     * @param speed Playback speed factor, 0 or less to send as fast as
+     * possible
+     */
+    InputReplayer(boost::asio::io_context& io_context,
+                  const unsigned short local_port, const SocketAddress& server,
+                  const double speed);
+
+    /**
+     * @brief Replay the trace, blocking until every message is sent
+     *
+     * @param trace Trace to replay
+     * @param loops Number of times to play the trace back to back
+     * @return ReplaySummary Messages sent and send-time lateness.
+     */
+    ReplaySummary run(const InputTraceReader& trace, const std::size_t loops);
+
+   private:
+    std::chrono::steady_clock::duration scaled(
+        const std::chrono::nanoseconds offset) const;
+    void wait_until(const std::chrono::steady_clock::time_point deadline);
+
+    udp::socket socket_;
+    udp::endpoint server_endpoint_;
+    double speed_;
+    Metrics::ChannelCounters stats_;
+    Metrics::Histogram& lateness_;
+};
+
+#endif  // INPUT_REPLAYER_HPP
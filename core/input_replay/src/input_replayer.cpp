@@ -0,0 +1,93 @@
+#include "input_replayer.hpp"
+
+#include <thread>
+
+#include "dual_stack.hpp"
+#include "logger.hpp"
+#include "socket_address.hpp"
+
+InputReplayer::InputReplayer(boost::asio::io_context& io_context,
+                             const unsigned short local_port,
+                             const std::string& server,
+                             const std::string& server_port, const double speed)
+    : InputReplayer(io_context, local_port,
+                    SocketAddress::resolve_address(io_context, server,
+                                                   server_port),
+                    speed) {}
+
+InputReplayer::InputReplayer(boost::asio::io_context& io_context,
+                             const unsigned short local_port,
+                             const SocketAddress& server, const double speed)
+    : socket_(DualStack::open_socket(io_context, local_port)),
+      server_endpoint_(
+          server.endpoint_for(socket_.local_endpoint().protocol())),
+      speed_(speed),
+      stats_("input"),
+      lateness_(Metrics::histogram("replay.lateness_ns")) {}
+
+ReplaySummary InputReplayer::run(const InputTraceReader& trace,
+                                 const std::size_t loops) {
+    ReplaySummary summary;
+    if (trace.empty()) return summary;
+
+    const uint64_t first_ns = trace.begin()->timestamp_ns;
+    const auto start = std::chrono::steady_clock::now();
+    auto loop_start = start;
+    std::array<char, InputMessages::Message::MAX_SERIALIZED_SIZE> buffer;
+
+    for (std::size_t loop = 0; loop < loops; ++loop) {
+        for (const InputTrace::Record& record : trace) {
+            const auto deadline =
+                loop_start + scaled(std::chrono::nanoseconds(
+                                 record.timestamp_ns - first_ns));
+            if (speed_ > 0) {
+                wait_until(deadline);
+                const auto lateness =
+                    std::chrono::steady_clock::now() - deadline;
+                lateness_.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        lateness)
+                        .count()));
+            }
+
+            const std::size_t size = record.message().serialize(
+                buffer.data(), buffer.size());
+            boost::system::error_code ec;
+            socket_.send_to(boost::asio::buffer(buffer.data(), size),
+                            server_endpoint_, 0, ec);
+            if (ec) {
+                LOG_WARNING("Error: ", ec.message());
+                ++summary.failed;
+                continue;
+            }
+            stats_.sent(size);
+            ++summary.sent;
+        }
+        // The next loop starts where this one ended in trace time
+        loop_start += scaled(trace.duration());
+    }
+
+    summary.elapsed = std::chrono::steady_clock::now() - start;
+    summary.lateness_ns = lateness_.snapshot();
+    return summary;
+}
+
+std::chrono::steady_clock::duration InputReplayer::scaled(
+    const std::chrono::nanoseconds offset) const {
+    if (speed_ <= 0) return std::chrono::steady_clock::duration::zero();
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double, std::nano>(
+            static_cast<double>(offset.count()) / speed_));
+}
+
+void InputReplayer::wait_until(
+    const std::chrono::steady_clock::time_point deadline) {
+    // The scheduler oversleeps by tens of microseconds or more, so sleep
+    // for the bulk of the wait and spin through the rest
+    const auto sleep_deadline = deadline - SPIN_THRESHOLD;
+    if (std::chrono::steady_clock::now() < sleep_deadline) {
+        std::this_thread::sleep_until(sleep_deadline);
+    }
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
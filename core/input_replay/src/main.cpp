@@ -0,0 +1,69 @@
+#include <iostream>
+
+#include "common.hpp"
+#include "input_replayer.hpp"
+#include "input_trace.hpp"
+#include "metrics.hpp"
+#include "socket_address.hpp"
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 5 || std::strcmp(argv[1], "-p") != 0) {
+            throw std::invalid_argument(
+                "Invalid arguments. Usage: " + std::string(argv[0]) +
+                " -p <local_port> <server_address> (IP:PORT or [IPv6]:PORT)"
+                " <trace_path>"
+                " [--speed <factor>] [--loops <count>]"
+                " [--stats <interval_ms>] [--stats-socket <path>]");
+        }
+
+        if (!Common::validate_port(argv[2])) {
+            throw std::invalid_argument("Invalid port number");
+        }
+
+        SocketAddress server_address;
+        if (!SocketAddress::try_parse(argv[3], server_address)) {
+            throw std::invalid_argument("Invalid server address");
+        }
+
+        const uint16_t local_port = static_cast<uint16_t>(std::stoi(argv[2]));
+        const InputTraceReader trace(argv[4]);
+        const auto options = Common::parse_options(argc, argv, 5);
+
+        double speed = 1.0;
+        if (const auto it = options.find("speed"); it != options.end()) {
+            speed = std::stod(it->second);
+        }
+
+        std::size_t loops = 1;
+        if (const auto it = options.find("loops"); it != options.end()) {
+            loops = std::stoul(it->second);
+        }
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            const auto socket = options.find("stats-socket");
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)),
+                socket != options.end() ? socket->second : "");
+        }
+
+        boost::asio::io_context io_context;
+        InputReplayer replayer(io_context, local_port, server_address,
+                               speed);
+        const ReplaySummary summary = replayer.run(trace, loops);
+
+        const double seconds =
+            std::chrono::duration<double>(summary.elapsed).count();
+        std::cout << "Sent " << summary.sent << " of "
+                  << trace.size() * loops << " messages in " << seconds
+                  << " s (" << (seconds > 0 ? summary.sent / seconds : 0)
+                  << " msg/s), lateness p50 " << summary.lateness_ns.p50
+                  << " ns, p99 " << summary.lateness_ns.p99 << " ns, max "
+                  << summary.lateness_ns.max << " ns" << std::endl;
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+#ifndef MEDIA_PIPELINE_HPP
+#define MEDIA_PIPELINE_HPP
+
+#include <array>
+#include <atomic>
+#include <boost/asio.hpp>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "bounded_queue.hpp"
+#include "color_convert.hpp"
+#include "frame_source.hpp"
+#include "metrics.hpp"
+#include "udp_segmentation.hpp"
+#include "vp8_encoder.hpp"
+#include "vp8_packetizer.hpp"
+
+constexpr std::size_t PIPELINE_QUEUE_SIZE = 2;  // frames between stages
+constexpr std::size_t ENCODED_FRAME_SLOTS = 4;  // encoded frames in flight
+constexpr int DEFAULT_CONVERT_THREADS = 2;
+
+/**
+ * @struct VideoFeedback
+ * @brief What the sending end reports back to the pipeline after taking a
+ * frame's packets. Zero leaves a value unchanged.
+ */
+struct VideoFeedback {
+    int bitrate = 0;  // kbit/s for the encoder
+    bool keyframe_requested = false;
+    std::size_t max_packet_size = 0;  // Largest RTP packet to packetize to
+};
+
+/**
+ * @brief Takes the packets of one frame on the io_context thread, e.g. into
+ * UDPServer::send_video, and reports back. The packets are only valid
+ * during the call.
+ */
+using VideoSink =
+    std::function<VideoFeedback(const std::vector<GatherDatagram>& packets)>;
+
+/**
+ * @struct PipelineSettings
+ * @brief What the pipeline captures and how it encodes it. The encoder's
+ * dimensions are taken from the frame source.
+ */
+struct PipelineSettings {
+    CaptureSettings capture;
+    EncoderSettings encoder;
+    int convert_threads = DEFAULT_CONVERT_THREADS;
+    std::size_t queue_size = PIPELINE_QUEUE_SIZE;
+    std::size_t max_packet_size = PathMtu::BASE_PLPMTU;
+
+    /**
+     * @brief Read the settings from command line options: the capture
+     * options of CaptureSettings::from_options, --frame-rate <fps>,
+     * --encode-threads <n> and --convert-threads <n>.
+     *
+     * @param options Options as parsed by Common::parse_options
+     * @return PipelineSettings The settings
+     *
+     * @throws std::invalid_argument If a value is invalid.
+     */
+    static PipelineSettings from_options(
+        const std::unordered_map<std::string, std::string>& options);
+};
+
+/**
+ * @class MediaPipeline
+ * @brief Captures, converts, encodes and packetizes video on a thread per
+ * stage, and hands the packets to the io_context thread to send.
+ *
+ * Stages pass pooled frame references through bounded lock-free queues and
+ * sleep on a condition variable only while they have nothing to do. When a
+ * stage falls behind, the stage before it drops the oldest frame waiting
+ * rather than queueing more, so a frame is never older than about
+ * queue_size frames by the time it is encoded. Encoded frames are not
+ * dropped, since later frames reference them: an encoded frame waits for
+ * a free slot instead, and the raw frames behind it are dropped as above.
+ *
+ * Packets reach the sink through boost::asio::post, so the io_context
+ * thread only ever sends, and a slow stage cannot hold up the datagrams it
+ * receives. What the sink reports back reaches the encoder and packetizer
+ * through atomics.
+ *
+ * Each stage records how long it takes per frame in the pipeline.*_us
+ * histograms, with pipeline.latency_us from capture to the sink.
+ */
+class MediaPipeline {
+   public:
+    /**
+     * @brief Construct a new MediaPipeline object and start streaming
+     *
+     * @param settings Capture and encoder settings
+     * @param io_context Context of the thread the sink runs on
+     * @param sink Called with the packets of each frame
+     *
+     * @throws std::invalid_argument If a setting is invalid or the source's
+     * dimensions are odd.
+     * @throws std::runtime_error If the source or encoder cannot be opened.
+     */
+    MediaPipeline(const PipelineSettings& settings,
+                  boost::asio::io_context& io_context, VideoSink sink);
+
+    /**
+     * @brief Destroy the MediaPipeline object, stopping every stage. Frames
+     * posted but not yet sent are discarded, so destroy it once the
+     * io_context has stopped running.
+     */
+    ~MediaPipeline();
+
+    MediaPipeline(const MediaPipeline&) = delete;
+    MediaPipeline& operator=(const MediaPipeline&) = delete;
+
+   private:
+    using Clock = FrameBuffer::Clock;
+
+    /**
+     * @struct Stage
+     * @brief Where a stage's thread sleeps while it has nothing to do.
+     */
+    struct Stage {
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+    };
+
+    /**
+     * @struct EncodedSlot
+     * @brief One encoded frame and, once packetized, its packets, which
+     * reference the slot's own copies of the headers.
+     */
+    struct EncodedSlot {
+        std::vector<unsigned char> data;
+        bool keyframe = false;
+        int temporal_layer = 0;
+        Clock::time_point capture_time;
+        std::vector<std::array<unsigned char, Vp8Packetizer::MAX_HEADER_SIZE>>
+            headers;
+        std::vector<GatherDatagram> packets;
+    };
+
+    void run_stage(Stage& stage, void (MediaPipeline::*loop)());
+    template <typename Ready>
+    bool wait(Stage& stage, Ready ready);
+    void wake(Stage& stage);
+    void stop();
+    void capture_loop();
+    void convert_loop();
+    void encode_loop();
+    void packetize_loop();
+    void send_ready();
+
+    std::unique_ptr<FrameSource> source_;
+    std::unique_ptr<FramePool> i420_pool_;  // Null for I420 sources
+    ColorConverter converter_;
+    Vp8Encoder encoder_;
+    Vp8Packetizer packetizer_;
+    int frame_rate_;
+    int temporal_layers_;
+    boost::asio::io_context& io_context_;
+    VideoSink sink_;
+    BoundedQueue<FrameRef> convert_queue_;
+    BoundedQueue<FrameRef> encode_queue_;
+    std::array<EncodedSlot, ENCODED_FRAME_SLOTS> slots_;
+    BoundedQueue<uint32_t> free_slots_;
+    BoundedQueue<uint32_t> packetize_queue_;
+    BoundedQueue<uint32_t> send_queue_;
+    std::atomic<int> bitrate_;  // kbit/s
+    std::atomic<bool> keyframe_requested_;
+    std::atomic<std::size_t> max_packet_size_;
+    std::atomic<bool> stopping_;
+    Stage capture_stage_;
+    Stage convert_stage_;
+    Stage encode_stage_;
+    Stage packetize_stage_;
+    Metrics::Histogram& capture_duration_;
+    Metrics::Histogram& convert_duration_;
+    Metrics::Histogram& encode_duration_;
+    Metrics::Histogram& packetize_duration_;
+    Metrics::Histogram& send_duration_;
+    Metrics::Histogram& latency_;
+    Metrics::Counter& stale_frames_;
+    Metrics::Counter& skipped_frames_;
+    Metrics::Counter& encoder_drops_;
+    Metrics::Counter& missed_deadlines_;
+};
+
+#endif  // MEDIA_PIPELINE_HPP
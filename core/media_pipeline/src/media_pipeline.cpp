@@ -0,0 +1,352 @@
+#include "media_pipeline.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "frame_clock.hpp"
+#include "logger.hpp"
+#include "rtp_packet.hpp"
+
+namespace {
+
+constexpr int MAX_FRAME_RATE = 240;  // frames/s
+constexpr int MAX_THREADS = 64;
+
+int positive_option(
+    const std::unordered_map<std::string, std::string>& options,
+    const char* name, const int fallback, const int max) {
+    const auto it = options.find(name);
+    if (it == options.end()) return fallback;
+
+    int value = 0;
+    try {
+        value = std::stoi(it->second);
+    } catch (const std::exception&) {
+        value = 0;
+    }
+    if (value <= 0 || value > max) {
+        throw std::invalid_argument(std::string("Invalid value for --") +
+                                    name);
+    }
+    return value;
+}
+
+uint64_t microseconds(const FrameBuffer::Clock::duration duration) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration)
+            .count());
+}
+
+/**
+ * @brief Open the source with enough frames for every queue and stage
+ */
+std::unique_ptr<FrameSource> open_source(const PipelineSettings& settings) {
+    if (settings.queue_size == 0) {
+        throw std::invalid_argument("Queue size must be positive");
+    }
+    CaptureSettings capture = settings.capture;
+    // One frame capturing, converting and encoding each, and the two
+    // queues full when the source is already I420
+    capture.pool_size =
+        std::max(capture.pool_size, 2 * settings.queue_size + 3);
+    auto source = FrameSource::create(capture);
+    const FrameLayout& layout = source->layout();
+    if (layout.width % 2 != 0 || layout.height % 2 != 0) {
+        throw std::invalid_argument("Capture dimensions must be even");
+    }
+    return source;
+}
+
+EncoderSettings encoder_settings(const PipelineSettings& settings,
+                                 const FrameLayout& layout) {
+    EncoderSettings encoder = settings.encoder;
+    encoder.width = layout.width;
+    encoder.height = layout.height;
+    return encoder;
+}
+
+}  // namespace
+
+PipelineSettings PipelineSettings::from_options(
+    const std::unordered_map<std::string, std::string>& options) {
+    PipelineSettings settings;
+    settings.capture = CaptureSettings::from_options(options);
+    settings.encoder.frame_rate = positive_option(
+        options, "frame-rate", settings.encoder.frame_rate, MAX_FRAME_RATE);
+    settings.encoder.threads =
+        positive_option(options, "encode-threads", settings.encoder.threads,
+                        MAX_THREADS);
+    settings.convert_threads =
+        positive_option(options, "convert-threads", settings.convert_threads,
+                        MAX_THREADS);
+    return settings;
+}
+
+MediaPipeline::MediaPipeline(const PipelineSettings& settings,
+                             boost::asio::io_context& io_context,
+                             VideoSink sink)
+    : source_(open_source(settings)),
+      converter_(settings.convert_threads),
+      encoder_(encoder_settings(settings, source_->layout())),
+      packetizer_(std::random_device()(), settings.max_packet_size),
+      frame_rate_(settings.encoder.frame_rate),
+      temporal_layers_(settings.encoder.temporal_layers),
+      io_context_(io_context),
+      sink_(std::move(sink)),
+      convert_queue_(settings.queue_size),
+      encode_queue_(settings.queue_size),
+      free_slots_(ENCODED_FRAME_SLOTS),
+      packetize_queue_(ENCODED_FRAME_SLOTS),
+      send_queue_(ENCODED_FRAME_SLOTS),
+      bitrate_(settings.encoder.bitrate),
+      keyframe_requested_(false),
+      max_packet_size_(settings.max_packet_size),
+      stopping_(false),
+      capture_duration_(Metrics::histogram("pipeline.capture_us")),
+      convert_duration_(Metrics::histogram("pipeline.convert_us")),
+      encode_duration_(Metrics::histogram("pipeline.encode_us")),
+      packetize_duration_(Metrics::histogram("pipeline.packetize_us")),
+      send_duration_(Metrics::histogram("pipeline.send_us")),
+      latency_(Metrics::histogram("pipeline.latency_us")),
+      stale_frames_(Metrics::counter("pipeline.stale_frames")),
+      skipped_frames_(Metrics::counter("pipeline.skipped_frames")),
+      encoder_drops_(Metrics::counter("pipeline.encoder_dropped_frames")),
+      missed_deadlines_(Metrics::counter("pipeline.missed_deadlines")) {
+    if (!sink_) {
+        throw std::invalid_argument("Pipeline needs a sink");
+    }
+    const FrameLayout& layout = source_->layout();
+    if (layout.format == PixelFormat::BGRA) {
+        // One frame converting and encoding each, and the queue between
+        i420_pool_ = std::make_unique<FramePool>(
+            FrameLayout::aligned(PixelFormat::I420, layout.width,
+                                 layout.height),
+            settings.queue_size + 2);
+    }
+    for (uint32_t i = 0; i < ENCODED_FRAME_SLOTS; ++i) {
+        uint32_t slot = i;
+        free_slots_.push(std::move(slot));
+    }
+
+    run_stage(capture_stage_, &MediaPipeline::capture_loop);
+    run_stage(convert_stage_, &MediaPipeline::convert_loop);
+    run_stage(encode_stage_, &MediaPipeline::encode_loop);
+    run_stage(packetize_stage_, &MediaPipeline::packetize_loop);
+}
+
+MediaPipeline::~MediaPipeline() {
+    stop();
+    for (Stage* stage : {&capture_stage_, &convert_stage_, &encode_stage_,
+                         &packetize_stage_}) {
+        if (stage->thread.joinable()) stage->thread.join();
+    }
+}
+
+void MediaPipeline::run_stage(Stage& stage, void (MediaPipeline::*loop)()) {
+    stage.thread = std::thread([this, loop]() {
+        try {
+            (this->*loop)();
+        } catch (const std::exception& e) {
+            // A stage that cannot go on stops the stream, not the server
+            LOG_ERROR("Media pipeline stopped: ", e.what());
+            stop();
+        }
+    });
+}
+
+template <typename Ready>
+bool MediaPipeline::wait(Stage& stage, Ready ready) {
+    std::unique_lock<std::mutex> lock(stage.mutex);
+    stage.wakeup.wait(lock, [this, &ready]() {
+        return stopping_.load(std::memory_order_relaxed) || ready();
+    });
+    return !stopping_.load(std::memory_order_relaxed);
+}
+
+void MediaPipeline::wake(Stage& stage) {
+    // Taking the lock orders the push before a waiter's check, so the
+    // notification cannot fall between its check and its sleep
+    { std::lock_guard<std::mutex> lock(stage.mutex); }
+    stage.wakeup.notify_one();
+}
+
+void MediaPipeline::stop() {
+    stopping_.store(true, std::memory_order_relaxed);
+    for (Stage* stage : {&capture_stage_, &convert_stage_, &encode_stage_,
+                         &packetize_stage_}) {
+        { std::lock_guard<std::mutex> lock(stage->mutex); }
+        stage->wakeup.notify_all();
+    }
+}
+
+void MediaPipeline::capture_loop() {
+    FrameClock clock(frame_rate_);
+    FrameRef dropped;
+    uint64_t missed = 0;
+    while (!stopping_.load(std::memory_order_relaxed)) {
+        clock.wait();
+        const Clock::time_point start = Clock::now();
+        FrameRef frame = source_->capture();
+        capture_duration_.record(microseconds(Clock::now() - start));
+        missed_deadlines_.add(clock.missed() - missed);
+        missed = clock.missed();
+        if (!frame) {
+            // Every pooled frame is still held downstream
+            skipped_frames_.add();
+            continue;
+        }
+
+        if (convert_queue_.push_dropping_oldest(std::move(frame), dropped)) {
+            stale_frames_.add();
+            dropped = FrameRef();
+        }
+        wake(convert_stage_);
+    }
+}
+
+void MediaPipeline::convert_loop() {
+    FrameRef frame;
+    FrameRef dropped;
+    while (wait(convert_stage_, [this]() { return !convert_queue_.empty(); })) {
+        if (!convert_queue_.pop(frame)) continue;
+
+        FrameRef converted;
+        if (!i420_pool_) {
+            converted = std::move(frame);
+        } else {
+            const Clock::time_point start = Clock::now();
+            converted = i420_pool_->acquire();
+            if (!converted) {
+                skipped_frames_.add();
+                frame = FrameRef();
+                continue;
+            }
+            converter_.convert(*frame, ColorConvert::Planes::of(*converted));
+            converted->set_capture(frame->capture_time(), frame->sequence());
+            frame = FrameRef();
+            convert_duration_.record(microseconds(Clock::now() - start));
+        }
+
+        if (encode_queue_.push_dropping_oldest(std::move(converted),
+                                               dropped)) {
+            stale_frames_.add();
+            dropped = FrameRef();
+        }
+        wake(encode_stage_);
+    }
+}
+
+void MediaPipeline::encode_loop() {
+    FrameRef frame;
+    uint32_t slot_index = 0;
+    EncodedFrame encoded;
+    // A slot is taken before a frame, so while every slot waits to be sent
+    // the raw frames keep being replaced by newer ones
+    while (wait(encode_stage_, [this]() {
+        return !encode_queue_.empty() && !free_slots_.empty();
+    })) {
+        if (!free_slots_.pop(slot_index)) continue;
+        if (!encode_queue_.pop(frame)) {
+            free_slots_.push(std::move(slot_index));
+            continue;
+        }
+
+        const int bitrate = bitrate_.load(std::memory_order_relaxed);
+        if (bitrate != encoder_.bitrate()) encoder_.set_bitrate(bitrate);
+        if (keyframe_requested_.exchange(false, std::memory_order_relaxed)) {
+            encoder_.request_keyframe();
+        }
+
+        const Clock::time_point start = Clock::now();
+        const bool produced = encoder_.encode(*frame, encoded);
+        frame = FrameRef();
+        encode_duration_.record(microseconds(Clock::now() - start));
+        if (!produced) {
+            encoder_drops_.add();
+            free_slots_.push(std::move(slot_index));
+            continue;
+        }
+
+        // The encoder reuses its output buffer, so the frame is copied out
+        EncodedSlot& slot = slots_[slot_index];
+        slot.data.assign(encoded.data, encoded.data + encoded.size);
+        slot.keyframe = encoded.keyframe;
+        slot.temporal_layer = encoded.temporal_layer;
+        slot.capture_time = encoded.capture_time;
+        packetize_queue_.push(std::move(slot_index));
+        wake(packetize_stage_);
+    }
+}
+
+void MediaPipeline::packetize_loop() {
+    uint32_t slot_index = 0;
+    bool started = false;
+    Clock::time_point first_capture;
+    while (wait(packetize_stage_,
+                [this]() { return !packetize_queue_.empty(); })) {
+        if (!packetize_queue_.pop(slot_index)) continue;
+
+        const Clock::time_point start = Clock::now();
+        const std::size_t max_packet_size =
+            max_packet_size_.load(std::memory_order_relaxed);
+        if (max_packet_size != packetizer_.max_packet_size()) {
+            packetizer_.set_max_packet_size(max_packet_size);
+        }
+
+        EncodedSlot& slot = slots_[slot_index];
+        if (!started) {
+            started = true;
+            first_capture = slot.capture_time;
+        }
+        Vp8FrameInfo info;
+        info.timestamp =
+            Rtp::video_timestamp(slot.capture_time - first_capture);
+        info.temporal_layer =
+            temporal_layers_ > 1 ? slot.temporal_layer : Vp8Payload::NONE;
+        const std::vector<GatherDatagram>& packets =
+            packetizer_.packetize(slot.data.data(), slot.data.size(), info);
+
+        // The packetizer reuses its headers, so they are copied into the
+        // slot; payloads already point into it
+        slot.headers.resize(packets.size());
+        slot.packets.resize(packets.size());
+        for (std::size_t i = 0; i < packets.size(); ++i) {
+            const boost::asio::const_buffer& header = packets[i].header;
+            std::memcpy(slot.headers[i].data(), header.data(), header.size());
+            slot.packets[i].header =
+                boost::asio::buffer(slot.headers[i].data(), header.size());
+            slot.packets[i].payload = packets[i].payload;
+        }
+        packetize_duration_.record(microseconds(Clock::now() - start));
+
+        send_queue_.push(std::move(slot_index));
+        boost::asio::post(io_context_, [this]() { send_ready(); });
+    }
+}
+
+void MediaPipeline::send_ready() {
+    uint32_t slot_index = 0;
+    while (send_queue_.pop(slot_index)) {
+        EncodedSlot& slot = slots_[slot_index];
+        const Clock::time_point start = Clock::now();
+        const VideoFeedback feedback = sink_(slot.packets);
+        const Clock::time_point end = Clock::now();
+        send_duration_.record(microseconds(end - start));
+        latency_.record(microseconds(end - slot.capture_time));
+
+        if (feedback.bitrate > 0) {
+            bitrate_.store(feedback.bitrate, std::memory_order_relaxed);
+        }
+        if (feedback.keyframe_requested) {
+            keyframe_requested_.store(true, std::memory_order_relaxed);
+        }
+        if (feedback.max_packet_size > 0) {
+            max_packet_size_.store(feedback.max_packet_size,
+                                   std::memory_order_relaxed);
+        }
+        free_slots_.push(std::move(slot_index));
+        wake(encode_stage_);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef IMPAIRMENT_MODEL_HPP
+#define IMPAIRMENT_MODEL_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @struct GilbertElliott
+ * @brief Two-state Markov loss model. The channel moves between a good and
+ * a bad state once per packet and drops with the loss rate of its state.
+ */
+struct GilbertElliott {
+    double p = 0.0;          // Probability of moving from good to bad
+    double r = 1.0;          // Probability of moving from bad to good
+    double loss_good = 0.0;  // Loss probability in the good state
+    double loss_bad = 1.0;   // Loss probability in the bad state
+};
+
+/**
+ * @struct ImpairmentConfig
+ * @brief Link impairments applied to one direction of traffic. All
+ * probabilities are in [0, 1]; zero disables the impairment.
+ */
+struct ImpairmentConfig {
+    uint64_t seed = 1;
+    double loss = 0.0;  // Bernoulli loss, ignored when use_gilbert_elliott
+    bool use_gilbert_elliott = false;
+    GilbertElliott gilbert_elliott;
+    std::chrono::microseconds delay{0};
+    std::chrono::microseconds jitter{0};  // Uniform in [-jitter, +jitter]
+    double reorder = 0.0;    // Packets sent without the configured delay
+    double duplicate = 0.0;  // Packets sent twice
+    uint64_t rate_bps = 0;   // Bandwidth cap, 0 for unlimited
+    std::chrono::microseconds queue_limit{200000};  // Tail drop threshold
+};
+
+/**
+ * @class ImpairmentModel
+ * @brief Decides the fate of each packet crossing an impaired link. The
+ * model is deterministic for a given seed and packet sequence, so runs are
+ * reproducible.
+ */
+class ImpairmentModel {
+   public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t MAX_COPIES = 2;
+
+    /**
+     * @struct Verdict
+     * @brief Outcome for one packet: how many copies to deliver and when.
+     */
+    struct Verdict {
+        std::size_t copies = 0;
+        std::array<Clock::time_point, MAX_COPIES> departures;
+    };
+
+    /**
+     * @brief Construct a new ImpairmentModel object
+     *
+     * @param config Impairments to apply
+     */
+    explicit ImpairmentModel(const ImpairmentConfig& config);
+
+    /**
+     * @brief Decide what happens to a packet entering the link
+     *
+     * @param bytes Packet size in bytes
+     * @param now Arrival time of the packet
+     * @return Verdict Copies to deliver, zero if the packet is dropped.
+     */
+    Verdict process(const std::size_t bytes, const Clock::time_point now);
+
+    /**
+     * @brief Change the bandwidth cap, e.g. to step the capacity of the
+     * link during a test. Packets already queued keep their departures.
+     *
+     * @param rate_bps New cap, 0 for unlimited
+     */
+    void set_rate(const uint64_t rate_bps) { config_.rate_bps = rate_bps; }
+
+   private:
+    double next_uniform();
+    bool lost();
+    Clock::duration serialization_delay(const std::size_t bytes) const;
+    Clock::duration propagation_delay();
+
+    ImpairmentConfig config_;
+    uint64_t rng_state_;
+    bool bad_state_;
+    Clock::time_point link_free_at_;
+};
+
+#endif  // IMPAIRMENT_MODEL_HPP
@@ -0,0 +1,112 @@
+#ifndef NETEM_PROXY_HPP
+#define NETEM_PROXY_HPP
+
+#include <array>
+#include <boost/asio.hpp>
+
+#include "impairment_model.hpp"
+#include "metrics.hpp"
+#include "packet_pool.hpp"
+#include "socket_address.hpp"
+#include "timer_wheel.hpp"
+
+using boost::asio::ip::udp;
+
+constexpr std::size_t NETEM_POOL_SIZE = 8192;  // buffers
+constexpr std::chrono::microseconds NETEM_TICK{100};
+constexpr std::size_t NETEM_WHEEL_SLOTS = 8192;  // ~820 ms per revolution
+
+/**
+ * @class NetemProxy
+ * @brief UDP proxy that applies seeded loss, delay, jitter, reordering,
+ * duplication and bandwidth limits between a local client and a target.
+ *
+ * The client talks to the listen port; the proxy forwards its datagrams to
+ * the target from the upstream port and relays replies back to the last
+ * client endpoint seen. Each direction has its own impairment model.
+ */
+class NetemProxy {
+   public:
+    /**
+     * @brief Construct a new NetemProxy object
+     *
+     * @param io_context Boost ASIO context
+     * @param listen_port Local port the client sends to
+     * @param upstream_port Local port used to talk to the target, 0 for any
+     * @param target Target name or IP address
+     * @param target_port Target port number
+     * @param upstream Impairments for client to target traffic
+     * @param downstream Impairments for target to client traffic
+     */
+    NetemProxy(boost::asio::io_context& io_context,
+               const unsigned short listen_port,
+               const unsigned short upstream_port, const std::string& target,
+               const std::string& target_port,
+               const ImpairmentConfig& upstream,
+               const ImpairmentConfig& downstream);
+
+    /**
+     * @brief Construct a new NetemProxy object for a target address already
+     * parsed
+     *
+     * @param io_context Boost ASIO context
+     * @param listen_port Local port the client sends to
+     * @param upstream_port Local port used to talk to the target, 0 for any
+     * @param target Target address and port
+     * @param upstream Impairments for client to target traffic
+     * @param downstream Impairments for target to client traffic
+     */
+    NetemProxy(boost::asio::io_context& io_context,
+               const unsigned short listen_port,
+               const unsigned short upstream_port, const SocketAddress& target,
+               const ImpairmentConfig& upstream,
+               const ImpairmentConfig& downstream);
+
+    /**
+     * @brief Destroy the Netem Proxy object
+     */
+    ~NetemProxy();
+
+   private:
+    enum Direction { UPSTREAM, DOWNSTREAM };
+
+    struct Link {
+        Link(udp::socket& in, udp::socket& out, const ImpairmentConfig& config,
+             const std::string& name);
+
+        udp::socket& in;
+        udp::socket& out;
+        ImpairmentModel model;
+        PacketRef recv_packet;
+        udp::endpoint sender;
+        Metrics::ChannelCounters stats;
+        Metrics::Counter& dropped;
+        Metrics::Counter& duplicated;
+    };
+
+    struct Pending {
+        PacketRef packet;
+        Direction direction;
+    };
+
+    void start_receive(const Direction direction);
+    void handle_receive(const Direction direction,
+                        const boost::system::error_code& ec,
+                        const std::size_t bytes_recvd);
+    void arm_timer();
+    void handle_timer(const boost::system::error_code& ec);
+    void forward(const Pending& pending);
+
+    udp::socket client_socket_;
+    udp::socket target_socket_;
+    udp::endpoint target_endpoint_;
+    udp::endpoint client_endpoint_;
+    boost::asio::steady_timer timer_;
+    bool timer_armed_;
+    PacketPool pool_;
+    std::array<unsigned char, PacketBuffer::CAPACITY> overflow_buffer_;
+    std::array<Link, 2> links_;
+    TimerWheel<Pending> wheel_;
+};
+
+#endif  // NETEM_PROXY_HPP
@@ -0,0 +1,73 @@
+#include "impairment_model.hpp"
+
+#include <algorithm>
+
+ImpairmentModel::ImpairmentModel(const ImpairmentConfig& config)
+    : config_(config),
+      rng_state_(config.seed),
+      bad_state_(false),
+      link_free_at_() {}
+
+ImpairmentModel::Verdict ImpairmentModel::process(const std::size_t bytes,
+                                                  const Clock::time_point now) {
+    Verdict verdict;
+    if (lost()) return verdict;
+
+    // Bandwidth cap: packets queue behind each other on the link and are
+    // tail dropped once the queue exceeds its limit
+    const Clock::time_point queue_start = std::max(now, link_free_at_);
+    if (config_.rate_bps != 0 && queue_start - now > config_.queue_limit) {
+        return verdict;
+    }
+    link_free_at_ = queue_start + serialization_delay(bytes);
+
+    verdict.copies = next_uniform() < config_.duplicate ? 2 : 1;
+    for (std::size_t i = 0; i < verdict.copies; ++i) {
+        // Reordered packets skip the delay line and overtake earlier ones
+        const bool reordered = next_uniform() < config_.reorder;
+        verdict.departures[i] =
+            link_free_at_ +
+            (reordered ? Clock::duration::zero() : propagation_delay());
+    }
+    return verdict;
+}
+
+double ImpairmentModel::next_uniform() {
+    // splitmix64, so sequences are identical on every standard library
+    uint64_t z = (rng_state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * 0x1.0p-53;
+}
+
+bool ImpairmentModel::lost() {
+    if (!config_.use_gilbert_elliott) return next_uniform() < config_.loss;
+
+    const GilbertElliott& model = config_.gilbert_elliott;
+    bad_state_ = bad_state_ ? next_uniform() >= model.r
+                            : next_uniform() < model.p;
+    return next_uniform() < (bad_state_ ? model.loss_bad : model.loss_good);
+}
+
+ImpairmentModel::Clock::duration ImpairmentModel::serialization_delay(
+    const std::size_t bytes) const {
+    if (config_.rate_bps == 0) return Clock::duration::zero();
+
+    const auto nanoseconds = static_cast<Clock::rep>(
+        static_cast<double>(bytes) * 8.0 * 1e9 /
+        static_cast<double>(config_.rate_bps));
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::nanoseconds(nanoseconds));
+}
+
+ImpairmentModel::Clock::duration ImpairmentModel::propagation_delay() {
+    auto delay = std::chrono::duration_cast<Clock::duration>(config_.delay);
+    if (config_.jitter.count() != 0) {
+        const double offset = (next_uniform() * 2.0 - 1.0) *
+                              static_cast<double>(config_.jitter.count());
+        delay += std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::micro>(offset));
+    }
+    return std::max(delay, Clock::duration::zero());
+}
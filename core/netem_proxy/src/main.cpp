@@ -0,0 +1,122 @@
+#include <iostream>
+#include <sstream>
+
+#include "common.hpp"
+#include "metrics.hpp"
+#include "netem_proxy.hpp"
+#include "socket_address.hpp"
+
+namespace {
+
+std::chrono::microseconds milliseconds_option(const Common::Options& options,
+                                              const std::string& name,
+                                              const double fallback) {
+    const auto it = options.find(name);
+    const double value = it != options.end() ? std::stod(it->second) : fallback;
+    return std::chrono::microseconds(static_cast<long long>(value * 1000.0));
+}
+
+double probability_option(const Common::Options& options,
+                          const std::string& name) {
+    const auto it = options.find(name);
+    if (it == options.end()) return 0.0;
+
+    const double value = std::stod(it->second);
+    if (value < 0.0 || value > 1.0) {
+        throw std::invalid_argument("Invalid probability for --" + name);
+    }
+    return value;
+}
+
+ImpairmentConfig parse_impairments(const Common::Options& options) {
+    ImpairmentConfig config;
+    if (const auto it = options.find("seed"); it != options.end()) {
+        config.seed = std::stoull(it->second);
+    }
+
+    config.loss = probability_option(options, "loss");
+    if (const auto it = options.find("ge"); it != options.end()) {
+        // p,r[,loss_good[,loss_bad]]
+        GilbertElliott& model = config.gilbert_elliott;
+        std::array<double*, 4> fields = {&model.p, &model.r, &model.loss_good,
+                                         &model.loss_bad};
+        std::stringstream ss(it->second);
+        std::string field;
+        std::size_t count = 0;
+        while (std::getline(ss, field, ',') && count < fields.size()) {
+            *fields[count++] = std::stod(field);
+        }
+        if (count < 2) {
+            throw std::invalid_argument("Invalid --ge, expected p,r");
+        }
+        config.use_gilbert_elliott = true;
+    }
+
+    config.delay = milliseconds_option(options, "delay", 0.0);
+    config.jitter = milliseconds_option(options, "jitter", 0.0);
+    config.reorder = probability_option(options, "reorder");
+    config.duplicate = probability_option(options, "duplicate");
+    if (const auto it = options.find("rate"); it != options.end()) {
+        config.rate_bps = std::stoull(it->second) * 1000;
+    }
+    config.queue_limit = milliseconds_option(options, "queue", 200.0);
+    return config;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc < 4 || std::strcmp(argv[1], "-p") != 0) {
+            throw std::invalid_argument(
+                "Invalid arguments. Usage: " + std::string(argv[0]) +
+                " -p <listen_port> <target_address> (IP:PORT or [IPv6]:PORT)"
+                " [--upstream-port <port>] [--seed <n>] [--loss <p>]"
+                " [--ge <p,r[,loss_good[,loss_bad]]>] [--delay <ms>]"
+                " [--jitter <ms>] [--reorder <p>] [--duplicate <p>]"
+                " [--rate <kbit/s>] [--queue <ms>] [--stats <interval_ms>]");
+        }
+
+        if (!Common::validate_port(argv[2])) {
+            throw std::invalid_argument("Invalid port number");
+        }
+
+        SocketAddress target_address;
+        if (!SocketAddress::try_parse(argv[3], target_address)) {
+            throw std::invalid_argument("Invalid target address");
+        }
+
+        const uint16_t listen_port = static_cast<uint16_t>(std::stoi(argv[2]));
+        const auto options = Common::parse_options(argc, argv, 4);
+
+        uint16_t upstream_port = 0;
+        if (const auto it = options.find("upstream-port");
+            it != options.end()) {
+            if (!Common::validate_port(it->second)) {
+                throw std::invalid_argument("Invalid upstream port number");
+            }
+            upstream_port = static_cast<uint16_t>(std::stoi(it->second));
+        }
+
+        // Both directions share the impairments but draw independent
+        // random sequences
+        const ImpairmentConfig upstream = parse_impairments(options);
+        ImpairmentConfig downstream = upstream;
+        downstream.seed = upstream.seed + 1;
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)));
+        }
+
+        boost::asio::io_context io_context;
+        NetemProxy proxy(io_context, listen_port, upstream_port,
+                         target_address, upstream, downstream);
+        io_context.run();
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+    }
+
+    return 0;
+}
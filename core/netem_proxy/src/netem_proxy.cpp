@@ -0,0 +1,148 @@
+#include "netem_proxy.hpp"
+
+#include "dual_stack.hpp"
+#include "logger.hpp"
+#include "socket_address.hpp"
+
+NetemProxy::Link::Link(udp::socket& in, udp::socket& out,
+                       const ImpairmentConfig& config, const std::string& name)
+    : in(in),
+      out(out),
+      model(config),
+      stats(name),
+      dropped(Metrics::counter(name + ".dropped")),
+      duplicated(Metrics::counter(name + ".duplicated")) {}
+
+NetemProxy::NetemProxy(boost::asio::io_context& io_context,
+                       const unsigned short listen_port,
+                       const unsigned short upstream_port,
+                       const std::string& target,
+                       const std::string& target_port,
+                       const ImpairmentConfig& upstream,
+                       const ImpairmentConfig& downstream)
+    : NetemProxy(io_context, listen_port, upstream_port,
+                 SocketAddress::resolve_address(io_context, target,
+                                                target_port),
+                 upstream, downstream) {}
+
+NetemProxy::NetemProxy(boost::asio::io_context& io_context,
+                       const unsigned short listen_port,
+                       const unsigned short upstream_port,
+                       const SocketAddress& target,
+                       const ImpairmentConfig& upstream,
+                       const ImpairmentConfig& downstream)
+    : client_socket_(DualStack::open_socket(io_context, listen_port)),
+      target_socket_(DualStack::open_socket(io_context, upstream_port)),
+      target_endpoint_(
+          target.endpoint_for(target_socket_.local_endpoint().protocol())),
+      timer_(io_context),
+      timer_armed_(false),
+      pool_(NETEM_POOL_SIZE),
+      links_{{Link(client_socket_, target_socket_, upstream, "netem.upstream"),
+              Link(target_socket_, client_socket_, downstream,
+                   "netem.downstream")}},
+      wheel_(NETEM_TICK, NETEM_WHEEL_SLOTS) {
+    LOG_INFO("Proxying ", client_socket_.local_endpoint(), " -> ",
+             target_endpoint_, " from ", target_socket_.local_endpoint());
+    start_receive(UPSTREAM);
+    start_receive(DOWNSTREAM);
+}
+
+NetemProxy::~NetemProxy() {
+    if (client_socket_.is_open()) client_socket_.close();
+    if (target_socket_.is_open()) target_socket_.close();
+}
+
+void NetemProxy::start_receive(const Direction direction) {
+    Link& link = links_[direction];
+    link.recv_packet = pool_.acquire();
+
+    // With every buffer held in the delay line, keep draining the socket so
+    // the excess is counted as queue overflow instead of stalling the proxy
+    const boost::asio::mutable_buffer buffer =
+        link.recv_packet ? link.recv_packet.writable()
+                         : boost::asio::mutable_buffer(boost::asio::buffer(
+                               overflow_buffer_));
+    link.in.async_receive_from(
+        buffer, link.sender,
+        [this, direction](const boost::system::error_code& ec,
+                          std::size_t bytes_recvd) {
+            handle_receive(direction, ec, bytes_recvd);
+        });
+}
+
+void NetemProxy::handle_receive(const Direction direction,
+                                const boost::system::error_code& ec,
+                                const std::size_t bytes_recvd) {
+    if (ec) {
+        if (ec != boost::asio::error::operation_aborted) {
+            LOG_ERROR("Error: ", ec.message());
+        }
+        return;
+    }
+
+    Link& link = links_[direction];
+    PacketRef packet = std::move(link.recv_packet);
+    const udp::endpoint sender = link.sender;
+    start_receive(direction);
+
+    if (direction == UPSTREAM) {
+        client_endpoint_ = sender;
+    } else if (sender != target_endpoint_) {
+        LOG_WARNING("Received message from unknown endpoint: ", sender);
+        return;
+    }
+
+    link.stats.received(bytes_recvd);
+    if (!packet) {
+        link.dropped.add();
+        return;
+    }
+    packet->set_size(bytes_recvd);
+
+    const auto verdict =
+        link.model.process(bytes_recvd, std::chrono::steady_clock::now());
+    if (verdict.copies == 0) {
+        link.dropped.add();
+        return;
+    }
+    if (verdict.copies > 1) link.duplicated.add(verdict.copies - 1);
+
+    for (std::size_t i = 0; i < verdict.copies; ++i) {
+        wheel_.schedule(verdict.departures[i], Pending{packet, direction});
+    }
+    arm_timer();
+}
+
+void NetemProxy::arm_timer() {
+    if (timer_armed_ || wheel_.empty()) return;
+
+    timer_armed_ = true;
+    timer_.expires_at(wheel_.next_tick());
+    timer_.async_wait(
+        [this](const boost::system::error_code& ec) { handle_timer(ec); });
+}
+
+void NetemProxy::handle_timer(const boost::system::error_code& ec) {
+    timer_armed_ = false;
+    if (ec) return;
+
+    wheel_.advance(std::chrono::steady_clock::now(),
+                   [this](Pending pending) { forward(pending); });
+    arm_timer();
+}
+
+void NetemProxy::forward(const Pending& pending) {
+    Link& link = links_[pending.direction];
+    const udp::endpoint& destination =
+        pending.direction == UPSTREAM ? target_endpoint_ : client_endpoint_;
+
+    boost::system::error_code ec;
+    const std::size_t bytes_sent =
+        link.out.send_to(pending.packet.payload(), destination, 0, ec);
+    if (ec) {
+        LOG_WARNING("Error forwarding to ", destination, ": ", ec.message());
+        return;
+    }
+    link.stats.sent(bytes_sent);
+}
@@ -0,0 +1,35 @@
+#ifndef ASIO_BACKEND_HPP
+#define ASIO_BACKEND_HPP
+
+#include "network_backend.hpp"
+
+/**
+ * @class AsioBackend
+ * @brief Network backend built on the Boost.Asio reactor.
+ */
+class AsioBackend : public NetworkBackend {
+   public:
+    AsioBackend(boost::asio::io_context& io_context,
+                const udp::endpoint& local_endpoint);
+    ~AsioBackend() override;
+
+    void start_receive(ReceiveHandler handler) override;
+    void send_to(const boost::asio::const_buffer& data,
+                 const udp::endpoint& endpoint) override;
+    void flush() override {}
+    void run() override;
+    void stop() override;
+    udp::endpoint local_endpoint() const override;
+    BackendType type() const override { return BackendType::ASIO; }
+
+   private:
+    void receive_next();
+
+    boost::asio::io_context& io_context_;
+    udp::socket socket_;
+    udp::endpoint remote_endpoint_;
+    std::array<unsigned char, 2048> recv_buffer_;
+    ReceiveHandler handler_;
+};
+
+#endif  // ASIO_BACKEND_HPP
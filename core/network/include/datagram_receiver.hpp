@@ -0,0 +1,70 @@
+#ifndef DATAGRAM_RECEIVER_HPP
+#define DATAGRAM_RECEIVER_HPP
+
+#include <boost/asio.hpp>
+#include <cstdint>
+
+#include "metrics.hpp"
+
+using boost::asio::ip::udp;
+
+/**
+ * @class DatagramReceiver
+ * @brief Non-blocking datagram receive that also tracks kernel drops.
+ *
+ * On Linux the socket gets SO_RXQ_OVFL, so every receive carries the
+ * socket's cumulative count of datagrams dropped because the receive
+ * buffer was full; increases are added to drops.rx_queue_overflow. Drops
+ * are only seen with the next datagram that makes it into the queue.
+ * Datagrams larger than the buffer report their full size instead of
+ * being silently truncated, so size validation can reject them.
+ *
+ * With PacketTimestamps enabled on the socket, the kernel's receive
+ * timestamp of each datagram is picked up as well.
+ */
+class DatagramReceiver {
+   public:
+    /**
+     * @brief Construct a new DatagramReceiver object
+     *
+     * @param socket Open UDP socket
+     */
+    explicit DatagramReceiver(udp::socket& socket);
+
+    /**
+     * @brief Receive one queued datagram without blocking
+     *
+     * @param buffer Destination buffer
+     * @param remote_endpoint Receives the sender's endpoint
+     * @param ec Set to would_block if nothing is queued, or to the error
+     * @return std::size_t Full size of the datagram, which may exceed the
+     * buffer size
+     */
+    std::size_t receive(const boost::asio::mutable_buffer& buffer,
+                        udp::endpoint& remote_endpoint,
+                        boost::system::error_code& ec);
+
+    /**
+     * @brief Check whether kernel drops are reported (SO_RXQ_OVFL)
+     *
+     * @return true if they are, false otherwise
+     */
+    bool tracks_drops() const { return tracks_drops_; }
+
+    /**
+     * @brief Get when the last datagram was received: the kernel timestamp
+     * if there is one, otherwise when receive() got it
+     *
+     * @return int64_t CLOCK_REALTIME nanoseconds (see PacketTimestamps)
+     */
+    int64_t receive_time() const { return receive_time_; }
+
+   private:
+    udp::socket& socket_;
+    bool tracks_drops_;
+    uint32_t kernel_drops_;  // Last cumulative count seen
+    int64_t receive_time_;
+    Metrics::Counter& overflow_drops_;
+};
+
+#endif  // DATAGRAM_RECEIVER_HPP
@@ -0,0 +1,100 @@
+#ifndef DSCP_HPP
+#define DSCP_HPP
+
+#include <boost/asio.hpp>
+#include <cstdint>
+
+using boost::asio::ip::udp;
+
+/**
+ * @brief Kinds of traffic the endpoints send, highest priority first
+ */
+enum class TrafficClass : uint8_t {
+    CONTROL,  // Ping and pong, which measure the latency input sees
+    INPUT,
+    AUDIO,
+    RETRANSMISSION,
+    VIDEO,  // Media, parity and path MTU probes
+};
+
+constexpr std::size_t TRAFFIC_CLASS_COUNT = 5;
+
+/**
+ * @namespace Dscp
+ * @brief Differentiated Services code points marking each traffic class,
+ * so networks that honour them queue input ahead of video (RFC 8837).
+ */
+namespace Dscp {
+
+constexpr uint8_t BEST_EFFORT = 0;
+constexpr uint8_t ASSURED_FORWARDING_41 = 34;  // Interactive video
+constexpr uint8_t EXPEDITED_FORWARDING = 46;   // Interactive audio
+
+/**
+ * @brief Get the code point of a traffic class
+ *
+ * @param traffic_class Traffic class
+ * @return uint8_t Code point: expedited forwarding for control, input and
+ * audio, assured forwarding 41 for video and retransmissions.
+ */
+constexpr uint8_t for_class(const TrafficClass traffic_class) {
+    return traffic_class <= TrafficClass::AUDIO ? EXPEDITED_FORWARDING
+                                                : ASSURED_FORWARDING_41;
+}
+
+/**
+ * @brief Mark the datagrams sent on a socket from now on, over IPv4 and
+ * IPv6 alike
+ *
+ * @param socket Open UDP socket
+ * @param dscp Code point, 0 to 63
+ * @return true if set, false if not supported or not permitted.
+ */
+bool set(udp::socket& socket, const uint8_t dscp);
+
+}  // namespace Dscp
+
+/**
+ * @class DscpMarker
+ * @brief Marks a socket for the class of each datagram about to be sent,
+ * changing the socket option only when the code point changes, which
+ * traffic in bursts of one class rarely does.
+ *
+ * Not thread-safe: every send on the socket must go through one thread,
+ * or a datagram may leave with another's mark. Once the option cannot be
+ * set, marking stops.
+ */
+class DscpMarker {
+   public:
+    /**
+     * @brief Construct a new DscpMarker object
+     *
+     * @param socket Open UDP socket, left unmarked until the first mark
+     * @param enabled Mark datagrams; when false, mark does nothing
+     * (default: true)
+     */
+    explicit DscpMarker(udp::socket& socket, const bool enabled = true);
+
+    /**
+     * @brief Mark the socket for a datagram of the given class
+     *
+     * @param traffic_class Class of the next datagram sent
+     */
+    void mark(const TrafficClass traffic_class);
+
+    /**
+     * @brief Turn marking on or off. Turning it off clears the mark.
+     *
+     * @param enabled Mark datagrams
+     */
+    void set_enabled(const bool enabled);
+
+    bool enabled() const { return enabled_; }
+
+   private:
+    udp::socket& socket_;
+    bool enabled_;
+    uint8_t current_;
+};
+
+#endif  // DSCP_HPP
@@ -0,0 +1,139 @@
+#ifndef HANDLER_POOL_HPP
+#define HANDLER_POOL_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @class HandlerPool
+ * @brief Fixed-size, process-wide pool of blocks for the operations of
+ * Boost.Asio completion handlers, so re-arming a socket wait or a timer
+ * does not allocate.
+ *
+ * Boost.Asio keeps one freed handler per thread for reuse, so a thread
+ * with several operations in flight, like the server's and the client's,
+ * allocates for most of them. The pool is a function-local static, so it
+ * outlives the io_contexts that destroy pending operations on shutdown.
+ * Handlers larger than BLOCK_SIZE, or more than BLOCKS at once, fall back
+ * to the heap.
+ *
+ * Allocate and deallocate are lock-free and safe from any thread.
+ */
+class HandlerPool {
+   public:
+    static constexpr std::size_t BLOCK_SIZE = 256;
+    static constexpr std::size_t BLOCKS = 256;
+
+    HandlerPool(const HandlerPool&) = delete;
+    HandlerPool& operator=(const HandlerPool&) = delete;
+
+    /**
+     * @brief Get the pool shared by every handler
+     *
+     * @return HandlerPool& The pool
+     */
+    static HandlerPool& instance();
+
+    /**
+     * @brief Take a block from the pool, or from the heap if none fits
+     *
+     * @param size Bytes needed
+     * @return void* Block of at least size bytes
+     */
+    void* allocate(const std::size_t size);
+
+    /**
+     * @brief Return a block taken with allocate
+     *
+     * @param pointer Block to return
+     */
+    void deallocate(void* pointer);
+
+   private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    HandlerPool();
+
+    std::array<std::aligned_storage_t<BLOCK_SIZE>, BLOCKS> blocks_;
+    std::array<std::atomic<uint32_t>, BLOCKS> next_free_;
+    std::atomic<uint64_t> free_head_;  // Tag in the upper half prevents ABA
+};
+
+/**
+ * @class HandlerAllocator
+ * @brief Allocator drawing from the HandlerPool, the one Boost.Asio finds
+ * through a handler's get_allocator()
+ *
+ * @tparam T Type allocated
+ */
+template <typename T>
+class HandlerAllocator {
+   public:
+    using value_type = T;
+
+    HandlerAllocator() noexcept = default;
+
+    template <typename U>
+    HandlerAllocator(const HandlerAllocator<U>& /* other */) noexcept {}
+
+    T* allocate(const std::size_t n) const {
+        return static_cast<T*>(HandlerPool::instance().allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* pointer, const std::size_t /* n */) const {
+        HandlerPool::instance().deallocate(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const HandlerAllocator<U>& /* other */) const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const HandlerAllocator<U>& /* other */) const noexcept {
+        return false;
+    }
+};
+
+/**
+ * @class PooledHandler
+ * @brief Wraps a completion handler so Boost.Asio allocates its operation
+ * from the HandlerPool
+ *
+ * @tparam Handler Wrapped handler
+ */
+template <typename Handler>
+class PooledHandler {
+   public:
+    using allocator_type = HandlerAllocator<Handler>;
+
+    explicit PooledHandler(Handler handler) : handler_(std::move(handler)) {}
+
+    allocator_type get_allocator() const noexcept { return allocator_type(); }
+
+    template <typename... Args>
+    void operator()(Args&&... args) {
+        handler_(std::forward<Args>(args)...);
+    }
+
+   private:
+    Handler handler_;
+};
+
+/**
+ * @brief Wrap a completion handler to allocate from the HandlerPool
+ *
+ * @param handler Completion handler
+ * @return PooledHandler<Handler> Handler to pass to the operation
+ */
+template <typename Handler>
+PooledHandler<std::decay_t<Handler>> pooled(Handler&& handler) {
+    return PooledHandler<std::decay_t<Handler>>(
+        std::forward<Handler>(handler));
+}
+
+#endif  // HANDLER_POOL_HPP
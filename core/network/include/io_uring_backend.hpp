@@ -0,0 +1,124 @@
+#ifndef IO_URING_BACKEND_HPP
+#define IO_URING_BACKEND_HPP
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <vector>
+
+#include "network_backend.hpp"
+
+/**
+ * @namespace IoUringConfig
+ * @brief Sizing of the io_uring backend rings and buffers.
+ */
+namespace IoUringConfig {
+
+constexpr unsigned RING_ENTRIES = 256;
+constexpr unsigned CQ_ENTRIES = 2048;  // Two per zero-copy send, plus receives
+constexpr unsigned RECV_BUFFER_COUNT = 1024;  // Must be a power of two
+constexpr unsigned RECV_BUFFER_SIZE = 2048;
+constexpr unsigned SEND_SLOT_COUNT = 512;
+constexpr unsigned SEND_BUFFER_SIZE = 2048;
+constexpr uint16_t BUFFER_GROUP = 0;
+constexpr uint16_t SEND_BUFFER_INDEX = 0;  // Registered buffer of the slots
+
+}  // namespace IoUringConfig
+
+/**
+ * @class IoUringBackend
+ * @brief Network backend built directly on the Linux io_uring interface.
+ *
+ * Receives use one multishot recvmsg over a kernel-registered provided buffer
+ * ring, so a single submission keeps delivering datagrams. The socket is a
+ * registered file and sends are queued into preallocated slots and submitted
+ * in batches with one io_uring_enter call.
+ *
+ * The send slots are one registered buffer, so a send is a fixed-buffer
+ * IORING_OP_SEND_ZC (Linux 6.0) that neither pins pages nor copies a
+ * msghdr per datagram. A slot is reused once the kernel's notification
+ * says it is done with it. Where the opcode is missing or the buffer cannot
+ * be registered, e.g. under a low RLIMIT_MEMLOCK, sends fall back to
+ * IORING_OP_SENDMSG from the same slots.
+ */
+class IoUringBackend : public NetworkBackend {
+   public:
+    /**
+     * @brief Construct a new IoUringBackend object
+     *
+     * @param io_context Boost ASIO context, only used to own the socket
+     * @param local_endpoint Local endpoint to bind the UDP socket
+     *
+     * @throws boost::system::system_error If the kernel rejects the setup
+     */
+    IoUringBackend(boost::asio::io_context& io_context,
+                   const udp::endpoint& local_endpoint);
+    ~IoUringBackend() override;
+
+    void start_receive(ReceiveHandler handler) override;
+    void send_to(const boost::asio::const_buffer& data,
+                 const udp::endpoint& endpoint) override;
+    void flush() override;
+    void run() override;
+    void stop() override;
+    udp::endpoint local_endpoint() const override;
+    BackendType type() const override { return BackendType::IO_URING; }
+
+   private:
+    struct SendSlot {
+        msghdr msg;  // Only for sendmsg
+        iovec iov;
+        udp::endpoint endpoint;
+    };
+
+    void setup_ring();
+    void setup_buffer_ring();
+    void register_socket();
+    void setup_send_buffers();
+    bool supports(const uint8_t opcode) const;
+    unsigned char* send_buffer(const uint16_t index);
+    io_uring_sqe* next_sqe();
+    void submit(const unsigned wait_for);
+    void arm_receive();
+    void arm_wakeup();
+    unsigned process_completions();
+    void handle_receive(const io_uring_cqe& cqe);
+    void recycle_buffer(const uint16_t buffer_id);
+
+    udp::socket socket_;
+    int ring_fd_;
+    int wake_fd_;
+    uint64_t wake_value_;
+    std::atomic<bool> stopped_;
+
+    void* sq_ring_;
+    void* cq_ring_;
+    std::size_t sq_ring_size_;
+    std::size_t cq_ring_size_;
+    io_uring_sqe* sqes_;
+    std::size_t sqes_size_;
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    io_uring_cqe* cqes_;
+    unsigned pending_;
+
+    io_uring_buf_ring* buf_ring_;
+    std::size_t buf_ring_size_;
+    std::vector<unsigned char> recv_slab_;
+    msghdr recv_msg_;
+    udp::endpoint remote_endpoint_;
+    ReceiveHandler handler_;
+
+    std::vector<SendSlot> send_slots_;
+    std::vector<unsigned char> send_arena_;  // SEND_BUFFER_SIZE per slot
+    bool fixed_sends_;
+    std::vector<uint16_t> free_slots_;
+};
+
+#endif  // IO_URING_BACKEND_HPP
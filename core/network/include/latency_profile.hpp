@@ -0,0 +1,76 @@
+#ifndef LATENCY_PROFILE_HPP
+#define LATENCY_PROFILE_HPP
+
+#include <boost/asio.hpp>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+using boost::asio::ip::udp;
+
+constexpr int DEFAULT_BUSY_POLL = 50;                   // microseconds
+constexpr int DEFAULT_REALTIME_PRIORITY = 50;           // SCHED_FIFO, 1-99
+constexpr int DEFAULT_SOCKET_BUFFER = 4 * 1024 * 1024;  // bytes
+
+/**
+ * @struct LatencyProfile
+ * @brief Opt-in socket and thread settings trading CPU for wake-up latency
+ * on the io thread.
+ *
+ * With the profile enabled, the io thread:
+ * - spins on the socket instead of sleeping in epoll (busy_poll > 0),
+ *   with SO_BUSY_POLL letting the kernel poll the device queue as well;
+ * - is pinned to one core (cpu >= 0);
+ * - runs under SCHED_FIFO where permitted (realtime_priority > 0), unless
+ *   it busy polls without being pinned to a core of its own;
+ * - gets larger socket buffers, so bursts are queued rather than dropped.
+ *
+ * Settings the process is not permitted to make are logged and skipped.
+ */
+struct LatencyProfile {
+    bool enabled = false;
+    int busy_poll = DEFAULT_BUSY_POLL;  // 0 to sleep in epoll as usual
+    int cpu = -1;                       // -1 to leave unpinned
+    int realtime_priority = DEFAULT_REALTIME_PRIORITY;  // 0 for default
+    int socket_buffer = DEFAULT_SOCKET_BUFFER;  // SO_RCVBUF and SO_SNDBUF
+
+    /**
+     * @brief Read the profile from command line options: --latency-profile
+     * enables it, and --busy-poll <us>, --cpu <n>, --rt-priority <n> and
+     * --socket-buffer <bytes> override the defaults.
+     *
+     * @param options Options as parsed by Common::parse_options
+     * @return LatencyProfile The profile, disabled without --latency-profile.
+     *
+     * @throws std::invalid_argument If a value is invalid.
+     */
+    static LatencyProfile from_options(
+        const std::unordered_map<std::string, std::string>& options);
+
+    /**
+     * @brief Apply the socket settings. Does nothing if disabled.
+     *
+     * @param socket Open UDP socket
+     */
+    void apply(udp::socket& socket) const;
+
+    /**
+     * @brief Pin the calling thread and raise its scheduling priority. Does
+     * nothing if disabled.
+     */
+    void apply_to_current_thread() const;
+
+    /**
+     * @brief Run the io_context on the calling thread until it stops. When
+     * busy polling, spins calling poll_receive and then handlers that are
+     * ready; otherwise the same as io_context.run(). Applies the thread
+     * settings first.
+     *
+     * @param io_context Boost ASIO context
+     * @param poll_receive Receives everything queued without blocking
+     */
+    void run(boost::asio::io_context& io_context,
+             const std::function<void()>& poll_receive) const;
+};
+
+#endif  // LATENCY_PROFILE_HPP
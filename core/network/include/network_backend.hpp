@@ -0,0 +1,99 @@
+#ifndef NETWORK_BACKEND_HPP
+#define NETWORK_BACKEND_HPP
+
+#include <boost/asio.hpp>
+#include <functional>
+#include <memory>
+
+using boost::asio::ip::udp;
+
+/**
+ * @enum BackendType
+ * @brief Enumerates the available network backends.
+ */
+enum class BackendType {
+    ASIO,     // Boost.Asio reactor (default, all platforms)
+    IO_URING  // Linux io_uring with multishot receives and batched sends
+};
+
+/**
+ * @class NetworkBackend
+ * @brief Interface for sending and receiving UDP datagrams on one bound
+ * socket. To be implemented by the different I/O backends.
+ */
+class NetworkBackend {
+   public:
+    /**
+     * @brief Handler called once per received datagram. The data pointer is
+     * only valid for the duration of the call.
+     */
+    using ReceiveHandler = std::function<void(
+        const unsigned char* data, const std::size_t size,
+        const udp::endpoint& remote_endpoint)>;
+
+    /**
+     * @brief Destroy the NetworkBackend object
+     */
+    virtual ~NetworkBackend() = default;
+
+    /**
+     * @brief Create a new NetworkBackend object. Falls back to the asio
+     * backend if the requested one is not available.
+     *
+     * @param type Requested backend type
+     * @param io_context Boost ASIO context
+     * @param local_endpoint Local endpoint to bind the UDP socket
+     * @return std::unique_ptr<NetworkBackend> Pointer to the created object.
+     */
+    static std::unique_ptr<NetworkBackend> create(
+        const BackendType type, boost::asio::io_context& io_context,
+        const udp::endpoint& local_endpoint);
+
+    /**
+     * @brief Start receiving datagrams until the backend is stopped
+     *
+     * @param handler Function to call for each received datagram
+     */
+    virtual void start_receive(ReceiveHandler handler) = 0;
+
+    /**
+     * @brief Queue a datagram to be sent. The data is copied if the backend
+     * sends asynchronously, so the caller may reuse it right away.
+     *
+     * @param data Datagram payload
+     * @param endpoint Destination endpoint
+     */
+    virtual void send_to(const boost::asio::const_buffer& data,
+                         const udp::endpoint& endpoint) = 0;
+
+    /**
+     * @brief Submit all queued sends to the kernel
+     */
+    virtual void flush() = 0;
+
+    /**
+     * @brief Run the event loop until stop() is called
+     */
+    virtual void run() = 0;
+
+    /**
+     * @brief Stop the event loop. Safe to call from any thread.
+     */
+    virtual void stop() = 0;
+
+    /**
+     * @brief Get the local endpoint the socket is bound to
+     *
+     * @return udp::endpoint Local endpoint
+     */
+    virtual udp::endpoint local_endpoint() const = 0;
+
+    /**
+     * @brief Get the backend type
+     *
+     * @return BackendType Backend type
+     */
+    virtual BackendType type() const = 0;
+};
+
+#endif  // NETWORK_BACKEND_HPP
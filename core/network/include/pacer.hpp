@@ -0,0 +1,140 @@
+#ifndef PACER_HPP
+#define PACER_HPP
+
+#include <array>
+#include <boost/asio/buffer.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "dscp.hpp"
+#include "packet_pool.hpp"
+
+constexpr double DEFAULT_PACING_FACTOR = 2.5;  // Times the target bitrate
+constexpr std::size_t PACER_QUEUE_SIZE = 512;  // packets
+constexpr std::chrono::milliseconds PACER_BURST{5};
+constexpr std::chrono::milliseconds PACER_INTERVAL{1};  // Between wakeups
+constexpr std::chrono::milliseconds PACER_MAX_QUEUE_TIME{200};
+
+/**
+ * @class Pacer
+ * @brief Releases queued datagrams to the socket no faster than a multiple
+ * of the media's target bitrate, so a keyframe leaves over several
+ * milliseconds instead of filling the device and bottleneck queues at once.
+ *
+ * Each traffic class has its own queue, served in strict priority: a
+ * datagram leaves only when every class above it is empty. Control, input
+ * and audio are small and go out as soon as they are queued; their bytes
+ * still count against the budget, so the media behind them makes room.
+ * Retransmissions and video wait for budget, which accrues at the pacing
+ * rate up to PACER_BURST of it. The pacing rate rises as needed to send
+ * what is queued within PACER_MAX_QUEUE_TIME, since a frame older than
+ * that is late for playout anyway.
+ *
+ * Queued datagrams are copied into buffers allocated up front, so the
+ * caller's may be reused at once. Not thread-safe; used from the sending
+ * thread.
+ */
+class Pacer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new Pacer object
+     *
+     * @param target_bitrate Media bitrate to pace to, in bits/s
+     * @param pacing_factor Pacing rate over the target (default:
+     * DEFAULT_PACING_FACTOR)
+     * @param capacity Most datagrams queued at once (default:
+     * PACER_QUEUE_SIZE)
+     *
+     * @throws std::invalid_argument If the bitrate is not positive, the
+     * factor is below 1 or the capacity is 0.
+     */
+    explicit Pacer(const int64_t target_bitrate,
+                   const double pacing_factor = DEFAULT_PACING_FACTOR,
+                   const std::size_t capacity = PACER_QUEUE_SIZE);
+
+    /**
+     * @brief Change the target bitrate, e.g. on congestion feedback
+     *
+     * @param target_bitrate Media bitrate to pace to, in bits/s
+     */
+    void set_target_bitrate(const int64_t target_bitrate);
+
+    /**
+     * @brief Change the pacing rate over the target bitrate
+     *
+     * @param pacing_factor Pacing rate over the target
+     *
+     * @throws std::invalid_argument If the factor is below 1.
+     */
+    void set_pacing_factor(const double pacing_factor);
+
+    /**
+     * @brief Copy a datagram to the back of its class's queue. Does not
+     * allocate.
+     *
+     * @param traffic_class Class of the datagram
+     * @param header First part of the datagram
+     * @param payload Rest of the datagram, possibly empty
+     * @return true if queued, false if the queue is full or the datagram
+     * too large.
+     */
+    bool enqueue(const TrafficClass traffic_class,
+                 const boost::asio::const_buffer& header,
+                 const boost::asio::const_buffer& payload);
+
+    /**
+     * @brief Take the next datagram due to be sent
+     *
+     * @param now Current time
+     * @param traffic_class Receives its class
+     * @param packet Receives the datagram
+     * @return true if one is due, false otherwise.
+     */
+    bool pop(const Clock::time_point now, TrafficClass& traffic_class,
+             PacketRef& packet);
+
+    /**
+     * @brief Get when the next datagram is due, to wake up for it. Valid
+     * after a pop. Callers wake up no more often than PACER_INTERVAL and
+     * send what is due by then, in bursts of about PACER_INTERVAL's worth.
+     *
+     * @param when Receives the time
+     * @return true if a datagram is queued, false otherwise.
+     */
+    bool next_send(Clock::time_point& when) const;
+
+    std::size_t size() const { return size_; }
+    uint64_t queued_bytes() const { return queued_bytes_; }  // Paced ones
+    double pacing_rate() const { return rate_; }  // bits/s, of the last pop
+    uint64_t dropped() const { return dropped_; }
+
+   private:
+    struct Queue {
+        std::vector<PacketRef> packets;  // Ring
+        std::size_t head = 0;
+        std::size_t count = 0;
+    };
+
+    static bool paced(const TrafficClass traffic_class) {
+        return traffic_class > TrafficClass::AUDIO;
+    }
+
+    void refill(const Clock::time_point now);
+
+    double pacing_factor_;
+    double target_rate_;  // bits/s
+    double rate_;         // bits/s, with what is queued
+    double budget_;       // bytes, negative while in debt
+    Clock::time_point last_refill_;
+    bool started_;
+    PacketPool pool_;
+    std::array<Queue, TRAFFIC_CLASS_COUNT> queues_;
+    std::size_t size_;
+    uint64_t queued_bytes_;
+    uint64_t dropped_;
+};
+
+#endif  // PACER_HPP
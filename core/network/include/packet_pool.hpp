@@ -0,0 +1,171 @@
+#ifndef PACKET_POOL_HPP
+#define PACKET_POOL_HPP
+
+#include <array>
+#include <atomic>
+#include <boost/asio/buffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+constexpr std::size_t PACKET_POOL_SIZE = 64;  // buffers per client or server
+
+class PacketPool;
+
+/**
+ * @class PacketBuffer
+ * @brief Fixed-capacity datagram buffer owned by a PacketPool. Reference
+ * counted intrusively so handles are one pointer wide.
+ */
+class PacketBuffer {
+   public:
+    static constexpr std::size_t CAPACITY = 2048;
+
+    unsigned char* data() { return data_.data(); }
+    const unsigned char* data() const { return data_.data(); }
+    std::size_t size() const { return size_; }
+    constexpr std::size_t capacity() const { return CAPACITY; }
+
+    /**
+     * @brief Set the number of valid bytes in the buffer
+     *
+     * @param size Payload size, clamped to the capacity
+     */
+    void set_size(const std::size_t size) {
+        size_ = size < CAPACITY ? size : CAPACITY;
+    }
+
+    /**
+     * @brief View the payload as characters
+     *
+     * @return std::string_view Payload view
+     */
+    std::string_view view() const {
+        return {reinterpret_cast<const char*>(data_.data()), size_};
+    }
+
+   private:
+    friend class PacketPool;
+    friend class PacketRef;
+
+    std::atomic<uint32_t> ref_count_{0};
+    PacketPool* pool_ = nullptr;
+    uint32_t index_ = 0;
+    std::atomic<uint32_t> next_free_{0};
+    std::size_t size_ = 0;
+    std::array<unsigned char, CAPACITY> data_;
+};
+
+/**
+ * @class PacketRef
+ * @brief Intrusive reference to a pooled PacketBuffer. The buffer returns to
+ * its pool when the last reference is dropped.
+ */
+class PacketRef {
+   public:
+    PacketRef() = default;
+    PacketRef(const PacketRef& other) : buffer_(other.buffer_) { retain(); }
+    PacketRef(PacketRef&& other) noexcept : buffer_(other.buffer_) {
+        other.buffer_ = nullptr;
+    }
+    ~PacketRef() { release(); }
+
+    PacketRef& operator=(PacketRef other) noexcept {
+        std::swap(buffer_, other.buffer_);
+        return *this;
+    }
+
+    explicit operator bool() const { return buffer_ != nullptr; }
+    PacketBuffer* operator->() const { return buffer_; }
+    PacketBuffer& operator*() const { return *buffer_; }
+
+    /**
+     * @brief Get an asio buffer over the valid payload
+     *
+     * @return boost::asio::const_buffer Payload buffer
+     */
+    boost::asio::const_buffer payload() const {
+        return boost::asio::buffer(buffer_->data(), buffer_->size());
+    }
+
+    /**
+     * @brief Get an asio buffer over the whole capacity, for receiving
+     *
+     * @return boost::asio::mutable_buffer Writable buffer
+     */
+    boost::asio::mutable_buffer writable() const {
+        return boost::asio::buffer(buffer_->data(), buffer_->capacity());
+    }
+
+   private:
+    friend class PacketPool;
+
+    explicit PacketRef(PacketBuffer* buffer) : buffer_(buffer) {}
+
+    void retain() {
+        if (buffer_) {
+            buffer_->ref_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void release();
+
+    PacketBuffer* buffer_ = nullptr;
+};
+
+/**
+ * @class PacketPool
+ * @brief Fixed-size pool of packet buffers allocated once up front.
+ *
+ * Acquire and release are lock-free and safe from any thread, so the input
+ * thread and the io thread can share one pool.
+ */
+class PacketPool {
+   public:
+    /**
+     * @brief Construct a new PacketPool object
+     *
+     * @param count Number of buffers to preallocate
+     */
+    explicit PacketPool(const std::size_t count);
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    /**
+     * @brief Take a buffer from the pool
+     *
+     * @return PacketRef Reference to an empty buffer, or a null reference if
+     * the pool is exhausted
+     */
+    PacketRef acquire();
+
+    /**
+     * @brief Get the number of buffers currently available
+     *
+     * @return std::size_t Free buffer count
+     */
+    std::size_t available() const {
+        return available_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    friend class PacketRef;
+
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    void give_back(PacketBuffer* buffer);
+
+    std::unique_ptr<PacketBuffer[]> buffers_;
+    std::atomic<uint64_t> free_head_;  // Tag in the upper half prevents ABA
+    std::atomic<std::size_t> available_;
+};
+
+inline void PacketRef::release() {
+    if (buffer_ &&
+        buffer_->ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        buffer_->pool_->give_back(buffer_);
+    }
+    buffer_ = nullptr;
+}
+
+#endif  // PACKET_POOL_HPP
@@ -0,0 +1,75 @@
+#ifndef PACKET_TIMESTAMPS_HPP
+#define PACKET_TIMESTAMPS_HPP
+
+#include <boost/asio.hpp>
+#include <cstdint>
+
+using boost::asio::ip::udp;
+
+/**
+ * @namespace PacketTimestamps
+ * @brief Software packet timestamps taken by the kernel (SO_TIMESTAMPING).
+ *
+ * Receive timestamps are taken when a datagram enters the stack, before it
+ * waits in the socket queue for the application, and are reported by
+ * DatagramReceiver. Transmit timestamps are only requested for datagrams
+ * sent with send_to below, and are taken when the datagram is handed to
+ * the device; they are read back from the socket's error queue. All times
+ * are CLOCK_REALTIME nanoseconds, the clock of now_ns().
+ */
+namespace PacketTimestamps {
+
+/**
+ * @brief Get the current time on the clock timestamps are taken with
+ *
+ * @return int64_t CLOCK_REALTIME in nanoseconds
+ */
+int64_t now_ns();
+
+/**
+ * @brief Enable software receive timestamps and transmit timestamps on
+ * request, numbered per socket from 0 in the order sent
+ *
+ * @param socket Open UDP socket
+ * @return true if enabled, false if not supported.
+ */
+bool enable(udp::socket& socket);
+
+/**
+ * @brief Send a datagram and request a transmit timestamp for it
+ *
+ * @param socket Socket timestamps were enabled on
+ * @param data Datagram
+ * @param endpoint Destination
+ * @param ec Set on failure
+ * @return std::size_t Bytes sent
+ */
+std::size_t send_to(udp::socket& socket, const boost::asio::const_buffer& data,
+                    const udp::endpoint& endpoint,
+                    boost::system::error_code& ec);
+
+/**
+ * @brief Read one transmit timestamp from the error queue without blocking
+ *
+ * @param socket Socket timestamps were enabled on
+ * @param id Receives the number of the timestamped datagram
+ * @param time_ns Receives the transmit time
+ * @return true if a timestamp was read, false if none is queued.
+ */
+bool read_transmit(udp::socket& socket, uint32_t& id, int64_t& time_ns);
+
+/**
+ * @brief Get the microseconds from one time to another, for histograms
+ *
+ * @param from_ns Earlier time
+ * @param to_ns Later time
+ * @return uint64_t Elapsed microseconds, 0 if to_ns is not later
+ */
+inline uint64_t elapsed_us(const int64_t from_ns, const int64_t to_ns) {
+    return to_ns > from_ns ? static_cast<uint64_t>(to_ns - from_ns) / 1000
+                           : 0;
+}
+
+}  // namespace PacketTimestamps
+
+#endif  // PACKET_TIMESTAMPS_HPP
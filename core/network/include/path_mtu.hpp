@@ -0,0 +1,185 @@
+#ifndef PATH_MTU_HPP
+#define PATH_MTU_HPP
+
+#include <array>
+#include <atomic>
+#include <boost/asio/ip/udp.hpp>
+#include <chrono>
+#include <cstdint>
+
+#include "packet_pool.hpp"
+
+using boost::asio::ip::udp;
+
+/**
+ * @namespace PathMtu
+ * @brief Probe format and limits for datagram packetization layer path MTU
+ * discovery (DPLPMTUD, RFC 8899). Sizes are UDP payload sizes.
+ *
+ * A probe is "PMTU", a type byte and a big-endian sequence number, padded
+ * with zeros to the probed size. Its acknowledgement echoes the sequence
+ * number and the size received, and is never padded.
+ */
+namespace PathMtu {
+
+constexpr std::size_t BASE_PLPMTU = 1200;  // Confirmed first, RFC 8899 5.1.2
+constexpr std::size_t MAX_PLPMTU = PacketBuffer::CAPACITY;  // Receivable
+constexpr std::size_t SEARCH_GRANULARITY = 8;  // bytes
+constexpr std::size_t MAX_PROBES = 3;          // Losses to give up a size
+constexpr std::chrono::milliseconds PROBE_TIMER{1000};  // RFC 8899 minimum
+constexpr std::chrono::seconds CONFIRMATION_TIMER{30};  // Black hole check
+constexpr std::chrono::seconds PMTU_RAISE_TIMER{600};   // Search again
+
+constexpr std::array<unsigned char, 4> MAGIC = {'P', 'M', 'T', 'U'};
+constexpr std::size_t PROBE_HEADER_SIZE = 9;  // magic, type, sequence
+constexpr std::size_t ACK_SIZE = 11;          // header, received size
+
+enum MessageType : uint8_t { PROBE = 1, PROBE_ACK = 2 };
+
+/**
+ * @brief Set the don't fragment bit on every datagram sent from the socket,
+ * ignoring the kernel's cached path MTU so larger probes still go out
+ *
+ * @param socket Open UDP socket, IPv4 or dual-stack IPv6
+ * @return true if fragmentation is disabled, false if not supported.
+ */
+bool set_dont_fragment(udp::socket& socket);
+
+/**
+ * @brief Write a zero padded probe
+ *
+ * @param sequence Probe sequence number
+ * @param size Probe size, at least PROBE_HEADER_SIZE
+ * @param buffer Destination of at least size bytes
+ */
+void build_probe(const uint32_t sequence, const std::size_t size,
+                 unsigned char* buffer);
+
+/**
+ * @brief Write the acknowledgement of a received probe
+ *
+ * @param probe Received probe
+ * @param size Size of the received probe
+ * @param buffer Destination of at least ACK_SIZE bytes
+ */
+void build_ack(const unsigned char* probe, const std::size_t size,
+               unsigned char* buffer);
+
+/**
+ * @brief Check whether a datagram is a path MTU message of the given type
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param type Expected message type
+ * @return true if it is, false otherwise.
+ */
+bool is_message(const unsigned char* data, const std::size_t size,
+                const MessageType type);
+
+/**
+ * @brief Read the sequence number of a probe or acknowledgement
+ */
+inline uint32_t sequence(const unsigned char* data) {
+    return static_cast<uint32_t>(data[5]) << 24 |
+           static_cast<uint32_t>(data[6]) << 16 |
+           static_cast<uint32_t>(data[7]) << 8 | data[8];
+}
+
+/**
+ * @brief Read the probe size echoed by an acknowledgement
+ */
+inline std::size_t acked_size(const unsigned char* data) {
+    return static_cast<std::size_t>(data[9]) << 8 | data[10];
+}
+
+}  // namespace PathMtu
+
+/**
+ * @class PathMtuDiscovery
+ * @brief Probing state machine of RFC 8899 for one path.
+ *
+ * Starts by confirming BASE_PLPMTU, then binary searches up to the maximum
+ * size, giving up a size after MAX_PROBES unacknowledged probes. Once the
+ * search completes the confirmed size is re-probed every
+ * CONFIRMATION_TIMER; if it stops getting through (a black hole), the
+ * search restarts from the base. The search for a larger size is repeated
+ * every PMTU_RAISE_TIMER. If not even the base gets through, the state is
+ * ERROR and the base is retried after CONFIRMATION_TIMER.
+ *
+ * The owner sends the probes and routes acknowledgements back. plpmtu() may
+ * be read from any thread, e.g. by a packetizer.
+ */
+class PathMtuDiscovery {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    enum State : uint8_t { BASE, SEARCHING, SEARCH_COMPLETE, ERROR };
+
+    /**
+     * @brief Construct a new PathMtuDiscovery object in the BASE state
+     *
+     * @param max_plpmtu Largest size to search for (default: MAX_PLPMTU)
+     *
+     * @throws std::invalid_argument If max_plpmtu is below BASE_PLPMTU or
+     * above MAX_PLPMTU.
+     */
+    explicit PathMtuDiscovery(
+        const std::size_t max_plpmtu = PathMtu::MAX_PLPMTU);
+
+    /**
+     * @brief Get the next probe to send. Call after every acknowledgement
+     * and at least every PROBE_TIMER.
+     *
+     * @param now Current time
+     * @param sequence Receives the sequence number of the probe
+     * @return std::size_t Size of the probe to send, 0 if none is due
+     */
+    std::size_t poll(const Clock::time_point now, uint32_t& sequence);
+
+    /**
+     * @brief Handle a probe acknowledgement
+     *
+     * @param sequence Acknowledged sequence number
+     * @param size Acknowledged size
+     * @return true if it acknowledged the outstanding probe, false otherwise.
+     */
+    bool on_ack(const uint32_t sequence, const std::size_t size);
+
+    /**
+     * @brief Handle a probe the local stack refused to send (EMSGSIZE),
+     * which fails its size at once
+     */
+    void on_send_failed();
+
+    /**
+     * @brief Get the largest confirmed UDP payload size on the path
+     *
+     * @return std::size_t Packetization layer path MTU
+     */
+    std::size_t plpmtu() const {
+        return plpmtu_.load(std::memory_order_relaxed);
+    }
+
+    State state() const { return state_; }
+
+   private:
+    void probe_failed();
+    void enter(const State state, const Clock::time_point now);
+    std::size_t next_size() const;
+
+    const std::size_t max_plpmtu_;
+    std::atomic<std::size_t> plpmtu_;
+    State state_;
+    std::size_t search_low_;   // Largest size known to pass
+    std::size_t search_high_;  // Largest size not yet known to fail
+    std::size_t probe_size_;
+    std::size_t probe_count_;  // Probes lost at probe_size_
+    uint32_t sequence_;
+    bool outstanding_;
+    bool confirming_;
+    Clock::time_point sent_time_;
+    Clock::time_point next_search_;
+    Clock::time_point next_confirmation_;
+};
+
+#endif  // PATH_MTU_HPP
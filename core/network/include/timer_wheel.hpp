@@ -0,0 +1,121 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @class TimerWheel
+ * @brief Hashed timer wheel for scheduling many short-lived deadlines with
+ * O(1) insertion. Deadlines are rounded up to the tick; entries further out
+ * than one revolution stay in their slot until their tick comes around.
+ * Entries due on the same tick expire in insertion order.
+ *
+ * @tparam T Value stored with each deadline
+ */
+template <typename T>
+class TimerWheel {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new TimerWheel object
+     *
+     * @param tick Resolution of the wheel
+     * @param slot_count Number of slots in one revolution
+     * @param start Time of tick zero
+     */
+    TimerWheel(const Clock::duration tick, const std::size_t slot_count,
+               const Clock::time_point start = Clock::now())
+        : tick_(tick), start_(start), slots_(slot_count) {}
+
+    /**
+     * @brief Schedule a value to expire at the given deadline. Deadlines in
+     * the past expire on the next advance.
+     *
+     * @param deadline Time at which the value expires
+     * @param value Value to hand back on expiry
+     */
+    void schedule(const Clock::time_point deadline, T value) {
+        const uint64_t tick = std::max(tick_at(deadline, true), current_tick_);
+        slots_[tick % slots_.size()].push_back({tick, std::move(value)});
+        ++size_;
+    }
+
+    /**
+     * @brief Expire every value due at or before now
+     *
+     * @param now Current time
+     * @param on_expire Callable invoked with each expired value. It may
+     * schedule new values.
+     * @return std::size_t Number of expired values.
+     */
+    template <typename Callback>
+    std::size_t advance(const Clock::time_point now, Callback&& on_expire) {
+        const uint64_t now_tick = tick_at(now, false);
+        std::size_t expired = 0;
+
+        while (current_tick_ <= now_tick) {
+            if (size_ == 0) {
+                current_tick_ = now_tick + 1;
+                break;
+            }
+
+            auto& slot = slots_[current_tick_ % slots_.size()];
+            due_.clear();
+            std::size_t kept = 0;
+            for (auto& entry : slot) {
+                if (entry.tick <= current_tick_) {
+                    due_.push_back(std::move(entry));
+                } else {
+                    slot[kept++] = std::move(entry);
+                }
+            }
+            slot.resize(kept);
+            size_ -= due_.size();
+            ++current_tick_;
+
+            for (auto& entry : due_) on_expire(std::move(entry.value));
+            expired += due_.size();
+        }
+        return expired;
+    }
+
+    /**
+     * @brief Time at which the wheel next needs advancing
+     *
+     * @return Clock::time_point Start of the next unprocessed tick.
+     */
+    Clock::time_point next_tick() const {
+        return start_ + tick_ * static_cast<Clock::rep>(current_tick_);
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+   private:
+    struct Entry {
+        uint64_t tick;
+        T value;
+    };
+
+    uint64_t tick_at(const Clock::time_point time, const bool round_up) const {
+        if (time <= start_) return 0;
+        const auto elapsed = (time - start_).count();
+        const auto tick = tick_.count();
+        return static_cast<uint64_t>(round_up ? (elapsed + tick - 1) / tick
+                                              : elapsed / tick);
+    }
+
+    Clock::duration tick_;
+    Clock::time_point start_;
+    std::vector<std::vector<Entry>> slots_;
+    std::vector<Entry> due_;
+    uint64_t current_tick_ = 0;
+    std::size_t size_ = 0;
+};
+
+#endif  // TIMER_WHEEL_HPP
@@ -0,0 +1,174 @@
+#ifndef UDP_SEGMENTATION_HPP
+#define UDP_SEGMENTATION_HPP
+
+#include <boost/asio.hpp>
+#include <functional>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+using boost::asio::ip::udp;
+
+/**
+ * @namespace UdpSegmentation
+ * @brief Limits used when batching datagrams with segmentation offload.
+ */
+namespace UdpSegmentation {
+
+constexpr std::size_t MAX_SEGMENTS = 64;           // Kernel UDP_MAX_SEGMENTS
+constexpr std::size_t MAX_SUPER_BUFFER = 65000;    // Below the IP length limit
+constexpr std::size_t MAX_GRO_BUFFER = 65535 + 1;  // One coalesced receive
+
+}  // namespace UdpSegmentation
+
+/**
+ * @struct GatherDatagram
+ * @brief A datagram sent from two separate buffers, e.g. a protocol header
+ * written by the sender and a payload slice that stays where it was
+ * produced. Either part may be empty.
+ */
+struct GatherDatagram {
+    boost::asio::const_buffer header;
+    boost::asio::const_buffer payload;
+
+    std::size_t size() const { return header.size() + payload.size(); }
+};
+
+/**
+ * @class UdpSegmentSender
+ * @brief Sends a batch of datagrams to one endpoint with as few syscalls as
+ * possible.
+ *
+ * Uses UDP generic segmentation offload (UDP_SEGMENT) when the kernel supports
+ * it, so a whole frame's packets are handed over as one super-buffer. Falls
+ * back to sendmmsg, and to one send_to per packet on other platforms. Packet
+ * buffers are referenced, never copied.
+ */
+class UdpSegmentSender {
+   public:
+    /**
+     * @brief Construct a new UdpSegmentSender object
+     *
+     * @param socket Open UDP socket used for sending
+     * @param enable_gso Try to use UDP_SEGMENT (default: true)
+     */
+    explicit UdpSegmentSender(udp::socket& socket,
+                              const bool enable_gso = true);
+
+    /**
+     * @brief Send a batch of datagrams to an endpoint
+     *
+     * Segmentation offload is only used for runs of equally sized, non-empty
+     * packets; the last packet of a run may be shorter. Stops early when
+     * the socket buffer is full or the kernel reports an earlier datagram
+     * refused, so the caller may retry the rest.
+     *
+     * @param packets Datagrams to send, in order
+     * @param endpoint Destination endpoint
+     * @return std::size_t Number of datagrams handed to the kernel, from the
+     * front of packets
+     *
+     * @throws boost::system::system_error On errors other than those above.
+     */
+    std::size_t send_batch(
+        const std::vector<boost::asio::const_buffer>& packets,
+        const udp::endpoint& endpoint);
+
+    /**
+     * @brief Send a batch of datagrams, each gathered from a header and a
+     * payload buffer, to an endpoint. Same batching as above.
+     *
+     * @param packets Datagrams to send, in order
+     * @param endpoint Destination endpoint
+     * @return std::size_t Number of datagrams handed to the kernel
+     */
+    std::size_t send_batch(const std::vector<GatherDatagram>& packets,
+                           const udp::endpoint& endpoint);
+
+    /**
+     * @brief Check whether segmentation offload is in use
+     *
+     * @return true if UDP_SEGMENT is used, false if falling back
+     */
+    bool gso_enabled() const { return gso_enabled_; }
+
+   private:
+    template <typename Packet>
+    std::size_t send_packets(const std::vector<Packet>& packets,
+                             const udp::endpoint& endpoint);
+    template <typename Packet>
+    std::size_t segment_run_length(const std::vector<Packet>& packets,
+                                   const std::size_t first) const;
+    template <typename Packet>
+    bool send_segmented(const std::vector<Packet>& packets,
+                        const std::size_t first, const std::size_t count,
+                        const udp::endpoint& endpoint);
+    template <typename Packet>
+    std::size_t send_mmsg(const std::vector<Packet>& packets,
+                          const std::size_t first, const std::size_t count,
+                          const udp::endpoint& endpoint);
+    template <typename Packet>
+    std::size_t send_each(const std::vector<Packet>& packets,
+                          const std::size_t first, const std::size_t count,
+                          const udp::endpoint& endpoint);
+
+    udp::socket& socket_;
+    bool gso_enabled_;
+#ifdef __linux__
+    std::vector<iovec> iovecs_;  // Up to two per datagram
+    std::vector<mmsghdr> headers_;
+#endif
+};
+
+/**
+ * @class UdpGroReceiver
+ * @brief Receives datagrams that the kernel may have coalesced with UDP
+ * generic receive offload (UDP_GRO) and splits them without copying.
+ */
+class UdpGroReceiver {
+   public:
+    /**
+     * @brief Handler called once per datagram. The data pointer is only valid
+     * for the duration of the call.
+     */
+    using DatagramHandler = std::function<void(
+        const unsigned char* data, const std::size_t size,
+        const udp::endpoint& remote_endpoint)>;
+
+    /**
+     * @brief Construct a new UdpGroReceiver object
+     *
+     * @param socket Open UDP socket used for receiving
+     * @param enable_gro Try to enable UDP_GRO on the socket (default: true)
+     */
+    explicit UdpGroReceiver(udp::socket& socket, const bool enable_gro = true);
+
+    /**
+     * @brief Receive everything currently queued on the socket without
+     * blocking
+     *
+     * @param handler Called for each datagram, in order
+     * @return std::size_t Number of datagrams delivered
+     */
+    std::size_t receive(const DatagramHandler& handler);
+
+    /**
+     * @brief Check whether coalesced receives are enabled
+     *
+     * @return true if UDP_GRO is enabled, false otherwise
+     */
+    bool gro_enabled() const { return gro_enabled_; }
+
+   private:
+    bool receive_one(const DatagramHandler& handler, std::size_t& delivered);
+
+    udp::socket& socket_;
+    bool gro_enabled_;
+    std::vector<unsigned char> buffer_;
+    udp::endpoint remote_endpoint_;
+};
+
+#endif  // UDP_SEGMENTATION_HPP
@@ -0,0 +1,45 @@
+#include "asio_backend.hpp"
+
+#include "logger.hpp"
+
+AsioBackend::AsioBackend(boost::asio::io_context& io_context,
+                         const udp::endpoint& local_endpoint)
+    : io_context_(io_context), socket_(io_context, local_endpoint) {}
+
+AsioBackend::~AsioBackend() {
+    if (socket_.is_open()) socket_.close();
+}
+
+void AsioBackend::start_receive(ReceiveHandler handler) {
+    handler_ = std::move(handler);
+    receive_next();
+}
+
+void AsioBackend::send_to(const boost::asio::const_buffer& data,
+                          const udp::endpoint& endpoint) {
+    socket_.send_to(data, endpoint);
+}
+
+void AsioBackend::run() { io_context_.run(); }
+
+void AsioBackend::stop() { io_context_.stop(); }
+
+udp::endpoint AsioBackend::local_endpoint() const {
+    return socket_.local_endpoint();
+}
+
+void AsioBackend::receive_next() {
+    socket_.async_receive_from(
+        boost::asio::buffer(recv_buffer_), remote_endpoint_,
+        [this](const boost::system::error_code& ec, std::size_t bytes_recvd) {
+            if (ec) {
+                if (ec != boost::asio::error::operation_aborted) {
+                    LOG_ERROR("Error: ", ec.message());
+                }
+                return;
+            }
+
+            handler_(recv_buffer_.data(), bytes_recvd, remote_endpoint_);
+            receive_next();
+        });
+}
@@ -0,0 +1,82 @@
+#include "datagram_receiver.hpp"
+
+#include "packet_timestamps.hpp"
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+DatagramReceiver::DatagramReceiver(udp::socket& socket)
+    : socket_(socket),
+      tracks_drops_(false),
+      kernel_drops_(0),
+      receive_time_(0),
+      overflow_drops_(Metrics::counter("drops.rx_queue_overflow")) {
+#ifdef __linux__
+    const int on = 1;
+    tracks_drops_ = setsockopt(socket_.native_handle(), SOL_SOCKET,
+                               SO_RXQ_OVFL, &on, sizeof(on)) == 0;
+#endif
+}
+
+std::size_t DatagramReceiver::receive(const boost::asio::mutable_buffer& buffer,
+                                      udp::endpoint& remote_endpoint,
+                                      boost::system::error_code& ec) {
+#ifdef __linux__
+    iovec iov = {buffer.data(), buffer.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t)) +
+                                  CMSG_SPACE(sizeof(scm_timestamping))];
+
+    msghdr msg = {};
+    msg.msg_name = remote_endpoint.data();
+    msg.msg_namelen = static_cast<socklen_t>(remote_endpoint.capacity());
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t bytes_recvd = recvmsg(socket_.native_handle(), &msg,
+                                        MSG_DONTWAIT | MSG_TRUNC);
+    if (bytes_recvd < 0) {
+        ec = errno == EAGAIN || errno == EWOULDBLOCK
+                 ? boost::asio::error::would_block
+                 : boost::system::error_code(
+                       errno, boost::asio::error::get_system_category());
+        return 0;
+    }
+    ec.clear();
+    remote_endpoint.resize(msg.msg_namelen);
+
+    // The drop count is only present once the socket has dropped something
+    receive_time_ = 0;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) continue;
+        if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+            scm_timestamping stamps;
+            std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+            receive_time_ =
+                static_cast<int64_t>(stamps.ts[0].tv_sec) * 1000000000 +
+                stamps.ts[0].tv_nsec;
+        } else if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+            uint32_t drops = 0;
+            std::memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+            overflow_drops_.add(drops - kernel_drops_);  // Wraps correctly
+            kernel_drops_ = drops;
+        }
+    }
+    if (receive_time_ == 0) receive_time_ = PacketTimestamps::now_ns();
+    return static_cast<std::size_t>(bytes_recvd);
+#else
+    if (socket_.available(ec) == 0) {
+        if (!ec) ec = boost::asio::error::would_block;
+        return 0;
+    }
+    receive_time_ = PacketTimestamps::now_ns();
+    return socket_.receive_from(buffer, remote_endpoint, 0, ec);
+#endif
+}
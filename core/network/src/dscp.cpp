@@ -0,0 +1,61 @@
+#include "dscp.hpp"
+
+#include "logger.hpp"
+
+#ifdef __linux__
+#include <netinet/in.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+namespace Dscp {
+
+bool set(udp::socket& socket, const uint8_t dscp) {
+#if defined(__linux__) || defined(_WIN32)
+    // The code point is the upper six bits of the traffic class octet; a
+    // dual-stack socket sends to IPv4-mapped peers with the IPv4 option
+    const int value = dscp << 2;
+    const auto handle = socket.native_handle();
+    bool ok = setsockopt(handle, IPPROTO_IP, IP_TOS,
+                         reinterpret_cast<const char*>(&value),
+                         sizeof(value)) == 0;
+    if (socket.local_endpoint().protocol() == udp::v6()) {
+        ok = setsockopt(handle, IPPROTO_IPV6, IPV6_TCLASS,
+                        reinterpret_cast<const char*>(&value),
+                        sizeof(value)) == 0 &&
+             ok;
+    }
+    return ok;
+#else
+    (void)socket;
+    (void)dscp;
+    return false;
+#endif
+}
+
+}  // namespace Dscp
+
+DscpMarker::DscpMarker(udp::socket& socket, const bool enabled)
+    : socket_(socket), enabled_(enabled), current_(Dscp::BEST_EFFORT) {}
+
+void DscpMarker::set_enabled(const bool enabled) {
+    if (!enabled && current_ != Dscp::BEST_EFFORT) {
+        Dscp::set(socket_, Dscp::BEST_EFFORT);
+        current_ = Dscp::BEST_EFFORT;
+    }
+    enabled_ = enabled;
+}
+
+void DscpMarker::mark(const TrafficClass traffic_class) {
+    const uint8_t dscp = Dscp::for_class(traffic_class);
+    if (!enabled_ || dscp == current_) return;
+
+    if (!Dscp::set(socket_, dscp)) {
+        LOG_WARNING("Cannot set DSCP, sending unmarked.");
+        Dscp::set(socket_, Dscp::BEST_EFFORT);
+        enabled_ = false;
+        return;
+    }
+    current_ = dscp;
+}
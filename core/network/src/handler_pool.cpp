@@ -0,0 +1,66 @@
+#include "handler_pool.hpp"
+
+#include <new>
+
+namespace {
+
+constexpr uint64_t pack(const uint32_t tag, const uint32_t index) {
+    return (static_cast<uint64_t>(tag) << 32) | index;
+}
+
+constexpr uint32_t index_of(const uint64_t head) {
+    return static_cast<uint32_t>(head);
+}
+
+constexpr uint32_t tag_of(const uint64_t head) {
+    return static_cast<uint32_t>(head >> 32);
+}
+
+}  // namespace
+
+HandlerPool::HandlerPool() : free_head_(pack(0, 0)) {
+    for (std::size_t i = 0; i < BLOCKS; ++i) {
+        next_free_[i].store(i + 1 < BLOCKS ? static_cast<uint32_t>(i + 1)
+                                           : NONE,
+                            std::memory_order_relaxed);
+    }
+}
+
+HandlerPool& HandlerPool::instance() {
+    static HandlerPool pool;
+    return pool;
+}
+
+void* HandlerPool::allocate(const std::size_t size) {
+    if (size > BLOCK_SIZE) return ::operator new(size);
+
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (index_of(head) != NONE) {
+        const uint64_t next =
+            pack(tag_of(head) + 1,
+                 next_free_[index_of(head)].load(std::memory_order_relaxed));
+        if (free_head_.compare_exchange_weak(head, next,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+            return &blocks_[index_of(head)];
+        }
+    }
+    return ::operator new(size);
+}
+
+void HandlerPool::deallocate(void* pointer) {
+    const auto address = reinterpret_cast<std::uintptr_t>(pointer);
+    const auto first = reinterpret_cast<std::uintptr_t>(blocks_.data());
+    if (address < first || address >= first + sizeof(blocks_)) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    const auto index = static_cast<uint32_t>((address - first) / BLOCK_SIZE);
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    do {
+        next_free_[index].store(index_of(head), std::memory_order_relaxed);
+    } while (!free_head_.compare_exchange_weak(
+        head, pack(tag_of(head) + 1, index), std::memory_order_release,
+        std::memory_order_relaxed));
+}
@@ -0,0 +1,417 @@
+#include "io_uring_backend.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "logger.hpp"
+
+using namespace IoUringConfig;
+
+namespace {
+
+// Operation tags stored in the upper bits of the SQE user data
+constexpr uint64_t OP_RECV = 1ULL << 32;
+constexpr uint64_t OP_SEND = 2ULL << 32;
+constexpr uint64_t OP_WAKE = 3ULL << 32;
+constexpr uint64_t OP_MASK = 0xFFFFFFFFULL << 32;
+
+constexpr int FIXED_SOCKET_INDEX = 0;
+
+[[noreturn]] void throw_error(const int error, const char* what) {
+    throw boost::system::system_error(
+        boost::system::error_code(error,
+                                  boost::asio::error::get_system_category()),
+        what);
+}
+
+int io_uring_setup(const unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(const int fd, const unsigned to_submit,
+                   const unsigned min_complete, const unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+int io_uring_register(const int fd, const unsigned opcode, void* arg,
+                      const unsigned nr_args) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+}  // namespace
+
+IoUringBackend::IoUringBackend(boost::asio::io_context& io_context,
+                               const udp::endpoint& local_endpoint)
+    : socket_(io_context, local_endpoint),
+      ring_fd_(-1),
+      wake_fd_(-1),
+      wake_value_(0),
+      stopped_(false),
+      sq_ring_(MAP_FAILED),
+      cq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_size_(0),
+      sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      sqes_size_(0),
+      pending_(0),
+      buf_ring_(static_cast<io_uring_buf_ring*>(MAP_FAILED)),
+      buf_ring_size_(0),
+      recv_slab_(static_cast<std::size_t>(RECV_BUFFER_COUNT) *
+                 RECV_BUFFER_SIZE),
+      recv_msg_{},
+      send_slots_(SEND_SLOT_COUNT),
+      send_arena_(static_cast<std::size_t>(SEND_SLOT_COUNT) *
+                  SEND_BUFFER_SIZE),
+      fixed_sends_(false) {
+    setup_ring();
+    setup_buffer_ring();
+    register_socket();
+    setup_send_buffers();
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (wake_fd_ < 0) throw_error(errno, "eventfd");
+
+    free_slots_.reserve(SEND_SLOT_COUNT);
+    for (unsigned i = 0; i < SEND_SLOT_COUNT; ++i) {
+        free_slots_.push_back(static_cast<uint16_t>(SEND_SLOT_COUNT - 1 - i));
+    }
+
+    // Only the source address is needed back; payload follows the header
+    recv_msg_.msg_namelen = static_cast<socklen_t>(remote_endpoint_.capacity());
+}
+
+IoUringBackend::~IoUringBackend() {
+    if (ring_fd_ >= 0) close(ring_fd_);  // Cancels all in-flight requests
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (buf_ring_ != MAP_FAILED) munmap(buf_ring_, buf_ring_size_);
+    if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+    if (socket_.is_open()) socket_.close();
+}
+
+void IoUringBackend::start_receive(ReceiveHandler handler) {
+    handler_ = std::move(handler);
+    arm_receive();
+    arm_wakeup();
+    submit(0);
+}
+
+void IoUringBackend::send_to(const boost::asio::const_buffer& data,
+                             const udp::endpoint& endpoint) {
+    if (data.size() > SEND_BUFFER_SIZE) {
+        throw std::invalid_argument("Datagram larger than the send buffer");
+    }
+
+    // Reap completed sends until a slot frees up
+    while (free_slots_.empty()) {
+        submit(1);
+        process_completions();
+    }
+
+    const uint16_t index = free_slots_.back();
+    free_slots_.pop_back();
+
+    SendSlot& slot = send_slots_[index];
+    unsigned char* buffer = send_buffer(index);
+    std::memcpy(buffer, data.data(), data.size());
+    slot.endpoint = endpoint;
+
+    io_uring_sqe* sqe = next_sqe();
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = FIXED_SOCKET_INDEX;
+    sqe->user_data = OP_SEND | index;
+    if (fixed_sends_) {
+        sqe->opcode = IORING_OP_SEND_ZC;
+        sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = SEND_BUFFER_INDEX;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = static_cast<uint32_t>(data.size());
+        sqe->addr2 = reinterpret_cast<uint64_t>(slot.endpoint.data());
+        sqe->addr_len = static_cast<uint16_t>(slot.endpoint.size());
+        return;
+    }
+
+    slot.iov = {buffer, data.size()};
+    slot.msg = {};
+    slot.msg.msg_name = slot.endpoint.data();
+    slot.msg.msg_namelen = static_cast<socklen_t>(slot.endpoint.size());
+    slot.msg.msg_iov = &slot.iov;
+    slot.msg.msg_iovlen = 1;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.msg);
+    sqe->len = 1;
+}
+
+void IoUringBackend::flush() { submit(0); }
+
+void IoUringBackend::run() {
+    while (!stopped_.load(std::memory_order_acquire)) {
+        submit(1);
+        process_completions();
+    }
+}
+
+void IoUringBackend::stop() {
+    stopped_.store(true, std::memory_order_release);
+    const uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+        LOG_ERROR("Failed to wake io_uring loop");
+    }
+}
+
+udp::endpoint IoUringBackend::local_endpoint() const {
+    return socket_.local_endpoint();
+}
+
+void IoUringBackend::setup_ring() {
+    io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = CQ_ENTRIES;
+    ring_fd_ = io_uring_setup(RING_ENTRIES, &params);
+    if (ring_fd_ < 0) throw_error(errno, "io_uring_setup");
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        throw_error(ENOSYS, "io_uring single mmap");
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) throw_error(errno, "mmap sq ring");
+    cq_ring_ = sq_ring_;
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(
+        mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) throw_error(errno, "mmap sqes");
+
+    auto* sq = static_cast<unsigned char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    auto* cq = static_cast<unsigned char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+void IoUringBackend::setup_buffer_ring() {
+    buf_ring_size_ = RECV_BUFFER_COUNT * sizeof(io_uring_buf);
+    buf_ring_ = static_cast<io_uring_buf_ring*>(
+        mmap(nullptr, buf_ring_size_, PROT_READ | PROT_WRITE,
+             MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    if (buf_ring_ == MAP_FAILED) throw_error(errno, "mmap buffer ring");
+
+    io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(buf_ring_);
+    reg.ring_entries = RECV_BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        throw_error(errno, "register buffer ring");
+    }
+
+    buf_ring_->tail = 0;
+    for (unsigned i = 0; i < RECV_BUFFER_COUNT; ++i) {
+        recycle_buffer(static_cast<uint16_t>(i));
+    }
+}
+
+void IoUringBackend::register_socket() {
+    int fd = socket_.native_handle();
+    if (io_uring_register(ring_fd_, IORING_REGISTER_FILES, &fd, 1) < 0) {
+        throw_error(errno, "register socket");
+    }
+}
+
+void IoUringBackend::setup_send_buffers() {
+    if (!supports(IORING_OP_SEND_ZC)) {
+        LOG_INFO("io_uring zero-copy send unsupported, sending with sendmsg");
+        return;
+    }
+
+    iovec arena = {send_arena_.data(), send_arena_.size()};
+    if (io_uring_register(ring_fd_, IORING_REGISTER_BUFFERS, &arena, 1) < 0) {
+        LOG_WARNING("Cannot register io_uring send buffers (",
+                    std::strerror(errno), "), sending with sendmsg");
+        return;
+    }
+    fixed_sends_ = true;
+}
+
+bool IoUringBackend::supports(const uint8_t opcode) const {
+    // The probe ends in a flexible array, sized here for every opcode
+    alignas(io_uring_probe) unsigned char
+        storage[sizeof(io_uring_probe) +
+                IORING_OP_LAST * sizeof(io_uring_probe_op)] = {};
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage);
+    if (io_uring_register(ring_fd_, IORING_REGISTER_PROBE, probe,
+                          IORING_OP_LAST) < 0) {
+        return false;
+    }
+    return opcode <= probe->last_op &&
+           (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+}
+
+unsigned char* IoUringBackend::send_buffer(const uint16_t index) {
+    return send_arena_.data() +
+           static_cast<std::size_t>(index) * SEND_BUFFER_SIZE;
+}
+
+io_uring_sqe* IoUringBackend::next_sqe() {
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (*sq_tail_ + pending_ - head > *sq_mask_) submit(0);
+
+    const unsigned tail = *sq_tail_ + pending_;
+    const unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    ++pending_;
+    return sqe;
+}
+
+void IoUringBackend::submit(const unsigned wait_for) {
+    const unsigned to_submit = pending_;
+    if (to_submit > 0) {
+        __atomic_store_n(sq_tail_, *sq_tail_ + to_submit, __ATOMIC_RELEASE);
+        pending_ = 0;
+    }
+    if (to_submit == 0 && wait_for == 0) return;
+
+    const unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (io_uring_enter(ring_fd_, to_submit, wait_for, flags) < 0) {
+        if (errno != EINTR) throw_error(errno, "io_uring_enter");
+    }
+}
+
+void IoUringBackend::arm_receive() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+    sqe->fd = FIXED_SOCKET_INDEX;
+    sqe->addr = reinterpret_cast<uint64_t>(&recv_msg_);
+    sqe->len = 1;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = OP_RECV;
+}
+
+void IoUringBackend::arm_wakeup() {
+    io_uring_sqe* sqe = next_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wake_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&wake_value_);
+    sqe->len = sizeof(wake_value_);
+    sqe->user_data = OP_WAKE;
+}
+
+unsigned IoUringBackend::process_completions() {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    unsigned processed = 0;
+
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+
+        switch (cqe.user_data & OP_MASK) {
+            case OP_RECV:
+                handle_receive(cqe);
+                break;
+            case OP_SEND:
+                // A zero-copy send completes with its result, then with a
+                // notification once the kernel no longer reads the slot
+                if (cqe.res < 0 && !(cqe.flags & IORING_CQE_F_NOTIF)) {
+                    LOG_ERROR("Error: ", std::strerror(-cqe.res));
+                }
+                if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                    free_slots_.push_back(
+                        static_cast<uint16_t>(cqe.user_data & ~OP_MASK));
+                }
+                break;
+            case OP_WAKE:
+                if (!stopped_.load(std::memory_order_acquire)) arm_wakeup();
+                break;
+            default:
+                break;
+        }
+
+        ++head;
+        ++processed;
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return processed;
+}
+
+void IoUringBackend::handle_receive(const io_uring_cqe& cqe) {
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        const uint16_t buffer_id =
+            static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+
+        if (cqe.res >= 0) {
+            const unsigned char* buffer =
+                recv_slab_.data() +
+                static_cast<std::size_t>(buffer_id) * RECV_BUFFER_SIZE;
+            io_uring_recvmsg_out out;
+            std::memcpy(&out, buffer, sizeof(out));
+
+            const unsigned char* name = buffer + sizeof(out);
+            const unsigned char* payload =
+                name + recv_msg_.msg_namelen + recv_msg_.msg_controllen;
+
+            if (out.flags & MSG_TRUNC) {
+                LOG_WARNING("Received message too large.");
+            } else if (handler_) {
+                std::memcpy(remote_endpoint_.data(), name,
+                            std::min<std::size_t>(out.namelen,
+                                                  recv_msg_.msg_namelen));
+                remote_endpoint_.resize(out.namelen);
+                handler_(payload, out.payloadlen, remote_endpoint_);
+            }
+        }
+
+        recycle_buffer(buffer_id);
+    } else if (cqe.res < 0 && cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        LOG_ERROR("Error: ", std::strerror(-cqe.res));
+    }
+
+    // The kernel ends a multishot request on errors or buffer exhaustion
+    if (!(cqe.flags & IORING_CQE_F_MORE) &&
+        !stopped_.load(std::memory_order_acquire)) {
+        arm_receive();
+    }
+}
+
+void IoUringBackend::recycle_buffer(const uint16_t buffer_id) {
+    // Index the entries by hand: in C++ the kernel's flexible array member
+    // macro inserts an empty struct that shifts bufs by eight bytes.
+    auto* bufs = reinterpret_cast<io_uring_buf*>(buf_ring_);
+    const uint16_t tail = buf_ring_->tail;
+    io_uring_buf& buf = bufs[tail & (RECV_BUFFER_COUNT - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(
+        recv_slab_.data() +
+        static_cast<std::size_t>(buffer_id) * RECV_BUFFER_SIZE);
+    buf.len = RECV_BUFFER_SIZE;
+    buf.bid = buffer_id;
+    __atomic_store_n(&buf_ring_->tail, static_cast<uint16_t>(tail + 1),
+                     __ATOMIC_RELEASE);
+}
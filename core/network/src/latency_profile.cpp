@@ -0,0 +1,148 @@
+#include "latency_profile.hpp"
+
+#include <stdexcept>
+
+#include "logger.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+int parse_int(const std::unordered_map<std::string, std::string>& options,
+              const std::string& name, const int fallback, const int min,
+              const int max) {
+    const auto it = options.find(name);
+    if (it == options.end()) return fallback;
+
+    std::size_t end = 0;
+    int value = 0;
+    try {
+        value = std::stoi(it->second, &end);
+    } catch (const std::exception&) {
+        end = 0;
+    }
+    if (end == 0 || end != it->second.size() || value < min || value > max) {
+        throw std::invalid_argument("Invalid value for --" + name);
+    }
+    return value;
+}
+
+#ifdef __linux__
+/**
+ * @brief Set a socket buffer size, past the system maximum if permitted
+ */
+void set_buffer(const int fd, const int force_option, const int option,
+                const int size, const char* name) {
+    if (setsockopt(fd, SOL_SOCKET, force_option, &size, sizeof(size)) != 0 &&
+        setsockopt(fd, SOL_SOCKET, option, &size, sizeof(size)) != 0) {
+        LOG_WARNING("Cannot set the ", name,
+                    " buffer: ", std::strerror(errno));
+        return;
+    }
+
+    // The kernel reports twice the usable size, for its bookkeeping
+    int effective = 0;
+    socklen_t length = sizeof(effective);
+    getsockopt(fd, SOL_SOCKET, option, &effective, &length);
+    if (effective / 2 < size) {
+        LOG_INFO("The ", name, " buffer is capped at ", effective / 2,
+                 " bytes; raise net.core.", force_option == SO_RCVBUFFORCE
+                                                ? "rmem_max"
+                                                : "wmem_max",
+                 " for more.");
+    }
+}
+#endif
+
+}  // namespace
+
+LatencyProfile LatencyProfile::from_options(
+    const std::unordered_map<std::string, std::string>& options) {
+    LatencyProfile profile;
+    profile.enabled = options.count("latency-profile") != 0;
+    profile.busy_poll =
+        parse_int(options, "busy-poll", DEFAULT_BUSY_POLL, 0, 1000000);
+    profile.cpu = parse_int(options, "cpu", -1, -1, 1023);
+    profile.realtime_priority =
+        parse_int(options, "rt-priority", DEFAULT_REALTIME_PRIORITY, 0, 99);
+    profile.socket_buffer = parse_int(options, "socket-buffer",
+                                      DEFAULT_SOCKET_BUFFER, 1, 1 << 30);
+    return profile;
+}
+
+void LatencyProfile::apply(udp::socket& socket) const {
+    if (!enabled) return;
+
+#ifdef __linux__
+    const int fd = socket.native_handle();
+    // Above net.core.busy_read this needs CAP_NET_ADMIN
+    if (busy_poll > 0 && setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll,
+                                    sizeof(busy_poll)) != 0) {
+        LOG_WARNING("Cannot set SO_BUSY_POLL: ", std::strerror(errno));
+    }
+    set_buffer(fd, SO_RCVBUFFORCE, SO_RCVBUF, socket_buffer, "receive");
+    set_buffer(fd, SO_SNDBUFFORCE, SO_SNDBUF, socket_buffer, "send");
+#else
+    boost::system::error_code ec;
+    socket.set_option(udp::socket::receive_buffer_size(socket_buffer), ec);
+    socket.set_option(udp::socket::send_buffer_size(socket_buffer), ec);
+    if (ec) LOG_WARNING("Cannot set the socket buffers: ", ec.message());
+#endif
+}
+
+void LatencyProfile::apply_to_current_thread() const {
+    if (!enabled) return;
+
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        const int error =
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (error != 0) {
+            LOG_WARNING("Cannot pin the io thread to CPU ", cpu, ": ",
+                        std::strerror(error));
+        }
+    }
+
+    if (realtime_priority > 0 && busy_poll > 0 && cpu < 0) {
+        // A spinning SCHED_FIFO thread would starve whatever shares its core
+        LOG_WARNING("Not using SCHED_FIFO while busy polling without --cpu.");
+    } else if (realtime_priority > 0) {
+        sched_param param = {};
+        param.sched_priority = realtime_priority;
+        const int error =
+            pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error != 0) {
+            LOG_INFO("SCHED_FIFO not permitted (", std::strerror(error),
+                     "), keeping the default scheduler.");
+        }
+    }
+#else
+    if (cpu >= 0 || realtime_priority > 0) {
+        LOG_INFO("CPU pinning and SCHED_FIFO are only supported on Linux.");
+    }
+#endif
+}
+
+void LatencyProfile::run(boost::asio::io_context& io_context,
+                         const std::function<void()>& poll_receive) const {
+    apply_to_current_thread();
+    if (!enabled || busy_poll == 0) {
+        io_context.run();
+        return;
+    }
+
+    while (!io_context.stopped()) {
+        poll_receive();
+        io_context.poll();
+    }
+}
@@ -0,0 +1,33 @@
+#include "network_backend.hpp"
+
+#include "asio_backend.hpp"
+#include "logger.hpp"
+
+#ifdef __linux__
+#include "io_uring_backend.hpp"
+#endif
+
+std::unique_ptr<NetworkBackend> NetworkBackend::create(
+    const BackendType type, boost::asio::io_context& io_context,
+    const udp::endpoint& local_endpoint) {
+    switch (type) {
+        case BackendType::IO_URING:
+#ifdef __linux__
+            try {
+                return std::make_unique<IoUringBackend>(io_context,
+                                                        local_endpoint);
+            } catch (const std::exception& e) {
+                LOG_WARNING("io_uring backend unavailable (", e.what(),
+                            "), falling back to asio");
+            }
+#else
+            LOG_WARNING(
+                "io_uring backend unavailable on this platform, falling back "
+                "to asio");
+#endif
+            [[fallthrough]];
+        case BackendType::ASIO:
+        default:
+            return std::make_unique<AsioBackend>(io_context, local_endpoint);
+    }
+}
@@ -0,0 +1,124 @@
+#include "pacer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+double seconds(const Pacer::Clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+Pacer::Pacer(const int64_t target_bitrate, const double pacing_factor,
+             const std::size_t capacity)
+    : pacing_factor_(pacing_factor),
+      target_rate_(static_cast<double>(target_bitrate)),
+      rate_(target_rate_ * pacing_factor),
+      budget_(0),
+      started_(false),
+      pool_(capacity),
+      size_(0),
+      queued_bytes_(0),
+      dropped_(0) {
+    if (target_bitrate <= 0 || !(pacing_factor >= 1) || capacity == 0) {
+        throw std::invalid_argument(
+            "Bitrate must be positive, pacing factor at least 1 and "
+            "capacity positive");
+    }
+    for (Queue& queue : queues_) {
+        queue.packets.resize(capacity);
+    }
+}
+
+void Pacer::set_target_bitrate(const int64_t target_bitrate) {
+    if (target_bitrate > 0) {
+        target_rate_ = static_cast<double>(target_bitrate);
+    }
+}
+
+void Pacer::set_pacing_factor(const double pacing_factor) {
+    if (!(pacing_factor >= 1)) {
+        throw std::invalid_argument("Pacing factor must be at least 1");
+    }
+    pacing_factor_ = pacing_factor;
+}
+
+bool Pacer::enqueue(const TrafficClass traffic_class,
+                    const boost::asio::const_buffer& header,
+                    const boost::asio::const_buffer& payload) {
+    Queue& queue = queues_[static_cast<std::size_t>(traffic_class)];
+    const std::size_t size = header.size() + payload.size();
+    PacketRef packet;
+    if (size > PacketBuffer::CAPACITY || queue.count == queue.packets.size() ||
+        !(packet = pool_.acquire())) {
+        ++dropped_;
+        return false;
+    }
+
+    std::memcpy(packet->data(), header.data(), header.size());
+    std::memcpy(packet->data() + header.size(), payload.data(),
+                payload.size());
+    packet->set_size(size);
+    queue.packets[(queue.head + queue.count) % queue.packets.size()] =
+        std::move(packet);
+    ++queue.count;
+    ++size_;
+    if (paced(traffic_class)) queued_bytes_ += size;
+    return true;
+}
+
+bool Pacer::pop(const Clock::time_point now, TrafficClass& traffic_class,
+                PacketRef& packet) {
+    refill(now);
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+        Queue& queue = queues_[i];
+        if (queue.count == 0) continue;
+
+        // Strict priority: while this class waits, the ones below it do too
+        const auto queue_class = static_cast<TrafficClass>(i);
+        if (paced(queue_class) && budget_ < 0) return false;
+
+        packet = std::move(queue.packets[queue.head]);
+        queue.head = (queue.head + 1) % queue.packets.size();
+        --queue.count;
+        --size_;
+        budget_ -= static_cast<double>(packet->size());
+        if (paced(queue_class)) queued_bytes_ -= packet->size();
+        traffic_class = queue_class;
+        return true;
+    }
+    return false;
+}
+
+bool Pacer::next_send(Clock::time_point& when) const {
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+        if (queues_[i].count == 0) continue;
+
+        when = last_refill_;
+        if (paced(static_cast<TrafficClass>(i)) && budget_ < 0) {
+            when += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(-budget_ * 8 / rate_));
+        }
+        return true;
+    }
+    return false;
+}
+
+void Pacer::refill(const Clock::time_point now) {
+    if (!started_) {
+        started_ = true;
+        last_refill_ = now;
+    }
+    const double elapsed = seconds(std::max(now - last_refill_,
+                                            Clock::duration::zero()));
+    last_refill_ = std::max(last_refill_, now);
+
+    rate_ = std::max(target_rate_ * pacing_factor_,
+                     static_cast<double>(queued_bytes_) * 8 /
+                         seconds(PACER_MAX_QUEUE_TIME));
+    budget_ = std::min(budget_ + rate_ * elapsed / 8,
+                       rate_ * seconds(PACER_BURST) / 8);
+}
@@ -0,0 +1,59 @@
+#include "packet_pool.hpp"
+
+namespace {
+
+constexpr uint64_t pack(const uint32_t tag, const uint32_t index) {
+    return (static_cast<uint64_t>(tag) << 32) | index;
+}
+
+constexpr uint32_t index_of(const uint64_t head) {
+    return static_cast<uint32_t>(head);
+}
+
+constexpr uint32_t tag_of(const uint64_t head) {
+    return static_cast<uint32_t>(head >> 32);
+}
+
+}  // namespace
+
+PacketPool::PacketPool(const std::size_t count)
+    : buffers_(std::make_unique<PacketBuffer[]>(count)),
+      free_head_(pack(0, count > 0 ? 0 : NONE)),
+      available_(count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        buffers_[i].pool_ = this;
+        buffers_[i].index_ = static_cast<uint32_t>(i);
+        buffers_[i].next_free_.store(
+            i + 1 < count ? static_cast<uint32_t>(i + 1) : NONE,
+            std::memory_order_relaxed);
+    }
+}
+
+PacketRef PacketPool::acquire() {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (index_of(head) != NONE) {
+        PacketBuffer& buffer = buffers_[index_of(head)];
+        const uint64_t next = pack(
+            tag_of(head) + 1,
+            buffer.next_free_.load(std::memory_order_relaxed));
+        if (free_head_.compare_exchange_weak(head, next,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+            available_.fetch_sub(1, std::memory_order_relaxed);
+            buffer.size_ = 0;
+            buffer.ref_count_.store(1, std::memory_order_relaxed);
+            return PacketRef(&buffer);
+        }
+    }
+    return PacketRef();
+}
+
+void PacketPool::give_back(PacketBuffer* buffer) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    do {
+        buffer->next_free_.store(index_of(head), std::memory_order_relaxed);
+    } while (!free_head_.compare_exchange_weak(
+        head, pack(tag_of(head) + 1, buffer->index_),
+        std::memory_order_release, std::memory_order_relaxed));
+    available_.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,129 @@
+#include "packet_timestamps.hpp"
+
+#include <chrono>
+
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#endif
+
+namespace PacketTimestamps {
+
+int64_t now_ns() {
+#ifdef __linux__
+    timespec time = {};
+    clock_gettime(CLOCK_REALTIME, &time);
+    return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+bool enable(udp::socket& socket) {
+#ifdef __linux__
+    // TSONLY: the error queue returns the timestamp without the packet
+    const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+                      SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    return setsockopt(socket.native_handle(), SOL_SOCKET, SO_TIMESTAMPING,
+                      &flags, sizeof(flags)) == 0;
+#else
+    (void)socket;
+    return false;
+#endif
+}
+
+std::size_t send_to(udp::socket& socket, const boost::asio::const_buffer& data,
+                    const udp::endpoint& endpoint,
+                    boost::system::error_code& ec) {
+#ifdef __linux__
+    iovec iov = {const_cast<void*>(data.data()), data.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint32_t))] = {};
+
+    msghdr msg = {};
+    msg.msg_name = const_cast<void*>(static_cast<const void*>(endpoint.data()));
+    msg.msg_namelen = static_cast<socklen_t>(endpoint.size());
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SO_TIMESTAMPING;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+    const uint32_t flags = SOF_TIMESTAMPING_TX_SOFTWARE;
+    std::memcpy(CMSG_DATA(cmsg), &flags, sizeof(flags));
+
+    const ssize_t bytes_sent = sendmsg(socket.native_handle(), &msg, 0);
+    if (bytes_sent < 0) {
+        ec = boost::system::error_code(
+            errno, boost::asio::error::get_system_category());
+        return 0;
+    }
+    ec.clear();
+    return static_cast<std::size_t>(bytes_sent);
+#else
+    return socket.send_to(data, endpoint, 0, ec);
+#endif
+}
+
+bool read_transmit(udp::socket& socket, uint32_t& id, int64_t& time_ns) {
+#ifdef __linux__
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping)) +
+                                  CMSG_SPACE(sizeof(sock_extended_err) +
+                                             sizeof(sockaddr_in6))];
+    msghdr msg = {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    // Not a timestamp, e.g. an ICMP error: skip it and look further
+    for (;;) {
+        if (recvmsg(socket.native_handle(), &msg,
+                    MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return false;
+        }
+
+        bool has_time = false;
+        bool has_id = false;
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET &&
+                cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                scm_timestamping stamps;
+                std::memcpy(&stamps, CMSG_DATA(cmsg), sizeof(stamps));
+                time_ns = static_cast<int64_t>(stamps.ts[0].tv_sec) *
+                              1000000000 +
+                          stamps.ts[0].tv_nsec;
+                has_time = true;
+            } else if ((cmsg->cmsg_level == SOL_IP &&
+                        cmsg->cmsg_type == IP_RECVERR) ||
+                       (cmsg->cmsg_level == SOL_IPV6 &&
+                        cmsg->cmsg_type == IPV6_RECVERR)) {
+                sock_extended_err error;
+                std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+                if (error.ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+                    id = error.ee_data;
+                    has_id = true;
+                }
+            }
+        }
+        if (has_time && has_id) return true;
+        msg.msg_controllen = sizeof(control);
+    }
+#else
+    (void)socket;
+    (void)id;
+    (void)time_ns;
+    return false;
+#endif
+}
+
+}  // namespace PacketTimestamps
@@ -0,0 +1,237 @@
+#include "path_mtu.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.hpp"
+
+#ifdef __linux__
+#include <netinet/in.h>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+using namespace PathMtu;
+
+namespace PathMtu {
+
+bool set_dont_fragment(udp::socket& socket) {
+#ifdef __linux__
+    // PROBE sets DF but ignores the cached path MTU, leaving the search to
+    // the probes instead of ICMP (RFC 8899, section 4.6)
+    const int value = IP_PMTUDISC_PROBE;
+    const int fd = socket.native_handle();
+    bool ok = setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &value,
+                         sizeof(value)) == 0;
+    if (socket.local_endpoint().protocol() == udp::v6()) {
+        ok = setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &value,
+                        sizeof(value)) == 0 &&
+             ok;
+    }
+    return ok;
+#elif defined(_WIN32)
+    const DWORD value = 1;
+    const auto handle = socket.native_handle();
+    bool ok = setsockopt(handle, IPPROTO_IP, IP_DONTFRAGMENT,
+                         reinterpret_cast<const char*>(&value),
+                         sizeof(value)) == 0;
+    if (socket.local_endpoint().protocol() == udp::v6()) {
+        ok = setsockopt(handle, IPPROTO_IPV6, IPV6_DONTFRAG,
+                        reinterpret_cast<const char*>(&value),
+                        sizeof(value)) == 0 &&
+             ok;
+    }
+    return ok;
+#else
+    (void)socket;
+    return false;
+#endif
+}
+
+void build_probe(const uint32_t sequence, const std::size_t size,
+                 unsigned char* buffer) {
+    std::memcpy(buffer, MAGIC.data(), MAGIC.size());
+    buffer[4] = PROBE;
+    buffer[5] = static_cast<unsigned char>(sequence >> 24);
+    buffer[6] = static_cast<unsigned char>(sequence >> 16);
+    buffer[7] = static_cast<unsigned char>(sequence >> 8);
+    buffer[8] = static_cast<unsigned char>(sequence);
+    std::memset(buffer + PROBE_HEADER_SIZE, 0, size - PROBE_HEADER_SIZE);
+}
+
+void build_ack(const unsigned char* probe, const std::size_t size,
+               unsigned char* buffer) {
+    std::memcpy(buffer, probe, PROBE_HEADER_SIZE);
+    buffer[4] = PROBE_ACK;
+    buffer[9] = static_cast<unsigned char>(size >> 8);
+    buffer[10] = static_cast<unsigned char>(size);
+}
+
+bool is_message(const unsigned char* data, const std::size_t size,
+                const MessageType type) {
+    const std::size_t expected_size = type == PROBE_ACK ? ACK_SIZE : 0;
+    if (size < PROBE_HEADER_SIZE ||
+        (expected_size != 0 && size != expected_size)) {
+        return false;
+    }
+    return std::memcmp(data, MAGIC.data(), MAGIC.size()) == 0 &&
+           data[4] == type;
+}
+
+}  // namespace PathMtu
+
+PathMtuDiscovery::PathMtuDiscovery(const std::size_t max_plpmtu)
+    : max_plpmtu_(max_plpmtu),
+      plpmtu_(BASE_PLPMTU),
+      state_(BASE),
+      search_low_(BASE_PLPMTU),
+      search_high_(max_plpmtu),
+      probe_size_(0),
+      probe_count_(0),
+      sequence_(0),
+      outstanding_(false),
+      confirming_(false) {
+    if (max_plpmtu < BASE_PLPMTU || max_plpmtu > MAX_PLPMTU) {
+        throw std::invalid_argument("Invalid maximum path MTU");
+    }
+}
+
+std::size_t PathMtuDiscovery::poll(const Clock::time_point now,
+                                   uint32_t& sequence) {
+    if (outstanding_) {
+        if (now - sent_time_ < PROBE_TIMER) return 0;
+        outstanding_ = false;
+        if (++probe_count_ >= MAX_PROBES) probe_failed();
+    }
+
+    switch (state_) {
+        case SEARCH_COMPLETE:
+            if (now >= next_search_) {
+                enter(SEARCHING, now);
+            } else if (now >= next_confirmation_) {
+                confirming_ = true;
+            } else if (!confirming_) {
+                return 0;
+            }
+            break;
+        case ERROR:
+            if (now < next_search_) return 0;
+            enter(BASE, now);
+            break;
+        default:
+            break;
+    }
+    // Entering SEARCHING may complete the search straight away
+    if (state_ == SEARCH_COMPLETE && !confirming_) return 0;
+
+    const std::size_t size = next_size();
+    if (size != probe_size_) {
+        probe_size_ = size;
+        probe_count_ = 0;
+    }
+    sequence = ++sequence_;
+    sent_time_ = now;
+    outstanding_ = true;
+    return size;
+}
+
+bool PathMtuDiscovery::on_ack(const uint32_t sequence,
+                              const std::size_t size) {
+    if (!outstanding_ || sequence != sequence_ || size != probe_size_) {
+        return false;
+    }
+    outstanding_ = false;
+    probe_count_ = 0;
+
+    switch (state_) {
+        case BASE:
+            LOG_INFO("Path MTU base size ", size, " confirmed, searching.");
+            enter(SEARCHING, sent_time_);
+            break;
+        case SEARCHING:
+            search_low_ = size;
+            plpmtu_.store(size, std::memory_order_relaxed);
+            if (search_high_ - search_low_ < SEARCH_GRANULARITY) {
+                enter(SEARCH_COMPLETE, sent_time_);
+            }
+            break;
+        case SEARCH_COMPLETE:
+            confirming_ = false;
+            next_confirmation_ = sent_time_ + CONFIRMATION_TIMER;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+void PathMtuDiscovery::on_send_failed() {
+    if (!outstanding_) return;
+    outstanding_ = false;
+    probe_failed();
+}
+
+void PathMtuDiscovery::probe_failed() {
+    probe_count_ = 0;
+
+    switch (state_) {
+        case BASE:
+            LOG_WARNING("Path MTU base size ", probe_size_,
+                        " not confirmed, retrying later.");
+            enter(ERROR, sent_time_);
+            break;
+        case SEARCHING:
+            search_high_ = probe_size_ - 1;
+            if (search_high_ - search_low_ < SEARCH_GRANULARITY) {
+                enter(SEARCH_COMPLETE, sent_time_);
+            }
+            break;
+        case SEARCH_COMPLETE:
+            LOG_WARNING("Path MTU ", probe_size_,
+                        " no longer confirmed, searching again.");
+            plpmtu_.store(BASE_PLPMTU, std::memory_order_relaxed);
+            enter(BASE, sent_time_);
+            break;
+        default:
+            break;
+    }
+}
+
+void PathMtuDiscovery::enter(const State state, const Clock::time_point now) {
+    state_ = state;
+    probe_size_ = 0;
+    probe_count_ = 0;
+    confirming_ = false;
+
+    switch (state) {
+        case SEARCHING:
+            search_low_ = plpmtu();
+            search_high_ = max_plpmtu_;
+            if (search_high_ - search_low_ < SEARCH_GRANULARITY) {
+                enter(SEARCH_COMPLETE, now);
+            }
+            break;
+        case SEARCH_COMPLETE:
+            LOG_INFO("Path MTU search complete: ", plpmtu(), " bytes.");
+            next_confirmation_ = now + CONFIRMATION_TIMER;
+            next_search_ = now + PMTU_RAISE_TIMER;
+            break;
+        case ERROR:
+            next_search_ = now + CONFIRMATION_TIMER;
+            break;
+        default:
+            break;
+    }
+}
+
+std::size_t PathMtuDiscovery::next_size() const {
+    switch (state_) {
+        case SEARCHING:
+            return search_low_ + (search_high_ - search_low_ + 1) / 2;
+        case SEARCH_COMPLETE:
+            return plpmtu();
+        default:
+            return BASE_PLPMTU;
+    }
+}
@@ -0,0 +1,356 @@
+#include "udp_segmentation.hpp"
+
+#include <array>
+
+#include "logger.hpp"
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
+using namespace UdpSegmentation;
+
+namespace {
+
+#ifdef __linux__
+/**
+ * @brief Check whether a send failed only for now: the socket buffer is
+ * full, or an ICMP error from an earlier datagram was reported
+ */
+bool is_transient(const int error) {
+    return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS ||
+           error == ECONNREFUSED || error == EINTR;
+}
+
+[[noreturn]] void throw_errno(const char* what) {
+    throw boost::system::system_error(
+        boost::system::error_code(errno,
+                                  boost::asio::error::get_system_category()),
+        what);
+}
+#endif
+
+bool is_transient(const boost::system::error_code& ec) {
+    return ec == boost::asio::error::would_block ||
+           ec == boost::asio::error::try_again ||
+           ec == boost::asio::error::no_buffer_space ||
+           ec == boost::asio::error::connection_refused;
+}
+
+std::size_t packet_size(const boost::asio::const_buffer& packet) {
+    return packet.size();
+}
+
+std::size_t packet_size(const GatherDatagram& packet) { return packet.size(); }
+
+#ifdef __linux__
+/**
+ * @brief Point iovecs at the parts of a datagram
+ *
+ * @return std::size_t Number of iovecs used
+ */
+std::size_t fill_iovecs(const boost::asio::const_buffer& packet,
+                        iovec* iovecs) {
+    iovecs[0].iov_base = const_cast<void*>(packet.data());
+    iovecs[0].iov_len = packet.size();
+    return 1;
+}
+
+std::size_t fill_iovecs(const GatherDatagram& packet, iovec* iovecs) {
+    std::size_t used = 0;
+    for (const boost::asio::const_buffer& part :
+         {packet.header, packet.payload}) {
+        if (part.size() == 0) continue;
+        iovecs[used].iov_base = const_cast<void*>(part.data());
+        iovecs[used].iov_len = part.size();
+        ++used;
+    }
+    return used;
+}
+#endif
+
+#ifndef __linux__
+boost::asio::const_buffer buffers(const boost::asio::const_buffer& packet) {
+    return packet;
+}
+
+std::array<boost::asio::const_buffer, 2> buffers(
+    const GatherDatagram& packet) {
+    return {packet.header, packet.payload};
+}
+#endif
+
+}  // namespace
+
+UdpSegmentSender::UdpSegmentSender(udp::socket& socket, const bool enable_gso)
+    : socket_(socket), gso_enabled_(false) {
+#ifdef __linux__
+    iovecs_.resize(2 * MAX_SEGMENTS);
+    headers_.resize(MAX_SEGMENTS);
+
+    if (enable_gso) {
+        // Probe kernel support, then clear the socket-wide default again so
+        // only batches sent by this class are segmented.
+        int probe = 1200;
+        gso_enabled_ = setsockopt(socket_.native_handle(), SOL_UDP,
+                                  UDP_SEGMENT, &probe, sizeof(probe)) == 0;
+        probe = 0;
+        if (gso_enabled_) {
+            setsockopt(socket_.native_handle(), SOL_UDP, UDP_SEGMENT, &probe,
+                       sizeof(probe));
+        }
+    }
+#else
+    (void)enable_gso;
+#endif
+}
+
+std::size_t UdpSegmentSender::send_batch(
+    const std::vector<boost::asio::const_buffer>& packets,
+    const udp::endpoint& endpoint) {
+    return send_packets(packets, endpoint);
+}
+
+std::size_t UdpSegmentSender::send_batch(
+    const std::vector<GatherDatagram>& packets,
+    const udp::endpoint& endpoint) {
+    return send_packets(packets, endpoint);
+}
+
+template <typename Packet>
+std::size_t UdpSegmentSender::send_packets(const std::vector<Packet>& packets,
+                                           const udp::endpoint& endpoint) {
+    std::size_t sent = 0;
+    std::size_t first = 0;
+
+    while (first < packets.size()) {
+        const std::size_t run = segment_run_length(packets, first);
+
+        // A segment size of 0 is invalid, so empty packets go one by one
+        if (gso_enabled_ && run > 1 && packet_size(packets[first]) > 0) {
+            if (send_segmented(packets, first, run, endpoint)) {
+                sent += run;
+                first += run;
+                continue;
+            }
+            if (gso_enabled_) break;  // Transient, the caller retries
+        }
+
+        const std::size_t count =
+            gso_enabled_ ? run
+                         : std::min(packets.size() - first, MAX_SEGMENTS);
+        const std::size_t batch_sent =
+            send_mmsg(packets, first, count, endpoint);
+        if (batch_sent == 0) break;
+
+        sent += batch_sent;
+        first += batch_sent;
+    }
+
+    return sent;
+}
+
+template <typename Packet>
+std::size_t UdpSegmentSender::segment_run_length(
+    const std::vector<Packet>& packets, const std::size_t first) const {
+    const std::size_t segment_size = packet_size(packets[first]);
+    std::size_t total = segment_size;
+    std::size_t run = 1;
+
+    while (first + run < packets.size() && run < MAX_SEGMENTS) {
+        const std::size_t size = packet_size(packets[first + run]);
+        if (size > segment_size || total + size > MAX_SUPER_BUFFER) break;
+
+        total += size;
+        ++run;
+        if (size < segment_size) break;  // A short packet ends the run
+    }
+
+    return run;
+}
+
+template <typename Packet>
+bool UdpSegmentSender::send_segmented(const std::vector<Packet>& packets,
+                                      const std::size_t first,
+                                      const std::size_t count,
+                                      const udp::endpoint& endpoint) {
+#ifdef __linux__
+    std::size_t iovec_count = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        iovec_count += fill_iovecs(packets[first + i], &iovecs_[iovec_count]);
+    }
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))] = {};
+    msghdr msg = {};
+    msg.msg_name = const_cast<sockaddr*>(
+        reinterpret_cast<const sockaddr*>(endpoint.data()));
+    msg.msg_namelen = static_cast<socklen_t>(endpoint.size());
+    msg.msg_iov = iovecs_.data();
+    msg.msg_iovlen = iovec_count;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    const uint16_t segment_size =
+        static_cast<uint16_t>(packet_size(packets[first]));
+    std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+
+    if (sendmsg(socket_.native_handle(), &msg, 0) >= 0) return true;
+    if (is_transient(errno)) return false;
+
+    // EIO means the device cannot checksum segments, EINVAL/ENOPROTOOPT that
+    // the kernel does not support GSO for this socket. Stop trying for good.
+    if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT) {
+        LOG_WARNING(
+            "UDP segmentation offload unavailable, falling back to sendmmsg");
+        gso_enabled_ = false;
+        return false;
+    }
+
+    throw_errno("sendmsg");
+#else
+    (void)packets;
+    (void)first;
+    (void)count;
+    (void)endpoint;
+    return false;
+#endif
+}
+
+template <typename Packet>
+std::size_t UdpSegmentSender::send_mmsg(const std::vector<Packet>& packets,
+                                        const std::size_t first,
+                                        const std::size_t count,
+                                        const udp::endpoint& endpoint) {
+#ifdef __linux__
+    std::size_t iovec_count = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        iovec* iovecs = &iovecs_[iovec_count];
+        const std::size_t used = fill_iovecs(packets[first + i], iovecs);
+        iovec_count += used;
+
+        msghdr& msg = headers_[i].msg_hdr;
+        msg = {};
+        msg.msg_name = const_cast<sockaddr*>(
+            reinterpret_cast<const sockaddr*>(endpoint.data()));
+        msg.msg_namelen = static_cast<socklen_t>(endpoint.size());
+        msg.msg_iov = iovecs;
+        msg.msg_iovlen = used;
+    }
+
+    const int sent = sendmmsg(socket_.native_handle(), headers_.data(),
+                              static_cast<unsigned int>(count), 0);
+    if (sent < 0) {
+        if (is_transient(errno)) return 0;
+        throw_errno("sendmmsg");
+    }
+
+    return static_cast<std::size_t>(sent);
+#else
+    return send_each(packets, first, count, endpoint);
+#endif
+}
+
+template <typename Packet>
+std::size_t UdpSegmentSender::send_each(const std::vector<Packet>& packets,
+                                        const std::size_t first,
+                                        const std::size_t count,
+                                        const udp::endpoint& endpoint) {
+    for (std::size_t i = 0; i < count; ++i) {
+        boost::system::error_code ec;
+        socket_.send_to(buffers(packets[first + i]), endpoint, 0, ec);
+        if (is_transient(ec)) return i;
+        if (ec) throw boost::system::system_error(ec, "send_to");
+    }
+    return count;
+}
+
+UdpGroReceiver::UdpGroReceiver(udp::socket& socket, const bool enable_gro)
+    : socket_(socket), gro_enabled_(false), buffer_(MAX_GRO_BUFFER) {
+#ifdef __linux__
+    if (enable_gro) {
+        const int on = 1;
+        gro_enabled_ = setsockopt(socket_.native_handle(), SOL_UDP, UDP_GRO,
+                                  &on, sizeof(on)) == 0;
+    }
+#else
+    (void)enable_gro;
+#endif
+}
+
+std::size_t UdpGroReceiver::receive(const DatagramHandler& handler) {
+    std::size_t delivered = 0;
+    while (receive_one(handler, delivered)) {
+    }
+    return delivered;
+}
+
+bool UdpGroReceiver::receive_one(const DatagramHandler& handler,
+                                 std::size_t& delivered) {
+#ifdef __linux__
+    iovec iov = {buffer_.data(), buffer_.size()};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr msg = {};
+    msg.msg_name = remote_endpoint_.data();
+    msg.msg_namelen = static_cast<socklen_t>(remote_endpoint_.capacity());
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t bytes_recvd =
+        recvmsg(socket_.native_handle(), &msg, MSG_DONTWAIT);
+    if (bytes_recvd < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+        throw_errno("recvmsg");
+    }
+    remote_endpoint_.resize(msg.msg_namelen);
+
+    if (msg.msg_flags & MSG_TRUNC) {
+        LOG_WARNING("Received datagram larger than the GRO buffer.");
+        return true;
+    }
+
+    std::size_t segment_size = static_cast<std::size_t>(bytes_recvd);
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int gso_size = 0;
+            std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            if (gso_size > 0) segment_size = static_cast<std::size_t>(gso_size);
+        }
+    }
+
+    // Every segment is segment_size bytes except possibly the last one
+    const std::size_t total = static_cast<std::size_t>(bytes_recvd);
+    for (std::size_t offset = 0; offset < total; offset += segment_size) {
+        handler(buffer_.data() + offset, std::min(segment_size, total - offset),
+                remote_endpoint_);
+        ++delivered;
+    }
+    return true;
+#else
+    if (socket_.available() == 0) return false;
+
+    const std::size_t bytes_recvd =
+        socket_.receive_from(boost::asio::buffer(buffer_), remote_endpoint_);
+    handler(buffer_.data(), bytes_recvd, remote_endpoint_);
+    ++delivered;
+    return true;
+#endif
+}
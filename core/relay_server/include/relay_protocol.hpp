@@ -0,0 +1,122 @@
+#ifndef RELAY_PROTOCOL_HPP
+#define RELAY_PROTOCOL_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "relay_token.hpp"
+
+/**
+ * @namespace RelayProtocol
+ * @brief Control messages exchanged between peers and the relay server.
+ *
+ * A peer sends ALLOCATE_REQUEST with its token to the relay's control port
+ * and gets the session's relay port back. It then sends BIND_REQUEST with
+ * the same token to the relay port, so the relay learns the address its
+ * NAT uses towards that port. Once both peers are bound, every other
+ * datagram sent to the relay port is forwarded unchanged to the other
+ * peer.
+ *
+ * Every message starts with MAGIC and a one byte MessageType. Integers
+ * are big endian.
+ */
+namespace RelayProtocol {
+
+constexpr std::array<unsigned char, 4> MAGIC = {'R', 'P', 'R', 'L'};
+
+enum MessageType : uint8_t {
+    ALLOCATE_REQUEST = 1,   // token
+    ALLOCATE_RESPONSE = 2,  // relay port (2)
+    BIND_REQUEST = 3,       // token
+    BIND_RESPONSE = 4,      // empty
+    ERROR_RESPONSE = 5      // ErrorCode (1)
+};
+
+enum ErrorCode : uint8_t {
+    UNAUTHORIZED = 1,  // Bad or expired token
+    NO_PORTS = 2,      // No relay port left to allocate
+    SESSION_FULL = 3   // Both sides already bound to other addresses
+};
+
+constexpr std::size_t HEADER_SIZE = MAGIC.size() + 1;
+constexpr std::size_t REQUEST_SIZE = HEADER_SIZE + RelayToken::SIZE;
+constexpr std::size_t ALLOCATE_RESPONSE_SIZE = HEADER_SIZE + 2;
+constexpr std::size_t BIND_RESPONSE_SIZE = HEADER_SIZE;
+constexpr std::size_t ERROR_RESPONSE_SIZE = HEADER_SIZE + 1;
+constexpr std::size_t MAX_MESSAGE_SIZE = REQUEST_SIZE;
+
+/**
+ * @brief Write an ALLOCATE_REQUEST or BIND_REQUEST
+ *
+ * @param type Request type
+ * @param token Session token
+ * @param buffer Destination of at least REQUEST_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t build_request(const MessageType type, const RelayToken& token,
+                          unsigned char* buffer);
+
+/**
+ * @brief Write an ALLOCATE_RESPONSE
+ *
+ * @param port Relay port of the session
+ * @param buffer Destination of at least ALLOCATE_RESPONSE_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t build_allocate_response(const uint16_t port,
+                                    unsigned char* buffer);
+
+/**
+ * @brief Write a BIND_RESPONSE
+ *
+ * @param buffer Destination of at least BIND_RESPONSE_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t build_bind_response(unsigned char* buffer);
+
+/**
+ * @brief Write an ERROR_RESPONSE
+ *
+ * @param code Error code
+ * @param buffer Destination of at least ERROR_RESPONSE_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t build_error_response(const ErrorCode code, unsigned char* buffer);
+
+/**
+ * @brief Check that a datagram is a relay message of the given type and
+ * size
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param type Expected message type
+ * @return true if the datagram is such a message, false otherwise.
+ */
+bool is_message(const unsigned char* data, const std::size_t size,
+                const MessageType type);
+
+/**
+ * @brief Read the relay port of an ALLOCATE_RESPONSE
+ *
+ * @param data Message checked with is_message
+ * @return uint16_t Relay port
+ */
+inline uint16_t allocated_port(const unsigned char* data) {
+    return static_cast<uint16_t>(data[HEADER_SIZE] << 8 |
+                                 data[HEADER_SIZE + 1]);
+}
+
+/**
+ * @brief Read the token of a request
+ *
+ * @param data Message checked with is_message
+ * @return RelayToken Token, not yet verified
+ */
+inline RelayToken request_token(const unsigned char* data) {
+    return RelayToken::decode(data + HEADER_SIZE);
+}
+
+}  // namespace RelayProtocol
+
+#endif  // RELAY_PROTOCOL_HPP
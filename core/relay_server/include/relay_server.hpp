@@ -0,0 +1,164 @@
+#ifndef RELAY_SERVER_HPP
+#define RELAY_SERVER_HPP
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "metrics.hpp"
+#include "packet_pool.hpp"
+#include "relay_token.hpp"
+
+constexpr std::size_t RELAY_BATCH_SIZE = 64;    // datagrams per syscall
+constexpr std::size_t RELAY_MAX_THREADS = 64;
+constexpr std::size_t RELAY_MAX_ROUNDS = 16;    // batches per wakeup
+constexpr std::chrono::milliseconds RELAY_HOUSEKEEPING_INTERVAL{100};
+
+/**
+ * @struct RelayConfig
+ * @brief Settings of a RelayServer.
+ */
+struct RelayConfig {
+    unsigned short control_port = 3479;  // 0 for any
+    uint16_t port_min = 50000;           // First relay port
+    uint16_t port_max = 50999;           // Last relay port
+    std::size_t threads = 0;             // 0 for one per core
+    RelayToken::Secret secret = {};
+    std::chrono::seconds idle_timeout{60};
+};
+
+/**
+ * @class RelayServer
+ * @brief Forwards datagrams between two peers that cannot reach each other
+ * directly, TURN style (see RelayProtocol).
+ *
+ * Each session gets its own relay port. Every worker thread owns one
+ * SO_REUSEPORT socket on the control port and on each relay port, all
+ * registered with its own epoll instance, so the kernel spreads flows over
+ * the workers and a datagram is received and forwarded by the same thread
+ * without any handoff. Datagrams are received and sent in batches with
+ * recvmmsg and sendmmsg, straight from per-worker buffers allocated up
+ * front. Session slots are preallocated as well, so nothing is allocated
+ * per packet or per session.
+ *
+ * The two sides of a session are fixed once bound. Sessions without
+ * traffic for idle_timeout are closed and their port reused.
+ */
+class RelayServer {
+   public:
+    /**
+     * @brief Construct a new RelayServer object and bind the control port
+     *
+     * @param config Relay settings
+     *
+     * @throws std::invalid_argument If the port range or thread count is
+     * invalid.
+     * @throws boost::system::system_error If a socket cannot be set up.
+     */
+    explicit RelayServer(const RelayConfig& config);
+
+    /**
+     * @brief Destroy the RelayServer object, stopping it if running
+     */
+    ~RelayServer();
+
+    RelayServer(const RelayServer&) = delete;
+    RelayServer& operator=(const RelayServer&) = delete;
+
+    /**
+     * @brief Run the worker threads until stop() is called
+     */
+    void run();
+
+    /**
+     * @brief Stop the worker threads. Safe to call from any thread.
+     */
+    void stop();
+
+    /**
+     * @brief Get the bound control port
+     *
+     * @return unsigned short Control port
+     */
+    unsigned short control_port() const { return control_port_; }
+
+    /**
+     * @brief Get the number of worker threads
+     *
+     * @return std::size_t Worker threads
+     */
+    std::size_t threads() const { return workers_.size(); }
+
+   private:
+    enum SessionState : uint8_t { FREE, ACTIVE, CLOSING };
+
+    struct Session {
+        Session() { fds.fill(-1); }
+
+        std::atomic<uint8_t> state{FREE};
+        std::mutex bind_mutex;
+        uint64_t id = 0;
+        uint16_t port = 0;
+        std::array<int, RELAY_MAX_THREADS> fds;
+        std::atomic<std::size_t> open_fds{0};
+        std::array<sockaddr_storage, 2> sides;
+        std::array<socklen_t, 2> side_sizes = {};
+        std::array<std::atomic<bool>, 2> bound = {};
+        std::atomic<int64_t> last_activity{0};  // steady clock seconds
+    };
+
+    struct Worker {
+        int epoll_fd = -1;
+        int control_fd = -1;
+        std::array<std::array<unsigned char, PacketBuffer::CAPACITY>,
+                   RELAY_BATCH_SIZE>
+            buffers;
+        std::array<sockaddr_storage, RELAY_BATCH_SIZE> sources;
+        std::array<iovec, RELAY_BATCH_SIZE> recv_iovecs;
+        std::array<mmsghdr, RELAY_BATCH_SIZE> recv_headers;
+        std::array<iovec, RELAY_BATCH_SIZE> send_iovecs;
+        std::array<mmsghdr, RELAY_BATCH_SIZE> send_headers;
+        std::thread thread;
+    };
+
+    int open_socket(const uint16_t port) const;
+    void run_worker(const std::size_t index);
+    int receive_batch(Worker& worker, const int fd);
+    void handle_control(Worker& worker);
+    void handle_session(const std::size_t index, Session& session);
+    bool handle_bind(Session& session, const int fd,
+                     const unsigned char* data, const std::size_t size,
+                     const sockaddr_storage& source,
+                     const socklen_t source_size);
+    int find_side(const Session& session, const sockaddr_storage& source,
+                  const socklen_t source_size) const;
+    Session* allocate(const uint64_t session_id);
+    void housekeeping(const std::size_t index);
+    void reply(const int fd, const unsigned char* data, const std::size_t size,
+               const sockaddr_storage& destination,
+               const socklen_t destination_size) const;
+
+    RelayConfig config_;
+    int family_;
+    unsigned short control_port_;
+    int wake_fd_;
+    std::atomic<bool> running_;
+    std::mutex allocate_mutex_;
+    std::unique_ptr<Session[]> sessions_;
+    std::size_t session_count_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    Metrics::Counter& forwarded_;
+    Metrics::Counter& forwarded_bytes_;
+    Metrics::Counter& auth_failures_;
+    Metrics::Gauge& active_sessions_;
+    Metrics::DropCounters drops_;
+};
+
+#endif  // RELAY_SERVER_HPP
@@ -0,0 +1,99 @@
+#ifndef RELAY_TOKEN_HPP
+#define RELAY_TOKEN_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @class RelayToken
+ * @brief Short-lived credential that authorizes the use of one relay
+ * session.
+ *
+ * A token carries a session ID and an expiry time, authenticated with
+ * SipHash-2-4 keyed by a secret shared between the relay and whoever hands
+ * out tokens. Both peers of a session get the same token out of band, the
+ * same way they exchange their public addresses.
+ *
+ * Wire format (20 bytes, big endian): session ID (8), expiry in Unix
+ * seconds (4), MAC (8). The text form is the wire format in hex.
+ */
+class RelayToken {
+   public:
+    static constexpr std::size_t SIZE = 20;
+    static constexpr std::size_t SECRET_SIZE = 16;
+
+    using Secret = std::array<uint8_t, SECRET_SIZE>;
+
+    RelayToken() = default;
+
+    /**
+     * @brief Issue a token for a session
+     *
+     * @param secret Relay secret
+     * @param session_id Session both peers will join
+     * @param expiry Unix time in seconds after which the token is rejected
+     * @return RelayToken The authenticated token.
+     */
+    static RelayToken issue(const Secret& secret, const uint64_t session_id,
+                            const uint32_t expiry);
+
+    /**
+     * @brief Read a token from its wire format
+     *
+     * @param data At least SIZE bytes
+     * @return RelayToken The token, not yet verified.
+     */
+    static RelayToken decode(const unsigned char* data);
+
+    /**
+     * @brief Parse a token from its hex text form
+     *
+     * @param text 2 * SIZE hex digits
+     * @param token Receives the token on success, not yet verified
+     * @return true if the text is a well formed token, false otherwise.
+     */
+    static bool try_parse(std::string_view text, RelayToken& token);
+
+    /**
+     * @brief Parse a secret from hex
+     *
+     * @param text 2 * SECRET_SIZE hex digits
+     * @param secret Receives the secret on success
+     * @return true if the text is a well formed secret, false otherwise.
+     */
+    static bool try_parse_secret(std::string_view text, Secret& secret);
+
+    /**
+     * @brief Write the token in its wire format
+     *
+     * @param data Destination of at least SIZE bytes
+     */
+    void encode(unsigned char* data) const;
+
+    /**
+     * @brief Check the MAC and the expiry time
+     *
+     * @param secret Relay secret
+     * @param now Current Unix time in seconds
+     * @return true if the token was issued with the secret and has not
+     * expired, false otherwise.
+     */
+    bool verify(const Secret& secret, const uint32_t now) const;
+
+    uint64_t session_id() const { return session_id_; }
+    uint32_t expiry() const { return expiry_; }
+
+    std::string to_string() const;
+
+   private:
+    static uint64_t mac(const Secret& secret, const uint64_t session_id,
+                        const uint32_t expiry);
+
+    uint64_t session_id_ = 0;
+    uint32_t expiry_ = 0;
+    uint64_t mac_ = 0;
+};
+
+#endif  // RELAY_TOKEN_HPP
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <random>
+
+#include "common.hpp"
+#include "metrics.hpp"
+#include "relay_server.hpp"
+
+namespace {
+
+constexpr uint32_t DEFAULT_TOKEN_TTL = 300;  // seconds
+
+RelayToken::Secret parse_secret(const Common::Options& options) {
+    RelayToken::Secret secret;
+    const auto it = options.find("secret");
+    if (it == options.end() ||
+        !RelayToken::try_parse_secret(it->second, secret)) {
+        throw std::invalid_argument("Missing or invalid --secret (32 hex)");
+    }
+    return secret;
+}
+
+void parse_port_range(const std::string& text, RelayConfig& config) {
+    const std::size_t dash = text.find('-');
+    const std::string first = text.substr(0, dash);
+    const std::string last =
+        dash == std::string::npos ? "" : text.substr(dash + 1);
+    if (!Common::validate_port(first) || !Common::validate_port(last)) {
+        throw std::invalid_argument("Invalid --ports, expected <min>-<max>");
+    }
+    config.port_min = static_cast<uint16_t>(std::stoi(first));
+    config.port_max = static_cast<uint16_t>(std::stoi(last));
+}
+
+/**
+ * @brief Print a token for a session, for whoever hands tokens to peers
+ */
+int issue_token(const Common::Options& options) {
+    const RelayToken::Secret secret = parse_secret(options);
+
+    uint64_t session_id = 0;
+    const auto it = options.find("issue-token");
+    if (it != options.end() && !it->second.empty()) {
+        session_id = std::stoull(it->second);
+    } else {
+        session_id = std::random_device()() |
+                     static_cast<uint64_t>(std::random_device()()) << 32;
+    }
+
+    uint32_t ttl = DEFAULT_TOKEN_TTL;
+    if (const auto ttl_it = options.find("ttl"); ttl_it != options.end()) {
+        ttl = static_cast<uint32_t>(std::stoul(ttl_it->second));
+    }
+    const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+
+    std::cout << RelayToken::issue(secret, session_id,
+                                   static_cast<uint32_t>(now) + ttl)
+                     .to_string()
+              << std::endl;
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc >= 2 && std::strcmp(argv[1], "--issue-token") == 0) {
+            return issue_token(Common::parse_options(argc, argv, 1));
+        }
+
+        if (argc < 3 || std::strcmp(argv[1], "-p") != 0) {
+            throw std::invalid_argument(
+                "Invalid arguments. Usage: " + std::string(argv[0]) +
+                " -p <control_port> --secret <hex> [--ports <min>-<max>]"
+                " [--threads <count>] [--idle <seconds>]"
+                " [--stats <interval_ms>] [--stats-socket <path>]\n"
+                "       " + std::string(argv[0]) +
+                " --issue-token [<session_id>] --secret <hex>"
+                " [--ttl <seconds>]");
+        }
+
+        if (!Common::validate_port(argv[2])) {
+            throw std::invalid_argument("Invalid port number");
+        }
+
+        const auto options = Common::parse_options(argc, argv, 3);
+        RelayConfig config;
+        config.control_port = static_cast<uint16_t>(std::stoi(argv[2]));
+        config.secret = parse_secret(options);
+        if (const auto it = options.find("ports"); it != options.end()) {
+            parse_port_range(it->second, config);
+        }
+        if (const auto it = options.find("threads"); it != options.end()) {
+            config.threads = std::stoul(it->second);
+        }
+        if (const auto it = options.find("idle"); it != options.end()) {
+            config.idle_timeout = std::chrono::seconds(std::stoul(it->second));
+        }
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            const auto socket = options.find("stats-socket");
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)),
+                socket != options.end() ? socket->second : "");
+        }
+
+        RelayServer relay(config);
+        relay.run();
+    } catch (std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "relay_protocol.hpp"
+
+#include <algorithm>
+
+namespace RelayProtocol {
+
+namespace {
+
+std::size_t write_header(const MessageType type, unsigned char* buffer) {
+    std::copy(MAGIC.begin(), MAGIC.end(), buffer);
+    buffer[MAGIC.size()] = type;
+    return HEADER_SIZE;
+}
+
+std::size_t expected_size(const MessageType type) {
+    switch (type) {
+        case ALLOCATE_REQUEST:
+        case BIND_REQUEST:
+            return REQUEST_SIZE;
+        case ALLOCATE_RESPONSE:
+            return ALLOCATE_RESPONSE_SIZE;
+        case BIND_RESPONSE:
+            return BIND_RESPONSE_SIZE;
+        case ERROR_RESPONSE:
+            return ERROR_RESPONSE_SIZE;
+    }
+    return 0;
+}
+
+}  // namespace
+
+std::size_t build_request(const MessageType type, const RelayToken& token,
+                          unsigned char* buffer) {
+    token.encode(buffer + write_header(type, buffer));
+    return REQUEST_SIZE;
+}
+
+std::size_t build_allocate_response(const uint16_t port,
+                                    unsigned char* buffer) {
+    write_header(ALLOCATE_RESPONSE, buffer);
+    buffer[HEADER_SIZE] = static_cast<unsigned char>(port >> 8);
+    buffer[HEADER_SIZE + 1] = static_cast<unsigned char>(port & 0xFF);
+    return ALLOCATE_RESPONSE_SIZE;
+}
+
+std::size_t build_bind_response(unsigned char* buffer) {
+    return write_header(BIND_RESPONSE, buffer);
+}
+
+std::size_t build_error_response(const ErrorCode code,
+                                 unsigned char* buffer) {
+    write_header(ERROR_RESPONSE, buffer);
+    buffer[HEADER_SIZE] = code;
+    return ERROR_RESPONSE_SIZE;
+}
+
+bool is_message(const unsigned char* data, const std::size_t size,
+                const MessageType type) {
+    return size == expected_size(type) &&
+           std::equal(MAGIC.begin(), MAGIC.end(), data) &&
+           data[MAGIC.size()] == type;
+}
+
+}  // namespace RelayProtocol
@@ -0,0 +1,491 @@
+#include "relay_server.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <boost/system/system_error.hpp>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.hpp"
+#include "relay_protocol.hpp"
+
+using namespace RelayProtocol;
+
+namespace {
+
+// Tags stored in the epoll user data; anything else is a session slot
+constexpr uint64_t CONTROL_TAG = ~0ULL;
+constexpr uint64_t WAKE_TAG = ~0ULL - 1;
+
+[[noreturn]] void throw_errno(const char* what) {
+    throw boost::system::system_error(
+        boost::system::error_code(errno, boost::system::system_category()),
+        what);
+}
+
+int64_t steady_seconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint32_t unix_seconds() {
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch())
+            .count());
+}
+
+void add_to_epoll(const int epoll_fd, const int fd, const uint64_t tag) {
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = tag;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        throw_errno("epoll_ctl");
+    }
+}
+
+}  // namespace
+
+RelayServer::RelayServer(const RelayConfig& config)
+    : config_(config),
+      family_(AF_INET6),
+      control_port_(config.control_port),
+      wake_fd_(-1),
+      running_(false),
+      session_count_(0),
+      forwarded_(Metrics::counter("relay.packets_forwarded")),
+      forwarded_bytes_(Metrics::counter("relay.bytes_forwarded")),
+      auth_failures_(Metrics::counter("relay.auth_failures")),
+      active_sessions_(Metrics::gauge("relay.sessions")) {
+    if (config_.port_min == 0 || config_.port_max < config_.port_min) {
+        throw std::invalid_argument("Invalid relay port range");
+    }
+    if (config_.threads == 0) {
+        config_.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (config_.threads > RELAY_MAX_THREADS) {
+        throw std::invalid_argument("Too many relay threads");
+    }
+
+    // Prefer dual-stack sockets, like the rest of the transport
+    const int probe = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (probe < 0) {
+        family_ = AF_INET;
+    } else {
+        close(probe);
+    }
+
+    session_count_ =
+        static_cast<std::size_t>(config_.port_max - config_.port_min) + 1;
+    sessions_ = std::make_unique<Session[]>(session_count_);
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) throw_errno("eventfd");
+
+    for (std::size_t i = 0; i < config_.threads; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epoll_fd < 0) throw_errno("epoll_create1");
+
+        // The first socket picks the port if 0 was requested
+        worker->control_fd = open_socket(control_port_);
+        if (worker->control_fd < 0) throw_errno("bind");
+        if (control_port_ == 0) {
+            sockaddr_storage local = {};
+            socklen_t size = sizeof(local);
+            getsockname(worker->control_fd,
+                        reinterpret_cast<sockaddr*>(&local), &size);
+            control_port_ = ntohs(
+                family_ == AF_INET6
+                    ? reinterpret_cast<sockaddr_in6*>(&local)->sin6_port
+                    : reinterpret_cast<sockaddr_in*>(&local)->sin_port);
+        }
+        add_to_epoll(worker->epoll_fd, worker->control_fd, CONTROL_TAG);
+        add_to_epoll(worker->epoll_fd, wake_fd_, WAKE_TAG);
+
+        for (std::size_t j = 0; j < RELAY_BATCH_SIZE; ++j) {
+            worker->recv_iovecs[j] = {worker->buffers[j].data(),
+                                      worker->buffers[j].size()};
+            worker->recv_headers[j] = {};
+            worker->recv_headers[j].msg_hdr.msg_iov = &worker->recv_iovecs[j];
+            worker->recv_headers[j].msg_hdr.msg_iovlen = 1;
+            worker->recv_headers[j].msg_hdr.msg_name = &worker->sources[j];
+
+            worker->send_headers[j] = {};
+            worker->send_headers[j].msg_hdr.msg_iov = &worker->send_iovecs[j];
+            worker->send_headers[j].msg_hdr.msg_iovlen = 1;
+        }
+        workers_.push_back(std::move(worker));
+    }
+
+    LOG_INFO("Relay listening on port ", control_port_, " with ",
+             workers_.size(), " threads, relay ports ", config_.port_min, "-",
+             config_.port_max);
+}
+
+RelayServer::~RelayServer() {
+    stop();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+
+    for (std::size_t slot = 0; slot < session_count_; ++slot) {
+        Session& session = sessions_[slot];
+        if (session.state.load() == FREE) continue;
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            if (session.fds[i] >= 0) close(session.fds[i]);
+        }
+    }
+    for (auto& worker : workers_) {
+        if (worker->control_fd >= 0) close(worker->control_fd);
+        if (worker->epoll_fd >= 0) close(worker->epoll_fd);
+    }
+    if (wake_fd_ >= 0) close(wake_fd_);
+}
+
+void RelayServer::run() {
+    running_ = true;
+    for (std::size_t i = 1; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread([this, i]() { run_worker(i); });
+    }
+    run_worker(0);
+
+    for (std::size_t i = 1; i < workers_.size(); ++i) {
+        workers_[i]->thread.join();
+    }
+}
+
+void RelayServer::stop() {
+    running_ = false;
+    const uint64_t value = 1;
+    if (wake_fd_ >= 0 && write(wake_fd_, &value, sizeof(value)) < 0) {
+        LOG_WARNING("Failed to wake relay workers: ", std::strerror(errno));
+    }
+}
+
+int RelayServer::open_socket(const uint16_t port) const {
+    const int fd = socket(family_, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0);
+    if (fd < 0) throw_errno("socket");
+
+    const int enable = 1;
+    const int disable = 0;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable));
+
+    int result;
+    if (family_ == AF_INET6) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &disable, sizeof(disable));
+        sockaddr_in6 address = {};
+        address.sin6_family = AF_INET6;
+        address.sin6_addr = in6addr_any;
+        address.sin6_port = htons(port);
+        result = bind(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address));
+    } else {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        result = bind(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address));
+    }
+
+    if (result != 0) {
+        const int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+void RelayServer::run_worker(const std::size_t index) {
+    Worker& worker = *workers_[index];
+    std::array<epoll_event, RELAY_BATCH_SIZE> events;
+    auto next_housekeeping = std::chrono::steady_clock::now();
+
+    while (running_.load(std::memory_order_relaxed)) {
+        const int count = epoll_wait(
+            worker.epoll_fd, events.data(), static_cast<int>(events.size()),
+            static_cast<int>(RELAY_HOUSEKEEPING_INTERVAL.count()));
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR("epoll_wait failed: ", std::strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const uint64_t tag = events[i].data.u64;
+            if (tag == WAKE_TAG) continue;
+            if (tag == CONTROL_TAG) {
+                handle_control(worker);
+            } else {
+                handle_session(index, sessions_[tag]);
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= next_housekeeping) {
+            housekeeping(index);
+            next_housekeeping = now + RELAY_HOUSEKEEPING_INTERVAL;
+        }
+    }
+}
+
+int RelayServer::receive_batch(Worker& worker, const int fd) {
+    // The kernel overwrites the name lengths, so reset them every time
+    for (auto& header : worker.recv_headers) {
+        header.msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    }
+    return recvmmsg(fd, worker.recv_headers.data(),
+                    static_cast<unsigned int>(worker.recv_headers.size()),
+                    MSG_DONTWAIT, nullptr);
+}
+
+void RelayServer::handle_control(Worker& worker) {
+    const int count = receive_batch(worker, worker.control_fd);
+    for (int i = 0; i < count; ++i) {
+        const mmsghdr& header = worker.recv_headers[i];
+        const unsigned char* data = worker.buffers[i].data();
+        const sockaddr_storage& source = worker.sources[i];
+
+        if (!is_message(data, header.msg_len, ALLOCATE_REQUEST)) {
+            drops_.parse_error.add();
+            continue;
+        }
+
+        std::array<unsigned char, MAX_MESSAGE_SIZE> response;
+        std::size_t size;
+        const RelayToken token = request_token(data);
+        if (!token.verify(config_.secret, unix_seconds())) {
+            auth_failures_.add();
+            size = build_error_response(UNAUTHORIZED, response.data());
+        } else if (const Session* session = allocate(token.session_id())) {
+            size = build_allocate_response(session->port, response.data());
+        } else {
+            size = build_error_response(NO_PORTS, response.data());
+        }
+        reply(worker.control_fd, response.data(), size, source,
+              header.msg_hdr.msg_namelen);
+    }
+}
+
+void RelayServer::handle_session(const std::size_t index, Session& session) {
+    Worker& worker = *workers_[index];
+    const int fd = session.fds[index];
+    if (fd < 0) return;
+
+    uint64_t forwarded = 0;
+    uint64_t bytes = 0;
+    for (std::size_t round = 0; round < RELAY_MAX_ROUNDS; ++round) {
+        const int count = receive_batch(worker, fd);
+        if (count <= 0) break;
+
+        unsigned int pending = 0;
+        for (int i = 0; i < count; ++i) {
+            const mmsghdr& header = worker.recv_headers[i];
+            const sockaddr_storage& source = worker.sources[i];
+            const socklen_t source_size = header.msg_hdr.msg_namelen;
+
+            if (header.msg_hdr.msg_flags & MSG_TRUNC) {
+                drops_.bad_size.add();
+                continue;
+            }
+
+            const int side = find_side(session, source, source_size);
+            if (side < 0 ||
+                (header.msg_len == REQUEST_SIZE &&
+                 is_message(worker.buffers[i].data(), header.msg_len,
+                            BIND_REQUEST))) {
+                if (!handle_bind(session, fd, worker.buffers[i].data(),
+                                 header.msg_len, source, source_size)) {
+                    drops_.unknown_endpoint.add();
+                }
+                continue;
+            }
+
+            const int other = 1 - side;
+            if (!session.bound[other].load(std::memory_order_acquire)) {
+                drops_.unknown_endpoint.add();
+                continue;
+            }
+
+            worker.send_iovecs[pending] = {worker.buffers[i].data(),
+                                           header.msg_len};
+            mmsghdr& out = worker.send_headers[pending++];
+            out.msg_hdr.msg_name = &session.sides[other];
+            out.msg_hdr.msg_namelen = session.side_sizes[other];
+        }
+
+        unsigned int sent = 0;
+        while (sent < pending) {
+            const int result = sendmmsg(fd, worker.send_headers.data() + sent,
+                                        pending - sent, 0);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) break;  // Datagrams are best effort
+            sent += static_cast<unsigned int>(result);
+        }
+        for (unsigned int i = 0; i < sent; ++i) {
+            bytes += worker.send_iovecs[i].iov_len;
+        }
+        forwarded += sent;
+
+        if (static_cast<std::size_t>(count) < RELAY_BATCH_SIZE) break;
+    }
+
+    if (forwarded != 0) {
+        forwarded_.add(forwarded);
+        forwarded_bytes_.add(bytes);
+        session.last_activity.store(steady_seconds(),
+                                    std::memory_order_relaxed);
+    }
+}
+
+bool RelayServer::handle_bind(Session& session, const int fd,
+                              const unsigned char* data,
+                              const std::size_t size,
+                              const sockaddr_storage& source,
+                              const socklen_t source_size) {
+    if (!is_message(data, size, BIND_REQUEST)) return false;
+
+    std::array<unsigned char, MAX_MESSAGE_SIZE> response;
+    const RelayToken token = request_token(data);
+    if (token.session_id() != session.id ||
+        !token.verify(config_.secret, unix_seconds())) {
+        auth_failures_.add();
+        reply(fd, response.data(),
+              build_error_response(UNAUTHORIZED, response.data()), source,
+              source_size);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(session.bind_mutex);
+    if (find_side(session, source, source_size) < 0) {
+        std::size_t side = 0;
+        while (side < session.bound.size() && session.bound[side].load()) {
+            ++side;
+        }
+        if (side == session.bound.size()) {
+            reply(fd, response.data(),
+                  build_error_response(SESSION_FULL, response.data()), source,
+                  source_size);
+            return true;
+        }
+
+        session.sides[side] = source;
+        session.side_sizes[side] = source_size;
+        session.bound[side].store(true, std::memory_order_release);
+        session.last_activity.store(steady_seconds(),
+                                    std::memory_order_relaxed);
+        LOG_INFO("Relay port ", session.port, ": side ", side, " bound");
+    }
+
+    reply(fd, response.data(), build_bind_response(response.data()), source,
+          source_size);
+    return true;
+}
+
+int RelayServer::find_side(const Session& session,
+                           const sockaddr_storage& source,
+                           const socklen_t source_size) const {
+    for (std::size_t side = 0; side < session.bound.size(); ++side) {
+        if (session.bound[side].load(std::memory_order_acquire) &&
+            session.side_sizes[side] == source_size &&
+            std::memcmp(&session.sides[side], &source, source_size) == 0) {
+            return static_cast<int>(side);
+        }
+    }
+    return -1;
+}
+
+RelayServer::Session* RelayServer::allocate(const uint64_t session_id) {
+    std::lock_guard<std::mutex> lock(allocate_mutex_);
+
+    for (std::size_t slot = 0; slot < session_count_; ++slot) {
+        Session& session = sessions_[slot];
+        if (session.state.load(std::memory_order_acquire) == ACTIVE &&
+            session.id == session_id) {
+            return &session;
+        }
+    }
+
+    for (std::size_t slot = 0; slot < session_count_; ++slot) {
+        Session& session = sessions_[slot];
+        if (session.state.load(std::memory_order_acquire) != FREE) continue;
+
+        const uint16_t port = static_cast<uint16_t>(config_.port_min + slot);
+        std::size_t opened = 0;
+        while (opened < workers_.size()) {
+            session.fds[opened] = open_socket(port);
+            if (session.fds[opened] < 0) break;
+            ++opened;
+        }
+        if (opened < workers_.size()) {
+            LOG_WARNING("Relay port ", port, " unavailable: ",
+                        std::strerror(errno));
+            while (opened > 0) close(session.fds[--opened]);
+            continue;
+        }
+
+        session.id = session_id;
+        session.port = port;
+        session.bound[0].store(false);
+        session.bound[1].store(false);
+        session.open_fds.store(workers_.size());
+        session.last_activity.store(steady_seconds());
+        for (std::size_t i = 0; i < workers_.size(); ++i) {
+            add_to_epoll(workers_[i]->epoll_fd, session.fds[i], slot);
+        }
+        session.state.store(ACTIVE, std::memory_order_release);
+        active_sessions_.add(1);
+        LOG_INFO("Relay port ", port, " allocated to session ", session_id);
+        return &session;
+    }
+
+    LOG_WARNING("No relay port left for session ", session_id);
+    return nullptr;
+}
+
+void RelayServer::housekeeping(const std::size_t index) {
+    const int64_t now = steady_seconds();
+    const int epoll_fd = workers_[index]->epoll_fd;
+
+    for (std::size_t slot = 0; slot < session_count_; ++slot) {
+        Session& session = sessions_[slot];
+        const uint8_t state = session.state.load(std::memory_order_acquire);
+
+        // One worker decides on expiry; each then closes its own socket
+        if (index == 0 && state == ACTIVE &&
+            now - session.last_activity.load(std::memory_order_relaxed) >
+                config_.idle_timeout.count()) {
+            LOG_INFO("Relay port ", session.port, " idle, closing");
+            session.state.store(CLOSING, std::memory_order_release);
+        }
+        if (session.state.load(std::memory_order_acquire) != CLOSING ||
+            session.fds[index] < 0) {
+            continue;
+        }
+
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, session.fds[index], nullptr);
+        close(session.fds[index]);
+        session.fds[index] = -1;
+        if (session.open_fds.fetch_sub(1) == 1) {
+            active_sessions_.add(-1);
+            session.state.store(FREE, std::memory_order_release);
+        }
+    }
+}
+
+void RelayServer::reply(const int fd, const unsigned char* data,
+                        const std::size_t size,
+                        const sockaddr_storage& destination,
+                        const socklen_t destination_size) const {
+    if (sendto(fd, data, size, 0,
+               reinterpret_cast<const sockaddr*>(&destination),
+               destination_size) < 0) {
+        LOG_WARNING("Relay reply failed: ", std::strerror(errno));
+    }
+}
@@ -0,0 +1,157 @@
+#include "relay_token.hpp"
+
+namespace {
+
+uint64_t rotl(const uint64_t x, const int b) {
+    return (x << b) | (x >> (64 - b));
+}
+
+uint64_t load_le64(const unsigned char* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) value = (value << 8) | p[i];
+    return value;
+}
+
+void sip_round(uint64_t& v0, uint64_t& v1, uint64_t& v2, uint64_t& v3) {
+    v0 += v1;
+    v1 = rotl(v1, 13);
+    v1 ^= v0;
+    v0 = rotl(v0, 32);
+    v2 += v3;
+    v3 = rotl(v3, 16);
+    v3 ^= v2;
+    v0 += v3;
+    v3 = rotl(v3, 21);
+    v3 ^= v0;
+    v2 += v1;
+    v1 = rotl(v1, 17);
+    v1 ^= v2;
+    v2 = rotl(v2, 32);
+}
+
+/**
+ * @brief SipHash-2-4 (Aumasson and Bernstein, 2012)
+ */
+uint64_t siphash24(const RelayToken::Secret& key, const unsigned char* data,
+                   const std::size_t size) {
+    const uint64_t k0 = load_le64(key.data());
+    const uint64_t k1 = load_le64(key.data() + 8);
+    uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+    uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+    uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+    uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+    const std::size_t blocks = size / 8;
+    for (std::size_t i = 0; i < blocks; ++i) {
+        const uint64_t m = load_le64(data + 8 * i);
+        v3 ^= m;
+        sip_round(v0, v1, v2, v3);
+        sip_round(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    uint64_t last = static_cast<uint64_t>(size) << 56;
+    for (std::size_t i = 0; i < size % 8; ++i) {
+        last |= static_cast<uint64_t>(data[8 * blocks + i]) << (8 * i);
+    }
+    v3 ^= last;
+    sip_round(v0, v1, v2, v3);
+    sip_round(v0, v1, v2, v3);
+    v0 ^= last;
+
+    v2 ^= 0xFF;
+    for (int i = 0; i < 4; ++i) sip_round(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+void store_be(unsigned char* p, const uint64_t value, const std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * (size - 1 - i)));
+    }
+}
+
+uint64_t load_be(const unsigned char* p, const std::size_t size) {
+    uint64_t value = 0;
+    for (std::size_t i = 0; i < size; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+bool parse_hex(std::string_view text, unsigned char* out,
+               const std::size_t size) {
+    if (text.size() != 2 * size) return false;
+
+    const auto nibble = [](const char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (std::size_t i = 0; i < size; ++i) {
+        const int high = nibble(text[2 * i]);
+        const int low = nibble(text[2 * i + 1]);
+        if (high < 0 || low < 0) return false;
+        out[i] = static_cast<unsigned char>(high << 4 | low);
+    }
+    return true;
+}
+
+}  // namespace
+
+RelayToken RelayToken::issue(const Secret& secret, const uint64_t session_id,
+                             const uint32_t expiry) {
+    RelayToken token;
+    token.session_id_ = session_id;
+    token.expiry_ = expiry;
+    token.mac_ = mac(secret, session_id, expiry);
+    return token;
+}
+
+RelayToken RelayToken::decode(const unsigned char* data) {
+    RelayToken token;
+    token.session_id_ = load_be(data, 8);
+    token.expiry_ = static_cast<uint32_t>(load_be(data + 8, 4));
+    token.mac_ = load_be(data + 12, 8);
+    return token;
+}
+
+bool RelayToken::try_parse(std::string_view text, RelayToken& token) {
+    std::array<unsigned char, SIZE> data;
+    if (!parse_hex(text, data.data(), data.size())) return false;
+    token = decode(data.data());
+    return true;
+}
+
+bool RelayToken::try_parse_secret(std::string_view text, Secret& secret) {
+    return parse_hex(text, secret.data(), secret.size());
+}
+
+void RelayToken::encode(unsigned char* data) const {
+    store_be(data, session_id_, 8);
+    store_be(data + 8, expiry_, 4);
+    store_be(data + 12, mac_, 8);
+}
+
+bool RelayToken::verify(const Secret& secret, const uint32_t now) const {
+    return now <= expiry_ && mac_ == mac(secret, session_id_, expiry_);
+}
+
+std::string RelayToken::to_string() const {
+    static constexpr char DIGITS[] = "0123456789abcdef";
+
+    std::array<unsigned char, SIZE> data;
+    encode(data.data());
+    std::string text(2 * SIZE, '0');
+    for (std::size_t i = 0; i < SIZE; ++i) {
+        text[2 * i] = DIGITS[data[i] >> 4];
+        text[2 * i + 1] = DIGITS[data[i] & 0x0F];
+    }
+    return text;
+}
+
+uint64_t RelayToken::mac(const Secret& secret, const uint64_t session_id,
+                         const uint32_t expiry) {
+    std::array<unsigned char, 12> message;
+    store_be(message.data(), session_id, 8);
+    store_be(message.data() + 8, expiry, 4);
+    return siphash24(secret, message.data(), message.size());
+}
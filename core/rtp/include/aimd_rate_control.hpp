@@ -0,0 +1,75 @@
+#ifndef AIMD_RATE_CONTROL_HPP
+#define AIMD_RATE_CONTROL_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#include "trendline_estimator.hpp"
+
+constexpr double AIMD_DECREASE_FACTOR = 0.85;  // Of the delivered bitrate
+
+/**
+ * @class AimdRateControl
+ * @brief Turns the delay detector's signal into a bitrate: additive or
+ * multiplicative increase while the path keeps up, multiplicative decrease
+ * when a queue builds (draft-ietf-rmcat-gcc-02 section 5.5).
+ *
+ * Overuse cuts the rate to AIMD_DECREASE_FACTOR of what the receiver got,
+ * at most once per round trip, then holds it until the queue has drained.
+ * The rates at which overuse was seen estimate the link capacity: near
+ * it the rate grows by about a packet per round trip, away from it by 8%
+ * a second, and by 25% a second once the receiver got more than that
+ * capacity, until the next overuse. It never grows past 1.5 times the
+ * delivered bitrate, so a sender that does not use its allowance cannot
+ * build one up.
+ *
+ * Bitrates are in bits/s. Does not allocate. Not thread-safe.
+ */
+class AimdRateControl {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new AimdRateControl object
+     *
+     * @param start_bitrate Bitrate before any feedback
+     * @param min_bitrate Lowest bitrate it goes down to
+     * @param max_bitrate Highest bitrate it goes up to
+     */
+    AimdRateControl(const int64_t start_bitrate, const int64_t min_bitrate,
+                    const int64_t max_bitrate);
+
+    /**
+     * @brief Update the bitrate on new feedback
+     *
+     * @param usage State of the path from the delay detector
+     * @param delivered_bitrate Bitrate the receiver got lately, 0 if not
+     * known yet
+     * @param rtt Round trip time
+     * @param now Current time
+     * @return int64_t New bitrate
+     */
+    int64_t update(const BandwidthUsage usage, const int64_t delivered_bitrate,
+                   const std::chrono::microseconds rtt,
+                   const Clock::time_point now);
+
+    int64_t bitrate() const { return bitrate_; }
+
+   private:
+    enum class State { HOLD, INCREASE, DECREASE };
+
+    void update_capacity(const double sample);
+
+    int64_t bitrate_;
+    int64_t min_bitrate_;
+    int64_t max_bitrate_;
+    State state_;
+    bool started_;
+    bool growing_;  // Delivered past the capacity seen, since the last cut
+    Clock::time_point last_update_;
+    Clock::time_point last_decrease_;
+    double capacity_;   // kbit/s at overuse, 0 when unknown
+    double deviation_;  // Normalized variance of the capacity samples
+};
+
+#endif  // AIMD_RATE_CONTROL_HPP
@@ -0,0 +1,71 @@
+#ifndef ARRIVAL_RECORDER_HPP
+#define ARRIVAL_RECORDER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "rtcp_feedback.hpp"
+
+constexpr std::chrono::milliseconds TRANSPORT_FEEDBACK_INTERVAL{25};
+constexpr std::size_t ARRIVAL_WINDOW = 1024;  // packets, a power of two
+
+/**
+ * @class ArrivalRecorder
+ * @brief Receiver side of transport-wide congestion control: keeps the
+ * arrival time of every datagram by its transport sequence number and
+ * reports them to the sender in transport feedback.
+ *
+ * Each feedback covers the sequence numbers from the first not yet
+ * reported to the highest received, those missing as lost; a packet
+ * arriving after its number was reported is left out. A gap longer than
+ * ARRIVAL_WINDOW skips ahead. All memory is allocated up front.
+ *
+ * Not thread-safe; used from the receiving thread.
+ */
+class ArrivalRecorder {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    ArrivalRecorder();
+
+    /**
+     * @brief Record a received datagram. Does not allocate.
+     *
+     * @param transport_sequence Its transport-wide sequence number
+     * @param arrival Arrival time
+     */
+    void on_packet(const uint16_t transport_sequence,
+                   const Clock::time_point arrival);
+
+    /**
+     * @brief Write a feedback with the arrivals not reported yet. Call
+     * again until it returns 0, since one feedback holds at most
+     * RtcpFeedback::MAX_FEEDBACK_PACKETS. Does not allocate.
+     *
+     * @param sender_ssrc SSRC of the receiver sending the feedback
+     * @param media_ssrc SSRC of the stream
+     * @param buffer Destination of at least
+     * RtcpFeedback::MAX_TRANSPORT_FEEDBACK_SIZE bytes
+     * @return std::size_t Message size, 0 if there is nothing to report
+     */
+    std::size_t write_feedback(const uint32_t sender_ssrc,
+                               const uint32_t media_ssrc,
+                               unsigned char* buffer);
+
+   private:
+    struct Slot {
+        uint16_t sequence = 0;
+        int64_t arrival = RtcpFeedback::NOT_RECEIVED;  // us
+    };
+
+    std::vector<Slot> slots_;
+    std::array<int64_t, RtcpFeedback::MAX_FEEDBACK_PACKETS> arrivals_;
+    bool started_;
+    uint16_t next_sequence_;  // First not reported
+    uint16_t highest_sequence_;
+    uint8_t feedback_count_;
+};
+
+#endif  // ARRIVAL_RECORDER_HPP
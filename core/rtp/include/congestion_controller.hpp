@@ -0,0 +1,137 @@
+#ifndef CONGESTION_CONTROLLER_HPP
+#define CONGESTION_CONTROLLER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "aimd_rate_control.hpp"
+#include "trendline_estimator.hpp"
+
+constexpr int64_t DEFAULT_START_BITRATE = 2500000;  // bits/s
+constexpr int64_t DEFAULT_MIN_BITRATE = 300000;     // bits/s
+constexpr int64_t DEFAULT_MAX_BITRATE = 25000000;   // bits/s
+constexpr std::size_t SEND_HISTORY_SIZE = 4096;  // packets, a power of two
+constexpr std::chrono::milliseconds DELIVERY_WINDOW{500};
+
+/**
+ * @class CongestionController
+ * @brief Sender side of Google Congestion Control (draft-ietf-rmcat-gcc-02)
+ * with transport-wide feedback: sets the bitrate of the media stream from
+ * what the path delivers.
+ *
+ * Every datagram sent gets a transport-wide sequence number, and its send
+ * time and size are kept until the receiver reports its arrival time. The
+ * reports drive two controllers and the target is the lower of the two:
+ *
+ * - delay-based: TrendlineEstimator watches the queueing delay and
+ *   AimdRateControl raises the rate while it is flat and cuts it below
+ *   the delivered bitrate when it grows, so queues stay short;
+ * - loss-based: over 10% loss the rate drops by half the loss, under 2%
+ *   it may grow 8% a second, in between it holds. The loss is smoothed
+ *   over updates of at least 20 reported packets each.
+ *
+ * The delivered bitrate is measured over DELIVERY_WINDOW of arrivals, and
+ * the round trip from each report's newest packet. All memory is
+ * allocated up front.
+ *
+ * Bitrates are in bits/s and count whole UDP payloads. Not thread-safe;
+ * used from the sending thread.
+ */
+class CongestionController {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new CongestionController object
+     *
+     * @param start_bitrate Target before any feedback (default:
+     * DEFAULT_START_BITRATE)
+     * @param min_bitrate Lowest target (default: DEFAULT_MIN_BITRATE)
+     * @param max_bitrate Highest target (default: DEFAULT_MAX_BITRATE)
+     *
+     * @throws std::invalid_argument If the bitrates are not positive and in
+     * order.
+     */
+    explicit CongestionController(
+        const int64_t start_bitrate = DEFAULT_START_BITRATE,
+        const int64_t min_bitrate = DEFAULT_MIN_BITRATE,
+        const int64_t max_bitrate = DEFAULT_MAX_BITRATE);
+
+    /**
+     * @brief Record a datagram being sent and number it. Does not allocate.
+     *
+     * @param size UDP payload size, with the header extension carrying the
+     * number
+     * @param now Send time
+     * @return uint16_t Transport-wide sequence number to send it with
+     */
+    uint16_t on_packet_sent(const std::size_t size,
+                            const Clock::time_point now);
+
+    /**
+     * @brief Process a transport feedback from the receiver and update the
+     * target. Does not allocate.
+     *
+     * @param base_sequence Transport sequence number of the first packet
+     * @param arrivals Arrival time of each packet in microseconds on the
+     * receiver's clock, RtcpFeedback::NOT_RECEIVED for lost ones
+     * @param count Number of packets
+     * @param now Time the feedback arrived
+     */
+    void on_feedback(const uint16_t base_sequence, const int64_t* arrivals,
+                     const std::size_t count, const Clock::time_point now);
+
+    int64_t target_bitrate() const { return target_; }
+    int64_t delivered_bitrate() const { return delivered_bitrate_; }
+    double loss_rate() const { return loss_rate_; }  // Of the last reports
+    std::chrono::microseconds rtt() const { return rtt_; }
+    BandwidthUsage usage() const { return trendline_.usage(); }
+
+   private:
+    struct SentPacket {
+        bool used = false;
+        bool reported = false;
+        uint16_t sequence = 0;
+        uint32_t size = 0;
+        Clock::time_point send_time;
+    };
+
+    struct Delivery {
+        int64_t arrival = 0;  // us on the receiver's clock
+        uint32_t size = 0;
+    };
+
+    int64_t unwrap_arrival(const int64_t arrival);
+    void record_delivery(const int64_t arrival, const uint32_t size);
+    void update_loss_limit(const Clock::time_point now);
+
+    int64_t min_bitrate_;
+    int64_t max_bitrate_;
+    uint16_t next_sequence_;
+    std::vector<SentPacket> history_;
+    Clock::time_point origin_;  // Of send times passed to the trendline
+    bool has_origin_;
+    TrendlineEstimator trendline_;
+    AimdRateControl aimd_;
+    int64_t target_;
+    int64_t loss_limit_;
+    std::chrono::microseconds rtt_;  // Zero until measured
+    int64_t last_arrival_;   // Unwrapped, to unwrap the next
+    int64_t arrival_offset_;  // Added for the wraps of the reference time
+    bool has_arrival_;
+    std::vector<Delivery> deliveries_;  // Ring, oldest at delivery_head_
+    std::size_t delivery_head_;
+    std::size_t delivery_count_;
+    uint64_t delivered_bytes_;  // In the ring
+    int64_t delivered_bitrate_;
+    uint32_t reported_;  // Since the last loss update
+    uint32_t lost_;
+    double loss_rate_;
+    double smoothed_loss_;  // What the loss-based limit follows
+    bool loss_started_;
+    Clock::time_point last_loss_update_;
+    Clock::time_point last_loss_decrease_;
+};
+
+#endif  // CONGESTION_CONTROLLER_HPP
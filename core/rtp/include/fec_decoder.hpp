@@ -0,0 +1,114 @@
+#ifndef FEC_DECODER_HPP
+#define FEC_DECODER_HPP
+
+#include <array>
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "fec_packet.hpp"
+#include "galois_field.hpp"
+
+constexpr std::size_t FEC_MEDIA_WINDOW = 512;   // packets, a power of two
+constexpr std::size_t FEC_PARITY_WINDOW = 128;  // packets, a power of two
+constexpr std::size_t FEC_GROUP_WINDOW = 32;    // groups
+
+/**
+ * @class FecDecoder
+ * @brief Rebuilds lost video packets from the parity packets of their
+ * group, before the jitter buffer or the NACK tracker sees the gap.
+ *
+ * Keeps a copy of the last FEC_MEDIA_WINDOW video packets and
+ * FEC_PARITY_WINDOW parity packets, and tries to repair a group whenever a
+ * packet of it arrives: XOR parities rebuild the one source they cover if
+ * it alone is missing, and Reed-Solomon parities rebuild as many sources
+ * as have arrived, by inverting the Cauchy submatrix of the lost sources.
+ * Rebuilt packets are checked against the sequence number they replace
+ * and kept like received ones, so they can help repair later. Video
+ * packets are kept without their header extension, which is added after
+ * protection, so rebuilt ones have none. All memory
+ * is allocated up front.
+ *
+ * Not thread-safe; used from the receiving thread.
+ */
+class FecDecoder {
+   public:
+    /**
+     * @brief Construct a new FecDecoder object
+     *
+     * @param kernel GF(2^8) kernel (default: the fastest supported)
+     *
+     * @throws std::invalid_argument If the kernel is not supported.
+     */
+    explicit FecDecoder(
+        const GaloisField::Kernel kernel = GaloisField::best_kernel());
+
+    /**
+     * @brief Record a received video packet. Does not allocate.
+     *
+     * @param data RTP packet
+     * @param size Packet size
+     * @return const std::vector<boost::asio::const_buffer>& Packets it let
+     * the decoder rebuild, valid until the next call. Usually empty.
+     */
+    const std::vector<boost::asio::const_buffer>& push_media(
+        const unsigned char* data, const std::size_t size);
+
+    /**
+     * @brief Record a received parity packet. Does not allocate.
+     *
+     * @param data RTP packet of payload type Fec::PAYLOAD_TYPE
+     * @param size Packet size
+     * @return const std::vector<boost::asio::const_buffer>& Packets it let
+     * the decoder rebuild, valid until the next call. Usually empty.
+     */
+    const std::vector<boost::asio::const_buffer>& push_parity(
+        const unsigned char* data, const std::size_t size);
+
+    uint64_t rebuilt() const { return rebuilt_; }
+    uint64_t parity_packets() const { return parity_packets_; }
+
+   private:
+    struct MediaSlot {
+        bool used = false;
+        uint16_t sequence = 0;
+        unsigned char* block = nullptr;  // Length prefix, then the packet
+    };
+
+    struct ParitySlot {
+        bool used = false;
+        uint16_t sequence = 0;
+        Fec::Header header;
+        std::size_t size = 0;  // Of the parity, after the FEC header
+        unsigned char* data = nullptr;
+    };
+
+    struct Group {
+        bool active = false;
+        bool complete = false;
+        Fec::Header header;
+        uint16_t first_parity = 0;  // Sequence number of parity index 0
+    };
+
+    MediaSlot* store_media(const unsigned char* data, const std::size_t size);
+    const ParitySlot* parity(const Group& group, const std::size_t index) const;
+    void repair(Group& group);
+    void repair_xor(Group& group, const std::size_t* lost,
+                    const std::size_t lost_count);
+    void repair_reed_solomon(Group& group, const std::size_t* lost,
+                             const std::size_t lost_count);
+    bool accept(const std::size_t block_size, const uint16_t sequence);
+
+    GaloisField::Kernel kernel_;
+    std::vector<MediaSlot> media_;
+    std::vector<ParitySlot> parities_;
+    std::array<Group, FEC_GROUP_WINDOW> groups_;
+    std::size_t next_group_;
+    std::vector<unsigned char> storage_;
+    std::vector<unsigned char> syndromes_;  // One block per parity
+    std::vector<boost::asio::const_buffer> rebuilt_packets_;
+    uint64_t rebuilt_;
+    uint64_t parity_packets_;
+};
+
+#endif  // FEC_DECODER_HPP
@@ -0,0 +1,110 @@
+#ifndef FEC_ENCODER_HPP
+#define FEC_ENCODER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "fec_packet.hpp"
+#include "galois_field.hpp"
+#include "udp_segmentation.hpp"
+
+constexpr double MIN_FEC_LOSS = 0.025;          // Below it NACK is enough
+constexpr double TARGET_SOURCE_LOSS = 0.002;  // Group failures per source
+constexpr double MAX_FEC_OVERHEAD = 0.5;       // Parities per source
+constexpr std::size_t MIN_GROUP_SOURCES = 16;
+constexpr std::size_t MAX_GROUP_FRAMES = 4;
+constexpr std::size_t MAX_FRAME_PARITIES = 64;
+
+/**
+ * @class FecEncoder
+ * @brief Adds parity packets to the RTP packets of each video frame, as
+ * many as the loss the receiver reports calls for.
+ *
+ * A few parities cannot protect a small group cheaply, so frames of fewer
+ * than MIN_GROUP_SOURCES packets are held back, copied, and protected
+ * together with the following ones once the run reaches that size or
+ * spans MAX_GROUP_FRAMES frames. Larger runs are split into groups of up
+ * to Fec::MAX_SOURCES. Losses are taken to come in bursts of geometric
+ * length with the reported mean, at a rate that gives the reported loss;
+ * each group gets the fewest parities for which it loses more packets
+ * than they rebuild with less than TARGET_SOURCE_LOSS probability per
+ * source, up to MAX_FEC_OVERHEAD of its size. Below MIN_FEC_LOSS no parity
+ * is sent, leaving occasional losses to NACK.
+ *
+ * Parity packets are at most Fec::OVERHEAD bytes larger than the largest
+ * packet they protect; groups that would not fit a PacketBuffer, or whose
+ * sequence numbers are not a run, are sent unprotected. All memory is
+ * allocated up front.
+ *
+ * Not thread-safe; used from the sending thread.
+ */
+class FecEncoder {
+   public:
+    /**
+     * @brief Construct a new FecEncoder object
+     *
+     * @param ssrc Synchronization source of the parity stream, not the
+     * video stream's
+     * @param scheme Code (default: Reed-Solomon)
+     * @param kernel GF(2^8) kernel (default: the fastest supported)
+     *
+     * @throws std::invalid_argument If the kernel is not supported.
+     */
+    explicit FecEncoder(
+        const uint32_t ssrc,
+        const Fec::Scheme scheme = Fec::Scheme::REED_SOLOMON,
+        const GaloisField::Kernel kernel = GaloisField::best_kernel());
+
+    /**
+     * @brief Update the loss of the path from a receiver report
+     *
+     * @param loss_rate Fraction of packets lost, 0 to 1
+     * @param mean_burst Mean number of packets lost in a row, at least 1
+     */
+    void set_loss(const double loss_rate, const double mean_burst);
+
+    /**
+     * @brief Get the number of parity packets a group gets at the current
+     * loss
+     *
+     * @param sources Packets in the group, up to Fec::MAX_SOURCES
+     * @return std::size_t Parity packets, 0 for none or below MIN_FEC_LOSS
+     */
+    std::size_t parities_for(const std::size_t sources) const;
+
+    /**
+     * @brief Compute the parity packets of one frame and of the small
+     * frames held back before it. Does not allocate.
+     *
+     * @param packets The frame's RTP packets, in sequence order
+     * @return const std::vector<GatherDatagram>& Parity packets, valid
+     * until the next call. Empty when no protection is needed or the frame
+     * is held back.
+     */
+    const std::vector<GatherDatagram>& protect(
+        const std::vector<GatherDatagram>& packets);
+
+    Fec::Scheme scheme() const { return scheme_; }
+    double loss_rate() const { return loss_rate_; }
+    double mean_burst() const { return mean_burst_; }
+    uint64_t parity_packets() const { return parity_packets_; }
+
+   private:
+    bool hold(const GatherDatagram* packets, const std::size_t count);
+    void protect_group(const GatherDatagram* sources, const std::size_t count,
+                       const std::size_t parities);
+
+    Rtp::Header header_;
+    Fec::Scheme scheme_;
+    GaloisField::Kernel kernel_;
+    double loss_rate_;
+    double mean_burst_;
+    uint64_t parity_packets_;
+    std::vector<unsigned char> storage_;  // One PacketBuffer per parity
+    std::vector<GatherDatagram> packets_;
+    std::vector<unsigned char> held_storage_;  // One PacketBuffer per source
+    std::vector<GatherDatagram> held_;         // Copies in held_storage_
+    std::size_t held_frames_;
+};
+
+#endif  // FEC_ENCODER_HPP
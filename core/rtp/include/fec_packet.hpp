@@ -0,0 +1,104 @@
+#ifndef FEC_PACKET_HPP
+#define FEC_PACKET_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rtp_packet.hpp"
+
+/**
+ * @namespace Fec
+ * @brief Forward error correction packets protecting a group of
+ * consecutive video packets, in the spirit of FlexFEC (RFC 8627).
+ *
+ * Parity packets are RTP packets of their own payload type, SSRC and
+ * sequence numbers, so they leave no gaps in the video stream. The payload
+ * starts with HEADER_SIZE bytes naming the group, then the parity of its
+ * source blocks: each source packet, header included, prefixed with its
+ * length in two bytes and padded with zeros to the longest in the group.
+ * A rebuilt block therefore carries its own length.
+ *
+ * Parity j is the sum over the group of coefficient(j, i) times block i
+ * in GF(2^8). With XOR, parity j covers the sources i with i % parities ==
+ * j, so bursts as long as the number of parities are recovered. With
+ * Reed-Solomon the coefficients form a Cauchy matrix, and any parities
+ * received rebuild as many lost sources. Integers are big endian.
+ *
+ * Header: scheme (1), sources (1), parities (1), parity index (1), first
+ * source sequence number (2).
+ */
+namespace Fec {
+
+/**
+ * @enum Scheme
+ * @brief Enumerates the codes, by their value on the wire.
+ */
+enum class Scheme : uint8_t {
+    XOR = 0,          // One loss per parity, cheapest to compute
+    REED_SOLOMON = 1  // As many losses as parities received
+};
+
+constexpr uint8_t PAYLOAD_TYPE = 97;  // Second dynamic type
+constexpr std::size_t HEADER_SIZE = 6;
+constexpr std::size_t LENGTH_SIZE = 2;  // Prefix of each source block
+// Bytes a parity packet exceeds the largest packet of its group by
+constexpr std::size_t OVERHEAD = Rtp::HEADER_SIZE + HEADER_SIZE + LENGTH_SIZE;
+constexpr std::size_t MAX_SOURCES = 64;   // Per group
+constexpr std::size_t MAX_PARITIES = 16;  // Per group
+
+/**
+ * @struct Header
+ * @brief Fields of the FEC header
+ */
+struct Header {
+    Scheme scheme = Scheme::REED_SOLOMON;
+    uint8_t sources = 0;   // Packets in the group
+    uint8_t parities = 0;  // Parity packets for the group
+    uint8_t index = 0;     // Of this parity packet
+    uint16_t base = 0;     // Sequence number of the first source
+
+    /**
+     * @brief Check whether two parity packets belong to the same group
+     */
+    bool same_group(const Header& other) const {
+        return scheme == other.scheme && sources == other.sources &&
+               parities == other.parities && base == other.base;
+    }
+};
+
+/**
+ * @brief Write an FEC header
+ *
+ * @param header Header fields
+ * @param buffer Destination of at least HEADER_SIZE bytes
+ * @return std::size_t Header size
+ */
+std::size_t write_header(const Header& header, unsigned char* buffer);
+
+/**
+ * @brief Read and check the FEC header at the start of an RTP payload
+ *
+ * @param data RTP payload of a parity packet
+ * @param size Payload size
+ * @param header Receives the header fields
+ * @return true if the header is well-formed and within MAX_SOURCES and
+ * MAX_PARITIES, false otherwise.
+ */
+bool read_header(const unsigned char* data, const std::size_t size,
+                 Header& header);
+
+/**
+ * @brief Get the coefficient of a source block in a parity
+ *
+ * @param scheme Code
+ * @param parities Parity packets in the group
+ * @param parity Index of the parity
+ * @param source Index of the source in the group
+ * @return uint8_t Coefficient, 0 if the parity does not cover the source
+ */
+uint8_t coefficient(const Scheme scheme, const std::size_t parities,
+                    const std::size_t parity, const std::size_t source);
+
+}  // namespace Fec
+
+#endif  // FEC_PACKET_HPP
@@ -0,0 +1,88 @@
+#ifndef GALOIS_FIELD_HPP
+#define GALOIS_FIELD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace GaloisField
+ * @brief Arithmetic in GF(2^8) for erasure codes, with the field generated
+ * by x^8 + x^4 + x^3 + x^2 + 1 (0x11D). Addition is XOR.
+ *
+ * Region operations multiply a whole packet by one coefficient. The SIMD
+ * kernels split each byte into nibbles and look both up in 16-entry
+ * product tables with a byte shuffle (PSHUFB), 16 or 32 bytes at a time.
+ * Every kernel produces exactly the output of the scalar reference; the
+ * SIMD ones only do it faster.
+ */
+namespace GaloisField {
+
+/**
+ * @enum Kernel
+ * @brief Enumerates the region kernel implementations, slowest first.
+ */
+enum class Kernel {
+    SCALAR,  // Reference, portable
+    SSSE3,   // 16 bytes per step
+    AVX2     // 32 bytes per step
+};
+
+/**
+ * @brief Get the fastest kernel the CPU supports
+ *
+ * @return Kernel Detected once, on first use
+ */
+Kernel best_kernel();
+
+/**
+ * @brief Check whether the CPU can run a kernel
+ *
+ * @param kernel Kernel to check
+ * @return true if it is compiled in and supported, false otherwise.
+ */
+bool supported(const Kernel kernel);
+
+/**
+ * @brief Get the name of a kernel, for logs and benchmarks
+ *
+ * @param kernel Kernel
+ * @return const char* "scalar", "ssse3" or "avx2"
+ */
+const char* name(const Kernel kernel);
+
+/**
+ * @brief Multiply two elements
+ *
+ * @param a First factor
+ * @param b Second factor
+ * @return uint8_t Product
+ */
+uint8_t multiply(const uint8_t a, const uint8_t b);
+
+/**
+ * @brief Get the multiplicative inverse of an element
+ *
+ * @param a Element, not zero
+ * @return uint8_t Inverse, 0 for 0
+ */
+uint8_t inverse(const uint8_t a);
+
+/**
+ * @brief Add a region multiplied by a coefficient to another:
+ * destination[i] ^= coefficient * source[i]. A coefficient of 1 is a
+ * plain XOR and 0 does nothing.
+ *
+ * @param source Region to multiply
+ * @param destination Region to add to; may not overlap source
+ * @param size Bytes in each region
+ * @param coefficient Factor
+ * @param kernel Kernel to use, supported by the CPU (default: the fastest
+ * supported)
+ */
+void multiply_add(const unsigned char* source, unsigned char* destination,
+                  const std::size_t size, const uint8_t coefficient,
+                  const Kernel kernel = best_kernel());
+
+}  // namespace GaloisField
+
+#endif  // GALOIS_FIELD_HPP
@@ -0,0 +1,42 @@
+#ifndef GALOIS_FIELD_KERNELS_HPP
+#define GALOIS_FIELD_KERNELS_HPP
+
+#include "galois_field.hpp"
+
+/**
+ * @namespace GaloisField::Kernels
+ * @brief Per-instruction-set region kernels behind GaloisField's dispatch.
+ * The SSSE3 and AVX2 ones are compiled with their own target flags and
+ * only called once the CPU is known to support them.
+ *
+ * Multiplication kernels take the coefficient as two 16-entry tables: the
+ * products of the low nibbles 0 to 15, then of the high nibbles 0x00 to
+ * 0xF0. Bytes past the last whole SIMD step are finished by the scalar
+ * kernel.
+ */
+namespace GaloisField::Kernels {
+
+constexpr std::size_t TABLE_SIZE = 32;  // Low then high nibble products
+
+void multiply_add_scalar(const unsigned char* source,
+                         unsigned char* destination, std::size_t size,
+                         const uint8_t* tables);
+void add_scalar(const unsigned char* source, unsigned char* destination,
+                std::size_t size);
+
+#ifdef GALOIS_FIELD_X86
+void multiply_add_ssse3(const unsigned char* source,
+                        unsigned char* destination, std::size_t size,
+                        const uint8_t* tables);
+void add_ssse3(const unsigned char* source, unsigned char* destination,
+               std::size_t size);
+void multiply_add_avx2(const unsigned char* source,
+                       unsigned char* destination, std::size_t size,
+                       const uint8_t* tables);
+void add_avx2(const unsigned char* source, unsigned char* destination,
+              std::size_t size);
+#endif
+
+}  // namespace GaloisField::Kernels
+
+#endif  // GALOIS_FIELD_KERNELS_HPP
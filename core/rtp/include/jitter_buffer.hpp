@@ -0,0 +1,183 @@
+#ifndef JITTER_BUFFER_HPP
+#define JITTER_BUFFER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "vp8_depacketizer.hpp"
+
+constexpr std::chrono::milliseconds DEFAULT_MAX_LATENCY{50};
+constexpr std::size_t DEFAULT_JITTER_FRAMES = 32;
+constexpr std::chrono::milliseconds KEYFRAME_REQUEST_INTERVAL{200};
+
+/**
+ * @class JitterBuffer
+ * @brief Holds reassembled frames until they are both decodable and due,
+ * with a playout delay that follows the measured jitter.
+ *
+ * Frames are ordered by RTP sequence number. A frame is decodable when it
+ * follows the last frame played without a gap, when it is a keyframe, or,
+ * with temporal layers, when the frames it references were played: a base
+ * layer frame needs the previous base layer frame (TL0PICIDX), an upper
+ * layer frame its own base frame and, unless it is a layer sync frame,
+ * the frame just before it. A frame behind a gap waits past its playout
+ * time for the loss wait, in case the missing packets are retransmitted,
+ * and is then given up on, unless a newer keyframe is already buffered.
+ *
+ * A frame is due at its RTP timestamp mapped to local time through the
+ * least delayed frame seen, plus the playout delay. The delay is a
+ * multiple of the RFC 3550 inter-arrival jitter, capped at the maximum
+ * latency. Once the oldest frame is later than that cap, the buffer skips
+ * ahead to the newest keyframe it holds, or drops frames of the top
+ * temporal layer that nothing references, instead of playing them late.
+ *
+ * Not thread-safe; used from the receiving thread.
+ */
+class JitterBuffer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new JitterBuffer object
+     *
+     * @param max_latency Largest playout delay, and how late a frame may be
+     * before the buffer skips ahead (default: DEFAULT_MAX_LATENCY)
+     * @param capacity Number of frames held (default: DEFAULT_JITTER_FRAMES)
+     *
+     * @throws std::invalid_argument If capacity is zero.
+     */
+    explicit JitterBuffer(
+        const std::chrono::microseconds max_latency = DEFAULT_MAX_LATENCY,
+        const std::size_t capacity = DEFAULT_JITTER_FRAMES);
+
+    /**
+     * @brief Add a reassembled frame. The data is copied; the buffer grows
+     * the frame storage of every slot to the largest frame seen and then
+     * reuses it.
+     *
+     * @param frame Frame from the depacketizer
+     * @param arrival When its last packet arrived
+     * @param retransmitted Whether a retransmitted packet completed it; its
+     * arrival then says nothing about the network's jitter and is left out
+     * of the delay (default: false)
+     * @return true if the frame was buffered, false if it arrived after
+     * newer frames were played
+     */
+    bool insert(const ReceivedFrame& frame, const Clock::time_point arrival,
+                const bool retransmitted = false);
+
+    /**
+     * @brief Take the next frame to decode if it is due
+     *
+     * @param now Current time
+     * @param frame Receives the frame; its data stays valid until the next
+     * insert
+     * @return true if a frame is ready, false otherwise.
+     */
+    bool pop(const Clock::time_point now, ReceivedFrame& frame);
+
+    /**
+     * @brief Get when the oldest buffered frame is due, to wake up for it
+     *
+     * @param when Receives the time
+     * @return true if a frame is buffered, false otherwise.
+     */
+    bool next_playout(Clock::time_point& when) const;
+
+    /**
+     * @brief Get the latest time a frame can still be played: its playout
+     * time, plus the loss wait if it is waiting for missing packets
+     *
+     * @param timestamp RTP timestamp of the frame
+     * @return Clock::time_point Deadline, the largest time point before the
+     * first frame is timed
+     */
+    Clock::time_point deadline(const uint32_t timestamp) const;
+
+    /**
+     * @brief Set how long past its playout time a frame behind missing
+     * packets waits for them to be retransmitted before it is given up on.
+     * Capped at the maximum latency; zero, the default, when packets are
+     * not retransmitted.
+     *
+     * @param wait Loss wait, about one round trip when retransmitting
+     */
+    void set_loss_wait(const std::chrono::microseconds wait);
+
+    /**
+     * @brief Check whether a keyframe should be requested: the stream can
+     * only recover with one, and none was requested in the last
+     * KEYFRAME_REQUEST_INTERVAL, in case a request or its keyframe was lost
+     *
+     * @param now Current time, recorded as the time of the request
+     * @return true if a keyframe should be requested, false otherwise.
+     */
+    bool take_keyframe_request(const Clock::time_point now);
+
+    std::size_t size() const { return count_; }
+    std::chrono::microseconds max_latency() const { return max_latency_; }
+    std::chrono::microseconds jitter() const;
+    std::chrono::microseconds target_delay() const;
+
+    uint64_t delivered() const { return delivered_; }
+    uint64_t late() const { return late_; }        // Arrived after newer
+    uint64_t dropped() const { return dropped_; }  // Skipped or undecodable
+    uint64_t concealed() const { return concealed_; }  // Never arrived
+
+   private:
+    struct Slot {
+        bool used = false;
+        ReceivedFrame frame;
+        std::vector<unsigned char> data;
+        int64_t stream_us = 0;  // Unwrapped RTP timestamp
+    };
+
+    int64_t unwrap(const uint32_t timestamp);
+    void update_delay(const int64_t stream_us, const int64_t arrival_us);
+    Clock::time_point playout_time(const Slot& slot) const;
+    const Slot* oldest() const;
+    Slot* oldest();
+    const Slot* newest_keyframe() const;
+    bool decodable(const ReceivedFrame& frame) const;
+    bool droppable(const ReceivedFrame& frame) const;
+    void drop(Slot& slot);
+    void drop_before(const Slot& keep);
+    void deliver(Slot& slot, ReceivedFrame& frame);
+
+    std::chrono::microseconds max_latency_;
+    std::chrono::microseconds loss_wait_;
+    std::vector<Slot> slots_;
+    std::size_t count_;
+    std::size_t frame_capacity_;  // Reserved in every slot
+
+    // Mapping of RTP time to local time
+    bool timing_started_;
+    Clock::time_point epoch_;
+    uint32_t last_timestamp_;
+    int64_t last_unwrapped_;
+    int64_t last_stream_us_;
+    int64_t last_arrival_us_;
+    int64_t offset_us_;  // Smallest arrival minus stream time
+    double jitter_us_;
+    int64_t target_delay_us_;
+
+    // What has been played, for decodability
+    bool started_;
+    bool broken_;  // A frame was given up on since the last one played
+    bool keyframe_needed_;
+    bool keyframe_requested_;
+    Clock::time_point keyframe_request_time_;
+    uint16_t played_sequence_;  // Last sequence number played or dropped
+    int played_picture_id_;
+    int consumed_picture_id_;  // Of the last frame played or dropped
+    int played_tl0_pic_idx_;
+    int top_layer_;
+
+    uint64_t delivered_;
+    uint64_t late_;
+    uint64_t dropped_;
+    uint64_t concealed_;
+};
+
+#endif  // JITTER_BUFFER_HPP
@@ -0,0 +1,57 @@
+#ifndef LOSS_ESTIMATOR_HPP
+#define LOSS_ESTIMATOR_HPP
+
+#include <chrono>
+#include <cstdint>
+
+constexpr std::chrono::milliseconds LOSS_REPORT_INTERVAL{250};
+
+/**
+ * @class LossEstimator
+ * @brief Measures the loss rate and burstiness of a received RTP stream,
+ * for the sender to size its forward error correction.
+ *
+ * Counts, per report interval, the packets expected from the advance of
+ * the highest sequence number and the gaps in it, as in RFC 3550 section
+ * 6.4.1; a late packet takes one back off the losses. Each report updates
+ * a smoothed loss rate, rising fast so protection follows new loss and
+ * falling slowly so it is not withdrawn between bursts, and the mean
+ * length of a run of losses.
+ *
+ * Only first transmissions count: packets rebuilt from parity or resent
+ * on a NACK were lost, and counting them would hide the loss that FEC is
+ * sized for.
+ * Not thread-safe; used from the receiving thread.
+ */
+class LossEstimator {
+   public:
+    LossEstimator();
+
+    /**
+     * @brief Record a packet received from the network
+     *
+     * @param sequence Its RTP sequence number
+     */
+    void on_packet(const uint16_t sequence);
+
+    /**
+     * @brief Close the interval and update the estimates
+     *
+     * @param loss_rate Receives the smoothed fraction of packets lost
+     * @param mean_burst Receives the smoothed mean loss run, at least 1
+     * @return true if packets were expected in the interval, false
+     * otherwise, with the estimates unchanged.
+     */
+    bool report(double& loss_rate, double& mean_burst);
+
+   private:
+    bool started_;
+    uint16_t highest_sequence_;
+    uint32_t expected_;  // In the interval
+    uint32_t lost_;
+    uint32_t bursts_;
+    double loss_rate_;
+    double mean_burst_;
+};
+
+#endif  // LOSS_ESTIMATOR_HPP
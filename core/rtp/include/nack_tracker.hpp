@@ -0,0 +1,117 @@
+#ifndef NACK_TRACKER_HPP
+#define NACK_TRACKER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "jitter_buffer.hpp"
+#include "rtp_packet.hpp"
+
+constexpr std::chrono::milliseconds DEFAULT_REORDER_GRACE{5};
+constexpr int DEFAULT_NACK_RETRIES = 3;
+constexpr std::size_t MAX_MISSING = 512;  // packets, a power of two
+
+/**
+ * @class NackTracker
+ * @brief Finds the packets missing from a received RTP stream and decides
+ * when to ask the sender for them again.
+ *
+ * A gap in sequence numbers marks the packets in it missing. Each one is
+ * requested once it has stayed missing for the reorder grace period, and
+ * again every round trip while it is still missing, up to a number of
+ * retries. A packet is only requested while a retransmission sent now can
+ * still arrive before the jitter buffer's deadline for its frame;
+ * otherwise the frame is lost anyway and a keyframe is the way out. Gaps
+ * longer than MAX_MISSING are not tracked. All memory is allocated up
+ * front.
+ *
+ * Not thread-safe; used from the receiving thread.
+ */
+class NackTracker {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new NackTracker object
+     *
+     * @param grace How long a packet may be reordered before it is
+     * requested (default: DEFAULT_REORDER_GRACE)
+     * @param max_retries Number of times a packet is requested (default:
+     * DEFAULT_NACK_RETRIES)
+     *
+     * @throws std::invalid_argument If max_retries is not positive.
+     */
+    explicit NackTracker(
+        const std::chrono::microseconds grace = DEFAULT_REORDER_GRACE,
+        const int max_retries = DEFAULT_NACK_RETRIES);
+
+    /**
+     * @brief Record a received packet. Does not allocate.
+     *
+     * @param header Its RTP header
+     * @param now Arrival time
+     * @return true if the packet had been requested, so it is likely a
+     * retransmission, false otherwise.
+     */
+    bool on_packet(const Rtp::Header& header, const Clock::time_point now);
+
+    /**
+     * @brief Get the packets to request now. Does not allocate.
+     *
+     * @param now Current time
+     * @param rtt Round trip time to the sender
+     * @param playout Jitter buffer giving each frame's deadline
+     * @param sequences Receives the sequence numbers, in increasing order
+     * @param capacity Room in sequences
+     * @return std::size_t Number of sequence numbers to request
+     */
+    std::size_t poll(const Clock::time_point now,
+                     const std::chrono::microseconds rtt,
+                     const JitterBuffer& playout, uint16_t* sequences,
+                     const std::size_t capacity);
+
+    /**
+     * @brief Get when a missing packet is next due to be requested, to
+     * wake up for it. Valid after a poll.
+     *
+     * @param when Receives the time
+     * @return true if a request is pending, false otherwise.
+     */
+    bool next_poll(Clock::time_point& when) const;
+
+    std::size_t missing() const { return missing_; }
+    uint64_t requested() const { return requested_; }  // Requests sent
+    uint64_t recovered() const { return recovered_; }  // Arrived after one
+    uint64_t expired() const { return expired_; }  // Given up on
+
+   private:
+    struct Entry {
+        bool missing = false;
+        uint16_t sequence = 0;
+        uint32_t timestamp = 0;  // Of the frame waiting for it
+        int retries = 0;
+        Clock::time_point detected;
+        Clock::time_point requested;
+    };
+
+    Entry& entry(const uint16_t sequence) {
+        return entries_[sequence & (MAX_MISSING - 1)];
+    }
+    void forget(Entry& entry);
+
+    std::chrono::microseconds grace_;
+    int max_retries_;
+    std::vector<Entry> entries_;
+    bool started_;
+    uint16_t highest_sequence_;
+    uint16_t oldest_;  // No packet before it is missing
+    std::size_t missing_;
+    Clock::time_point next_poll_;
+
+    uint64_t requested_;
+    uint64_t recovered_;
+    uint64_t expired_;
+};
+
+#endif  // NACK_TRACKER_HPP
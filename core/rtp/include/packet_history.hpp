@@ -0,0 +1,82 @@
+#ifndef PACKET_HISTORY_HPP
+#define PACKET_HISTORY_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "packet_pool.hpp"
+#include "udp_segmentation.hpp"
+
+constexpr std::size_t DEFAULT_HISTORY_SIZE = 1024;  // packets
+constexpr std::chrono::milliseconds MIN_RESEND_INTERVAL{5};
+
+/**
+ * @class PacketHistory
+ * @brief Copies of the RTP packets recently sent, so lost ones can be sent
+ * again when the receiver asks, without encoding the frame again.
+ *
+ * A ring indexed by sequence number: each packet overwrites the one sent
+ * a ring size earlier. At 2.5 Mbit/s in 1200 byte packets the default
+ * holds about four seconds, far more than a retransmission can be useful
+ * for. All memory is allocated up front.
+ *
+ * Not thread-safe; used from the sending thread.
+ */
+class PacketHistory {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Construct a new PacketHistory object
+     *
+     * @param size Number of packets held, a power of two (default:
+     * DEFAULT_HISTORY_SIZE)
+     *
+     * @throws std::invalid_argument If size is not a power of two up to
+     * 32768.
+     */
+    explicit PacketHistory(const std::size_t size = DEFAULT_HISTORY_SIZE);
+
+    /**
+     * @brief Keep a copy of a packet being sent. Does not allocate.
+     *
+     * @param packet RTP header and payload
+     */
+    void store(const GatherDatagram& packet);
+
+    /**
+     * @brief Get a packet to send again. Packets already resent within
+     * MIN_RESEND_INTERVAL are refused, so one loss reported twice costs
+     * one retransmission.
+     *
+     * @param sequence Sequence number of the lost packet
+     * @param now Current time, recorded as the resend time
+     * @param packet Receives the packet; valid until the next store
+     * @return true if the packet is held and can be resent, false
+     * otherwise.
+     */
+    bool resend(const uint16_t sequence, const Clock::time_point now,
+                boost::asio::const_buffer& packet);
+
+    uint64_t resent() const { return resent_; }
+    uint64_t missing() const { return missing_; }  // No longer held
+
+   private:
+    struct Slot {
+        bool used = false;
+        uint16_t sequence = 0;
+        std::size_t size = 0;
+        unsigned char* data = nullptr;
+        Clock::time_point resent_at;
+        bool resent = false;
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<unsigned char> storage_;
+    uint64_t resent_;
+    uint64_t missing_;
+};
+
+#endif  // PACKET_HISTORY_HPP
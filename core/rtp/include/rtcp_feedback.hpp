@@ -0,0 +1,192 @@
+#ifndef RTCP_FEEDBACK_HPP
+#define RTCP_FEEDBACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/**
+ * @namespace RtcpFeedback
+ * @brief RTCP feedback messages (RFC 4585 section 6) that the receiver of
+ * a video stream sends back to its sender: generic NACK for lost packets,
+ * picture loss indication (PLI) for a keyframe, and transport-wide
+ * congestion control feedback (draft-holmer-rmcat-transport-wide-cc-
+ * extensions-01) with the arrival time of every packet. Loss reports for
+ * forward error correction travel in an application-defined packet (RFC
+ * 3550 section 6.7) named LOSS.
+ *
+ * Each message is sent as its own datagram, not in a compound packet, on
+ * the socket that carries the stream (RFC 5761 multiplexing). Integers are
+ * big endian.
+ */
+namespace RtcpFeedback {
+
+constexpr uint8_t TRANSPORT_FEEDBACK = 205;  // RTPFB
+constexpr uint8_t PAYLOAD_FEEDBACK = 206;    // PSFB
+constexpr uint8_t APPLICATION = 204;         // APP
+constexpr uint8_t GENERIC_NACK = 1;          // FMT of RTPFB
+constexpr uint8_t TRANSPORT_WIDE_CC = 15;    // FMT of RTPFB
+constexpr uint8_t PLI = 1;                   // FMT of PSFB
+constexpr std::size_t HEADER_SIZE = 12;  // Common header and both SSRCs
+constexpr std::size_t NACK_ITEM_SIZE = 4;   // PID and BLP
+constexpr std::size_t NACK_ITEM_SPAN = 17;  // Sequences one item covers
+constexpr std::size_t MAX_NACK_ITEMS = 64;
+constexpr std::size_t MAX_NACK_SIZE =
+    HEADER_SIZE + MAX_NACK_ITEMS * NACK_ITEM_SIZE;
+constexpr std::size_t PLI_SIZE = HEADER_SIZE;
+// Header, SSRC and name, then loss in 1/65535 and mean burst in 1/256
+constexpr std::size_t LOSS_REPORT_SIZE = 16;
+// Base sequence, status count, reference time and feedback count
+constexpr std::size_t TRANSPORT_FEEDBACK_HEADER_SIZE = HEADER_SIZE + 8;
+constexpr std::size_t MAX_FEEDBACK_PACKETS = 256;  // Per transport feedback
+// Two-bit status chunks and two-byte deltas at worst, padded to a word
+constexpr std::size_t MAX_TRANSPORT_FEEDBACK_SIZE =
+    (TRANSPORT_FEEDBACK_HEADER_SIZE + (MAX_FEEDBACK_PACKETS + 6) / 7 * 2 +
+     MAX_FEEDBACK_PACKETS * 2 + 3) /
+    4 * 4;
+constexpr int64_t NOT_RECEIVED = std::numeric_limits<int64_t>::min();
+// Arrival times read wrap with the 24-bit reference time of 64 ms units
+constexpr int64_t TRANSPORT_FEEDBACK_WRAP = (int64_t{1} << 24) * 64000;  // us
+
+/**
+ * @brief Check whether a datagram is an RTCP packet rather than RTP, by
+ * its packet type (RFC 5761 section 4)
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @return true if the datagram is RTCP, false otherwise.
+ */
+inline bool is_rtcp(const unsigned char* data, const std::size_t size) {
+    return size >= 4 && data[0] >> 6 == 2 && data[1] >= 192 &&
+           data[1] <= 223;
+}
+
+/**
+ * @brief Write a generic NACK. Sequence numbers must be in increasing
+ * order; each item covers up to NACK_ITEM_SPAN of them. Stops at
+ * MAX_NACK_ITEMS items.
+ *
+ * @param sender_ssrc SSRC of the receiver sending the NACK
+ * @param media_ssrc SSRC of the stream that lost the packets
+ * @param sequences Lost sequence numbers
+ * @param count Number of sequence numbers
+ * @param buffer Destination of at least MAX_NACK_SIZE bytes
+ * @param written Receives the number of sequence numbers written
+ * @return std::size_t Message size, 0 if count is 0
+ */
+std::size_t write_nack(const uint32_t sender_ssrc, const uint32_t media_ssrc,
+                       const uint16_t* sequences, const std::size_t count,
+                       unsigned char* buffer, std::size_t& written);
+
+/**
+ * @brief Write a picture loss indication
+ *
+ * @param sender_ssrc SSRC of the receiver asking for a keyframe
+ * @param media_ssrc SSRC of the stream
+ * @param buffer Destination of at least PLI_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t write_pli(const uint32_t sender_ssrc, const uint32_t media_ssrc,
+                      unsigned char* buffer);
+
+/**
+ * @brief Read the sequence numbers of a generic NACK. Does not allocate.
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param media_ssrc Receives the SSRC of the stream
+ * @param sequences Receives the lost sequence numbers
+ * @param capacity Room in sequences; at least MAX_NACK_ITEMS *
+ * NACK_ITEM_SPAN holds any NACK this module writes
+ * @param count Receives the number of sequence numbers read
+ * @return true if the datagram is a well-formed generic NACK, false
+ * otherwise.
+ */
+bool read_nack(const unsigned char* data, const std::size_t size,
+               uint32_t& media_ssrc, uint16_t* sequences,
+               const std::size_t capacity, std::size_t& count);
+
+/**
+ * @brief Read a picture loss indication
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param media_ssrc Receives the SSRC of the stream
+ * @return true if the datagram is a well-formed PLI, false otherwise.
+ */
+bool read_pli(const unsigned char* data, const std::size_t size,
+              uint32_t& media_ssrc);
+
+/**
+ * @brief Write a loss report
+ *
+ * @param sender_ssrc SSRC of the receiver sending the report
+ * @param loss_rate Fraction of packets lost, 0 to 1
+ * @param mean_burst Mean number of packets lost in a row, at least 1
+ * @param buffer Destination of at least LOSS_REPORT_SIZE bytes
+ * @return std::size_t Message size
+ */
+std::size_t write_loss_report(const uint32_t sender_ssrc,
+                              const double loss_rate, const double mean_burst,
+                              unsigned char* buffer);
+
+/**
+ * @brief Read a loss report
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param loss_rate Receives the fraction of packets lost
+ * @param mean_burst Receives the mean number of packets lost in a row
+ * @return true if the datagram is a well-formed loss report, false
+ * otherwise.
+ */
+bool read_loss_report(const unsigned char* data, const std::size_t size,
+                      double& loss_rate, double& mean_burst);
+
+/**
+ * @brief Write a transport-wide congestion control feedback: the arrival
+ * times of a run of transport sequence numbers, to 250 microseconds. Stops
+ * early at a packet that arrived more than about 8 seconds from the one
+ * before it; the next feedback can start from there.
+ *
+ * @param sender_ssrc SSRC of the receiver sending the feedback
+ * @param media_ssrc SSRC of the stream
+ * @param base_sequence Transport sequence number of the first packet
+ * @param arrivals Arrival time of each packet in microseconds on the
+ * receiver's clock, NOT_RECEIVED for lost ones
+ * @param count Number of packets; at most MAX_FEEDBACK_PACKETS are written
+ * @param feedback_count Count of feedbacks sent, modulo 256
+ * @param buffer Destination of at least MAX_TRANSPORT_FEEDBACK_SIZE bytes
+ * @param written Receives the number of packets written
+ * @return std::size_t Message size, 0 if count is 0
+ */
+std::size_t write_transport_feedback(
+    const uint32_t sender_ssrc, const uint32_t media_ssrc,
+    const uint16_t base_sequence, const int64_t* arrivals,
+    const std::size_t count, const uint8_t feedback_count,
+    unsigned char* buffer, std::size_t& written);
+
+/**
+ * @brief Read a transport-wide congestion control feedback. Does not
+ * allocate.
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param base_sequence Receives the transport sequence number of the first
+ * packet
+ * @param arrivals Receives the arrival time of each packet in microseconds,
+ * from an origin that wraps every 2^24 * 64 ms, NOT_RECEIVED for lost ones
+ * @param capacity Room in arrivals; MAX_FEEDBACK_PACKETS holds any
+ * feedback this module writes
+ * @param count Receives the number of packets read
+ * @return true if the datagram is a well-formed transport feedback of at
+ * most capacity packets, false otherwise.
+ */
+bool read_transport_feedback(const unsigned char* data,
+                             const std::size_t size, uint16_t& base_sequence,
+                             int64_t* arrivals, const std::size_t capacity,
+                             std::size_t& count);
+
+}  // namespace RtcpFeedback
+
+#endif  // RTCP_FEEDBACK_HPP
@@ -0,0 +1,161 @@
+#ifndef RTP_PACKET_HPP
+#define RTP_PACKET_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace Rtp
+ * @brief RTP fixed header (RFC 3550 section 5.1) and sequence arithmetic.
+ *
+ * Packets are written with the 12 byte fixed header only: no CSRCs, no
+ * header extension and no padding. Received packets may carry any of them;
+ * read_header skips over them to the payload. Integers are big endian.
+ *
+ * The one exception is the transport-wide sequence number for congestion
+ * control (draft-holmer-rmcat-transport-wide-cc-extensions-01), which the
+ * sender adds as a header extension to each datagram when it is sent:
+ * retransmissions and parity packets get their own. Without session
+ * negotiation its RFC 8285 one-byte element always has the ID
+ * TRANSPORT_SEQUENCE_ID.
+ */
+namespace Rtp {
+
+constexpr uint8_t VERSION = 2;
+constexpr std::size_t HEADER_SIZE = 12;       // Fixed header
+constexpr uint32_t VIDEO_CLOCK_RATE = 90000;  // Hz, RFC 7741 section 4.1
+constexpr uint8_t VP8_PAYLOAD_TYPE = 96;      // First dynamic type
+constexpr uint8_t TRANSPORT_SEQUENCE_ID = 1;  // RFC 8285 element ID
+// Extension header and the sequence number element, padded to a word
+constexpr std::size_t TRANSPORT_EXTENSION_SIZE = 8;
+
+/**
+ * @struct Header
+ * @brief Fields of the fixed header that the stream uses
+ */
+struct Header {
+    bool marker = false;  // Last packet of a video frame
+    uint8_t payload_type = VP8_PAYLOAD_TYPE;
+    uint16_t sequence = 0;
+    uint32_t timestamp = 0;
+    uint32_t ssrc = 0;
+};
+
+/**
+ * @brief Write a fixed header
+ *
+ * @param header Header fields
+ * @param buffer Destination of at least HEADER_SIZE bytes
+ * @return std::size_t Header size
+ */
+std::size_t write_header(const Header& header, unsigned char* buffer);
+
+/**
+ * @brief Read the header of a received packet and locate its payload,
+ * skipping CSRCs, a header extension and padding. Does not allocate.
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param header Receives the header fields
+ * @param payload_offset Receives the offset of the payload
+ * @param payload_size Receives the payload size, without padding
+ * @return true if the datagram is a well-formed RTP packet, false otherwise.
+ */
+bool read_header(const unsigned char* data, const std::size_t size,
+                 Header& header, std::size_t& payload_offset,
+                 std::size_t& payload_size);
+
+/**
+ * @brief Copy a fixed header written by write_header, adding a header
+ * extension with a transport-wide sequence number. The rest of the packet
+ * follows unchanged.
+ *
+ * @param header Fixed header, without CSRCs or extension
+ * @param transport_sequence Transport-wide sequence number
+ * @param buffer Destination of at least HEADER_SIZE +
+ * TRANSPORT_EXTENSION_SIZE bytes
+ * @return std::size_t Size written
+ */
+std::size_t write_transport_header(const unsigned char* header,
+                                   const uint16_t transport_sequence,
+                                   unsigned char* buffer);
+
+/**
+ * @brief Read the transport-wide sequence number of a received packet
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @param transport_sequence Receives the sequence number
+ * @return true if the packet carries one, false otherwise.
+ */
+bool read_transport_sequence(const unsigned char* data,
+                             const std::size_t size,
+                             uint16_t& transport_sequence);
+
+/**
+ * @brief Get the size of a packet's header extension, to copy the packet
+ * without it
+ *
+ * @param data RTP packet
+ * @param size Packet size
+ * @return std::size_t Extension size with its own header, 0 if the packet
+ * has none or is malformed
+ */
+std::size_t extension_size(const unsigned char* data, const std::size_t size);
+
+/**
+ * @brief Check cheaply whether a datagram can be an RTP packet, to tell it
+ * apart from the other messages sharing the socket. None of those start
+ * with version 2 in the top bits, and RTCP packet types take the second
+ * byte values 192 to 223, which the payload types in use never do (RFC
+ * 5761 section 4).
+ *
+ * @param data Datagram
+ * @param size Datagram size
+ * @return true if the datagram may be RTP, false otherwise.
+ */
+inline bool is_rtp(const unsigned char* data, const std::size_t size) {
+    return size >= HEADER_SIZE && data[0] >> 6 == VERSION &&
+           (data[1] < 192 || data[1] > 223);
+}
+
+/**
+ * @brief Distance from one sequence number to another, across wrap-around
+ *
+ * @param from Earlier sequence number
+ * @param to Later sequence number
+ * @return int Signed distance, positive if to is newer
+ */
+inline int sequence_delta(const uint16_t from, const uint16_t to) {
+    return static_cast<int16_t>(static_cast<uint16_t>(to - from));
+}
+
+/**
+ * @brief Check whether a sequence number is newer than another
+ *
+ * @param sequence Sequence number to check
+ * @param reference Sequence number to compare with
+ * @return true if sequence comes after reference, false otherwise.
+ */
+inline bool is_newer(const uint16_t sequence, const uint16_t reference) {
+    return sequence_delta(reference, sequence) > 0;
+}
+
+/**
+ * @brief Convert a time offset to 90 kHz video timestamp units
+ *
+ * @param elapsed Time since the stream's first frame
+ * @return uint32_t Timestamp offset, wrapping modulo 2^32
+ */
+inline uint32_t video_timestamp(const std::chrono::nanoseconds elapsed) {
+    // Through microseconds so the product cannot overflow
+    const auto microseconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+    return static_cast<uint32_t>(microseconds.count() *
+                                 (VIDEO_CLOCK_RATE / 1000) / 1000);
+}
+
+}  // namespace Rtp
+
+#endif  // RTP_PACKET_HPP
@@ -0,0 +1,88 @@
+#ifndef TRENDLINE_ESTIMATOR_HPP
+#define TRENDLINE_ESTIMATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+constexpr int64_t SEND_GROUP_SPAN_US = 5000;  // Packets sent as one burst
+constexpr std::size_t TRENDLINE_WINDOW = 20;  // Delay samples in the fit
+
+/**
+ * @enum BandwidthUsage
+ * @brief What the queueing delay along the path is doing
+ */
+enum class BandwidthUsage { NORMAL, UNDERUSING, OVERUSING };
+
+/**
+ * @class TrendlineEstimator
+ * @brief Detects a queue building up on the path from the arrival times
+ * of packets, as the delay-based half of Google Congestion Control
+ * (draft-ietf-rmcat-gcc-02 section 5).
+ *
+ * Packets sent within SEND_GROUP_SPAN_US of the first of a group are
+ * taken as one, since the sender bursts a frame at a time; so are packets
+ * arriving in a burst after a delay. Between consecutive groups the
+ * growth of the one-way delay is the arrival spacing less the send
+ * spacing. Its running sum, smoothed, is fitted by least squares over the
+ * last TRENDLINE_WINDOW groups: a positive slope means a queue is
+ * growing. The slope, scaled, is compared with a threshold that adapts to
+ * it, slowly upwards and quickly downwards, so that competing flows with
+ * loss-based control do not starve this one. Overuse must persist for
+ * 10 ms over two groups and not be easing before it is signalled.
+ *
+ * Times are in microseconds; arrival times are on the receiver's clock,
+ * which only needs a steady rate. Does not allocate. Not thread-safe.
+ */
+class TrendlineEstimator {
+   public:
+    TrendlineEstimator();
+
+    /**
+     * @brief Record a packet reported received, in transport sequence order
+     *
+     * @param send_time When it was sent, on the sender's clock
+     * @param arrival_time When it arrived, on the receiver's clock
+     */
+    void on_packet(const int64_t send_time, const int64_t arrival_time);
+
+    BandwidthUsage usage() const { return usage_; }
+    double trend() const { return trend_; }  // Delay growth, ms per ms
+    double threshold() const { return threshold_; }  // ms
+
+   private:
+    struct Group {
+        int64_t first_send = 0;
+        int64_t last_send = 0;
+        int64_t first_arrival = 0;
+        int64_t last_arrival = 0;
+    };
+
+    bool belongs(const int64_t send_time, const int64_t arrival_time) const;
+    void update(const double delay_variation, const double send_delta,
+                const int64_t arrival_time);
+    void detect(const double send_delta, const double now);
+    void adapt_threshold(const double modified_trend, const double now);
+
+    bool started_;
+    bool has_previous_;
+    Group current_;
+    Group previous_;
+    std::size_t deltas_;  // Groups seen, capped
+    int64_t first_arrival_;
+    double accumulated_delay_;  // ms
+    double smoothed_delay_;     // ms
+    std::array<double, TRENDLINE_WINDOW> times_;   // ms since first arrival
+    std::array<double, TRENDLINE_WINDOW> delays_;  // Smoothed, ms
+    std::size_t samples_;  // In the window
+    std::size_t next_sample_;
+    double trend_;
+    double previous_trend_;
+    double threshold_;
+    double last_threshold_update_;  // ms, negative before the first
+    double time_over_using_;        // ms, negative when not overusing
+    int overuse_count_;
+    BandwidthUsage usage_;
+};
+
+#endif  // TRENDLINE_ESTIMATOR_HPP
@@ -0,0 +1,109 @@
+#ifndef VP8_DEPACKETIZER_HPP
+#define VP8_DEPACKETIZER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "packet_pool.hpp"
+#include "rtp_packet.hpp"
+#include "vp8_payload.hpp"
+
+constexpr std::size_t DEFAULT_REORDER_WINDOW = 512;  // packets
+
+/**
+ * @struct ReceivedFrame
+ * @brief A VP8 frame reassembled from its RTP packets. The data belongs to
+ * the depacketizer and stays valid until its next push.
+ */
+struct ReceivedFrame {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    uint32_t timestamp = 0;  // 90 kHz RTP timestamp
+    uint32_t ssrc = 0;
+    uint16_t first_sequence = 0;
+    uint16_t last_sequence = 0;
+    int picture_id = Vp8Payload::NONE;
+    int tl0_pic_idx = Vp8Payload::NONE;
+    int temporal_layer = Vp8Payload::NONE;
+    bool layer_sync = false;
+    bool keyframe = false;
+};
+
+/**
+ * @class Vp8Depacketizer
+ * @brief Reassembles VP8 frames from RTP packets that may arrive out of
+ * order or more than once.
+ *
+ * Packets wait in a ring indexed by sequence number until their frame is
+ * complete: a packet starting partition 0, one with the marker bit, the
+ * same timestamp and no sequence gap between them. Frames are delivered as
+ * soon as they complete, so a later frame can come out before an earlier
+ * one that still waits for a packet; ordering them is up to the caller.
+ * Packets further behind the newest one than the ring holds are dropped.
+ * All memory is allocated up front.
+ */
+class Vp8Depacketizer {
+   public:
+    /**
+     * @brief Construct a new Vp8Depacketizer object
+     *
+     * @param window Number of packets that can wait for their frame, a
+     * power of two (default: DEFAULT_REORDER_WINDOW)
+     *
+     * @throws std::invalid_argument If window is not a power of two up to
+     * 32768.
+     */
+    explicit Vp8Depacketizer(const std::size_t window =
+                                 DEFAULT_REORDER_WINDOW);
+
+    /**
+     * @brief Add a received packet. Does not allocate.
+     *
+     * @param data Datagram, only read during the call
+     * @param size Datagram size
+     * @param frame Receives the frame if this packet completes one
+     * @return true if a frame was completed, false otherwise.
+     */
+    bool push(const unsigned char* data, const std::size_t size,
+              ReceivedFrame& frame);
+
+    uint64_t packets() const { return packets_; }
+    uint64_t frames() const { return frames_; }
+    uint64_t malformed() const { return malformed_; }
+    uint64_t duplicates() const { return duplicates_; }
+    uint64_t late() const { return late_; }
+
+   private:
+    enum class SlotState : uint8_t { EMPTY, PENDING, DONE };
+
+    struct Slot {
+        SlotState state = SlotState::EMPTY;
+        bool first = false;  // Starts partition 0
+        bool last = false;   // Marker bit
+        uint16_t sequence = 0;
+        uint32_t timestamp = 0;
+        std::size_t size = 0;
+        unsigned char* data = nullptr;
+        Vp8Payload::Descriptor descriptor;
+    };
+
+    Slot& slot(const uint16_t sequence) {
+        return slots_[sequence % slots_.size()];
+    }
+    bool waiting(const uint16_t sequence, const uint32_t timestamp);
+    bool assemble(const uint16_t sequence, const Rtp::Header& header,
+                  ReceivedFrame& frame);
+
+    std::vector<Slot> slots_;
+    std::vector<unsigned char> storage_;  // PacketBuffer::CAPACITY per slot
+    std::vector<unsigned char> frame_;
+    bool started_;
+    uint16_t highest_sequence_;
+    uint64_t packets_;
+    uint64_t frames_;
+    uint64_t malformed_;
+    uint64_t duplicates_;
+    uint64_t late_;
+};
+
+#endif  // VP8_DEPACKETIZER_HPP
@@ -0,0 +1,103 @@
+#ifndef VP8_PACKETIZER_HPP
+#define VP8_PACKETIZER_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "path_mtu.hpp"
+#include "rtp_packet.hpp"
+#include "udp_segmentation.hpp"
+#include "vp8_payload.hpp"
+
+/**
+ * @struct Vp8FrameInfo
+ * @brief What the packetizer needs to know about an encoded frame besides
+ * its data
+ */
+struct Vp8FrameInfo {
+    uint32_t timestamp = 0;  // 90 kHz RTP timestamp
+    int temporal_layer = Vp8Payload::NONE;  // NONE without temporal layers
+    bool layer_sync = false;
+    bool non_reference = false;  // No later frame references this one
+};
+
+/**
+ * @class Vp8Packetizer
+ * @brief Splits encoded VP8 frames into RTP packets of at most the path's
+ * packet size, without copying the frame.
+ *
+ * Each packet is a GatherDatagram: the RTP header and payload descriptor,
+ * written into a buffer the packetizer owns, and a slice of the caller's
+ * frame. Every packet but the last is filled to the maximum size, so
+ * UdpSegmentSender can hand a whole frame to the kernel as one segmented
+ * send. The frame data must stay valid until the packets are sent.
+ *
+ * Every packet carries a 15 bit picture ID; TL0PICIDX and TID are added
+ * when the frame has a temporal layer. The first sequence number is random
+ * (RFC 3550 section 5.1).
+ */
+class Vp8Packetizer {
+   public:
+    static constexpr std::size_t MAX_HEADER_SIZE =
+        Rtp::HEADER_SIZE + Vp8Payload::MAX_DESCRIPTOR_SIZE;
+
+    /**
+     * @brief Construct a new Vp8Packetizer object
+     *
+     * @param ssrc Synchronization source of the stream
+     * @param max_packet_size Largest UDP payload to produce (default: the
+     * size every path is assumed to carry)
+     * @param payload_type RTP payload type (default: Rtp::VP8_PAYLOAD_TYPE)
+     *
+     * @throws std::invalid_argument If max_packet_size cannot hold a header
+     * and some data.
+     */
+    explicit Vp8Packetizer(const uint32_t ssrc,
+                           const std::size_t max_packet_size =
+                               PathMtu::BASE_PLPMTU,
+                           const uint8_t payload_type = Rtp::VP8_PAYLOAD_TYPE);
+
+    /**
+     * @brief Packetize one encoded frame
+     *
+     * @param data Encoded frame, referenced by the packets
+     * @param size Frame size
+     * @param info Timestamp and temporal layer of the frame
+     * @return const std::vector<GatherDatagram>& Packets in sequence order,
+     * valid until the next call. Empty if the frame is empty.
+     */
+    const std::vector<GatherDatagram>& packetize(const unsigned char* data,
+                                                 const std::size_t size,
+                                                 const Vp8FrameInfo& info);
+
+    /**
+     * @brief Change the largest packet size from the next frame, e.g. when
+     * path MTU discovery confirms a new size
+     *
+     * @param max_packet_size Largest UDP payload to produce
+     *
+     * @throws std::invalid_argument If it cannot hold a header and some data.
+     */
+    void set_max_packet_size(const std::size_t max_packet_size);
+
+    std::size_t max_packet_size() const { return max_packet_size_; }
+    uint32_t ssrc() const { return header_.ssrc; }
+
+    /**
+     * @brief Get the sequence number the next packet will have
+     *
+     * @return uint16_t Next sequence number
+     */
+    uint16_t next_sequence() const { return header_.sequence; }
+
+   private:
+    Rtp::Header header_;
+    std::size_t max_packet_size_;
+    uint16_t picture_id_;
+    uint8_t tl0_pic_idx_;
+    std::vector<std::array<unsigned char, MAX_HEADER_SIZE>> headers_;
+    std::vector<GatherDatagram> packets_;
+};
+
+#endif  // VP8_PACKETIZER_HPP
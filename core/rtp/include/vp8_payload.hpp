@@ -0,0 +1,91 @@
+#ifndef VP8_PAYLOAD_HPP
+#define VP8_PAYLOAD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace Vp8Payload
+ * @brief VP8 payload descriptor of RFC 7741 section 4.2, which starts the
+ * payload of every VP8 RTP packet.
+ *
+ *      0 1 2 3 4 5 6 7
+ *     +-+-+-+-+-+-+-+-+
+ *     |X|R|N|S|R| PID |  N: non-reference, S: start of partition
+ *     +-+-+-+-+-+-+-+-+
+ *  X: |I|L|T|K| RSV   |  Which optional fields follow
+ *     +-+-+-+-+-+-+-+-+
+ *  I: |M| PictureID   |  7 bits, or 15 with M set and a second byte
+ *     +-+-+-+-+-+-+-+-+
+ *  L: |   TL0PICIDX   |  Counts base layer frames
+ *     +-+-+-+-+-+-+-+-+
+ * T/K:|TID|Y| KEYIDX  |  Temporal layer, layer sync
+ *     +-+-+-+-+-+-+-+-+
+ */
+namespace Vp8Payload {
+
+constexpr std::size_t MAX_DESCRIPTOR_SIZE = 6;
+constexpr int NONE = -1;  // Optional field absent
+constexpr int PICTURE_ID_MASK = 0x7FFF;
+
+/**
+ * @struct Descriptor
+ * @brief Payload descriptor fields. Optional fields are NONE when absent.
+ */
+struct Descriptor {
+    bool non_reference = false;  // Frame can be discarded without harm
+    bool start_of_partition = false;
+    uint8_t partition_id = 0;
+    int picture_id = NONE;  // Written with 15 bits
+    int tl0_pic_idx = NONE;
+    int temporal_layer = NONE;
+    bool layer_sync = false;  // Only references base layer frames
+    int key_index = NONE;
+};
+
+/**
+ * @brief Get the size a descriptor will be written with
+ *
+ * @param descriptor Descriptor fields
+ * @return std::size_t Size in bytes, at most MAX_DESCRIPTOR_SIZE
+ */
+std::size_t descriptor_size(const Descriptor& descriptor);
+
+/**
+ * @brief Write a descriptor
+ *
+ * @param descriptor Descriptor fields
+ * @param buffer Destination of at least descriptor_size() bytes
+ * @return std::size_t Descriptor size
+ */
+std::size_t write_descriptor(const Descriptor& descriptor,
+                             unsigned char* buffer);
+
+/**
+ * @brief Read the descriptor at the start of an RTP payload. Does not
+ * allocate.
+ *
+ * @param data RTP payload
+ * @param size Payload size
+ * @param descriptor Receives the descriptor fields
+ * @param size_read Receives the descriptor size
+ * @return true if the descriptor is well-formed and followed by at least
+ * one byte of VP8 data, false otherwise.
+ */
+bool read_descriptor(const unsigned char* data, const std::size_t size,
+                     Descriptor& descriptor, std::size_t& size_read);
+
+/**
+ * @brief Check whether VP8 data starts a keyframe, from the inverse key
+ * frame flag of the VP8 payload header (RFC 7741 section 4.3)
+ *
+ * @param data VP8 data at the start of partition 0
+ * @return true if the frame is a keyframe, false otherwise.
+ */
+inline bool is_keyframe(const unsigned char* data) {
+    return (data[0] & 0x01) == 0;
+}
+
+}  // namespace Vp8Payload
+
+#endif  // VP8_PAYLOAD_HPP
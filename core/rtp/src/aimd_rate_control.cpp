@@ -0,0 +1,139 @@
+#include "aimd_rate_control.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double INCREASE_PER_SECOND = 1.08;  // Away from the capacity
+constexpr double GROWTH_PER_SECOND = 1.25;    // Once past the capacity seen
+constexpr double MIN_INCREASE = 1000;         // bits/s
+constexpr double PACKET_BITS = 1200 * 8;      // Added per response time
+constexpr double MIN_ADDITIVE_INCREASE = 4000;  // bits/s per second
+constexpr std::chrono::milliseconds RESPONSE_MARGIN{100};
+constexpr double DELIVERED_HEADROOM = 1.5;
+constexpr int64_t DELIVERED_MARGIN = 10000;  // bits/s
+constexpr std::chrono::milliseconds MIN_DECREASE_INTERVAL{10};
+constexpr std::chrono::milliseconds MAX_DECREASE_INTERVAL{200};
+constexpr double CAPACITY_GAIN = 0.05;
+constexpr double MIN_DEVIATION = 0.4;
+constexpr double MAX_DEVIATION = 2.5;
+
+double seconds(const AimdRateControl::Clock::duration duration) {
+    return std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+AimdRateControl::AimdRateControl(const int64_t start_bitrate,
+                                 const int64_t min_bitrate,
+                                 const int64_t max_bitrate)
+    : bitrate_(start_bitrate),
+      min_bitrate_(min_bitrate),
+      max_bitrate_(max_bitrate),
+      state_(State::HOLD),
+      started_(false),
+      growing_(false),
+      capacity_(0),
+      deviation_(MIN_DEVIATION) {}
+
+int64_t AimdRateControl::update(const BandwidthUsage usage,
+                                const int64_t delivered_bitrate,
+                                const std::chrono::microseconds rtt,
+                                const Clock::time_point now) {
+    if (!started_) {
+        started_ = true;
+        last_update_ = now;
+        last_decrease_ = now - MAX_DECREASE_INTERVAL;
+    }
+
+    switch (usage) {
+        case BandwidthUsage::OVERUSING:
+            state_ = State::DECREASE;
+            break;
+        case BandwidthUsage::UNDERUSING:
+            // A queue is draining: let it, before probing further
+            state_ = State::HOLD;
+            break;
+        case BandwidthUsage::NORMAL:
+            if (state_ == State::HOLD) state_ = State::INCREASE;
+            break;
+    }
+
+    const double elapsed = std::min(seconds(now - last_update_), 1.0);
+    last_update_ = now;
+    const auto delivered = static_cast<double>(delivered_bitrate);
+    auto bitrate = static_cast<double>(bitrate_);
+    if (state_ == State::INCREASE) {
+        // Delivered past the capacity seen: it has grown
+        if (capacity_ > 0 && delivered_bitrate > 0 &&
+            delivered / 1000 >
+                capacity_ + 3 * std::sqrt(deviation_ * capacity_)) {
+            capacity_ = 0;
+            growing_ = true;
+        }
+
+        // Near a known capacity, about a packet per response time
+        double increase = 0;
+        if (capacity_ > 0) {
+            const double response_time = seconds(rtt + RESPONSE_MARGIN);
+            increase = std::max(MIN_ADDITIVE_INCREASE,
+                                PACKET_BITS / response_time) *
+                       elapsed;
+        } else {
+            // A link that grew is probed faster than an unknown one, or
+            // climbing to its new capacity takes as many seconds
+            const double rate =
+                growing_ ? GROWTH_PER_SECOND : INCREASE_PER_SECOND;
+            increase = std::max(bitrate * (std::pow(rate, elapsed) - 1),
+                                MIN_INCREASE * elapsed);
+        }
+        bitrate += increase;
+        if (delivered_bitrate > 0) {
+            const double limit =
+                DELIVERED_HEADROOM * delivered + DELIVERED_MARGIN;
+            bitrate = std::min(bitrate,
+                               std::max(static_cast<double>(bitrate_), limit));
+        }
+    } else if (state_ == State::DECREASE) {
+        // Once per round trip, since feedback on the cut takes that long;
+        // sooner if the path delivers less than half the rate
+        const auto interval = std::clamp<Clock::duration>(
+            rtt, MIN_DECREASE_INTERVAL, MAX_DECREASE_INTERVAL);
+        if (now - last_decrease_ >= interval ||
+            (delivered_bitrate > 0 && delivered < bitrate / 2)) {
+            double decreased =
+                AIMD_DECREASE_FACTOR * (delivered_bitrate > 0 ? delivered
+                                                              : bitrate);
+            if (decreased > bitrate && capacity_ > 0) {
+                decreased = AIMD_DECREASE_FACTOR * capacity_ * 1000;
+            }
+            bitrate = std::min(bitrate, decreased);
+            if (delivered_bitrate > 0) {
+                if (capacity_ > 0 &&
+                    delivered / 1000 <
+                        capacity_ - 3 * std::sqrt(deviation_ * capacity_)) {
+                    capacity_ = 0;  // Dropped: start over
+                }
+                update_capacity(delivered / 1000);
+            }
+            last_decrease_ = now;
+            growing_ = false;
+        }
+        state_ = State::HOLD;
+    }
+
+    bitrate_ = std::clamp(static_cast<int64_t>(bitrate), min_bitrate_,
+                          max_bitrate_);
+    return bitrate_;
+}
+
+void AimdRateControl::update_capacity(const double sample) {
+    capacity_ = capacity_ == 0
+                    ? sample
+                    : (1 - CAPACITY_GAIN) * capacity_ + CAPACITY_GAIN * sample;
+    const double error = capacity_ - sample;
+    deviation_ = (1 - CAPACITY_GAIN) * deviation_ +
+                 CAPACITY_GAIN * error * error / std::max(capacity_, 1.0);
+    deviation_ = std::clamp(deviation_, MIN_DEVIATION, MAX_DEVIATION);
+}
@@ -0,0 +1,71 @@
+#include "arrival_recorder.hpp"
+
+#include <algorithm>
+
+#include "rtp_packet.hpp"
+
+ArrivalRecorder::ArrivalRecorder()
+    : slots_(ARRIVAL_WINDOW),
+      arrivals_{},
+      started_(false),
+      next_sequence_(0),
+      highest_sequence_(0),
+      feedback_count_(0) {}
+
+void ArrivalRecorder::on_packet(const uint16_t transport_sequence,
+                                const Clock::time_point arrival) {
+    if (!started_) {
+        started_ = true;
+        next_sequence_ = transport_sequence;
+        highest_sequence_ = transport_sequence;
+    } else if (Rtp::sequence_delta(next_sequence_, transport_sequence) < 0) {
+        return;  // Already reported lost
+    } else if (Rtp::is_newer(transport_sequence, highest_sequence_)) {
+        highest_sequence_ = transport_sequence;
+        const int pending =
+            Rtp::sequence_delta(next_sequence_, highest_sequence_) + 1;
+        if (pending > static_cast<int>(ARRIVAL_WINDOW)) {
+            next_sequence_ =
+                static_cast<uint16_t>(highest_sequence_ - ARRIVAL_WINDOW + 1);
+        }
+    }
+
+    Slot& slot = slots_[transport_sequence & (slots_.size() - 1)];
+    slot.sequence = transport_sequence;
+    slot.arrival = std::chrono::duration_cast<std::chrono::microseconds>(
+                       arrival.time_since_epoch())
+                       .count();
+}
+
+std::size_t ArrivalRecorder::write_feedback(const uint32_t sender_ssrc,
+                                            const uint32_t media_ssrc,
+                                            unsigned char* buffer) {
+    if (!started_ || Rtp::is_newer(next_sequence_, highest_sequence_)) {
+        return 0;
+    }
+
+    const std::size_t count = std::min<std::size_t>(
+        Rtp::sequence_delta(next_sequence_, highest_sequence_) + 1,
+        arrivals_.size());
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto sequence = static_cast<uint16_t>(next_sequence_ + i);
+        const Slot& slot = slots_[sequence & (slots_.size() - 1)];
+        arrivals_[i] = slot.sequence == sequence ? slot.arrival
+                                                 : RtcpFeedback::NOT_RECEIVED;
+    }
+
+    // Packets after an arrival too far from the one before are reported
+    // in the next feedback
+    std::size_t written = 0;
+    const std::size_t size = RtcpFeedback::write_transport_feedback(
+        sender_ssrc, media_ssrc, next_sequence_, arrivals_.data(), count,
+        feedback_count_, buffer, written);
+    for (std::size_t i = 0; i < written; ++i) {
+        const auto sequence = static_cast<uint16_t>(next_sequence_ + i);
+        slots_[sequence & (slots_.size() - 1)].arrival =
+            RtcpFeedback::NOT_RECEIVED;
+    }
+    ++feedback_count_;
+    next_sequence_ = static_cast<uint16_t>(next_sequence_ + written);
+    return size;
+}
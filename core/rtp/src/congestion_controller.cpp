@@ -0,0 +1,199 @@
+#include "congestion_controller.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "rtcp_feedback.hpp"
+
+namespace {
+
+constexpr int RTT_GAIN = 8;  // 1/8, as RFC 6298
+constexpr std::chrono::milliseconds MIN_DELIVERY_SPAN{100};
+constexpr uint32_t LOSS_MIN_PACKETS = 20;  // Per loss update
+constexpr int LOSS_GAIN = 4;               // 1/4 of each update
+constexpr double HIGH_LOSS = 0.1;
+constexpr double LOW_LOSS = 0.02;
+constexpr double LOSS_INCREASE_PER_SECOND = 1.08;
+constexpr std::chrono::milliseconds LOSS_DECREASE_INTERVAL{300};  // + RTT
+
+int64_t microseconds(const CongestionController::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+        .count();
+}
+
+}  // namespace
+
+CongestionController::CongestionController(const int64_t start_bitrate,
+                                           const int64_t min_bitrate,
+                                           const int64_t max_bitrate)
+    : min_bitrate_(min_bitrate),
+      max_bitrate_(max_bitrate),
+      next_sequence_(0),
+      history_(SEND_HISTORY_SIZE),
+      has_origin_(false),
+      aimd_(start_bitrate, min_bitrate, max_bitrate),
+      target_(start_bitrate),
+      loss_limit_(max_bitrate),
+      rtt_(0),
+      last_arrival_(0),
+      arrival_offset_(0),
+      has_arrival_(false),
+      deliveries_(SEND_HISTORY_SIZE),
+      delivery_head_(0),
+      delivery_count_(0),
+      delivered_bytes_(0),
+      delivered_bitrate_(0),
+      reported_(0),
+      lost_(0),
+      loss_rate_(0),
+      smoothed_loss_(0),
+      loss_started_(false) {
+    if (min_bitrate <= 0 || start_bitrate < min_bitrate ||
+        max_bitrate < start_bitrate) {
+        throw std::invalid_argument("Bitrates must be positive and in order");
+    }
+}
+
+uint16_t CongestionController::on_packet_sent(const std::size_t size,
+                                              const Clock::time_point now) {
+    const uint16_t sequence = next_sequence_++;
+    SentPacket& packet = history_[sequence & (history_.size() - 1)];
+    packet.used = true;
+    packet.reported = false;
+    packet.sequence = sequence;
+    packet.size = static_cast<uint32_t>(size);
+    packet.send_time = now;
+    return sequence;
+}
+
+void CongestionController::on_feedback(const uint16_t base_sequence,
+                                       const int64_t* arrivals,
+                                       const std::size_t count,
+                                       const Clock::time_point now) {
+    bool received = false;
+    Clock::time_point newest_send;
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto sequence = static_cast<uint16_t>(base_sequence + i);
+        SentPacket& packet = history_[sequence & (history_.size() - 1)];
+        if (!packet.used || packet.sequence != sequence || packet.reported) {
+            continue;
+        }
+
+        packet.reported = true;
+        ++reported_;
+        if (arrivals[i] == RtcpFeedback::NOT_RECEIVED) {
+            ++lost_;
+            continue;
+        }
+
+        const int64_t arrival = unwrap_arrival(arrivals[i]);
+        if (!has_origin_) {
+            has_origin_ = true;
+            origin_ = packet.send_time;
+        }
+        trendline_.on_packet(microseconds(packet.send_time - origin_),
+                             arrival);
+        record_delivery(arrival, packet.size);
+        if (!received || packet.send_time > newest_send) {
+            newest_send = packet.send_time;
+        }
+        received = true;
+    }
+
+    // The receiver reports as soon as a packet completes its interval, so
+    // the newest one reported has only just arrived
+    if (received) {
+        const auto sample =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                now - newest_send);
+        rtt_ = rtt_.count() == 0 ? sample : rtt_ + (sample - rtt_) / RTT_GAIN;
+    }
+
+    const int64_t delay_based =
+        aimd_.update(trendline_.usage(), delivered_bitrate_, rtt_, now);
+    update_loss_limit(now);
+    target_ =
+        std::clamp(std::min(delay_based, loss_limit_), min_bitrate_,
+                   max_bitrate_);
+}
+
+int64_t CongestionController::unwrap_arrival(const int64_t arrival) {
+    constexpr int64_t WRAP = RtcpFeedback::TRANSPORT_FEEDBACK_WRAP;
+    int64_t value = arrival + arrival_offset_;
+    if (has_arrival_) {
+        if (value < last_arrival_ - WRAP / 2) {
+            arrival_offset_ += WRAP;
+            value += WRAP;
+        } else if (value > last_arrival_ + WRAP / 2) {
+            value -= WRAP;  // Reordered from before the last wrap
+        }
+    }
+    last_arrival_ = has_arrival_ ? std::max(last_arrival_, value) : value;
+    has_arrival_ = true;
+    return value;
+}
+
+void CongestionController::record_delivery(const int64_t arrival,
+                                           const uint32_t size) {
+    if (delivery_count_ == deliveries_.size()) {
+        delivered_bytes_ -= deliveries_[delivery_head_].size;
+        delivery_head_ = (delivery_head_ + 1) % deliveries_.size();
+        --delivery_count_;
+    }
+    deliveries_[(delivery_head_ + delivery_count_) % deliveries_.size()] = {
+        arrival, size};
+    ++delivery_count_;
+    delivered_bytes_ += size;
+
+    const int64_t start = last_arrival_ - microseconds(DELIVERY_WINDOW);
+    while (delivery_count_ > 1 &&
+           deliveries_[delivery_head_].arrival < start) {
+        delivered_bytes_ -= deliveries_[delivery_head_].size;
+        delivery_head_ = (delivery_head_ + 1) % deliveries_.size();
+        --delivery_count_;
+    }
+
+    // The first packet marks the start of the span, its bytes came before
+    const Delivery& first = deliveries_[delivery_head_];
+    const int64_t span = last_arrival_ - first.arrival;
+    if (span >= microseconds(MIN_DELIVERY_SPAN)) {
+        delivered_bitrate_ = static_cast<int64_t>(
+            static_cast<double>(delivered_bytes_ - first.size) * 8e6 /
+            static_cast<double>(span));
+    }
+}
+
+void CongestionController::update_loss_limit(const Clock::time_point now) {
+    if (!loss_started_) {
+        loss_started_ = true;
+        last_loss_update_ = now;
+        last_loss_decrease_ = now - LOSS_DECREASE_INTERVAL;
+    }
+    if (reported_ < LOSS_MIN_PACKETS) return;
+
+    // One loss in LOSS_MIN_PACKETS is already 5%, so a steady 1% would
+    // look like a run of 0% and 5% updates and keep the limit from growing
+    loss_rate_ = static_cast<double>(lost_) / reported_;
+    smoothed_loss_ += (loss_rate_ - smoothed_loss_) / LOSS_GAIN;
+    reported_ = 0;
+    lost_ = 0;
+    const double elapsed = std::min(
+        std::chrono::duration<double>(now - last_loss_update_).count(), 1.0);
+    last_loss_update_ = now;
+
+    if (smoothed_loss_ > HIGH_LOSS) {
+        if (now - last_loss_decrease_ >= LOSS_DECREASE_INTERVAL + rtt_) {
+            loss_limit_ = static_cast<int64_t>(
+                static_cast<double>(target_) * (1 - smoothed_loss_ / 2));
+            last_loss_decrease_ = now;
+        }
+    } else if (smoothed_loss_ < LOW_LOSS) {
+        loss_limit_ = static_cast<int64_t>(std::min(
+            static_cast<double>(loss_limit_) *
+                std::pow(LOSS_INCREASE_PER_SECOND, elapsed),
+            static_cast<double>(max_bitrate_)));
+    } else {
+        loss_limit_ = std::min(loss_limit_, target_);
+    }
+}
@@ -0,0 +1,338 @@
+#include "fec_decoder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "packet_pool.hpp"
+#include "rtp_packet.hpp"
+
+namespace {
+
+constexpr std::size_t BLOCK_SIZE = Fec::LENGTH_SIZE + PacketBuffer::CAPACITY;
+
+uint16_t read_u16(const unsigned char* data) {
+    return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+/**
+ * @brief Invert a square matrix in GF(2^8) by Gauss-Jordan elimination
+ *
+ * @return true if the matrix is invertible, false otherwise.
+ */
+bool invert(uint8_t (&matrix)[Fec::MAX_PARITIES][Fec::MAX_PARITIES],
+            uint8_t (&inverse)[Fec::MAX_PARITIES][Fec::MAX_PARITIES],
+            const std::size_t size) {
+    for (std::size_t r = 0; r < size; ++r) {
+        for (std::size_t c = 0; c < size; ++c) inverse[r][c] = r == c ? 1 : 0;
+    }
+
+    for (std::size_t column = 0; column < size; ++column) {
+        std::size_t pivot = column;
+        while (pivot < size && matrix[pivot][column] == 0) ++pivot;
+        if (pivot == size) return false;
+        for (std::size_t c = 0; c < size; ++c) {
+            std::swap(matrix[pivot][c], matrix[column][c]);
+            std::swap(inverse[pivot][c], inverse[column][c]);
+        }
+
+        const uint8_t scale = GaloisField::inverse(matrix[column][column]);
+        for (std::size_t c = 0; c < size; ++c) {
+            matrix[column][c] = GaloisField::multiply(matrix[column][c], scale);
+            inverse[column][c] =
+                GaloisField::multiply(inverse[column][c], scale);
+        }
+        for (std::size_t r = 0; r < size; ++r) {
+            const uint8_t factor = matrix[r][column];
+            if (r == column || factor == 0) continue;
+            for (std::size_t c = 0; c < size; ++c) {
+                matrix[r][c] ^=
+                    GaloisField::multiply(factor, matrix[column][c]);
+                inverse[r][c] ^=
+                    GaloisField::multiply(factor, inverse[column][c]);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+FecDecoder::FecDecoder(const GaloisField::Kernel kernel)
+    : kernel_(kernel), next_group_(0), rebuilt_(0), parity_packets_(0) {
+    if (!GaloisField::supported(kernel)) {
+        throw std::invalid_argument("GF(2^8) kernel not supported");
+    }
+
+    media_.resize(FEC_MEDIA_WINDOW);
+    parities_.resize(FEC_PARITY_WINDOW);
+    storage_.resize((FEC_MEDIA_WINDOW + FEC_PARITY_WINDOW) * BLOCK_SIZE);
+    for (std::size_t i = 0; i < FEC_MEDIA_WINDOW; ++i) {
+        media_[i].block = storage_.data() + i * BLOCK_SIZE;
+    }
+    for (std::size_t i = 0; i < FEC_PARITY_WINDOW; ++i) {
+        parities_[i].data =
+            storage_.data() + (FEC_MEDIA_WINDOW + i) * BLOCK_SIZE;
+    }
+    syndromes_.resize(Fec::MAX_PARITIES * BLOCK_SIZE);
+    rebuilt_packets_.reserve(Fec::MAX_SOURCES);
+}
+
+const std::vector<boost::asio::const_buffer>& FecDecoder::push_media(
+    const unsigned char* data, const std::size_t size) {
+    rebuilt_packets_.clear();
+    const MediaSlot* slot = store_media(data, size);
+    if (slot == nullptr) return rebuilt_packets_;
+
+    // Only groups still waiting for this packet can use it
+    for (Group& group : groups_) {
+        if (!group.active || group.complete) continue;
+        const int offset = Rtp::sequence_delta(group.header.base,
+                                               slot->sequence);
+        if (offset >= 0 && offset < group.header.sources) repair(group);
+    }
+    return rebuilt_packets_;
+}
+
+const std::vector<boost::asio::const_buffer>& FecDecoder::push_parity(
+    const unsigned char* data, const std::size_t size) {
+    rebuilt_packets_.clear();
+    Rtp::Header rtp;
+    Fec::Header header;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+    if (!Rtp::read_header(data, size, rtp, payload_offset, payload_size) ||
+        rtp.payload_type != Fec::PAYLOAD_TYPE ||
+        !Fec::read_header(data + payload_offset, payload_size, header)) {
+        return rebuilt_packets_;
+    }
+    const std::size_t parity_size = payload_size - Fec::HEADER_SIZE;
+    if (parity_size < Fec::LENGTH_SIZE + Rtp::HEADER_SIZE ||
+        parity_size > BLOCK_SIZE) {
+        return rebuilt_packets_;
+    }
+
+    ParitySlot& slot = parities_[rtp.sequence & (parities_.size() - 1)];
+    slot.used = true;
+    slot.sequence = rtp.sequence;
+    slot.header = header;
+    slot.size = parity_size;
+    std::memcpy(slot.data, data + payload_offset + Fec::HEADER_SIZE,
+                parity_size);
+    ++parity_packets_;
+
+    const auto first_parity =
+        static_cast<uint16_t>(rtp.sequence - header.index);
+    Group* group = nullptr;
+    for (Group& candidate : groups_) {
+        if (candidate.active && candidate.first_parity == first_parity &&
+            candidate.header.same_group(header)) {
+            group = &candidate;
+            break;
+        }
+    }
+    if (group == nullptr) {
+        // Replaces the oldest group
+        group = &groups_[next_group_];
+        next_group_ = (next_group_ + 1) % groups_.size();
+        group->active = true;
+        group->complete = false;
+        group->header = header;
+        group->first_parity = first_parity;
+    }
+    if (!group->complete) repair(*group);
+    return rebuilt_packets_;
+}
+
+FecDecoder::MediaSlot* FecDecoder::store_media(const unsigned char* data,
+                                               const std::size_t size) {
+    if (size < Rtp::HEADER_SIZE || size > PacketBuffer::CAPACITY) {
+        return nullptr;
+    }
+
+    const uint16_t sequence = read_u16(data + 2);
+    MediaSlot& slot = media_[sequence & (media_.size() - 1)];
+    if (slot.used && slot.sequence == sequence) return nullptr;  // Duplicate
+
+    // Parity covers packets as packetized, without the header extension
+    // added when they were sent
+    const std::size_t extension = Rtp::extension_size(data, size);
+    const std::size_t stored = size - extension;
+    const std::size_t start = Rtp::HEADER_SIZE + (data[0] & 0x0F) * 4;
+    slot.used = true;
+    slot.sequence = sequence;
+    slot.block[0] = static_cast<unsigned char>(stored >> 8);
+    slot.block[1] = static_cast<unsigned char>(stored);
+    unsigned char* packet = slot.block + Fec::LENGTH_SIZE;
+    if (extension == 0) {
+        std::memcpy(packet, data, size);
+    } else {
+        std::memcpy(packet, data, start);
+        packet[0] = static_cast<unsigned char>(packet[0] & ~0x10);
+        std::memcpy(packet + start, data + start + extension,
+                    size - start - extension);
+    }
+    return &slot;
+}
+
+const FecDecoder::ParitySlot* FecDecoder::parity(
+    const Group& group, const std::size_t index) const {
+    const auto sequence = static_cast<uint16_t>(group.first_parity + index);
+    const ParitySlot& slot = parities_[sequence & (parities_.size() - 1)];
+    if (!slot.used || slot.sequence != sequence ||
+        slot.header.index != index || !slot.header.same_group(group.header)) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+void FecDecoder::repair(Group& group) {
+    std::array<std::size_t, Fec::MAX_SOURCES> lost;
+    std::size_t lost_count = 0;
+    for (std::size_t i = 0; i < group.header.sources; ++i) {
+        const auto sequence = static_cast<uint16_t>(group.header.base + i);
+        const MediaSlot& slot = media_[sequence & (media_.size() - 1)];
+        if (slot.used && slot.sequence == sequence) continue;
+        if (slot.used && Rtp::is_newer(slot.sequence, sequence)) {
+            group.complete = true;  // Fell out of the window
+            return;
+        }
+        lost[lost_count++] = i;
+    }
+    if (lost_count == 0) {
+        group.complete = true;
+        return;
+    }
+
+    if (group.header.scheme == Fec::Scheme::XOR) {
+        repair_xor(group, lost.data(), lost_count);
+    } else {
+        repair_reed_solomon(group, lost.data(), lost_count);
+    }
+}
+
+void FecDecoder::repair_xor(Group& group, const std::size_t* lost,
+                            const std::size_t lost_count) {
+    const std::size_t parities = group.header.parities;
+    std::size_t repaired = 0;
+    for (std::size_t j = 0; j < parities; ++j) {
+        const ParitySlot* slot = parity(group, j);
+        if (slot == nullptr) continue;
+
+        // A parity rebuilds its source only when no other one is missing
+        std::size_t missing = 0;
+        std::size_t missing_count = 0;
+        for (std::size_t l = 0; l < lost_count; ++l) {
+            if (lost[l] % parities != j) continue;
+            missing = lost[l];
+            ++missing_count;
+        }
+        if (missing_count != 1) continue;
+
+        const auto sequence =
+            static_cast<uint16_t>(group.header.base + missing);
+        MediaSlot& target = media_[sequence & (media_.size() - 1)];
+        target.used = false;
+        std::memcpy(target.block, slot->data, slot->size);
+        bool consistent = true;
+        for (std::size_t i = j; i < group.header.sources; i += parities) {
+            if (i == missing) continue;
+            const MediaSlot& source =
+                media_[(group.header.base + i) & (media_.size() - 1)];
+            const std::size_t size =
+                Fec::LENGTH_SIZE + read_u16(source.block);
+            if (size > slot->size) {
+                consistent = false;
+                break;
+            }
+            GaloisField::multiply_add(source.block, target.block, size, 1,
+                                      kernel_);
+        }
+        if (consistent && accept(slot->size, sequence)) ++repaired;
+    }
+    if (repaired == lost_count) group.complete = true;
+}
+
+void FecDecoder::repair_reed_solomon(Group& group, const std::size_t* lost,
+                                     const std::size_t lost_count) {
+    const std::size_t parities = group.header.parities;
+    if (lost_count > parities) return;
+
+    // Any lost_count parities will do
+    const ParitySlot* rows[Fec::MAX_PARITIES] = {};
+    std::size_t indices[Fec::MAX_PARITIES];
+    std::size_t row_count = 0;
+    for (std::size_t j = 0; j < parities && row_count < lost_count; ++j) {
+        const ParitySlot* slot = parity(group, j);
+        if (slot == nullptr) continue;
+        if (row_count > 0 && slot->size != rows[0]->size) return;
+        rows[row_count] = slot;
+        indices[row_count++] = j;
+    }
+    if (row_count < lost_count) return;
+    const std::size_t size = rows[0]->size;
+
+    // Remove the received sources from each parity, leaving the lost ones
+    bool is_lost[Fec::MAX_SOURCES] = {};
+    for (std::size_t l = 0; l < lost_count; ++l) is_lost[lost[l]] = true;
+    for (std::size_t r = 0; r < row_count; ++r) {
+        std::memcpy(syndromes_.data() + r * BLOCK_SIZE, rows[r]->data, size);
+    }
+    for (std::size_t i = 0; i < group.header.sources; ++i) {
+        if (is_lost[i]) continue;
+        const MediaSlot& source =
+            media_[(group.header.base + i) & (media_.size() - 1)];
+        const std::size_t block_size =
+            Fec::LENGTH_SIZE + read_u16(source.block);
+        if (block_size > size) return;
+        for (std::size_t r = 0; r < row_count; ++r) {
+            GaloisField::multiply_add(
+                source.block, syndromes_.data() + r * BLOCK_SIZE, block_size,
+                Fec::coefficient(Fec::Scheme::REED_SOLOMON, parities,
+                                 indices[r], i),
+                kernel_);
+        }
+    }
+
+    uint8_t matrix[Fec::MAX_PARITIES][Fec::MAX_PARITIES];
+    uint8_t inverse[Fec::MAX_PARITIES][Fec::MAX_PARITIES];
+    for (std::size_t r = 0; r < lost_count; ++r) {
+        for (std::size_t c = 0; c < lost_count; ++c) {
+            matrix[r][c] = Fec::coefficient(Fec::Scheme::REED_SOLOMON,
+                                            parities, indices[r], lost[c]);
+        }
+    }
+    if (!invert(matrix, inverse, lost_count)) return;
+
+    for (std::size_t c = 0; c < lost_count; ++c) {
+        const auto sequence =
+            static_cast<uint16_t>(group.header.base + lost[c]);
+        MediaSlot& target = media_[sequence & (media_.size() - 1)];
+        target.used = false;
+        std::memset(target.block, 0, size);
+        for (std::size_t r = 0; r < lost_count; ++r) {
+            GaloisField::multiply_add(syndromes_.data() + r * BLOCK_SIZE,
+                                      target.block, size, inverse[c][r],
+                                      kernel_);
+        }
+        accept(size, sequence);
+    }
+    group.complete = true;
+}
+
+bool FecDecoder::accept(const std::size_t block_size,
+                        const uint16_t sequence) {
+    MediaSlot& slot = media_[sequence & (media_.size() - 1)];
+    const std::size_t size = read_u16(slot.block);
+    const unsigned char* packet = slot.block + Fec::LENGTH_SIZE;
+    if (size < Rtp::HEADER_SIZE || Fec::LENGTH_SIZE + size > block_size ||
+        packet[0] >> 6 != Rtp::VERSION || read_u16(packet + 2) != sequence) {
+        return false;
+    }
+
+    slot.used = true;
+    slot.sequence = sequence;
+    rebuilt_packets_.emplace_back(packet, size);
+    ++rebuilt_;
+    return true;
+}
@@ -0,0 +1,219 @@
+#include "fec_encoder.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+#include "packet_pool.hpp"
+
+FecEncoder::FecEncoder(const uint32_t ssrc, const Fec::Scheme scheme,
+                       const GaloisField::Kernel kernel)
+    : scheme_(scheme),
+      kernel_(kernel),
+      loss_rate_(0),
+      mean_burst_(1),
+      parity_packets_(0),
+      held_frames_(0) {
+    static_assert(MIN_GROUP_SOURCES <= Fec::MAX_SOURCES / 2,
+                  "Held packets must fit the first group of a run");
+    if (!GaloisField::supported(kernel)) {
+        throw std::invalid_argument("GF(2^8) kernel not supported");
+    }
+
+    std::random_device random;
+    header_.payload_type = Fec::PAYLOAD_TYPE;
+    header_.ssrc = ssrc;
+    header_.sequence = static_cast<uint16_t>(random());
+    storage_.resize(MAX_FRAME_PARITIES * PacketBuffer::CAPACITY);
+    packets_.reserve(MAX_FRAME_PARITIES);
+    held_storage_.resize(Fec::MAX_SOURCES * PacketBuffer::CAPACITY);
+    held_.reserve(Fec::MAX_SOURCES);
+}
+
+void FecEncoder::set_loss(const double loss_rate, const double mean_burst) {
+    loss_rate_ = std::clamp(loss_rate, 0.0, 1.0);
+    mean_burst_ = std::max(mean_burst, 1.0);
+}
+
+std::size_t FecEncoder::parities_for(const std::size_t sources) const {
+    if (sources == 0 || loss_rate_ < MIN_FEC_LOSS) return 0;
+
+    std::size_t limit = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::ceil(sources * MAX_FEC_OVERHEAD)));
+    limit = std::min(limit, Fec::MAX_PARITIES);
+    if (scheme_ == Fec::Scheme::XOR) limit = std::min(limit, sources);
+
+    // Bursts start at a rate giving the loss rate, and their lengths are
+    // geometric with the mean burst. The number lost in a group is then
+    // compound Poisson, its distribution given by Panjer's recursion.
+    const double bursts_per_packet = loss_rate_ / mean_burst_;
+    const double continues = 1 - 1 / mean_burst_;
+    std::array<double, Fec::MAX_PARITIES + 1> lengths{};  // Of one burst
+    lengths[1] = 1 - continues;
+    for (std::size_t n = 2; n <= limit; ++n) {
+        lengths[n] = lengths[n - 1] * continues;
+    }
+    for (std::size_t parities = 0; parities < limit; ++parities) {
+        const double mean =
+            static_cast<double>(sources + parities) * bursts_per_packet;
+        std::array<double, Fec::MAX_PARITIES + 1> lost{};
+        lost[0] = std::exp(-mean);
+        double repaired = lost[0];  // Chance of no more losses than parities
+        for (std::size_t n = 1; n <= parities; ++n) {
+            for (std::size_t j = 1; j <= n; ++j) {
+                lost[n] += static_cast<double>(j) * lengths[j] * lost[n - j];
+            }
+            lost[n] *= mean / static_cast<double>(n);
+            repaired += lost[n];
+        }
+        if (1 - repaired < TARGET_SOURCE_LOSS * static_cast<double>(sources)) {
+            return parities;
+        }
+    }
+    return limit;
+}
+
+const std::vector<GatherDatagram>& FecEncoder::protect(
+    const std::vector<GatherDatagram>& packets) {
+    packets_.clear();
+    if (packets.empty()) return packets_;
+    if (loss_rate_ < MIN_FEC_LOSS) {
+        held_.clear();
+        held_frames_ = 0;
+        return packets_;
+    }
+
+    const std::size_t total = held_.size() + packets.size();
+    if (total < MIN_GROUP_SOURCES && held_frames_ + 1 < MAX_GROUP_FRAMES) {
+        if (hold(packets.data(), packets.size())) {
+            ++held_frames_;
+        } else {
+            held_.clear();
+            held_frames_ = 0;
+        }
+        return packets_;
+    }
+
+    // Groups of nearly equal size, each within MAX_SOURCES. The first
+    // takes in the held packets, which protect_group checks run on into
+    // this frame.
+    const std::size_t groups =
+        (total + Fec::MAX_SOURCES - 1) / Fec::MAX_SOURCES;
+    std::size_t offset = 0;
+    for (std::size_t group = 0; group < groups; ++group) {
+        const std::size_t count =
+            total / groups + (group < total % groups ? 1 : 0);
+        const std::size_t parities =
+            std::min(parities_for(count), MAX_FRAME_PARITIES - packets_.size());
+        if (group == 0 && !held_.empty()) {
+            const std::size_t taken = count - held_.size();
+            if (parities > 0 && hold(packets.data(), taken)) {
+                protect_group(held_.data(), count, parities);
+            }
+            offset += taken;
+            continue;
+        }
+        if (parities > 0) protect_group(&packets[offset], count, parities);
+        offset += count;
+    }
+    held_.clear();
+    held_frames_ = 0;
+    return packets_;
+}
+
+bool FecEncoder::hold(const GatherDatagram* packets, const std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const GatherDatagram& packet = packets[i];
+        if (packet.size() > PacketBuffer::CAPACITY) return false;
+
+        unsigned char* copy = held_storage_.data() +
+                              held_.size() * PacketBuffer::CAPACITY;
+        std::memcpy(copy, packet.header.data(), packet.header.size());
+        std::memcpy(copy + packet.header.size(), packet.payload.data(),
+                    packet.payload.size());
+        held_.push_back(
+            {boost::asio::buffer(copy, packet.header.size()),
+             boost::asio::buffer(copy + packet.header.size(),
+                                 packet.payload.size())});
+    }
+    return true;
+}
+
+void FecEncoder::protect_group(const GatherDatagram* sources,
+                               const std::size_t count,
+                               const std::size_t parities) {
+    constexpr std::size_t PARITY_OFFSET = Rtp::HEADER_SIZE + Fec::HEADER_SIZE;
+    std::size_t longest = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (sources[i].header.size() < Rtp::HEADER_SIZE) return;
+        longest = std::max(longest, Fec::LENGTH_SIZE + sources[i].size());
+    }
+    if (PARITY_OFFSET + longest > PacketBuffer::CAPACITY) return;
+
+    // The group must be a run of sequence numbers
+    const auto* first =
+        static_cast<const unsigned char*>(sources[0].header.data());
+    const auto* last =
+        static_cast<const unsigned char*>(sources[count - 1].header.data());
+    const auto base = static_cast<uint16_t>(first[2] << 8 | first[3]);
+    if (static_cast<uint16_t>(last[2] << 8 | last[3]) !=
+        static_cast<uint16_t>(base + count - 1)) {
+        return;
+    }
+
+    Fec::Header fec;
+    fec.scheme = scheme_;
+    fec.sources = static_cast<uint8_t>(count);
+    fec.parities = static_cast<uint8_t>(parities);
+    fec.base = base;
+    header_.timestamp = static_cast<uint32_t>(first[4]) << 24 |
+                        static_cast<uint32_t>(first[5]) << 16 |
+                        static_cast<uint32_t>(first[6]) << 8 | first[7];
+    unsigned char* buffers = storage_.data() +
+                             packets_.size() * PacketBuffer::CAPACITY;
+    for (std::size_t j = 0; j < parities; ++j) {
+        unsigned char* buffer = buffers + j * PacketBuffer::CAPACITY;
+        fec.index = static_cast<uint8_t>(j);
+        Rtp::write_header(header_, buffer);
+        Fec::write_header(fec, buffer + Rtp::HEADER_SIZE);
+        std::memset(buffer + PARITY_OFFSET, 0, longest);
+        ++header_.sequence;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const GatherDatagram& source = sources[i];
+        const auto size = static_cast<uint16_t>(source.size());
+        const unsigned char length[Fec::LENGTH_SIZE] = {
+            static_cast<unsigned char>(size >> 8),
+            static_cast<unsigned char>(size)};
+        for (std::size_t j = 0; j < parities; ++j) {
+            const uint8_t coefficient =
+                Fec::coefficient(scheme_, parities, j, i);
+            if (coefficient == 0) continue;
+
+            unsigned char* parity =
+                buffers + j * PacketBuffer::CAPACITY + PARITY_OFFSET;
+            GaloisField::multiply_add(length, parity, Fec::LENGTH_SIZE,
+                                      coefficient, kernel_);
+            parity += Fec::LENGTH_SIZE;
+            GaloisField::multiply_add(
+                static_cast<const unsigned char*>(source.header.data()),
+                parity, source.header.size(), coefficient, kernel_);
+            GaloisField::multiply_add(
+                static_cast<const unsigned char*>(source.payload.data()),
+                parity + source.header.size(), source.payload.size(),
+                coefficient, kernel_);
+        }
+    }
+
+    for (std::size_t j = 0; j < parities; ++j) {
+        unsigned char* buffer = buffers + j * PacketBuffer::CAPACITY;
+        packets_.push_back({boost::asio::buffer(buffer, PARITY_OFFSET),
+                            boost::asio::buffer(buffer + PARITY_OFFSET,
+                                                longest)});
+    }
+    parity_packets_ += parities;
+}
@@ -0,0 +1,47 @@
+#include "fec_packet.hpp"
+
+#include "galois_field.hpp"
+
+namespace Fec {
+
+std::size_t write_header(const Header& header, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(header.scheme);
+    buffer[1] = header.sources;
+    buffer[2] = header.parities;
+    buffer[3] = header.index;
+    buffer[4] = static_cast<unsigned char>(header.base >> 8);
+    buffer[5] = static_cast<unsigned char>(header.base);
+    return HEADER_SIZE;
+}
+
+bool read_header(const unsigned char* data, const std::size_t size,
+                 Header& header) {
+    if (size < HEADER_SIZE) return false;
+    if (data[0] != static_cast<uint8_t>(Scheme::XOR) &&
+        data[0] != static_cast<uint8_t>(Scheme::REED_SOLOMON)) {
+        return false;
+    }
+
+    header.scheme = static_cast<Scheme>(data[0]);
+    header.sources = data[1];
+    header.parities = data[2];
+    header.index = data[3];
+    header.base = static_cast<uint16_t>(data[4] << 8 | data[5]);
+    return header.sources > 0 && header.sources <= MAX_SOURCES &&
+           header.parities > 0 && header.parities <= MAX_PARITIES &&
+           header.index < header.parities &&
+           (header.scheme != Scheme::XOR ||
+            header.parities <= header.sources);
+}
+
+uint8_t coefficient(const Scheme scheme, const std::size_t parities,
+                    const std::size_t parity, const std::size_t source) {
+    if (scheme == Scheme::XOR) return source % parities == parity ? 1 : 0;
+
+    // Cauchy matrix 1 / (x + y), with sources and parities drawn from
+    // disjoint sets so that every square submatrix is invertible
+    return GaloisField::inverse(
+        static_cast<uint8_t>(source ^ (MAX_SOURCES + parity)));
+}
+
+}  // namespace Fec
@@ -0,0 +1,179 @@
+#include "galois_field.hpp"
+
+#include <array>
+#include <cstring>
+
+#include "galois_field_kernels.hpp"
+
+#if defined(GALOIS_FIELD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace GaloisField {
+
+namespace {
+
+constexpr unsigned POLYNOMIAL = 0x11D;
+
+/**
+ * @struct Tables
+ * @brief Logarithms, exponentials and the nibble product tables of every
+ * coefficient, built at compile time
+ */
+struct Tables {
+    std::array<uint8_t, 512> exp{};  // Doubled so log sums need no modulo
+    std::array<uint8_t, 256> log{};
+    std::array<std::array<uint8_t, Kernels::TABLE_SIZE>, 256> nibbles{};
+};
+
+constexpr Tables make_tables() {
+    Tables tables;
+    unsigned value = 1;
+    for (unsigned i = 0; i < 255; ++i) {
+        tables.exp[i] = static_cast<uint8_t>(value);
+        tables.exp[i + 255] = static_cast<uint8_t>(value);
+        tables.log[value] = static_cast<uint8_t>(i);
+        value <<= 1;
+        if (value & 0x100) value ^= POLYNOMIAL;
+    }
+
+    for (unsigned c = 1; c < 256; ++c) {
+        for (unsigned n = 1; n < 16; ++n) {
+            tables.nibbles[c][n] =
+                tables.exp[tables.log[c] + tables.log[n]];
+            tables.nibbles[c][16 + n] =
+                tables.exp[tables.log[c] + tables.log[n << 4]];
+        }
+    }
+    return tables;
+}
+
+constexpr Tables TABLES = make_tables();
+
+bool cpu_has(const bool avx2) {
+#if !defined(GALOIS_FIELD_X86)
+    (void)avx2;
+    return false;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int leaves = info[0];
+    __cpuid(info, 1);
+    if (!avx2) return (info[2] & (1 << 9)) != 0;  // SSSE3
+    if (leaves < 7) return false;
+    const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 &&  // OSXSAVE
+                              (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+    // Also checks that the OS saves the AVX registers
+    return avx2 ? __builtin_cpu_supports("avx2")
+                : __builtin_cpu_supports("ssse3");
+#endif
+}
+
+}  // namespace
+
+namespace Kernels {
+
+void multiply_add_scalar(const unsigned char* source,
+                         unsigned char* destination, const std::size_t size,
+                         const uint8_t* tables) {
+    for (std::size_t i = 0; i < size; ++i) {
+        destination[i] ^= static_cast<unsigned char>(
+            tables[source[i] & 0x0F] ^ tables[16 + (source[i] >> 4)]);
+    }
+}
+
+void add_scalar(const unsigned char* source, unsigned char* destination,
+                const std::size_t size) {
+    std::size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t a;
+        uint64_t b;
+        std::memcpy(&a, source + i, sizeof(a));
+        std::memcpy(&b, destination + i, sizeof(b));
+        b ^= a;
+        std::memcpy(destination + i, &b, sizeof(b));
+    }
+    for (; i < size; ++i) destination[i] ^= source[i];
+}
+
+}  // namespace Kernels
+
+Kernel best_kernel() {
+    static const Kernel best = supported(Kernel::AVX2)    ? Kernel::AVX2
+                               : supported(Kernel::SSSE3) ? Kernel::SSSE3
+                                                          : Kernel::SCALAR;
+    return best;
+}
+
+bool supported(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+        case Kernel::SSSE3:
+            return cpu_has(false);
+        case Kernel::AVX2:
+            return cpu_has(true);
+    }
+    return false;
+}
+
+const char* name(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return "scalar";
+        case Kernel::SSSE3:
+            return "ssse3";
+        case Kernel::AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+uint8_t multiply(const uint8_t a, const uint8_t b) {
+    if (a == 0 || b == 0) return 0;
+    return TABLES.exp[TABLES.log[a] + TABLES.log[b]];
+}
+
+uint8_t inverse(const uint8_t a) {
+    if (a == 0) return 0;
+    return TABLES.exp[255 - TABLES.log[a]];
+}
+
+void multiply_add(const unsigned char* source, unsigned char* destination,
+                  const std::size_t size, const uint8_t coefficient,
+                  const Kernel kernel) {
+    if (coefficient == 0 || size == 0) return;
+
+    const uint8_t* tables = TABLES.nibbles[coefficient].data();
+    switch (kernel) {
+#ifdef GALOIS_FIELD_X86
+        case Kernel::AVX2:
+            if (coefficient == 1) {
+                Kernels::add_avx2(source, destination, size);
+            } else {
+                Kernels::multiply_add_avx2(source, destination, size, tables);
+            }
+            return;
+        case Kernel::SSSE3:
+            if (coefficient == 1) {
+                Kernels::add_ssse3(source, destination, size);
+            } else {
+                Kernels::multiply_add_ssse3(source, destination, size,
+                                            tables);
+            }
+            return;
+#endif
+        default:
+            if (coefficient == 1) {
+                Kernels::add_scalar(source, destination, size);
+            } else {
+                Kernels::multiply_add_scalar(source, destination, size,
+                                             tables);
+            }
+    }
+}
+
+}  // namespace GaloisField
@@ -0,0 +1,52 @@
+#include <immintrin.h>
+
+#include "galois_field_kernels.hpp"
+
+namespace GaloisField::Kernels {
+
+namespace {
+
+constexpr std::size_t STEP = 32;  // bytes
+
+}  // namespace
+
+void multiply_add_avx2(const unsigned char* source,
+                       unsigned char* destination, const std::size_t size,
+                       const uint8_t* tables) {
+    // Shuffles look up within 128-bit lanes, so both lanes get the tables
+    const __m256i low_table = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables)));
+    const __m256i high_table = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables + 16)));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    std::size_t i = 0;
+    for (; i + STEP <= size; i += STEP) {
+        const __m256i in =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        const __m256i low = _mm256_and_si256(in, nibble);
+        const __m256i high =
+            _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble);
+        const __m256i product =
+            _mm256_xor_si256(_mm256_shuffle_epi8(low_table, low),
+                             _mm256_shuffle_epi8(high_table, high));
+        auto* out = reinterpret_cast<__m256i*>(destination + i);
+        _mm256_storeu_si256(out,
+                            _mm256_xor_si256(_mm256_loadu_si256(out), product));
+    }
+    multiply_add_scalar(source + i, destination + i, size - i, tables);
+}
+
+void add_avx2(const unsigned char* source, unsigned char* destination,
+              const std::size_t size) {
+    std::size_t i = 0;
+    for (; i + STEP <= size; i += STEP) {
+        const __m256i in =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        auto* out = reinterpret_cast<__m256i*>(destination + i);
+        _mm256_storeu_si256(out, _mm256_xor_si256(_mm256_loadu_si256(out), in));
+    }
+    add_scalar(source + i, destination + i, size - i);
+}
+
+}  // namespace GaloisField::Kernels
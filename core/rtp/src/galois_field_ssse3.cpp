@@ -0,0 +1,50 @@
+#include <tmmintrin.h>
+
+#include "galois_field_kernels.hpp"
+
+namespace GaloisField::Kernels {
+
+namespace {
+
+constexpr std::size_t STEP = 16;  // bytes
+
+}  // namespace
+
+void multiply_add_ssse3(const unsigned char* source,
+                        unsigned char* destination, const std::size_t size,
+                        const uint8_t* tables) {
+    const __m128i low_table =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables));
+    const __m128i high_table =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables + 16));
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+
+    std::size_t i = 0;
+    for (; i + STEP <= size; i += STEP) {
+        const __m128i in =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        // No byte shift: shift words, then mask off the neighbour's bits
+        const __m128i low = _mm_and_si128(in, nibble);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(in, 4), nibble);
+        const __m128i product =
+            _mm_xor_si128(_mm_shuffle_epi8(low_table, low),
+                          _mm_shuffle_epi8(high_table, high));
+        auto* out = reinterpret_cast<__m128i*>(destination + i);
+        _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), product));
+    }
+    multiply_add_scalar(source + i, destination + i, size - i, tables);
+}
+
+void add_ssse3(const unsigned char* source, unsigned char* destination,
+               const std::size_t size) {
+    std::size_t i = 0;
+    for (; i + STEP <= size; i += STEP) {
+        const __m128i in =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        auto* out = reinterpret_cast<__m128i*>(destination + i);
+        _mm_storeu_si128(out, _mm_xor_si128(_mm_loadu_si128(out), in));
+    }
+    add_scalar(source + i, destination + i, size - i);
+}
+
+}  // namespace GaloisField::Kernels
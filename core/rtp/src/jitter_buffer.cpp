@@ -0,0 +1,339 @@
+#include "jitter_buffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+constexpr double JITTER_GAIN = 1.0 / 16;  // RFC 3550 section 6.4.1
+constexpr double JITTER_FACTOR = 4;       // Delay in multiples of jitter
+constexpr int64_t BASELINE_DRIFT = 1000;  // Baseline rises 1 us per ms
+
+int64_t to_us(const JitterBuffer::Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+        .count();
+}
+
+}  // namespace
+
+JitterBuffer::JitterBuffer(const std::chrono::microseconds max_latency,
+                           const std::size_t capacity)
+    : max_latency_(max_latency),
+      loss_wait_(0),
+      count_(0),
+      frame_capacity_(0),
+      timing_started_(false),
+      last_timestamp_(0),
+      last_unwrapped_(0),
+      last_stream_us_(0),
+      last_arrival_us_(0),
+      offset_us_(0),
+      jitter_us_(0),
+      target_delay_us_(0),
+      started_(false),
+      broken_(true),
+      keyframe_needed_(false),
+      keyframe_requested_(false),
+      played_sequence_(0),
+      played_picture_id_(Vp8Payload::NONE),
+      consumed_picture_id_(Vp8Payload::NONE),
+      played_tl0_pic_idx_(Vp8Payload::NONE),
+      top_layer_(0),
+      delivered_(0),
+      late_(0),
+      dropped_(0),
+      concealed_(0) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Jitter buffer needs room for a frame");
+    }
+    slots_.resize(capacity);
+}
+
+bool JitterBuffer::insert(const ReceivedFrame& frame,
+                          const Clock::time_point arrival,
+                          const bool retransmitted) {
+    if (started_ && !Rtp::is_newer(frame.first_sequence, played_sequence_)) {
+        ++late_;
+        return false;
+    }
+    for (const Slot& slot : slots_) {
+        if (slot.used && slot.frame.first_sequence == frame.first_sequence) {
+            return false;
+        }
+    }
+
+    if (count_ == slots_.size()) drop(*oldest());
+
+    // Grow every slot at once, so a slot first used when the buffer is
+    // fuller than before does not allocate either
+    if (frame.size > frame_capacity_) {
+        frame_capacity_ = frame.size;
+        for (Slot& slot : slots_) slot.data.reserve(frame_capacity_);
+    }
+    Slot& slot = *std::find_if(slots_.begin(), slots_.end(),
+                               [](const Slot& slot) { return !slot.used; });
+    slot.used = true;
+    slot.frame = frame;
+    slot.data.assign(frame.data, frame.data + frame.size);
+    slot.frame.data = nullptr;
+    ++count_;
+
+    if (!timing_started_) epoch_ = arrival;
+    slot.stream_us = unwrap(frame.timestamp) * 1000000 /
+                     static_cast<int64_t>(Rtp::VIDEO_CLOCK_RATE);
+    if (!retransmitted || !timing_started_) {
+        update_delay(slot.stream_us, to_us(arrival - epoch_));
+    }
+    timing_started_ = true;
+
+    top_layer_ = std::max(top_layer_, frame.temporal_layer);
+    return true;
+}
+
+bool JitterBuffer::pop(const Clock::time_point now, ReceivedFrame& frame) {
+    // Every pass that does not return takes a frame out
+    while (Slot* slot = oldest()) {
+        const Clock::time_point due = playout_time(*slot);
+        if (now < due) return false;
+
+        const bool late = now - due > max_latency_;
+        const Slot* keyframe = newest_keyframe();
+        if (decodable(slot->frame)) {
+            if (late && keyframe != nullptr && keyframe != slot) {
+                drop_before(*keyframe);
+            } else if (late && droppable(slot->frame)) {
+                drop(*slot);
+            } else {
+                deliver(*slot, frame);
+                return true;
+            }
+        } else if (keyframe != nullptr) {
+            // Restart from the newest keyframe rather than wait
+            drop_before(*keyframe);
+        } else if (now - due < loss_wait_) {
+            // The missing packets may still be retransmitted
+            return false;
+        } else {
+            // They did not arrive in time: give up on this frame
+            drop(*slot);
+        }
+    }
+    return false;
+}
+
+bool JitterBuffer::next_playout(Clock::time_point& when) const {
+    const Slot* first = oldest();
+    if (first == nullptr) return false;
+    when = playout_time(*first);
+    if (!decodable(first->frame) && newest_keyframe() == nullptr) {
+        when += loss_wait_;
+    }
+    return true;
+}
+
+JitterBuffer::Clock::time_point JitterBuffer::deadline(
+    const uint32_t timestamp) const {
+    if (!timing_started_) return Clock::time_point::max();
+
+    const auto delta = static_cast<int32_t>(timestamp - last_timestamp_);
+    const int64_t stream_us = (last_unwrapped_ + delta) * 1000000 /
+                              static_cast<int64_t>(Rtp::VIDEO_CLOCK_RATE);
+    return epoch_ + std::chrono::microseconds(offset_us_ + stream_us +
+                                              target_delay_us_) +
+           loss_wait_;
+}
+
+void JitterBuffer::set_loss_wait(const std::chrono::microseconds wait) {
+    loss_wait_ = std::clamp(wait, std::chrono::microseconds(0), max_latency_);
+}
+
+bool JitterBuffer::take_keyframe_request(const Clock::time_point now) {
+    if (!keyframe_needed_ ||
+        (keyframe_requested_ &&
+         now - keyframe_request_time_ < KEYFRAME_REQUEST_INTERVAL)) {
+        return false;
+    }
+    keyframe_requested_ = true;
+    keyframe_request_time_ = now;
+    return true;
+}
+
+std::chrono::microseconds JitterBuffer::jitter() const {
+    return std::chrono::microseconds(static_cast<int64_t>(jitter_us_));
+}
+
+std::chrono::microseconds JitterBuffer::target_delay() const {
+    return std::chrono::microseconds(target_delay_us_);
+}
+
+int64_t JitterBuffer::unwrap(const uint32_t timestamp) {
+    if (!timing_started_) {
+        last_timestamp_ = timestamp;
+        last_unwrapped_ = 0;
+        return 0;
+    }
+    const auto delta = static_cast<int32_t>(timestamp - last_timestamp_);
+    const int64_t unwrapped = last_unwrapped_ + delta;
+    if (delta > 0) {
+        last_timestamp_ = timestamp;
+        last_unwrapped_ = unwrapped;
+    }
+    return unwrapped;
+}
+
+void JitterBuffer::update_delay(const int64_t stream_us,
+                                const int64_t arrival_us) {
+    const int64_t relative_us = arrival_us - stream_us;
+    if (!timing_started_) {
+        offset_us_ = relative_us;
+    } else {
+        if (stream_us != last_stream_us_) {
+            // Change in transit time between consecutive arrivals
+            const int64_t difference = (arrival_us - last_arrival_us_) -
+                                       (stream_us - last_stream_us_);
+            jitter_us_ += (std::abs(static_cast<double>(difference)) -
+                           jitter_us_) *
+                          JITTER_GAIN;
+        }
+        // Follow the least delayed frame, rising slowly so clock drift and
+        // route changes do not leave the baseline behind
+        if (stream_us > last_stream_us_) {
+            offset_us_ += (stream_us - last_stream_us_) / BASELINE_DRIFT;
+        }
+        offset_us_ = std::min(offset_us_, relative_us);
+    }
+    last_stream_us_ = stream_us;
+    last_arrival_us_ = arrival_us;
+    target_delay_us_ =
+        std::min<int64_t>(max_latency_.count(),
+                          static_cast<int64_t>(JITTER_FACTOR * jitter_us_));
+}
+
+JitterBuffer::Clock::time_point JitterBuffer::playout_time(
+    const Slot& slot) const {
+    return epoch_ + std::chrono::microseconds(offset_us_ + slot.stream_us +
+                                              target_delay_us_);
+}
+
+const JitterBuffer::Slot* JitterBuffer::oldest() const {
+    const Slot* first = nullptr;
+    for (const Slot& slot : slots_) {
+        if (slot.used &&
+            (first == nullptr || Rtp::is_newer(first->frame.first_sequence,
+                                               slot.frame.first_sequence))) {
+            first = &slot;
+        }
+    }
+    return first;
+}
+
+JitterBuffer::Slot* JitterBuffer::oldest() {
+    return const_cast<Slot*>(std::as_const(*this).oldest());
+}
+
+const JitterBuffer::Slot* JitterBuffer::newest_keyframe() const {
+    const Slot* newest = nullptr;
+    for (const Slot& slot : slots_) {
+        if (slot.used && slot.frame.keyframe &&
+            (newest == nullptr ||
+             Rtp::is_newer(slot.frame.first_sequence,
+                           newest->frame.first_sequence))) {
+            newest = &slot;
+        }
+    }
+    return newest;
+}
+
+bool JitterBuffer::decodable(const ReceivedFrame& frame) const {
+    if (frame.keyframe) return true;
+    if (started_ && !broken_ &&
+        frame.first_sequence == static_cast<uint16_t>(played_sequence_ + 1)) {
+        return true;
+    }
+
+    // Across a gap, temporal layers tell what the frame references
+    if (frame.temporal_layer == Vp8Payload::NONE ||
+        frame.tl0_pic_idx == Vp8Payload::NONE ||
+        played_tl0_pic_idx_ == Vp8Payload::NONE) {
+        return false;
+    }
+    if (frame.temporal_layer == 0) {
+        return frame.tl0_pic_idx == ((played_tl0_pic_idx_ + 1) & 0xFF);
+    }
+    if (frame.tl0_pic_idx != played_tl0_pic_idx_) return false;
+    return frame.layer_sync ||
+           (frame.picture_id != Vp8Payload::NONE &&
+            frame.picture_id ==
+                ((played_picture_id_ + 1) & Vp8Payload::PICTURE_ID_MASK));
+}
+
+bool JitterBuffer::droppable(const ReceivedFrame& frame) const {
+    // Nothing references the top temporal layer
+    return !frame.keyframe && frame.temporal_layer > 0 &&
+           frame.temporal_layer == top_layer_;
+}
+
+void JitterBuffer::drop(Slot& slot) {
+    const ReceivedFrame& frame = slot.frame;
+    if (!droppable(frame)) {
+        broken_ = true;
+        // Losing an upper layer frame only breaks its own layer
+        if (frame.temporal_layer <= 0) keyframe_needed_ = true;
+    }
+    if (!started_ || Rtp::is_newer(frame.last_sequence, played_sequence_)) {
+        played_sequence_ = frame.last_sequence;
+        consumed_picture_id_ = frame.picture_id;
+    }
+    started_ = true;
+    slot.used = false;
+    --count_;
+    ++dropped_;
+}
+
+void JitterBuffer::drop_before(const Slot& keep) {
+    for (Slot& slot : slots_) {
+        if (slot.used && Rtp::is_newer(keep.frame.first_sequence,
+                                       slot.frame.first_sequence)) {
+            drop(slot);
+        }
+    }
+}
+
+void JitterBuffer::deliver(Slot& slot, ReceivedFrame& frame) {
+    const ReceivedFrame& played = slot.frame;
+    if (started_ &&
+        played.first_sequence != static_cast<uint16_t>(played_sequence_ + 1)) {
+        // Whole frames went missing here: count them by picture ID
+        int missing = 1;
+        if (played.picture_id != Vp8Payload::NONE &&
+            consumed_picture_id_ != Vp8Payload::NONE) {
+            const int distance =
+                (played.picture_id - consumed_picture_id_) &
+                Vp8Payload::PICTURE_ID_MASK;
+            missing = std::max(1, distance - 1);
+        }
+        concealed_ += static_cast<uint64_t>(missing);
+    }
+
+    played_sequence_ = played.last_sequence;
+    played_picture_id_ = played.picture_id;
+    consumed_picture_id_ = played.picture_id;
+    if (played.keyframe || played.temporal_layer == 0) {
+        played_tl0_pic_idx_ = played.tl0_pic_idx;
+    }
+    started_ = true;
+    broken_ = false;
+    if (played.keyframe) {
+        keyframe_needed_ = false;
+        keyframe_requested_ = false;
+    }
+
+    frame = played;
+    frame.data = slot.data.data();
+    frame.size = slot.data.size();
+    slot.used = false;
+    --count_;
+    ++delivered_;
+}
@@ -0,0 +1,69 @@
+#include "loss_estimator.hpp"
+
+#include <algorithm>
+
+#include "rtp_packet.hpp"
+
+namespace {
+
+constexpr double RISE_GAIN = 0.5;
+constexpr double FALL_GAIN = 0.125;
+constexpr double BURST_GAIN = 0.25;
+constexpr int MAX_GAP = 1000;  // packets; more is a restart, not a loss
+
+}  // namespace
+
+LossEstimator::LossEstimator()
+    : started_(false),
+      highest_sequence_(0),
+      expected_(0),
+      lost_(0),
+      bursts_(0),
+      loss_rate_(0),
+      mean_burst_(1) {}
+
+void LossEstimator::on_packet(const uint16_t sequence) {
+    if (!started_) {
+        started_ = true;
+        highest_sequence_ = sequence;
+        expected_ = 1;
+        return;
+    }
+
+    const int delta = Rtp::sequence_delta(highest_sequence_, sequence);
+    if (delta <= 0) {
+        // Reordered or retransmitted, counted lost when the gap opened
+        if (lost_ > 0) --lost_;
+        return;
+    }
+
+    highest_sequence_ = sequence;
+    if (delta > MAX_GAP) {
+        expected_ += 1;
+        return;
+    }
+    expected_ += static_cast<uint32_t>(delta);
+    if (delta > 1) {
+        lost_ += static_cast<uint32_t>(delta - 1);
+        ++bursts_;
+    }
+}
+
+bool LossEstimator::report(double& loss_rate, double& mean_burst) {
+    if (expected_ == 0) return false;
+
+    const double sample = static_cast<double>(lost_) / expected_;
+    loss_rate_ += (sample - loss_rate_) *
+                  (sample > loss_rate_ ? RISE_GAIN : FALL_GAIN);
+    if (bursts_ > 0 && lost_ > 0) {
+        const double burst = static_cast<double>(lost_) / bursts_;
+        mean_burst_ += (std::max(burst, 1.0) - mean_burst_) * BURST_GAIN;
+    }
+    expected_ = 0;
+    lost_ = 0;
+    bursts_ = 0;
+
+    loss_rate = loss_rate_;
+    mean_burst = mean_burst_;
+    return true;
+}
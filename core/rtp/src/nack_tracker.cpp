@@ -0,0 +1,144 @@
+#include "nack_tracker.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+NackTracker::NackTracker(const std::chrono::microseconds grace,
+                         const int max_retries)
+    : grace_(grace),
+      max_retries_(max_retries),
+      entries_(MAX_MISSING),
+      started_(false),
+      highest_sequence_(0),
+      oldest_(0),
+      missing_(0),
+      next_poll_(Clock::time_point::max()),
+      requested_(0),
+      recovered_(0),
+      expired_(0) {
+    if (max_retries <= 0) {
+        throw std::invalid_argument("NACK retries must be positive");
+    }
+}
+
+bool NackTracker::on_packet(const Rtp::Header& header,
+                            const Clock::time_point now) {
+    const uint16_t sequence = header.sequence;
+    if (!started_) {
+        started_ = true;
+        highest_sequence_ = sequence;
+        oldest_ = static_cast<uint16_t>(sequence + 1);
+        return false;
+    }
+
+    const int delta = Rtp::sequence_delta(highest_sequence_, sequence);
+    if (delta <= 0) {
+        Entry& late = entry(sequence);
+        if (!late.missing || late.sequence != sequence) return false;
+
+        const bool requested = late.retries > 0;
+        if (requested) ++recovered_;
+        forget(late);
+        return requested;
+    }
+
+    if (delta > static_cast<int>(MAX_MISSING)) {
+        // Too much lost to recover packet by packet
+        for (Entry& stale : entries_) {
+            if (stale.missing) {
+                ++expired_;
+                forget(stale);
+            }
+        }
+        oldest_ = sequence;
+    } else {
+        // Whatever frames the packets in the gap belong to, the first frame
+        // the jitter buffer holds behind it is at the earliest the one of
+        // the packet after it, and is what waits for them
+        for (auto missing = static_cast<uint16_t>(highest_sequence_ + 1);
+             missing != sequence; ++missing) {
+            Entry& gap = entry(missing);
+            if (gap.missing) {
+                // Still missing a ring ago
+                ++expired_;
+                forget(gap);
+            }
+            gap.missing = true;
+            gap.sequence = missing;
+            gap.timestamp = header.timestamp;
+            gap.retries = 0;
+            gap.detected = now;
+            ++missing_;
+        }
+        Entry& received = entry(sequence);
+        if (received.missing) {
+            ++expired_;
+            forget(received);
+        }
+    }
+
+    highest_sequence_ = sequence;
+    if (Rtp::sequence_delta(oldest_, highest_sequence_) >=
+        static_cast<int>(MAX_MISSING)) {
+        oldest_ = static_cast<uint16_t>(highest_sequence_ - MAX_MISSING + 1);
+    }
+    return false;
+}
+
+std::size_t NackTracker::poll(const Clock::time_point now,
+                              const std::chrono::microseconds rtt,
+                              const JitterBuffer& playout,
+                              uint16_t* sequences,
+                              const std::size_t capacity) {
+    std::size_t count = 0;
+    next_poll_ = Clock::time_point::max();
+    const std::chrono::microseconds retry_interval = std::max(rtt, grace_);
+    for (uint16_t sequence = oldest_; sequence != highest_sequence_;
+         ++sequence) {
+        Entry& gap = entry(sequence);
+        if (gap.missing && gap.sequence == sequence &&
+            now >= playout.deadline(gap.timestamp)) {
+            ++expired_;
+            forget(gap);
+        }
+        if (!gap.missing || gap.sequence != sequence) {
+            if (sequence == oldest_) ++oldest_;
+            continue;
+        }
+        if (gap.retries >= max_retries_) continue;
+
+        const Clock::time_point due = gap.retries == 0
+                                          ? gap.detected + grace_
+                                          : gap.requested + retry_interval;
+        if (now < due) {
+            next_poll_ = std::min(next_poll_, due);
+            continue;
+        }
+        // Too late for a retransmission to help
+        if (now + rtt > playout.deadline(gap.timestamp)) continue;
+        if (count == capacity) {
+            next_poll_ = now;
+            continue;
+        }
+
+        sequences[count++] = sequence;
+        gap.requested = now;
+        ++gap.retries;
+        ++requested_;
+        if (gap.retries < max_retries_) {
+            next_poll_ = std::min(next_poll_, now + retry_interval);
+        }
+    }
+    return count;
+}
+
+bool NackTracker::next_poll(Clock::time_point& when) const {
+    if (next_poll_ == Clock::time_point::max()) return false;
+    when = next_poll_;
+    return true;
+}
+
+void NackTracker::forget(Entry& entry) {
+    entry.missing = false;
+    --missing_;
+}
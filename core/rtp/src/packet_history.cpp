@@ -0,0 +1,65 @@
+#include "packet_history.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "rtp_packet.hpp"
+
+namespace {
+
+constexpr std::size_t MAX_SIZE = 32768;  // Half the sequence number space
+
+}  // namespace
+
+PacketHistory::PacketHistory(const std::size_t size)
+    : resent_(0), missing_(0) {
+    if (size == 0 || size > MAX_SIZE || (size & (size - 1)) != 0) {
+        throw std::invalid_argument(
+            "Packet history size must be a power of two up to 32768");
+    }
+
+    slots_.resize(size);
+    storage_.resize(size * PacketBuffer::CAPACITY);
+    for (std::size_t i = 0; i < size; ++i) {
+        slots_[i].data = storage_.data() + i * PacketBuffer::CAPACITY;
+    }
+}
+
+void PacketHistory::store(const GatherDatagram& packet) {
+    const std::size_t size = packet.size();
+    if (packet.header.size() < Rtp::HEADER_SIZE ||
+        size > PacketBuffer::CAPACITY) {
+        return;
+    }
+
+    const auto* header =
+        static_cast<const unsigned char*>(packet.header.data());
+    const auto sequence = static_cast<uint16_t>(header[2] << 8 | header[3]);
+    Slot& slot = slots_[sequence & (slots_.size() - 1)];
+    slot.used = true;
+    slot.sequence = sequence;
+    slot.size = size;
+    slot.resent = false;
+    std::memcpy(slot.data, packet.header.data(), packet.header.size());
+    std::memcpy(slot.data + packet.header.size(), packet.payload.data(),
+                packet.payload.size());
+}
+
+bool PacketHistory::resend(const uint16_t sequence,
+                           const Clock::time_point now,
+                           boost::asio::const_buffer& packet) {
+    Slot& slot = slots_[sequence & (slots_.size() - 1)];
+    if (!slot.used || slot.sequence != sequence) {
+        ++missing_;
+        return false;
+    }
+    if (slot.resent && now - slot.resent_at < MIN_RESEND_INTERVAL) {
+        return false;
+    }
+
+    slot.resent = true;
+    slot.resent_at = now;
+    packet = boost::asio::const_buffer(slot.data, slot.size);
+    ++resent_;
+    return true;
+}
@@ -0,0 +1,351 @@
+#include "rtcp_feedback.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace RtcpFeedback {
+
+namespace {
+
+constexpr uint8_t VERSION = 2;
+constexpr uint8_t LOSS_REPORT_SUBTYPE = 0;
+constexpr unsigned char LOSS_REPORT_NAME[4] = {'L', 'O', 'S', 'S'};
+constexpr double LOSS_SCALE = 65535;
+constexpr double BURST_SCALE = 256;
+
+// Transport feedback: packet status symbols and the chunks holding them
+constexpr uint8_t SYMBOL_NOT_RECEIVED = 0;
+constexpr uint8_t SYMBOL_SMALL_DELTA = 1;  // One byte, 0 to 63.75 ms
+constexpr uint8_t SYMBOL_LARGE_DELTA = 2;  // Two bytes, signed
+constexpr std::size_t MAX_RUN_LENGTH = 0x1FFF;
+constexpr std::size_t ONE_BIT_SYMBOLS = 14;  // Per status vector chunk
+constexpr std::size_t TWO_BIT_SYMBOLS = 7;
+constexpr int64_t DELTA_TICK = 250;          // microseconds
+constexpr int64_t REFERENCE_TICK = 64000;    // microseconds
+constexpr int64_t REFERENCE_WRAP = 1 << 24;  // Of the 24-bit reference time
+
+uint16_t read_u16(const unsigned char* data) {
+    return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+uint32_t read_u32(const unsigned char* data) {
+    return static_cast<uint32_t>(data[0]) << 24 |
+           static_cast<uint32_t>(data[1]) << 16 |
+           static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+void write_u16(const uint16_t value, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(value >> 8);
+    buffer[1] = static_cast<unsigned char>(value);
+}
+
+void write_u32(const uint32_t value, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(value >> 24);
+    buffer[1] = static_cast<unsigned char>(value >> 16);
+    buffer[2] = static_cast<unsigned char>(value >> 8);
+    buffer[3] = static_cast<unsigned char>(value);
+}
+
+std::size_t write_common(const uint8_t type, const uint8_t format,
+                         const uint32_t sender_ssrc,
+                         const uint32_t media_ssrc, const std::size_t size,
+                         unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(VERSION << 6 | format);
+    buffer[1] = type;
+    // Length in 32-bit words minus one
+    write_u16(static_cast<uint16_t>(size / 4 - 1), buffer + 2);
+    write_u32(sender_ssrc, buffer + 4);
+    write_u32(media_ssrc, buffer + 8);
+    return size;
+}
+
+/**
+ * @brief Check the common header of a feedback message and get its size
+ *
+ * @return std::size_t Message size from its length field, 0 if the
+ * datagram is not the expected message or is truncated
+ */
+std::size_t read_common(const unsigned char* data, const std::size_t size,
+                        const uint8_t type, const uint8_t format) {
+    if (size < HEADER_SIZE || data[0] >> 6 != VERSION ||
+        (data[0] & 0x1F) != format || data[1] != type) {
+        return 0;
+    }
+    const std::size_t length = (read_u16(data + 2) + std::size_t{1}) * 4;
+    return length >= HEADER_SIZE && length <= size ? length : 0;
+}
+
+}  // namespace
+
+std::size_t write_nack(const uint32_t sender_ssrc, const uint32_t media_ssrc,
+                       const uint16_t* sequences, const std::size_t count,
+                       unsigned char* buffer, std::size_t& written) {
+    written = 0;
+    std::size_t items = 0;
+    unsigned char* item = buffer + HEADER_SIZE;
+    while (written < count && items < MAX_NACK_ITEMS) {
+        // PID is the first lost packet, bit i of BLP the packet PID + i + 1
+        const uint16_t pid = sequences[written++];
+        uint16_t blp = 0;
+        while (written < count) {
+            const auto offset = static_cast<uint16_t>(sequences[written] - pid);
+            if (offset == 0 || offset >= NACK_ITEM_SPAN) break;
+            blp = static_cast<uint16_t>(blp | 1 << (offset - 1));
+            ++written;
+        }
+        write_u16(pid, item);
+        write_u16(blp, item + 2);
+        item += NACK_ITEM_SIZE;
+        ++items;
+    }
+    if (items == 0) return 0;
+
+    return write_common(TRANSPORT_FEEDBACK, GENERIC_NACK, sender_ssrc,
+                        media_ssrc, HEADER_SIZE + items * NACK_ITEM_SIZE,
+                        buffer);
+}
+
+std::size_t write_pli(const uint32_t sender_ssrc, const uint32_t media_ssrc,
+                      unsigned char* buffer) {
+    return write_common(PAYLOAD_FEEDBACK, PLI, sender_ssrc, media_ssrc,
+                        PLI_SIZE, buffer);
+}
+
+bool read_nack(const unsigned char* data, const std::size_t size,
+               uint32_t& media_ssrc, uint16_t* sequences,
+               const std::size_t capacity, std::size_t& count) {
+    const std::size_t length =
+        read_common(data, size, TRANSPORT_FEEDBACK, GENERIC_NACK);
+    if (length == 0 || length == HEADER_SIZE) return false;
+
+    media_ssrc = read_u32(data + 8);
+    count = 0;
+    for (std::size_t offset = HEADER_SIZE; offset < length;
+         offset += NACK_ITEM_SIZE) {
+        const uint16_t pid = read_u16(data + offset);
+        const uint16_t blp = read_u16(data + offset + 2);
+        if (count < capacity) sequences[count++] = pid;
+        for (int bit = 0; bit < 16; ++bit) {
+            if ((blp & 1 << bit) != 0 && count < capacity) {
+                sequences[count++] = static_cast<uint16_t>(pid + bit + 1);
+            }
+        }
+    }
+    return true;
+}
+
+bool read_pli(const unsigned char* data, const std::size_t size,
+              uint32_t& media_ssrc) {
+    if (read_common(data, size, PAYLOAD_FEEDBACK, PLI) == 0) return false;
+
+    media_ssrc = read_u32(data + 8);
+    return true;
+}
+
+std::size_t write_loss_report(const uint32_t sender_ssrc,
+                              const double loss_rate, const double mean_burst,
+                              unsigned char* buffer) {
+    // The name takes the place of the media SSRC of feedback messages
+    uint32_t name = 0;
+    for (const unsigned char c : LOSS_REPORT_NAME) name = name << 8 | c;
+    write_common(APPLICATION, LOSS_REPORT_SUBTYPE, sender_ssrc, name,
+                 LOSS_REPORT_SIZE, buffer);
+    write_u16(static_cast<uint16_t>(std::lround(
+                  std::clamp(loss_rate, 0.0, 1.0) * LOSS_SCALE)),
+              buffer + HEADER_SIZE);
+    write_u16(static_cast<uint16_t>(std::lround(
+                  std::clamp(mean_burst, 1.0, 255.0) * BURST_SCALE)),
+              buffer + HEADER_SIZE + 2);
+    return LOSS_REPORT_SIZE;
+}
+
+bool read_loss_report(const unsigned char* data, const std::size_t size,
+                      double& loss_rate, double& mean_burst) {
+    if (read_common(data, size, APPLICATION, LOSS_REPORT_SUBTYPE) !=
+            LOSS_REPORT_SIZE ||
+        !std::equal(std::begin(LOSS_REPORT_NAME), std::end(LOSS_REPORT_NAME),
+                    data + 8)) {
+        return false;
+    }
+
+    loss_rate = read_u16(data + HEADER_SIZE) / LOSS_SCALE;
+    mean_burst = std::max(read_u16(data + HEADER_SIZE + 2) / BURST_SCALE, 1.0);
+    return true;
+}
+
+std::size_t write_transport_feedback(
+    const uint32_t sender_ssrc, const uint32_t media_ssrc,
+    const uint16_t base_sequence, const int64_t* arrivals,
+    const std::size_t count, const uint8_t feedback_count,
+    unsigned char* buffer, std::size_t& written) {
+    written = 0;
+    if (count == 0) return 0;
+
+    // Reference time at or before the first arrival, in whole ticks
+    int64_t reference = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (arrivals[i] == NOT_RECEIVED) continue;
+        reference = arrivals[i] / REFERENCE_TICK -
+                    (arrivals[i] % REFERENCE_TICK < 0 ? 1 : 0);
+        break;
+    }
+
+    const std::size_t packets = std::min(count, MAX_FEEDBACK_PACKETS);
+    std::array<uint8_t, MAX_FEEDBACK_PACKETS> symbols;
+    std::array<unsigned char, MAX_FEEDBACK_PACKETS * 2> deltas;
+    std::size_t deltas_size = 0;
+    int64_t previous = reference * REFERENCE_TICK;
+    for (; written < packets; ++written) {
+        const int64_t arrival = arrivals[written];
+        if (arrival == NOT_RECEIVED) {
+            symbols[written] = SYMBOL_NOT_RECEIVED;
+            continue;
+        }
+
+        // Rounded, and each delta taken from the rounded time before it so
+        // the error does not build up
+        const int64_t difference = arrival - previous;
+        const int64_t ticks =
+            (difference + (difference < 0 ? -DELTA_TICK : DELTA_TICK) / 2) /
+            DELTA_TICK;
+        if (ticks >= 0 && ticks <= 0xFF) {
+            symbols[written] = SYMBOL_SMALL_DELTA;
+            deltas[deltas_size++] = static_cast<unsigned char>(ticks);
+        } else if (ticks >= std::numeric_limits<int16_t>::min() &&
+                   ticks <= std::numeric_limits<int16_t>::max()) {
+            symbols[written] = SYMBOL_LARGE_DELTA;
+            write_u16(static_cast<uint16_t>(ticks),
+                      deltas.data() + deltas_size);
+            deltas_size += 2;
+        } else {
+            break;
+        }
+        previous += ticks * DELTA_TICK;
+    }
+
+    // A run where it covers a vector's worth, else a vector of one-bit
+    // symbols when no delta in it is large, else of two-bit symbols
+    unsigned char* chunk = buffer + TRANSPORT_FEEDBACK_HEADER_SIZE;
+    for (std::size_t i = 0; i < written;) {
+        std::size_t run = 1;
+        while (i + run < written && run < MAX_RUN_LENGTH &&
+               symbols[i + run] == symbols[i]) {
+            ++run;
+        }
+        const std::size_t vector = std::min(written - i, ONE_BIT_SYMBOLS);
+        const auto begin = symbols.begin() + static_cast<std::ptrdiff_t>(i);
+        uint16_t value = 0;
+        if (run >= ONE_BIT_SYMBOLS || i + run == written) {
+            value = static_cast<uint16_t>(symbols[i] << 13 | run);
+            i += run;
+        } else if (std::find(begin, begin + static_cast<std::ptrdiff_t>(vector),
+                             SYMBOL_LARGE_DELTA) ==
+                   begin + static_cast<std::ptrdiff_t>(vector)) {
+            value = 0x8000;
+            for (std::size_t j = 0; j < ONE_BIT_SYMBOLS && i < written;
+                 ++j, ++i) {
+                value = static_cast<uint16_t>(
+                    value | symbols[i] << (ONE_BIT_SYMBOLS - 1 - j));
+            }
+        } else {
+            value = 0xC000;
+            for (std::size_t j = 0; j < TWO_BIT_SYMBOLS && i < written;
+                 ++j, ++i) {
+                value = static_cast<uint16_t>(
+                    value | symbols[i] << 2 * (TWO_BIT_SYMBOLS - 1 - j));
+            }
+        }
+        write_u16(value, chunk);
+        chunk += 2;
+    }
+    std::memcpy(chunk, deltas.data(), deltas_size);
+    std::size_t size = static_cast<std::size_t>(chunk - buffer) + deltas_size;
+
+    // Padded to a word, the last byte counting the padding (RFC 3550)
+    const std::size_t padding = (4 - size % 4) % 4;
+    if (padding > 0) {
+        std::memset(buffer + size, 0, padding);
+        size += padding;
+        buffer[size - 1] = static_cast<unsigned char>(padding);
+    }
+
+    write_common(TRANSPORT_FEEDBACK, TRANSPORT_WIDE_CC, sender_ssrc,
+                 media_ssrc, size, buffer);
+    if (padding > 0) buffer[0] = static_cast<unsigned char>(buffer[0] | 0x20);
+    write_u16(base_sequence, buffer + HEADER_SIZE);
+    write_u16(static_cast<uint16_t>(written), buffer + HEADER_SIZE + 2);
+    const auto wrapped = static_cast<uint32_t>(
+        (reference % REFERENCE_WRAP + REFERENCE_WRAP) % REFERENCE_WRAP);
+    write_u32(wrapped << 8 | feedback_count, buffer + HEADER_SIZE + 4);
+    return size;
+}
+
+bool read_transport_feedback(const unsigned char* data,
+                             const std::size_t size, uint16_t& base_sequence,
+                             int64_t* arrivals, const std::size_t capacity,
+                             std::size_t& count) {
+    const std::size_t length =
+        read_common(data, size, TRANSPORT_FEEDBACK, TRANSPORT_WIDE_CC);
+    if (length < TRANSPORT_FEEDBACK_HEADER_SIZE) return false;
+    const std::size_t packets = read_u16(data + HEADER_SIZE + 2);
+    if (packets == 0 || packets > capacity) return false;
+
+    // Symbols first, kept in arrivals until the deltas are read
+    std::size_t offset = TRANSPORT_FEEDBACK_HEADER_SIZE;
+    std::size_t symbols = 0;
+    while (symbols < packets) {
+        if (offset + 2 > length) return false;
+        const uint16_t chunk = read_u16(data + offset);
+        offset += 2;
+        if ((chunk & 0x8000) == 0) {
+            const std::size_t run = chunk & MAX_RUN_LENGTH;
+            for (std::size_t j = 0; j < run && symbols < packets; ++j) {
+                arrivals[symbols++] = chunk >> 13 & 0x03;
+            }
+        } else if ((chunk & 0x4000) == 0) {
+            for (std::size_t j = 0; j < ONE_BIT_SYMBOLS && symbols < packets;
+                 ++j) {
+                arrivals[symbols++] = chunk >> (ONE_BIT_SYMBOLS - 1 - j) & 1;
+            }
+        } else {
+            for (std::size_t j = 0; j < TWO_BIT_SYMBOLS && symbols < packets;
+                 ++j) {
+                arrivals[symbols++] =
+                    chunk >> 2 * (TWO_BIT_SYMBOLS - 1 - j) & 0x03;
+            }
+        }
+    }
+
+    int64_t arrival =
+        static_cast<int64_t>(read_u32(data + HEADER_SIZE + 4) >> 8) *
+        REFERENCE_TICK;
+    for (std::size_t i = 0; i < packets; ++i) {
+        const int64_t symbol = arrivals[i];
+        if (symbol == SYMBOL_NOT_RECEIVED) {
+            arrivals[i] = NOT_RECEIVED;
+            continue;
+        }
+        if (symbol == SYMBOL_SMALL_DELTA) {
+            if (offset + 1 > length) return false;
+            arrival += data[offset] * DELTA_TICK;
+            offset += 1;
+        } else if (symbol == SYMBOL_LARGE_DELTA) {
+            if (offset + 2 > length) return false;
+            arrival +=
+                static_cast<int16_t>(read_u16(data + offset)) * DELTA_TICK;
+            offset += 2;
+        } else {
+            return false;  // Reserved
+        }
+        arrivals[i] = arrival;
+    }
+
+    base_sequence = read_u16(data + HEADER_SIZE);
+    count = packets;
+    return true;
+}
+
+}  // namespace RtcpFeedback
@@ -0,0 +1,143 @@
+#include "rtp_packet.hpp"
+
+#include <cstring>
+
+namespace Rtp {
+
+namespace {
+
+constexpr std::size_t CSRC_SIZE = 4;
+constexpr std::size_t EXTENSION_HEADER_SIZE = 4;  // profile, length
+constexpr uint16_t ONE_BYTE_PROFILE = 0xBEDE;      // RFC 8285 section 4.2
+constexpr uint8_t ONE_BYTE_RESERVED_ID = 15;       // Stops the parsing
+
+uint16_t read_u16(const unsigned char* data) {
+    return static_cast<uint16_t>(data[0] << 8 | data[1]);
+}
+
+uint32_t read_u32(const unsigned char* data) {
+    return static_cast<uint32_t>(data[0]) << 24 |
+           static_cast<uint32_t>(data[1]) << 16 |
+           static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+void write_u16(const uint16_t value, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(value >> 8);
+    buffer[1] = static_cast<unsigned char>(value);
+}
+
+void write_u32(const uint32_t value, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(value >> 24);
+    buffer[1] = static_cast<unsigned char>(value >> 16);
+    buffer[2] = static_cast<unsigned char>(value >> 8);
+    buffer[3] = static_cast<unsigned char>(value);
+}
+
+}  // namespace
+
+std::size_t write_header(const Header& header, unsigned char* buffer) {
+    buffer[0] = static_cast<unsigned char>(VERSION << 6);
+    buffer[1] = static_cast<unsigned char>((header.marker ? 0x80 : 0) |
+                                           (header.payload_type & 0x7F));
+    buffer[2] = static_cast<unsigned char>(header.sequence >> 8);
+    buffer[3] = static_cast<unsigned char>(header.sequence);
+    write_u32(header.timestamp, buffer + 4);
+    write_u32(header.ssrc, buffer + 8);
+    return HEADER_SIZE;
+}
+
+bool read_header(const unsigned char* data, const std::size_t size,
+                 Header& header, std::size_t& payload_offset,
+                 std::size_t& payload_size) {
+    if (size < HEADER_SIZE || data[0] >> 6 != VERSION) return false;
+
+    const bool padding = (data[0] & 0x20) != 0;
+    const bool extension = (data[0] & 0x10) != 0;
+    const std::size_t csrc_count = data[0] & 0x0F;
+
+    std::size_t offset = HEADER_SIZE + csrc_count * CSRC_SIZE;
+    if (extension) {
+        if (size < offset + EXTENSION_HEADER_SIZE) return false;
+        const std::size_t words = read_u16(data + offset + 2);
+        offset += EXTENSION_HEADER_SIZE + words * 4;
+    }
+    if (size < offset) return false;
+
+    std::size_t end = size;
+    if (padding) {
+        // The last byte counts the padding, itself included
+        const std::size_t padding_size = data[size - 1];
+        if (padding_size == 0 || padding_size > size - offset) return false;
+        end -= padding_size;
+    }
+
+    header.marker = (data[1] & 0x80) != 0;
+    header.payload_type = data[1] & 0x7F;
+    header.sequence = read_u16(data + 2);
+    header.timestamp = read_u32(data + 4);
+    header.ssrc = read_u32(data + 8);
+    payload_offset = offset;
+    payload_size = end - offset;
+    return true;
+}
+
+std::size_t write_transport_header(const unsigned char* header,
+                                   const uint16_t transport_sequence,
+                                   unsigned char* buffer) {
+    std::memcpy(buffer, header, HEADER_SIZE);
+    buffer[0] = static_cast<unsigned char>(buffer[0] | 0x10);
+
+    // One element of two bytes, padded to the word
+    unsigned char* extension = buffer + HEADER_SIZE;
+    write_u16(ONE_BYTE_PROFILE, extension);
+    write_u16(1, extension + 2);
+    extension[4] = static_cast<unsigned char>(TRANSPORT_SEQUENCE_ID << 4 | 1);
+    write_u16(transport_sequence, extension + 5);
+    extension[7] = 0;
+    return HEADER_SIZE + TRANSPORT_EXTENSION_SIZE;
+}
+
+bool read_transport_sequence(const unsigned char* data,
+                             const std::size_t size,
+                             uint16_t& transport_sequence) {
+    const std::size_t extension = extension_size(data, size);
+    if (extension == 0) return false;
+
+    const std::size_t start = HEADER_SIZE + (data[0] & 0x0F) * CSRC_SIZE;
+    if (read_u16(data + start) != ONE_BYTE_PROFILE) return false;
+
+    // Elements are an ID and length byte, then 1 to 16 bytes of data;
+    // zero bytes are padding between them
+    const std::size_t end = start + extension;
+    std::size_t offset = start + EXTENSION_HEADER_SIZE;
+    while (offset < end) {
+        if (data[offset] == 0) {
+            ++offset;
+            continue;
+        }
+        const uint8_t id = data[offset] >> 4;
+        const std::size_t length = (data[offset] & 0x0F) + std::size_t{1};
+        if (id == ONE_BYTE_RESERVED_ID || offset + 1 + length > end) break;
+        if (id == TRANSPORT_SEQUENCE_ID && length == 2) {
+            transport_sequence = read_u16(data + offset + 1);
+            return true;
+        }
+        offset += 1 + length;
+    }
+    return false;
+}
+
+std::size_t extension_size(const unsigned char* data, const std::size_t size) {
+    if (size < HEADER_SIZE || data[0] >> 6 != VERSION ||
+        (data[0] & 0x10) == 0) {
+        return 0;
+    }
+
+    const std::size_t start = HEADER_SIZE + (data[0] & 0x0F) * CSRC_SIZE;
+    if (size < start + EXTENSION_HEADER_SIZE) return 0;
+    const std::size_t extension =
+        EXTENSION_HEADER_SIZE + read_u16(data + start + 2) * std::size_t{4};
+    return size >= start + extension ? extension : 0;
+}
+
+}  // namespace Rtp
@@ -0,0 +1,174 @@
+#include "trendline_estimator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int64_t ARRIVAL_BURST_US = 5000;
+constexpr int64_t MAX_BURST_DURATION_US = 100000;
+constexpr double SMOOTHING = 0.9;
+constexpr double THRESHOLD_GAIN = 4;
+constexpr std::size_t MAX_DELTAS = 60;
+constexpr double INITIAL_THRESHOLD = 12.5;  // ms
+constexpr double MIN_THRESHOLD = 6;         // ms
+constexpr double MAX_THRESHOLD = 600;       // ms
+constexpr double THRESHOLD_UP = 0.0087;     // Per ms, above the threshold
+constexpr double THRESHOLD_DOWN = 0.039;    // Per ms, below it
+constexpr double MAX_ADAPT_OFFSET = 15;     // ms; spikes leave it alone
+constexpr double MAX_ADAPT_INTERVAL = 100;  // ms
+constexpr double OVERUSE_TIME = 10;         // ms
+
+double milliseconds(const int64_t microseconds) {
+    return static_cast<double>(microseconds) / 1000;
+}
+
+}  // namespace
+
+TrendlineEstimator::TrendlineEstimator()
+    : started_(false),
+      has_previous_(false),
+      deltas_(0),
+      first_arrival_(0),
+      accumulated_delay_(0),
+      smoothed_delay_(0),
+      times_{},
+      delays_{},
+      samples_(0),
+      next_sample_(0),
+      trend_(0),
+      previous_trend_(0),
+      threshold_(INITIAL_THRESHOLD),
+      last_threshold_update_(-1),
+      time_over_using_(-1),
+      overuse_count_(0),
+      usage_(BandwidthUsage::NORMAL) {}
+
+void TrendlineEstimator::on_packet(const int64_t send_time,
+                                   const int64_t arrival_time) {
+    if (!started_) {
+        started_ = true;
+        current_ = {send_time, send_time, arrival_time, arrival_time};
+        return;
+    }
+    if (send_time < current_.first_send) return;  // Of a group gone by
+
+    if (belongs(send_time, arrival_time)) {
+        current_.last_send = std::max(current_.last_send, send_time);
+        current_.last_arrival = std::max(current_.last_arrival, arrival_time);
+        return;
+    }
+
+    // The current group is complete: compare it with the one before
+    if (has_previous_) {
+        const int64_t send_delta = current_.last_send - previous_.last_send;
+        const int64_t arrival_delta =
+            current_.last_arrival - previous_.last_arrival;
+        if (arrival_delta >= 0) {
+            update(milliseconds(arrival_delta - send_delta),
+                   milliseconds(send_delta), current_.last_arrival);
+        }
+    }
+    previous_ = current_;
+    has_previous_ = true;
+    current_ = {send_time, send_time, arrival_time, arrival_time};
+}
+
+bool TrendlineEstimator::belongs(const int64_t send_time,
+                                 const int64_t arrival_time) const {
+    if (send_time - current_.first_send <= SEND_GROUP_SPAN_US) return true;
+
+    // Held up together, then delivered back to back: spacing at arrival
+    // that is less than at sending is the queue draining, not the path
+    const int64_t arrival_delta = arrival_time - current_.last_arrival;
+    const int64_t send_delta = send_time - current_.last_send;
+    return arrival_delta - send_delta < 0 &&
+           arrival_delta <= ARRIVAL_BURST_US &&
+           arrival_time - current_.first_arrival < MAX_BURST_DURATION_US;
+}
+
+void TrendlineEstimator::update(const double delay_variation,
+                                const double send_delta,
+                                const int64_t arrival_time) {
+    deltas_ = std::min(deltas_ + 1, MAX_DELTAS);
+    if (samples_ == 0 && next_sample_ == 0) first_arrival_ = arrival_time;
+    accumulated_delay_ += delay_variation;
+    smoothed_delay_ = SMOOTHING * smoothed_delay_ +
+                      (1 - SMOOTHING) * accumulated_delay_;
+
+    times_[next_sample_] = milliseconds(arrival_time - first_arrival_);
+    delays_[next_sample_] = smoothed_delay_;
+    next_sample_ = (next_sample_ + 1) % TRENDLINE_WINDOW;
+    samples_ = std::min(samples_ + 1, TRENDLINE_WINDOW);
+
+    if (samples_ == TRENDLINE_WINDOW) {
+        // Least squares slope of delay over time
+        double mean_time = 0;
+        double mean_delay = 0;
+        for (std::size_t i = 0; i < samples_; ++i) {
+            mean_time += times_[i];
+            mean_delay += delays_[i];
+        }
+        mean_time /= static_cast<double>(samples_);
+        mean_delay /= static_cast<double>(samples_);
+        double numerator = 0;
+        double denominator = 0;
+        for (std::size_t i = 0; i < samples_; ++i) {
+            numerator += (times_[i] - mean_time) * (delays_[i] - mean_delay);
+            denominator += (times_[i] - mean_time) * (times_[i] - mean_time);
+        }
+        if (denominator != 0) trend_ = numerator / denominator;
+    }
+    detect(send_delta, milliseconds(arrival_time - first_arrival_));
+}
+
+void TrendlineEstimator::detect(const double send_delta, const double now) {
+    if (deltas_ < 2) {
+        usage_ = BandwidthUsage::NORMAL;
+        return;
+    }
+
+    const double modified_trend =
+        static_cast<double>(deltas_) * trend_ * THRESHOLD_GAIN;
+    if (modified_trend > threshold_) {
+        time_over_using_ = time_over_using_ < 0
+                               ? send_delta / 2
+                               : time_over_using_ + send_delta;
+        ++overuse_count_;
+        if (time_over_using_ > OVERUSE_TIME && overuse_count_ > 1 &&
+            trend_ >= previous_trend_) {
+            time_over_using_ = 0;
+            overuse_count_ = 0;
+            usage_ = BandwidthUsage::OVERUSING;
+        }
+    } else if (modified_trend < -threshold_) {
+        time_over_using_ = -1;
+        overuse_count_ = 0;
+        usage_ = BandwidthUsage::UNDERUSING;
+    } else {
+        time_over_using_ = -1;
+        overuse_count_ = 0;
+        usage_ = BandwidthUsage::NORMAL;
+    }
+    previous_trend_ = trend_;
+    adapt_threshold(modified_trend, now);
+}
+
+void TrendlineEstimator::adapt_threshold(const double modified_trend,
+                                         const double now) {
+    if (last_threshold_update_ < 0) last_threshold_update_ = now;
+
+    const double magnitude = std::abs(modified_trend);
+    if (magnitude > threshold_ + MAX_ADAPT_OFFSET) {
+        last_threshold_update_ = now;
+        return;
+    }
+
+    const double gain =
+        magnitude < threshold_ ? THRESHOLD_DOWN : THRESHOLD_UP;
+    const double elapsed =
+        std::min(now - last_threshold_update_, MAX_ADAPT_INTERVAL);
+    threshold_ += gain * (magnitude - threshold_) * elapsed;
+    threshold_ = std::clamp(threshold_, MIN_THRESHOLD, MAX_THRESHOLD);
+    last_threshold_update_ = now;
+}
@@ -0,0 +1,136 @@
+#include "vp8_depacketizer.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t MAX_WINDOW = 32768;  // Half the sequence number space
+
+}  // namespace
+
+Vp8Depacketizer::Vp8Depacketizer(const std::size_t window)
+    : started_(false),
+      highest_sequence_(0),
+      packets_(0),
+      frames_(0),
+      malformed_(0),
+      duplicates_(0),
+      late_(0) {
+    // A power of two keeps slot indices continuous across sequence wrap
+    if (window == 0 || window > MAX_WINDOW || (window & (window - 1)) != 0) {
+        throw std::invalid_argument(
+            "Reorder window must be a power of two up to 32768");
+    }
+
+    slots_.resize(window);
+    storage_.resize(window * PacketBuffer::CAPACITY);
+    for (std::size_t i = 0; i < window; ++i) {
+        slots_[i].data = storage_.data() + i * PacketBuffer::CAPACITY;
+    }
+    frame_.reserve(storage_.size());
+}
+
+bool Vp8Depacketizer::push(const unsigned char* data, const std::size_t size,
+                           ReceivedFrame& frame) {
+    ++packets_;
+
+    Rtp::Header header;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+    Vp8Payload::Descriptor descriptor;
+    std::size_t descriptor_size = 0;
+    if (!Rtp::read_header(data, size, header, payload_offset, payload_size) ||
+        !Vp8Payload::read_descriptor(data + payload_offset, payload_size,
+                                     descriptor, descriptor_size) ||
+        payload_size - descriptor_size > PacketBuffer::CAPACITY) {
+        ++malformed_;
+        return false;
+    }
+
+    const uint16_t sequence = header.sequence;
+    if (!started_) {
+        highest_sequence_ = sequence;
+        started_ = true;
+    } else {
+        const int delta = Rtp::sequence_delta(highest_sequence_, sequence);
+        if (delta <= -static_cast<int>(slots_.size())) {
+            // Its slot may already hold a newer packet
+            ++late_;
+            return false;
+        }
+        if (delta > 0) highest_sequence_ = sequence;
+    }
+
+    Slot& entry = slot(sequence);
+    if (entry.state != SlotState::EMPTY && entry.sequence == sequence) {
+        ++duplicates_;
+        return false;
+    }
+
+    entry.state = SlotState::PENDING;
+    entry.first =
+        descriptor.start_of_partition && descriptor.partition_id == 0;
+    entry.last = header.marker;
+    entry.sequence = sequence;
+    entry.timestamp = header.timestamp;
+    entry.size = payload_size - descriptor_size;
+    entry.descriptor = descriptor;
+    std::memcpy(entry.data, data + payload_offset + descriptor_size,
+                entry.size);
+
+    return assemble(sequence, header, frame);
+}
+
+bool Vp8Depacketizer::waiting(const uint16_t sequence,
+                              const uint32_t timestamp) {
+    const Slot& entry = slot(sequence);
+    return entry.state == SlotState::PENDING && entry.sequence == sequence &&
+           entry.timestamp == timestamp;
+}
+
+bool Vp8Depacketizer::assemble(const uint16_t sequence,
+                               const Rtp::Header& header,
+                               ReceivedFrame& frame) {
+    // Walk back to the packet starting the frame and on to its marker
+    uint16_t first = sequence;
+    std::size_t span = 1;
+    while (!slot(first).first) {
+        const auto previous = static_cast<uint16_t>(first - 1);
+        if (++span > slots_.size() || !waiting(previous, header.timestamp)) {
+            return false;
+        }
+        first = previous;
+    }
+    uint16_t last = sequence;
+    while (!slot(last).last) {
+        const auto next = static_cast<uint16_t>(last + 1);
+        if (++span > slots_.size() || !waiting(next, header.timestamp)) {
+            return false;
+        }
+        last = next;
+    }
+
+    frame_.clear();
+    for (uint16_t current = first;; ++current) {
+        Slot& entry = slot(current);
+        frame_.insert(frame_.end(), entry.data, entry.data + entry.size);
+        entry.state = SlotState::DONE;
+        if (current == last) break;
+    }
+
+    const Slot& start = slot(first);
+    frame.data = frame_.data();
+    frame.size = frame_.size();
+    frame.timestamp = header.timestamp;
+    frame.ssrc = header.ssrc;
+    frame.first_sequence = first;
+    frame.last_sequence = last;
+    frame.picture_id = start.descriptor.picture_id;
+    frame.tl0_pic_idx = start.descriptor.tl0_pic_idx;
+    frame.temporal_layer = start.descriptor.temporal_layer;
+    frame.layer_sync = start.descriptor.layer_sync;
+    frame.keyframe = Vp8Payload::is_keyframe(start.data);
+    ++frames_;
+    return true;
+}
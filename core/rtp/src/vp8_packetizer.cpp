@@ -0,0 +1,77 @@
+#include "vp8_packetizer.hpp"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t MIN_PACKET_DATA = 64;  // bytes of frame per packet
+
+}  // namespace
+
+Vp8Packetizer::Vp8Packetizer(const uint32_t ssrc,
+                             const std::size_t max_packet_size,
+                             const uint8_t payload_type)
+    : max_packet_size_(0), picture_id_(0), tl0_pic_idx_(0) {
+    set_max_packet_size(max_packet_size);
+
+    std::random_device random;
+    header_.payload_type = payload_type;
+    header_.ssrc = ssrc;
+    header_.sequence = static_cast<uint16_t>(random());
+    picture_id_ = static_cast<uint16_t>(random() & Vp8Payload::PICTURE_ID_MASK);
+}
+
+const std::vector<GatherDatagram>& Vp8Packetizer::packetize(
+    const unsigned char* data, const std::size_t size,
+    const Vp8FrameInfo& info) {
+    packets_.clear();
+    if (size == 0) return packets_;
+
+    Vp8Payload::Descriptor descriptor;
+    descriptor.non_reference = info.non_reference;
+    descriptor.picture_id = picture_id_;
+    if (info.temporal_layer != Vp8Payload::NONE) {
+        if (info.temporal_layer == 0) ++tl0_pic_idx_;
+        descriptor.tl0_pic_idx = tl0_pic_idx_;
+        descriptor.temporal_layer = info.temporal_layer;
+        descriptor.layer_sync = info.layer_sync;
+    }
+    picture_id_ =
+        static_cast<uint16_t>((picture_id_ + 1) & Vp8Payload::PICTURE_ID_MASK);
+
+    // Every header has the same size, so all packets but the last are full
+    const std::size_t header_size =
+        Rtp::HEADER_SIZE + Vp8Payload::descriptor_size(descriptor);
+    const std::size_t capacity = max_packet_size_ - header_size;
+    const std::size_t count = (size + capacity - 1) / capacity;
+    if (headers_.size() < count) headers_.resize(count);
+
+    header_.timestamp = info.timestamp;
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t length = std::min(capacity, size - offset);
+        unsigned char* header = headers_[i].data();
+
+        // The whole frame is one partition run, started by the first packet
+        header_.marker = i + 1 == count;
+        descriptor.start_of_partition = i == 0;
+        const std::size_t rtp_size = Rtp::write_header(header_, header);
+        Vp8Payload::write_descriptor(descriptor, header + rtp_size);
+        ++header_.sequence;
+
+        packets_.push_back({boost::asio::buffer(header, header_size),
+                            boost::asio::buffer(data + offset, length)});
+        offset += length;
+    }
+    return packets_;
+}
+
+void Vp8Packetizer::set_max_packet_size(const std::size_t max_packet_size) {
+    if (max_packet_size < MAX_HEADER_SIZE + MIN_PACKET_DATA ||
+        max_packet_size > PathMtu::MAX_PLPMTU) {
+        throw std::invalid_argument("Invalid RTP packet size");
+    }
+    max_packet_size_ = max_packet_size;
+}
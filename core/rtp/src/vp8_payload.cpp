@@ -0,0 +1,128 @@
+#include "vp8_payload.hpp"
+
+namespace Vp8Payload {
+
+namespace {
+
+constexpr unsigned char EXTENDED = 0x80;
+constexpr unsigned char NON_REFERENCE = 0x20;
+constexpr unsigned char START_OF_PARTITION = 0x10;
+constexpr unsigned char PARTITION_ID = 0x07;
+
+constexpr unsigned char HAS_PICTURE_ID = 0x80;
+constexpr unsigned char HAS_TL0_PIC_IDX = 0x40;
+constexpr unsigned char HAS_TEMPORAL_LAYER = 0x20;
+constexpr unsigned char HAS_KEY_INDEX = 0x10;
+
+constexpr unsigned char LONG_PICTURE_ID = 0x80;
+constexpr unsigned char LAYER_SYNC = 0x20;
+constexpr unsigned char KEY_INDEX = 0x1F;
+
+unsigned char extension_flags(const Descriptor& descriptor) {
+    unsigned char flags = 0;
+    if (descriptor.picture_id != NONE) flags |= HAS_PICTURE_ID;
+    if (descriptor.tl0_pic_idx != NONE) flags |= HAS_TL0_PIC_IDX;
+    if (descriptor.temporal_layer != NONE) flags |= HAS_TEMPORAL_LAYER;
+    if (descriptor.key_index != NONE) flags |= HAS_KEY_INDEX;
+    return flags;
+}
+
+}  // namespace
+
+std::size_t descriptor_size(const Descriptor& descriptor) {
+    const unsigned char flags = extension_flags(descriptor);
+    if (flags == 0) return 1;
+
+    std::size_t size = 2;
+    if (flags & HAS_PICTURE_ID) size += 2;
+    if (flags & HAS_TL0_PIC_IDX) size += 1;
+    if (flags & (HAS_TEMPORAL_LAYER | HAS_KEY_INDEX)) size += 1;
+    return size;
+}
+
+std::size_t write_descriptor(const Descriptor& descriptor,
+                             unsigned char* buffer) {
+    const unsigned char flags = extension_flags(descriptor);
+    std::size_t size = 1;
+    buffer[0] = static_cast<unsigned char>(
+        (flags != 0 ? EXTENDED : 0) |
+        (descriptor.non_reference ? NON_REFERENCE : 0) |
+        (descriptor.start_of_partition ? START_OF_PARTITION : 0) |
+        (descriptor.partition_id & PARTITION_ID));
+    if (flags == 0) return size;
+
+    buffer[size++] = flags;
+    if (flags & HAS_PICTURE_ID) {
+        const int picture_id = descriptor.picture_id & PICTURE_ID_MASK;
+        buffer[size++] =
+            static_cast<unsigned char>(LONG_PICTURE_ID | picture_id >> 8);
+        buffer[size++] = static_cast<unsigned char>(picture_id);
+    }
+    if (flags & HAS_TL0_PIC_IDX) {
+        buffer[size++] = static_cast<unsigned char>(descriptor.tl0_pic_idx);
+    }
+    if (flags & (HAS_TEMPORAL_LAYER | HAS_KEY_INDEX)) {
+        unsigned char byte = 0;
+        if (descriptor.temporal_layer != NONE) {
+            byte |= static_cast<unsigned char>(
+                (descriptor.temporal_layer & 0x03) << 6 |
+                (descriptor.layer_sync ? LAYER_SYNC : 0));
+        }
+        if (descriptor.key_index != NONE) {
+            byte |= static_cast<unsigned char>(descriptor.key_index &
+                                               KEY_INDEX);
+        }
+        buffer[size++] = byte;
+    }
+    return size;
+}
+
+bool read_descriptor(const unsigned char* data, const std::size_t size,
+                     Descriptor& descriptor, std::size_t& size_read) {
+    if (size < 1) return false;
+
+    descriptor = Descriptor();
+    descriptor.non_reference = (data[0] & NON_REFERENCE) != 0;
+    descriptor.start_of_partition = (data[0] & START_OF_PARTITION) != 0;
+    descriptor.partition_id = data[0] & PARTITION_ID;
+
+    std::size_t offset = 1;
+    if (data[0] & EXTENDED) {
+        if (size <= offset) return false;
+        const unsigned char flags = data[offset++];
+
+        if (flags & HAS_PICTURE_ID) {
+            if (size <= offset) return false;
+            if (data[offset] & LONG_PICTURE_ID) {
+                if (size <= offset + 1) return false;
+                descriptor.picture_id =
+                    (data[offset] & 0x7F) << 8 | data[offset + 1];
+                offset += 2;
+            } else {
+                descriptor.picture_id = data[offset++];
+            }
+        }
+        if (flags & HAS_TL0_PIC_IDX) {
+            if (size <= offset) return false;
+            descriptor.tl0_pic_idx = data[offset++];
+        }
+        if (flags & (HAS_TEMPORAL_LAYER | HAS_KEY_INDEX)) {
+            if (size <= offset) return false;
+            if (flags & HAS_TEMPORAL_LAYER) {
+                descriptor.temporal_layer = data[offset] >> 6;
+                descriptor.layer_sync = (data[offset] & LAYER_SYNC) != 0;
+            }
+            if (flags & HAS_KEY_INDEX) {
+                descriptor.key_index = data[offset] & KEY_INDEX;
+            }
+            ++offset;
+        }
+    }
+
+    // A packet without VP8 data carries nothing to decode
+    if (size <= offset) return false;
+    size_read = offset;
+    return true;
+}
+
+}  // namespace Vp8Payload
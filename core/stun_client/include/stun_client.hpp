@@ -3,7 +3,9 @@
 
 #include <boost/asio.hpp>
 
+#include "socket_address.hpp"
 #include "stun_constants.hpp"
+#include "stun_message.hpp"
 
 using boost::asio::ip::udp;
 
@@ -20,10 +22,16 @@ class StunClient {
      * @param local_port Local port to bind the UDP socket
      * @param server STUN server name (default: stun.l.google.com)
      * @param server_port STUN server port (default: 19302)
+     * @param family Address family to query the server over, which is the
+     * family of the public address found (default: IPv4)
+     *
+     * @throws boost::system::system_error If the server has no address of
+     * the requested family.
      */
     StunClient(boost::asio::io_context& io_context, const uint16_t local_port,
                const std::string& server = StunServerInfo::GOOGLE_STUN_SERVER,
-               const uint16_t server_port = StunServerInfo::GOOGLE_STUN_PORT);
+               const uint16_t server_port = StunServerInfo::GOOGLE_STUN_PORT,
+               const udp& family = udp::v4());
 
     /**
      * @brief Destroy the StunClient object
@@ -49,14 +57,21 @@ class StunClient {
      *
      * @return std::string Public IP
      */
-    std::string public_ip() const { return public_ip_; }
+    std::string public_ip() const { return public_address_.ip_string(); }
 
     /**
      * @brief Get the public port
      *
      * @return uint16_t Public port
      */
-    uint16_t public_port() const { return public_port_; }
+    uint16_t public_port() const { return public_address_.port(); }
+
+    /**
+     * @brief Get the public IP and port
+     *
+     * @return const SocketAddress& Public socket address
+     */
+    const SocketAddress& public_address() const { return public_address_; }
 
     /**
      * @brief Print the public IP and port to stdout in the format "IP:port"
@@ -71,11 +86,10 @@ class StunClient {
     boost::asio::io_context& io_context_;
     udp::socket stun_socket_;
     udp::endpoint stun_server_;
-    std::array<unsigned char, 20> send_buf_;
+    std::array<unsigned char, StunMessage::HEADER_SIZE> send_buf_;
     std::array<unsigned char, 1024> recv_buf_;
-    std::array<unsigned char, 12> transaction_id_;
-    std::string public_ip_;
-    uint16_t public_port_;
+    StunMessage::TransactionId transaction_id_;
+    SocketAddress public_address_;
 };
 
 #endif  // STUN_CLIENT_HPP
@@ -41,6 +41,9 @@ constexpr uint32_t MAGIC_COOKIE = 0x2112A442;
 constexpr uint16_t MAPPED_ADDRESS = 0x0001;
 constexpr uint16_t XOR_MAPPED_ADDRESS = 0x0020;
 
+constexpr uint16_t FAMILY_IPV4 = 0x01;
+constexpr uint16_t FAMILY_IPV6 = 0x02;
+
 }  // namespace StunConstants
 
 #endif  // STUN_CONSTANTS_HPP
@@ -0,0 +1,29 @@
+#ifndef STUN_MESSAGE_HPP
+#define STUN_MESSAGE_HPP
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @namespace StunMessage
+ * @brief Encoding of the STUN messages sent by the client
+ */
+namespace StunMessage {
+
+constexpr std::size_t HEADER_SIZE = 20;          // bytes
+constexpr std::size_t TRANSACTION_ID_SIZE = 12;  // bytes
+
+using TransactionId = std::array<unsigned char, TRANSACTION_ID_SIZE>;
+
+/**
+ * @brief Write a Binding Request without attributes
+ *
+ * @param buffer Destination for the encoded request
+ * @param transaction_id Transaction ID of the request
+ */
+void build_binding_request(std::array<unsigned char, HEADER_SIZE>& buffer,
+                           const TransactionId& transaction_id);
+
+}  // namespace StunMessage
+
+#endif  // STUN_MESSAGE_HPP
@@ -36,14 +36,6 @@ class StunResponseValidator {
      */
     bool validate_port(const uint16_t port) const;
 
-    /**
-     * @brief Validates an IP address
-     *
-     * @param ip IP address to validate
-     * @return true if the IP address is valid, false otherwise
-     */
-    bool validate_ip(const std::string& ip) const;
-
    private:
     bool validate_response_length(const std::size_t bytes_recvd) const;
     bool validate_message_type() const;
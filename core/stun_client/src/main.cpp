@@ -6,18 +6,23 @@
 
 int main(int argc, char* argv[]) {
     try {
-        if (argc != 2) {
+        if (argc < 2) {
             throw std::invalid_argument("Invalid number of arguments. Usage: " +
-                                        std::string(argv[0]) + " <local_port>");
+                                        std::string(argv[0]) +
+                                        " <local_port> [--ipv6]");
         }
 
         if (!Common::validate_port(argv[1])) {
             throw std::invalid_argument("Invalid port number");
         }
         const uint16_t local_port = static_cast<uint16_t>(std::stoi(argv[1]));
+        const auto options = Common::parse_options(argc, argv, 2);
+        const udp family = options.count("ipv6") ? udp::v6() : udp::v4();
 
         boost::asio::io_context io_context;
-        StunClient stun_client(io_context, local_port);
+        StunClient stun_client(io_context, local_port,
+                               StunServerInfo::GOOGLE_STUN_SERVER,
+                               StunServerInfo::GOOGLE_STUN_PORT, family);
 
         stun_client.periodic_query_stun_server(
             [&stun_client]() { stun_client.print_public_socket(); });
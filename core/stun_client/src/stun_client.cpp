@@ -1,20 +1,42 @@
 #include "stun_client.hpp"
 
-#include <iostream>
 #include <random>
 
+#include "control_channel.hpp"
+#include "dual_stack.hpp"
+#include "logger.hpp"
+#include "stun_message.hpp"
 #include "stun_response_validator.hpp"
 
 using namespace StunConstants;
 
+namespace {
+
+udp::endpoint resolve_server(boost::asio::io_context& io_context,
+                             const std::string& server,
+                             const uint16_t server_port,
+                             const udp::socket& socket, const udp& family) {
+    for (const auto& endpoint : SocketAddress::resolve_all(
+             io_context, server, std::to_string(server_port),
+             socket.local_endpoint().protocol())) {
+        if (SocketAddress::from_endpoint(endpoint).is_v6() ==
+            (family == udp::v6())) {
+            return endpoint;
+        }
+    }
+    throw boost::system::system_error(
+        boost::asio::error::address_family_not_supported, server);
+}
+
+}  // namespace
+
 StunClient::StunClient(boost::asio::io_context& io_context,
                        const uint16_t local_port, const std::string& server,
-                       const uint16_t server_port)
+                       const uint16_t server_port, const udp& family)
     : io_context_(io_context),
-      stun_socket_(io_context, udp::endpoint(udp::v4(), local_port)),
-      stun_server_(*udp::resolver(io_context)
-                        .resolve(udp::v4(), server, std::to_string(server_port))
-                        .begin()) {}
+      stun_socket_(DualStack::open_socket(io_context, local_port)),
+      stun_server_(resolve_server(io_context, server, server_port,
+                                  stun_socket_, family)) {}
 
 StunClient::~StunClient() {
     if (stun_socket_.is_open()) stun_socket_.close();
@@ -45,7 +67,7 @@ void StunClient::query_stun_server() {
         boost::asio::buffer(recv_buf_), sender_endpoint);
 
     if (sender_endpoint != stun_server_) {
-        std::cerr << "Received response from unknown endpoint" << std::endl;
+        LOG_WARNING("Received response from unknown endpoint");
         return;
     }
 
@@ -53,24 +75,14 @@ void StunClient::query_stun_server() {
 }
 
 void StunClient::print_public_socket() const {
-    std::cout << public_ip_ << ":" << public_port_ << std::endl;
+    std::array<char, SocketAddress::MAX_STRING_SIZE> buffer;
+    ControlChannel::send(std::string_view(
+        buffer.data(), public_address_.format(buffer.data(), buffer.size())));
 }
 
 void StunClient::generate_stun_request() {
-    const uint16_t message_length = 0;
-
-    send_buf_[0] = (BINDING_REQUEST >> 8) & 0xFF;
-    send_buf_[1] = BINDING_REQUEST & 0xFF;
-    send_buf_[2] = (message_length >> 8) & 0xFF;
-    send_buf_[3] = message_length & 0xFF;
-    send_buf_[4] = (MAGIC_COOKIE >> 24) & 0xFF;
-    send_buf_[5] = (MAGIC_COOKIE >> 16) & 0xFF;
-    send_buf_[6] = (MAGIC_COOKIE >> 8) & 0xFF;
-    send_buf_[7] = MAGIC_COOKIE & 0xFF;
-
     generate_transaction_id();
-    std::copy(transaction_id_.begin(), transaction_id_.end(),
-              send_buf_.begin() + 8);
+    StunMessage::build_binding_request(send_buf_, transaction_id_);
 }
 
 void StunClient::generate_transaction_id() {
@@ -87,19 +99,29 @@ void StunClient::handle_stun_response(const std::size_t bytes_recvd) {
     if (!validator.validate_stun_response(bytes_recvd)) return;
 
     const uint16_t xor_port = (recv_buf_[26] << 8) | recv_buf_[27];
-    const uint32_t xor_ip = (recv_buf_[28] << 24) | (recv_buf_[29] << 16) |
-                            (recv_buf_[30] << 8) | recv_buf_[31];
-
     const uint16_t port = xor_port ^ (MAGIC_COOKIE >> 16);
     if (!validator.validate_port(port)) return;
 
-    const uint32_t ip = xor_ip ^ MAGIC_COOKIE;
-    const std::string ip_str = std::to_string((ip >> 24) & 0xFF) + "." +
-                               std::to_string((ip >> 16) & 0xFF) + "." +
-                               std::to_string((ip >> 8) & 0xFF) + "." +
-                               std::to_string(ip & 0xFF);
-    if (!validator.validate_ip(ip_str)) return;
-
-    public_ip_ = ip_str;
-    public_port_ = port;
+    // The address is XORed with the magic cookie followed, for IPv6, by the
+    // transaction ID (RFC 5389, section 15.2)
+    std::array<uint8_t, 16> key;
+    for (std::size_t i = 0; i < 4; ++i) {
+        key[i] = static_cast<uint8_t>(MAGIC_COOKIE >> (24 - 8 * i));
+    }
+    std::copy(transaction_id_.begin(), transaction_id_.end(), key.begin() + 4);
+
+    const uint16_t family = (recv_buf_[24] << 8) | recv_buf_[25];
+    if (family == FAMILY_IPV4) {
+        SocketAddress::V4Bytes ip;
+        for (std::size_t i = 0; i < ip.size(); ++i) {
+            ip[i] = recv_buf_[28 + i] ^ key[i];
+        }
+        public_address_ = SocketAddress(ip, port);
+    } else {
+        SocketAddress::V6Bytes ip;
+        for (std::size_t i = 0; i < ip.size(); ++i) {
+            ip[i] = recv_buf_[28 + i] ^ key[i];
+        }
+        public_address_ = SocketAddress(ip, port);
+    }
 }
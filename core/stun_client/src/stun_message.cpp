@@ -0,0 +1,27 @@
+#include "stun_message.hpp"
+
+#include <algorithm>
+
+#include "stun_constants.hpp"
+
+using namespace StunConstants;
+
+namespace StunMessage {
+
+void build_binding_request(std::array<unsigned char, HEADER_SIZE>& buffer,
+                           const TransactionId& transaction_id) {
+    const uint16_t message_length = 0;
+
+    buffer[0] = (BINDING_REQUEST >> 8) & 0xFF;
+    buffer[1] = BINDING_REQUEST & 0xFF;
+    buffer[2] = (message_length >> 8) & 0xFF;
+    buffer[3] = message_length & 0xFF;
+    buffer[4] = (MAGIC_COOKIE >> 24) & 0xFF;
+    buffer[5] = (MAGIC_COOKIE >> 16) & 0xFF;
+    buffer[6] = (MAGIC_COOKIE >> 8) & 0xFF;
+    buffer[7] = MAGIC_COOKIE & 0xFF;
+
+    std::copy(transaction_id.begin(), transaction_id.end(), buffer.begin() + 8);
+}
+
+}  // namespace StunMessage
@@ -1,8 +1,7 @@
 #include "stun_response_validator.hpp"
 
-#include <iostream>
-
 #include "common.hpp"
+#include "logger.hpp"
 #include "stun_constants.hpp"
 
 using namespace StunConstants;
@@ -28,15 +27,7 @@ bool StunResponseValidator::validate_stun_response(
 
 bool StunResponseValidator::validate_port(const uint16_t port) const {
     if (!Common::validate_port(port)) {
-        std::cerr << "Invalid port" << std::endl;
-        return false;
-    }
-    return true;
-}
-
-bool StunResponseValidator::validate_ip(const std::string& ip) const {
-    if (!Common::validate_ip(ip)) {
-        std::cerr << "Invalid IP address" << std::endl;
+        LOG_WARNING("Invalid port");
         return false;
     }
     return true;
@@ -45,7 +36,7 @@ bool StunResponseValidator::validate_ip(const std::string& ip) const {
 bool StunResponseValidator::validate_response_length(
     const std::size_t bytes_recvd) const {
     if (bytes_recvd < 20) {
-        std::cerr << "Invalid STUN response" << std::endl;
+        LOG_WARNING("Invalid STUN response");
         return false;
     }
     return true;
@@ -54,7 +45,7 @@ bool StunResponseValidator::validate_response_length(
 bool StunResponseValidator::validate_message_type() const {
     const uint16_t message_type = (recv_buf_[0] << 8) | recv_buf_[1];
     if (message_type != BINDING_RESPONSE) {
-        std::cerr << "Invalid message type" << std::endl;
+        LOG_WARNING("Invalid message type");
         return false;
     }
     return true;
@@ -64,11 +55,11 @@ bool StunResponseValidator::validate_message_length(
     const std::size_t bytes_recvd) const {
     const uint16_t length = (recv_buf_[2] << 8) | recv_buf_[3];
     if (length != bytes_recvd - 20) {
-        std::cerr << "Invalid message length" << std::endl;
+        LOG_WARNING("Invalid message length");
         return false;
     }
-    if (length != 12) {  // Only XOR-MAPPED-ADDRESS supported
-        std::cerr << "Invalid attributes" << std::endl;
+    if (length != 12 && length != 24) {  // Only XOR-MAPPED-ADDRESS supported
+        LOG_WARNING("Invalid attributes");
         return false;
     }
     return true;
@@ -78,7 +69,7 @@ bool StunResponseValidator::validate_magic_cookie() const {
     const uint32_t magic_cookie = (recv_buf_[4] << 24) | (recv_buf_[5] << 16) |
                                   (recv_buf_[6] << 8) | recv_buf_[7];
     if (magic_cookie != MAGIC_COOKIE) {
-        std::cerr << "Invalid magic cookie" << std::endl;
+        LOG_WARNING("Invalid magic cookie");
         return false;
     }
     return true;
@@ -89,7 +80,7 @@ bool StunResponseValidator::validate_transaction_id() const {
     std::copy(recv_buf_.begin() + 8, recv_buf_.begin() + 20,
               transaction_id.begin());
     if (transaction_id != transaction_id_) {
-        std::cerr << "Invalid transaction ID" << std::endl;
+        LOG_WARNING("Invalid transaction ID");
         return false;
     }
     return true;
@@ -98,25 +89,28 @@ bool StunResponseValidator::validate_transaction_id() const {
 bool StunResponseValidator::validate_attribute_type() const {
     const uint16_t attr_type = (recv_buf_[20] << 8) | recv_buf_[21];
     if (attr_type != XOR_MAPPED_ADDRESS) {
-        std::cerr << "Invalid attribute type" << std::endl;
+        LOG_WARNING("Invalid attribute type");
         return false;
     }
     return true;
 }
 
 bool StunResponseValidator::validate_attribute_length() const {
+    const uint16_t length = (recv_buf_[2] << 8) | recv_buf_[3];
     const uint16_t attr_length = (recv_buf_[22] << 8) | recv_buf_[23];
-    if (attr_length != 8) {  // Only IPv4 addresses supported
-        std::cerr << "Invalid attribute length" << std::endl;
+    if (attr_length != length - 4) {  // Attribute header is 4 bytes
+        LOG_WARNING("Invalid attribute length");
         return false;
     }
     return true;
 }
 
 bool StunResponseValidator::validate_address_family() const {
+    const uint16_t attr_length = (recv_buf_[22] << 8) | recv_buf_[23];
     const uint16_t family = (recv_buf_[24] << 8) | recv_buf_[25];
-    if (family != 0x01) {  // Only IPv4 addresses supported
-        std::cerr << "Invalid address family" << std::endl;
+    if (!(family == FAMILY_IPV4 && attr_length == 8) &&
+        !(family == FAMILY_IPV6 && attr_length == 20)) {
+        LOG_WARNING("Invalid address family");
         return false;
     }
     return true;
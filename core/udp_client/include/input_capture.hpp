@@ -3,6 +3,7 @@
 
 #include <SFML/Window.hpp>
 
+#include "input_trace.hpp"
 #include "udp_client.hpp"
 
 constexpr const char* WINDOW_TITLE = "Keyboard Input Capture";
@@ -20,8 +21,10 @@ class InputCapture {
      *
      * @param io_context Boost ASIO context
      * @param client UDP client to send the input
+     * @param trace Optional trace recording every sent message
      */
-    InputCapture(boost::asio::io_context& io_context, UdpClient& client);
+    InputCapture(boost::asio::io_context& io_context, UdpClient& client,
+                 InputTraceWriter* trace = nullptr);
 
     /**
      * @brief Destroy the InputCapture object
@@ -40,10 +43,12 @@ class InputCapture {
     void handle_joystick_button_event(const sf::Event& event);
     void handle_joystick_moved(const sf::Event& event);
     void handle_joystick_connect_event(const sf::Event& event);
+    void send(const InputMessages::Message& message);
     void stop_client();
 
     boost::asio::io_context& io_context_;
     UdpClient& client_;
+    InputTraceWriter* trace_;
     sf::Window window_;
     std::unordered_map<sf::Event::EventType,
                        std::function<void(const sf::Event&)>>
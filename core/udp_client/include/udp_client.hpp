@@ -1,7 +1,24 @@
 #ifndef UDP_CLIENT_HPP
 #define UDP_CLIENT_HPP
 
+#include <array>
 #include <boost/asio.hpp>
+#include <string_view>
+
+#include "arrival_recorder.hpp"
+#include "datagram_receiver.hpp"
+#include "dscp.hpp"
+#include "fec_decoder.hpp"
+#include "input_messages.hpp"
+#include "jitter_buffer.hpp"
+#include "latency_profile.hpp"
+#include "loss_estimator.hpp"
+#include "metrics.hpp"
+#include "nack_tracker.hpp"
+#include "packet_pool.hpp"
+#include "rtcp_feedback.hpp"
+#include "socket_address.hpp"
+#include "vp8_depacketizer.hpp"
 
 using boost::asio::ip::udp;
 
@@ -11,6 +28,17 @@ constexpr uint8_t TIMEOUT = 30;           // seconds
 /**
  * @class UdpClient
  * @brief UDP client for sending and receiving messages
+ *
+ * Video from the server is reassembled and played out through a jitter
+ * buffer. Lost packets are rebuilt from the server's parity packets when
+ * possible, requested again with RTCP generic NACKs while they can still
+ * be played, and a keyframe with a PLI once the stream cannot recover
+ * otherwise. The loss seen before repair is reported to the server, which
+ * sizes its parity to it, and the arrival time of every video datagram is
+ * fed back for the server's congestion control.
+ *
+ * Everything the client sends is small and waits on no video, so every
+ * datagram is marked with the DSCP of input.
  */
 class UdpClient {
    public:
@@ -21,10 +49,39 @@ class UdpClient {
      * @param local_port Local port to bind the UDP socket
      * @param server Server name or IP address
      * @param server_port Server port number
+     * @param profile Socket latency settings (default: none)
+     * @param timestamps Use kernel receive and ping transmit timestamps
+     * (default: false)
+     * @param max_video_latency Largest playout delay of the video jitter
+     * buffer (default: DEFAULT_MAX_LATENCY)
      */
     UdpClient(boost::asio::io_context& io_context,
               const unsigned short local_port, const std::string& server,
-              const std::string& server_port);
+              const std::string& server_port,
+              const LatencyProfile& profile = {},
+              const bool timestamps = false,
+              const std::chrono::milliseconds max_video_latency =
+                  DEFAULT_MAX_LATENCY);
+
+    /**
+     * @brief Construct a new UdpClient object for a server address already
+     * parsed
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param server Server address and port
+     * @param profile Socket latency settings (default: none)
+     * @param timestamps Use kernel receive and ping transmit timestamps
+     * (default: false)
+     * @param max_video_latency Largest playout delay of the video jitter
+     * buffer (default: DEFAULT_MAX_LATENCY)
+     */
+    UdpClient(boost::asio::io_context& io_context,
+              const unsigned short local_port, const SocketAddress& server,
+              const LatencyProfile& profile = {},
+              const bool timestamps = false,
+              const std::chrono::milliseconds max_video_latency =
+                  DEFAULT_MAX_LATENCY);
 
     /**
      * @brief Destroy the Udp Client object
@@ -33,32 +90,117 @@ class UdpClient {
     ~UdpClient();
 
     /**
-     * @brief Schedule a message to be sent with the event loop
+     * @brief Send a control message to the server. Safe to call from any
+     * thread and does not allocate.
      *
      * @param message Message to be sent
      */
-    void send_message(const std::string& message);
+    void send_message(std::string_view message);
+
+    /**
+     * @brief Serialize an input message into a pooled buffer and send it to
+     * the server. Safe to call from any thread and does not allocate.
+     *
+     * @param message Input message to be sent
+     */
+    void send_message(const InputMessages::Message& message);
+
+    /**
+     * @brief Receive and handle every datagram queued on the socket without
+     * blocking. Called by busy-poll loops; otherwise the io_context does.
+     *
+     * @return std::size_t Number of datagrams received
+     */
+    std::size_t poll_receive();
+
+    /**
+     * @brief Turn DSCP marking on or off. It is on from construction.
+     * Safe to call from any thread.
+     *
+     * @param enabled Mark datagrams with the DSCP of input
+     */
+    void set_dscp(const bool enabled);
 
    private:
+    bool send_packet(const PacketRef& packet, Metrics::ChannelCounters& stats,
+                     const bool timestamp = false);
+    void read_transmit_times();
     void start_receive();
-    void handle_receive(const boost::system::error_code& ec,
-                        const std::size_t bytes_recvd,
-                        const udp::endpoint& remote_endpoint);
-    bool validate_message(const std::string& message,
+    void handle_receive(const std::size_t bytes_recvd);
+    bool validate_message(std::string_view message,
                           const std::size_t bytes_recvd,
                           const udp::endpoint& remote_endpoint) const;
     bool validate_endpoint(const udp::endpoint& remote_endpoint) const;
     bool validate_message_size(const std::size_t bytes_recvd) const;
-    void handle_response(const std::string& message);
-    void handle_pong();
+    void handle_response(std::string_view message);
+    void handle_pong(const int64_t server_receive_ns,
+                     const int64_t server_send_ns);
+    void send_probe_ack(const unsigned char* probe, const std::size_t size);
+    void handle_video(const unsigned char* data, const std::size_t size);
+    bool receive_media(const unsigned char* data, const std::size_t size,
+                       const JitterBuffer::Clock::time_point now);
+    void send_loss_report(const JitterBuffer::Clock::time_point now);
+    void send_transport_feedback(const JitterBuffer::Clock::time_point now);
+    void play_frames();
+    void send_nacks();
+    void send_pli();
     void start_ping();
 
     udp::socket socket_;
+    DatagramReceiver receiver_;
     udp::endpoint server_endpoint_;
     boost::asio::steady_timer timer_;
-    std::array<char, 1024> recv_buffer_;
+    boost::asio::steady_timer playout_timer_;
+    JitterBuffer::Clock::time_point playout_wakeup_;
+    boost::asio::steady_timer nack_timer_;
+    NackTracker::Clock::time_point nack_wakeup_;
+    PacketPool pool_;
+    PacketRef recv_packet_;
+    udp::endpoint remote_endpoint_;
     std::chrono::steady_clock::time_point last_pong_;
     std::chrono::steady_clock::time_point ping_time_;
+    bool timestamps_;
+    int64_t receive_ns_;
+    int64_t ping_sent_ns_;
+    uint32_t pings_sent_;
+    int64_t min_owd_up_ns_;
+    int64_t min_owd_down_ns_;
+    std::chrono::microseconds smoothed_rtt_;  // Zero until measured
+    Vp8Depacketizer depacketizer_;
+    JitterBuffer jitter_buffer_;
+    NackTracker nack_tracker_;
+    FecDecoder fec_decoder_;
+    LossEstimator loss_estimator_;
+    JitterBuffer::Clock::time_point last_loss_report_;
+    ArrivalRecorder arrival_recorder_;
+    JitterBuffer::Clock::time_point last_transport_feedback_;
+    ReceivedFrame received_frame_;
+    ReceivedFrame playout_frame_;
+    uint32_t feedback_ssrc_;
+    uint32_t video_ssrc_;
+    std::array<uint16_t, RtcpFeedback::MAX_NACK_ITEMS> nack_sequences_;
+    Metrics::ChannelCounters input_stats_;
+    Metrics::ChannelCounters control_stats_;
+    Metrics::ChannelCounters probe_stats_;
+    Metrics::ChannelCounters video_stats_;
+    Metrics::DropCounters drops_;
+    Metrics::Histogram& rtt_;
+    Metrics::Histogram& network_rtt_;
+    Metrics::Histogram& server_delay_;
+    Metrics::Histogram& owd_up_;
+    Metrics::Histogram& owd_down_;
+    Metrics::Histogram& queueing_;
+    Metrics::Gauge& video_jitter_;
+    Metrics::Gauge& video_delay_;
+    Metrics::Gauge& video_played_;
+    Metrics::Gauge& video_late_;
+    Metrics::Gauge& video_dropped_;
+    Metrics::Gauge& video_concealed_;
+    Metrics::Counter& keyframe_requests_;
+    Metrics::Counter& nacked_packets_;
+    Metrics::Gauge& recovered_packets_;
+    Metrics::Gauge& lost_packets_;
+    Metrics::Gauge& fec_rebuilt_packets_;
 };
 
 #endif  // UDP_CLIENT_HPP
@@ -5,9 +5,10 @@
 #include "common.hpp"
 
 InputCapture::InputCapture(boost::asio::io_context& io_context,
-                           UdpClient& client)
+                           UdpClient& client, InputTraceWriter* trace)
     : io_context_(io_context),
       client_(client),
+      trace_(trace),
       window_(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), WINDOW_TITLE) {}
 
 void InputCapture::run() {
@@ -46,29 +47,27 @@ void InputCapture::handle_event(const sf::Event& event) {
 void InputCapture::handle_close() { window_.close(); }
 
 void InputCapture::handle_key_event(const sf::Event& event) {
-    client_.send_message(
-        InputMessages::Message(event.type, event.key.code).to_string());
+    send(InputMessages::Message(event.type, event.key.code));
 }
 
 void InputCapture::handle_joystick_button_event(const sf::Event& event) {
-    client_.send_message(InputMessages::Message(event.type,
-                                                event.joystickButton.joystickId,
-                                                event.joystickButton.button)
-                             .to_string());
+    send(InputMessages::Message(event.type, event.joystickButton.joystickId,
+                                event.joystickButton.button));
 }
 
 void InputCapture::handle_joystick_moved(const sf::Event& event) {
-    client_.send_message(InputMessages::Message(event.type,
-                                                event.joystickButton.joystickId,
-                                                event.joystickMove.axis,
-                                                event.joystickMove.position)
-                             .to_string());
+    send(InputMessages::Message(event.type, event.joystickButton.joystickId,
+                                event.joystickMove.axis,
+                                event.joystickMove.position));
 }
 
 void InputCapture::handle_joystick_connect_event(const sf::Event& event) {
-    client_.send_message(
-        InputMessages::Message(event.type, event.joystickConnect.joystickId)
-            .to_string());
+    send(InputMessages::Message(event.type, event.joystickConnect.joystickId));
+}
+
+void InputCapture::send(const InputMessages::Message& message) {
+    if (trace_ != nullptr) trace_->record(message);
+    client_.send_message(message);
 }
 
 void InputCapture::stop_client() { io_context_.stop(); }
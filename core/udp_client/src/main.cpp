@@ -1,33 +1,76 @@
 #include <iostream>
 
 #include "common.hpp"
+#include "metrics.hpp"
 #include "input_capture.hpp"
+#include "input_trace.hpp"
+#include "socket_address.hpp"
 #include "udp_client.hpp"
 
 int main(int argc, char* argv[]) {
     try {
-        if (argc != 4 || std::strcmp(argv[1], "-p") != 0) {
+        if (argc < 4 || std::strcmp(argv[1], "-p") != 0) {
             throw std::invalid_argument(
                 "Invalid arguments. Usage: " + std::string(argv[0]) +
-                " -p <local_port> <peer_address> (IP:PORT)");
+                " -p <local_port> <peer_address> (IP:PORT or [IPv6]:PORT)"
+                " [--stats <interval_ms>] [--stats-socket <path>]"
+                " [--record <trace_path>] [--latency-profile [--cpu <n>]"
+                " [--busy-poll <us>] [--rt-priority <n>]"
+                " [--socket-buffer <bytes>]] [--timestamps]"
+                " [--video-latency <ms>] [--dscp <on|off>]");
         }
 
         if (!Common::validate_port(argv[2])) {
             throw std::invalid_argument("Invalid port number");
         }
 
-        if (!Common::validate_socket_string(argv[3])) {
+        SocketAddress peer_address;
+        if (!SocketAddress::try_parse(argv[3], peer_address)) {
             throw std::invalid_argument("Invalid peer address");
         }
 
         const uint16_t local_port = static_cast<uint16_t>(std::stoi(argv[2]));
-        auto [peer, peer_port] = Common::extract_ip_port(argv[3]);
+        const auto options = Common::parse_options(argc, argv, 4);
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            const auto socket = options.find("stats-socket");
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)),
+                socket != options.end() ? socket->second : "");
+        }
+
+        std::unique_ptr<InputTraceWriter> trace;
+        if (const auto it = options.find("record"); it != options.end()) {
+            trace = std::make_unique<InputTraceWriter>(it->second);
+        }
+
+        const auto profile = LatencyProfile::from_options(options);
+        std::chrono::milliseconds max_video_latency = DEFAULT_MAX_LATENCY;
+        if (const auto it = options.find("video-latency");
+            it != options.end()) {
+            max_video_latency =
+                std::chrono::milliseconds(std::stoi(it->second));
+        }
+
+        bool dscp = true;
+        if (const auto it = options.find("dscp"); it != options.end()) {
+            if (it->second == "off") {
+                dscp = false;
+            } else if (it->second != "on") {
+                throw std::invalid_argument("Invalid DSCP setting");
+            }
+        }
 
         boost::asio::io_context io_context;
-        UdpClient client(io_context, local_port, peer, peer_port);
-        InputCapture input_capture(io_context, client);
+        UdpClient client(io_context, local_port, peer_address, profile,
+                         options.count("timestamps") > 0, max_video_latency);
+        if (!dscp) client.set_dscp(false);
+        InputCapture input_capture(io_context, client, trace.get());
 
-        std::thread networking_thread([&io_context]() { io_context.run(); });
+        std::thread networking_thread([&io_context, &client, &profile]() {
+            profile.run(io_context, [&client]() { client.poll_receive(); });
+        });
         input_capture.run();
 
         networking_thread.join();
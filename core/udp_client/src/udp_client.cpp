@@ -1,16 +1,86 @@
 #include "udp_client.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <random>
+
+#include "control_channel.hpp"
+#include "dual_stack.hpp"
+#include "handler_pool.hpp"
+#include "logger.hpp"
+#include "packet_timestamps.hpp"
+#include "path_mtu.hpp"
+#include "ping_messages.hpp"
+#include "socket_address.hpp"
+
+namespace {
+
+constexpr int RTT_GAIN = 8;  // Smoothing as in RFC 6298
+
+}  // namespace
 
 UdpClient::UdpClient(boost::asio::io_context& io_context,
                      const unsigned short local_port, const std::string& server,
-                     const std::string& server_port)
-    : socket_(io_context, udp::endpoint(udp::v4(), local_port)),
-      server_endpoint_(*udp::resolver(io_context)
-                            .resolve(udp::v4(), server, server_port)
-                            .begin()),
+                     const std::string& server_port,
+                     const LatencyProfile& profile, const bool timestamps,
+                     const std::chrono::milliseconds max_video_latency)
+    : UdpClient(io_context, local_port,
+                SocketAddress::resolve_address(io_context, server, server_port),
+                profile, timestamps, max_video_latency) {}
+
+UdpClient::UdpClient(boost::asio::io_context& io_context,
+                     const unsigned short local_port,
+                     const SocketAddress& server,
+                     const LatencyProfile& profile, const bool timestamps,
+                     const std::chrono::milliseconds max_video_latency)
+    : socket_(DualStack::open_socket(io_context, local_port)),
+      receiver_(socket_),
+      server_endpoint_(
+          server.endpoint_for(socket_.local_endpoint().protocol())),
+      timer_(io_context),
+      playout_timer_(io_context),
+      nack_timer_(io_context),
+      pool_(PACKET_POOL_SIZE),
       last_pong_(std::chrono::steady_clock::now()),
-      timer_(io_context) {
+      timestamps_(timestamps),
+      receive_ns_(0),
+      ping_sent_ns_(0),
+      pings_sent_(0),
+      min_owd_up_ns_(std::numeric_limits<int64_t>::max()),
+      min_owd_down_ns_(std::numeric_limits<int64_t>::max()),
+      smoothed_rtt_(0),
+      jitter_buffer_(max_video_latency),
+      feedback_ssrc_(std::random_device()()),
+      video_ssrc_(0),
+      input_stats_("input"),
+      control_stats_("control"),
+      probe_stats_("pmtud"),
+      video_stats_("video"),
+      rtt_(Metrics::histogram("control.rtt_us")),
+      network_rtt_(Metrics::histogram("control.network_rtt_us")),
+      server_delay_(Metrics::histogram("control.server_delay_us")),
+      owd_up_(Metrics::histogram("control.owd_up_us")),
+      owd_down_(Metrics::histogram("control.owd_down_us")),
+      queueing_(Metrics::histogram("receive.queueing_us")),
+      video_jitter_(Metrics::gauge("video.jitter_us")),
+      video_delay_(Metrics::gauge("video.playout_delay_us")),
+      video_played_(Metrics::gauge("video.played_frames")),
+      video_late_(Metrics::gauge("video.late_frames")),
+      video_dropped_(Metrics::gauge("video.dropped_frames")),
+      video_concealed_(Metrics::gauge("video.concealed_frames")),
+      keyframe_requests_(Metrics::counter("video.keyframe_requests")),
+      nacked_packets_(Metrics::counter("video.nacked_packets")),
+      recovered_packets_(Metrics::gauge("video.recovered_packets")),
+      lost_packets_(Metrics::gauge("video.lost_packets")),
+      fec_rebuilt_packets_(Metrics::gauge("video.fec_rebuilt_packets")) {
+    profile.apply(socket_);
+    if (timestamps_ && !PacketTimestamps::enable(socket_)) {
+        LOG_WARNING("Kernel timestamps not supported, using send and "
+                    "receive times.");
+        timestamps_ = false;
+    }
+    set_dscp(true);
     start_receive();
     start_ping();
 }
@@ -19,44 +89,124 @@ UdpClient::~UdpClient() {
     if (socket_.is_open()) socket_.close();
 }
 
-void UdpClient::send_message(const std::string& message) {
-    socket_.async_send_to(boost::asio::buffer(message), server_endpoint_,
-                          [this, message](const boost::system::error_code& ec,
-                                          std::size_t /*bytes_sent*/) {
-                              if (ec) {
-                                  std::cerr << "Error: " << ec.message()
-                                            << std::endl;
-                              }
-                          });
+void UdpClient::set_dscp(const bool enabled) {
+    // One mark for all: the input thread and the io thread both send
+    const uint8_t dscp =
+        enabled ? Dscp::for_class(TrafficClass::INPUT) : Dscp::BEST_EFFORT;
+    if (!Dscp::set(socket_, dscp)) {
+        LOG_WARNING("Cannot set DSCP, sending unmarked.");
+    }
 }
 
-void UdpClient::start_receive() {
-    auto remote_endpoint = std::make_shared<udp::endpoint>();
-    socket_.async_receive_from(
-        boost::asio::buffer(recv_buffer_), *remote_endpoint,
-        [this, remote_endpoint](const boost::system::error_code& ec,
-                                std::size_t bytes_recvd) {
-            handle_receive(ec, bytes_recvd, *remote_endpoint);
-        });
-}
-
-void UdpClient::handle_receive(const boost::system::error_code& ec,
-                               const std::size_t bytes_recvd,
-                               const udp::endpoint& remote_endpoint) {
-    if (ec) {
-        std::cerr << "Error: " << ec.message() << std::endl;
+void UdpClient::send_message(std::string_view message) {
+    PacketRef packet = pool_.acquire();
+    if (!packet) {
+        LOG_ERROR("Packet pool exhausted, dropping message.");
         return;
     }
 
-    const std::string message(recv_buffer_.data(), bytes_recvd);
-    start_receive();  // Receiving the next message after flushing the buffer
+    const std::size_t size = std::min(message.size(), packet->capacity());
+    std::memcpy(packet->data(), message.data(), size);
+    packet->set_size(size);
+    send_packet(packet, control_stats_);
+}
+
+void UdpClient::send_message(const InputMessages::Message& message) {
+    PacketRef packet = pool_.acquire();
+    if (!packet) {
+        LOG_ERROR("Packet pool exhausted, dropping message.");
+        return;
+    }
+
+    packet->set_size(message.serialize(reinterpret_cast<char*>(packet->data()),
+                                       packet->capacity()));
+    send_packet(packet, input_stats_);
+}
+
+bool UdpClient::send_packet(const PacketRef& packet,
+                            Metrics::ChannelCounters& stats,
+                            const bool timestamp) {
+    // Sent synchronously: callers include the input thread, where an async
+    // send would allocate an operation per packet outside the io thread.
+    boost::system::error_code ec;
+    const std::size_t bytes_sent =
+        timestamp && timestamps_
+            ? PacketTimestamps::send_to(socket_, packet.payload(),
+                                        server_endpoint_, ec)
+            : socket_.send_to(packet.payload(), server_endpoint_, 0, ec);
+    if (ec) {
+        LOG_ERROR("Error: ", ec.message());
+        return false;
+    }
+    stats.sent(bytes_sent);
+    return true;
+}
+
+void UdpClient::start_receive() {
+    socket_.async_wait(udp::socket::wait_read,
+                       pooled([this](const boost::system::error_code& ec) {
+                           if (ec) {
+                               LOG_ERROR("Error: ", ec.message());
+                               return;
+                           }
+                           poll_receive();
+                           start_receive();
+                       }));
+}
 
-    if (validate_message(message, bytes_recvd, remote_endpoint)) {
-        handle_response(message);
+void UdpClient::read_transmit_times() {
+    uint32_t id = 0;
+    int64_t time_ns = 0;
+    while (PacketTimestamps::read_transmit(socket_, id, time_ns)) {
+        // Only pings request a timestamp, numbered in the order sent
+        if (id == pings_sent_ - 1) ping_sent_ns_ = time_ns;
     }
 }
 
-bool UdpClient::validate_message(const std::string& /* message */,
+std::size_t UdpClient::poll_receive() {
+    // Queued transmit timestamps keep the socket ready until read
+    if (timestamps_) read_transmit_times();
+
+    std::size_t received = 0;
+    for (;;) {
+        if (!recv_packet_) {
+            recv_packet_ = pool_.acquire();
+            if (!recv_packet_) {
+                LOG_ERROR("Packet pool exhausted, receiving paused.");
+                return received;
+            }
+        }
+
+        boost::system::error_code ec;
+        const std::size_t bytes_recvd =
+            receiver_.receive(recv_packet_.writable(), remote_endpoint_, ec);
+        if (ec == boost::asio::error::would_block) return received;
+        if (ec) {
+            LOG_ERROR("Error: ", ec.message());
+            return received;
+        }
+        handle_receive(bytes_recvd);
+        ++received;
+    }
+}
+
+void UdpClient::handle_receive(const std::size_t bytes_recvd) {
+    const PacketRef packet = std::move(recv_packet_);
+    const udp::endpoint remote_endpoint = remote_endpoint_;
+    packet->set_size(bytes_recvd);
+    receive_ns_ = receiver_.receive_time();
+    if (timestamps_) {
+        // Time spent queued in the socket before the handler ran
+        queueing_.record(PacketTimestamps::elapsed_us(
+            receive_ns_, PacketTimestamps::now_ns()));
+    }
+
+    if (validate_message(packet->view(), bytes_recvd, remote_endpoint)) {
+        handle_response(packet->view());
+    }
+}
+
+bool UdpClient::validate_message(std::string_view /* message */,
                                  const std::size_t bytes_recvd,
                                  const udp::endpoint& remote_endpoint) const {
     if (!validate_endpoint(remote_endpoint)) return false;
@@ -67,49 +217,303 @@ bool UdpClient::validate_message(const std::string& /* message */,
 
 bool UdpClient::validate_endpoint(const udp::endpoint& remote_endpoint) const {
     if (remote_endpoint != server_endpoint_) {
-        std::cerr << "Received message from unknown endpoint: "
-                  << remote_endpoint << std::endl;
+        LOG_WARNING("Received message from unknown endpoint: ",
+                    remote_endpoint);
+        drops_.unknown_endpoint.add();
         return false;
     }
     return true;
 }
 
 bool UdpClient::validate_message_size(const std::size_t bytes_recvd) const {
-    if (bytes_recvd > recv_buffer_.size()) {
-        std::cerr << "Received message too large." << std::endl;
+    if (bytes_recvd > PacketBuffer::CAPACITY) {
+        LOG_WARNING("Received message too large.");
+        drops_.bad_size.add();
         return false;
     }
 
     if (bytes_recvd == 0) {
-        std::cerr << "Received empty message." << std::endl;
+        LOG_WARNING("Received empty message.");
+        drops_.bad_size.add();
         return false;
     }
 
     return true;
 }
 
-void UdpClient::handle_response(const std::string& message) {
-    if (message == "pong") handle_pong();
+void UdpClient::handle_response(std::string_view message) {
+    const auto* data = reinterpret_cast<const unsigned char*>(message.data());
+    if (Rtp::is_rtp(data, message.size())) {
+        handle_video(data, message.size());
+        return;
+    }
+    if (PathMtu::is_message(data, message.size(), PathMtu::PROBE)) {
+        probe_stats_.received(message.size());
+        send_probe_ack(data, message.size());
+        return;
+    }
+
+    int64_t server_receive_ns = 0;
+    int64_t server_send_ns = 0;
+    if (!PingMessages::read_pong(message, server_receive_ns, server_send_ns)) {
+        drops_.parse_error.add();
+        return;
+    }
+
+    control_stats_.received(message.size());
+    handle_pong(server_receive_ns, server_send_ns);
 }
 
-void UdpClient::handle_pong() {
+void UdpClient::handle_pong(const int64_t server_receive_ns,
+                            const int64_t server_send_ns) {
     last_pong_ = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         last_pong_ - ping_time_);
-    std::cout << elapsed.count() << std::endl;
+    rtt_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            last_pong_ - ping_time_)
+            .count()));
+    ControlChannel::send(elapsed.count());
+
+    // Round trip for retransmissions, which frames behind a loss wait for
+    // as long as the latency allows
+    const auto sample = std::chrono::duration_cast<std::chrono::microseconds>(
+        last_pong_ - ping_time_);
+    smoothed_rtt_ = smoothed_rtt_.count() == 0
+                        ? sample
+                        : smoothed_rtt_ + (sample - smoothed_rtt_) / RTT_GAIN;
+    const auto loss_wait = smoothed_rtt_ + DEFAULT_REORDER_GRACE;
+    jitter_buffer_.set_loss_wait(loss_wait <= jitter_buffer_.max_latency()
+                                     ? loss_wait
+                                     : std::chrono::microseconds(0));
+
+    // Round trip without the server's own delay, as in NTP
+    const int64_t server_delay = server_send_ns - server_receive_ns;
+    server_delay_.record(
+        PacketTimestamps::elapsed_us(server_receive_ns, server_send_ns));
+    network_rtt_.record(PacketTimestamps::elapsed_us(
+        ping_sent_ns_ + server_delay, receive_ns_));
+
+    // The clocks are not synchronized, so one-way delays are only
+    // meaningful as changes: report them above the smallest seen
+    const int64_t owd_up = server_receive_ns - ping_sent_ns_;
+    const int64_t owd_down = receive_ns_ - server_send_ns;
+    min_owd_up_ns_ = std::min(min_owd_up_ns_, owd_up);
+    min_owd_down_ns_ = std::min(min_owd_down_ns_, owd_down);
+    owd_up_.record(PacketTimestamps::elapsed_us(min_owd_up_ns_, owd_up));
+    owd_down_.record(PacketTimestamps::elapsed_us(min_owd_down_ns_, owd_down));
+}
+
+void UdpClient::handle_video(const unsigned char* data,
+                             const std::size_t size) {
+    video_stats_.received(size);
+    const auto now = JitterBuffer::Clock::now();
+    Rtp::Header header;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+    if (!Rtp::read_header(data, size, header, payload_offset, payload_size)) {
+        drops_.parse_error.add();
+        return;
+    }
+
+    uint16_t transport_sequence = 0;
+    if (Rtp::read_transport_sequence(data, size, transport_sequence)) {
+        arrival_recorder_.on_packet(transport_sequence, now);
+    }
+
+    // Rebuilt packets go the same way as received ones, but were lost
+    const std::vector<boost::asio::const_buffer>* rebuilt = nullptr;
+    if (header.payload_type == Fec::PAYLOAD_TYPE) {
+        rebuilt = &fec_decoder_.push_parity(data, size);
+    } else {
+        video_ssrc_ = header.ssrc;
+        if (!receive_media(data, size, now)) {
+            loss_estimator_.on_packet(header.sequence);
+        }
+        rebuilt = &fec_decoder_.push_media(data, size);
+    }
+    for (const boost::asio::const_buffer& packet : *rebuilt) {
+        receive_media(static_cast<const unsigned char*>(packet.data()),
+                      packet.size(), now);
+    }
+    fec_rebuilt_packets_.set(static_cast<int64_t>(fec_decoder_.rebuilt()));
+
+    if (now - last_loss_report_ >= LOSS_REPORT_INTERVAL) {
+        send_loss_report(now);
+    }
+    if (now - last_transport_feedback_ >= TRANSPORT_FEEDBACK_INTERVAL) {
+        send_transport_feedback(now);
+    }
+    play_frames();
+    send_nacks();
+}
+
+bool UdpClient::receive_media(const unsigned char* data,
+                              const std::size_t size,
+                              const JitterBuffer::Clock::time_point now) {
+    Rtp::Header header;
+    std::size_t payload_offset = 0;
+    std::size_t payload_size = 0;
+    bool retransmitted = false;
+    if (Rtp::read_header(data, size, header, payload_offset, payload_size)) {
+        retransmitted = nack_tracker_.on_packet(header, now);
+    }
+    if (depacketizer_.push(data, size, received_frame_)) {
+        jitter_buffer_.insert(received_frame_, now, retransmitted);
+    }
+    return retransmitted;
+}
+
+void UdpClient::play_frames() {
+    // No decoder yet: frames are released on schedule and counted
+    const auto now = JitterBuffer::Clock::now();
+    while (jitter_buffer_.pop(now, playout_frame_)) {
+    }
+
+    video_jitter_.set(jitter_buffer_.jitter().count());
+    video_delay_.set(jitter_buffer_.target_delay().count());
+    video_played_.set(static_cast<int64_t>(jitter_buffer_.delivered()));
+    video_late_.set(static_cast<int64_t>(jitter_buffer_.late()));
+    video_dropped_.set(static_cast<int64_t>(jitter_buffer_.dropped()));
+    video_concealed_.set(static_cast<int64_t>(jitter_buffer_.concealed()));
+    if (jitter_buffer_.take_keyframe_request(now)) send_pli();
+
+    // Wake up for the next frame unless already set to wake up before it
+    JitterBuffer::Clock::time_point due;
+    if (!jitter_buffer_.next_playout(due)) return;
+    if (playout_wakeup_ > now && playout_wakeup_ <= due) return;
+
+    playout_wakeup_ = due;
+    playout_timer_.expires_at(due);
+    playout_timer_.async_wait(
+        pooled([this](const boost::system::error_code& ec) {
+            if (!ec) play_frames();
+        }));
+}
+
+void UdpClient::send_nacks() {
+    // Without a round trip there is no telling whether a retransmission
+    // would arrive in time
+    if (smoothed_rtt_.count() == 0) return;
+
+    const auto now = NackTracker::Clock::now();
+    const std::size_t count =
+        nack_tracker_.poll(now, smoothed_rtt_, jitter_buffer_,
+                           nack_sequences_.data(), nack_sequences_.size());
+    recovered_packets_.set(static_cast<int64_t>(nack_tracker_.recovered()));
+    lost_packets_.set(static_cast<int64_t>(nack_tracker_.expired()));
+    if (count > 0) {
+        PacketRef packet = pool_.acquire();
+        if (packet) {
+            std::size_t written = 0;
+            packet->set_size(RtcpFeedback::write_nack(
+                feedback_ssrc_, video_ssrc_, nack_sequences_.data(), count,
+                packet->data(), written));
+            send_packet(packet, video_stats_);
+            nacked_packets_.add(written);
+        } else {
+            LOG_ERROR("Packet pool exhausted, dropping NACK.");
+        }
+    }
+
+    // Wake up for the next request unless already set to wake up before it
+    NackTracker::Clock::time_point due;
+    if (!nack_tracker_.next_poll(due)) return;
+    if (nack_wakeup_ > now && nack_wakeup_ <= due) return;
+
+    nack_wakeup_ = due;
+    nack_timer_.expires_at(due);
+    nack_timer_.async_wait(pooled([this](const boost::system::error_code& ec) {
+        if (!ec) send_nacks();
+    }));
+}
+
+void UdpClient::send_pli() {
+    PacketRef packet = pool_.acquire();
+    if (!packet) {
+        LOG_ERROR("Packet pool exhausted, dropping keyframe request.");
+        return;
+    }
+
+    packet->set_size(
+        RtcpFeedback::write_pli(feedback_ssrc_, video_ssrc_, packet->data()));
+    send_packet(packet, video_stats_);
+    keyframe_requests_.add();
+}
+
+void UdpClient::send_loss_report(const JitterBuffer::Clock::time_point now) {
+    last_loss_report_ = now;
+    double loss_rate = 0;
+    double mean_burst = 1;
+    if (!loss_estimator_.report(loss_rate, mean_burst)) return;
+
+    PacketRef packet = pool_.acquire();
+    if (!packet) {
+        LOG_ERROR("Packet pool exhausted, dropping loss report.");
+        return;
+    }
+
+    packet->set_size(RtcpFeedback::write_loss_report(
+        feedback_ssrc_, loss_rate, mean_burst, packet->data()));
+    send_packet(packet, video_stats_);
+}
+
+void UdpClient::send_transport_feedback(
+    const JitterBuffer::Clock::time_point now) {
+    last_transport_feedback_ = now;
+    for (;;) {
+        PacketRef packet = pool_.acquire();
+        if (!packet) {
+            LOG_ERROR("Packet pool exhausted, dropping transport feedback.");
+            return;
+        }
+
+        const std::size_t size = arrival_recorder_.write_feedback(
+            feedback_ssrc_, video_ssrc_, packet->data());
+        if (size == 0) return;
+        packet->set_size(size);
+        send_packet(packet, video_stats_);
+    }
+}
+
+void UdpClient::send_probe_ack(const unsigned char* probe,
+                               const std::size_t size) {
+    PacketRef packet = pool_.acquire();
+    if (!packet) {
+        LOG_ERROR("Packet pool exhausted, dropping probe ack.");
+        return;
+    }
+
+    PathMtu::build_ack(probe, size, packet->data());
+    packet->set_size(PathMtu::ACK_SIZE);
+    send_packet(packet, probe_stats_);
 }
 
 void UdpClient::start_ping() {
     ping_time_ = std::chrono::steady_clock::now();
     if (std::chrono::duration_cast<std::chrono::seconds>(
             ping_time_ - last_pong_) > std::chrono::seconds(TIMEOUT)) {
-        std::cerr << "Connection timed out." << std::endl;
+        LOG_ERROR("Connection timed out.");
         return;
     }
 
-    send_message("ping");
+    PacketRef packet = pool_.acquire();
+    if (packet) {
+        std::memcpy(packet->data(), PingMessages::PING.data(),
+                    PingMessages::PING.size());
+        packet->set_size(PingMessages::PING.size());
+        // Replaced by the kernel's transmit time once it is read back
+        ping_sent_ns_ = PacketTimestamps::now_ns();
+        // The kernel numbers only datagrams that went out
+        if (send_packet(packet, control_stats_, true) && timestamps_) {
+            ++pings_sent_;
+        }
+    } else {
+        LOG_ERROR("Packet pool exhausted, dropping ping.");
+    }
+
     timer_.expires_after(std::chrono::milliseconds(PING_INTERVAL));
-    timer_.async_wait([this](const boost::system::error_code& ec) {
+    timer_.async_wait(pooled([this](const boost::system::error_code& ec) {
         if (!ec) start_ping();
-    });
+    }));
 }
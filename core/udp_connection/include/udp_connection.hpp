@@ -2,20 +2,48 @@
 #define UDP_CONNECTION_HPP
 
 #include <boost/asio.hpp>
+#include <optional>
+#include <vector>
+
+#include "metrics.hpp"
+#include "relay_protocol.hpp"
+#include "socket_address.hpp"
 
 using boost::asio::ip::udp;
 
 constexpr uint16_t PING_INTERVAL = 1000;  // milliseconds
 constexpr uint8_t TIMEOUT = 30;           // seconds
+constexpr uint16_t CONNECTION_ATTEMPT_DELAY = 250;  // milliseconds, RFC 8305
+constexpr uint8_t RELAY_FALLBACK_DELAY = 5;         // seconds
+
+/**
+ * @struct RelayOptions
+ * @brief Relay server to fall back to when no direct path answers.
+ */
+struct RelayOptions {
+    SocketAddress server;  // Control address of the relay
+    RelayToken token;      // Session token shared with the peer
+};
 
 /**
  * @class UdpPeer
  * @brief UDP peer for sending and receiving messages
+ *
+ * The peer may be reachable at several addresses, typically a native IPv6
+ * one and a NATed IPv4 one. Until a path is selected, each ping round is
+ * sent to every candidate in turn, IPv6 first and CONNECTION_ATTEMPT_DELAY
+ * apart (happy eyeballs, RFC 8305). The first candidate to answer becomes
+ * the only path for the rest of the session.
+ *
+ * If a relay is configured and no candidate has answered after
+ * RELAY_FALLBACK_DELAY, a relay port is allocated and bound for the session
+ * and added as one more candidate, so both sides end up talking through it.
  */
 class UdpPeer {
    public:
     /**
-     * @brief Construct a new UdpPeer object
+     * @brief Construct a new UdpPeer object. Every address the peer name
+     * resolves to becomes a candidate path.
      *
      * @param io_context Boost ASIO context
      * @param local_port Local port to bind the UDP socket
@@ -26,18 +54,50 @@ class UdpPeer {
             const unsigned short local_port, const std::string& peer,
             const std::string& peer_port);
 
+    /**
+     * @brief Construct a new UdpPeer object racing several peer addresses
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param candidates Addresses the peer may be reachable at
+     * @param relay Relay to fall back to (default: none)
+     *
+     * @throws std::invalid_argument If no candidate is usable on the socket.
+     */
+    UdpPeer(boost::asio::io_context& io_context,
+            const unsigned short local_port,
+            const std::vector<SocketAddress>& candidates,
+            const std::optional<RelayOptions>& relay = std::nullopt);
+
     /**
      * @brief Destroy the Udp Peer object
      */
     ~UdpPeer();
 
    private:
+    /**
+     * @brief Candidate path to the peer
+     */
+    struct Candidate {
+        udp::endpoint endpoint;
+        std::chrono::steady_clock::time_point send_time;
+    };
+
+    UdpPeer(boost::asio::io_context& io_context,
+            const unsigned short local_port);
+
+    void start(std::vector<udp::endpoint> endpoints);
+    void send_candidate(const std::size_t index);
+    void select_candidate(const udp::endpoint& remote_endpoint);
+    const Candidate* find_candidate(const udp::endpoint& endpoint) const;
+    void send_relay_request();
+    bool handle_relay_message(const std::size_t bytes_recvd,
+                              const udp::endpoint& remote_endpoint);
     void start_send();
     void start_receive();
     void start_listener();
     void handle_receive(const boost::system::error_code& ec,
-                        const std::size_t bytes_recvd,
-                        const udp::endpoint& remote_endpoint);
+                        const std::size_t bytes_recvd);
     void handle_input(const std::string& input);
     bool validate_message(const int message, const std::size_t bytes_recvd,
                           const udp::endpoint& remote_endpoint) const;
@@ -50,15 +110,30 @@ class UdpPeer {
                                const udp::endpoint& remote_endpoint);
     void reset_ping(const int signal);
     void send_message(const int message, const udp::endpoint& endpoint);
+    void send_datagram(const boost::asio::const_buffer& data,
+                       const udp::endpoint& endpoint);
 
     udp::socket socket_;
     udp::endpoint endpoint_;
+    std::vector<Candidate> candidates_;
+    bool selected_;
+    bool relay_enabled_;
+    bool relay_bound_;
+    RelayToken relay_token_;
+    udp::endpoint relay_control_;
+    udp::endpoint relay_endpoint_;
+    std::chrono::steady_clock::time_point start_time_;
+    udp::endpoint remote_endpoint_;
     int message_;
-    std::array<int, 1> recv_buffer_;
+    std::array<unsigned char, RelayProtocol::MAX_MESSAGE_SIZE> recv_buffer_;
     std::chrono::steady_clock::time_point send_time_;
     std::chrono::steady_clock::time_point last_receive_;
     boost::asio::steady_timer timer_;
+    boost::asio::steady_timer race_timer_;
     std::thread listener_thread_;
+    Metrics::ChannelCounters control_stats_;
+    Metrics::DropCounters drops_;
+    Metrics::Histogram& rtt_;
 };
 
 #endif  // UDP_CONNECTION_HPP
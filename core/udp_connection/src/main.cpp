@@ -1,29 +1,68 @@
 #include <iostream>
 
 #include "common.hpp"
+#include "metrics.hpp"
+#include "socket_address.hpp"
 #include "udp_connection.hpp"
 
 int main(int argc, char* argv[]) {
     try {
-        if (argc != 4 || std::strcmp(argv[1], "-p") != 0) {
+        if (argc < 4 || std::strcmp(argv[1], "-p") != 0) {
             throw std::invalid_argument(
                 "Invalid arguments. Usage: " + std::string(argv[0]) +
-                " -p <local_port> <peer_address> (IP:PORT)");
+                " -p <local_port> <peer_address> (IP:PORT or [IPv6]:PORT)"
+                " [--alt-peer <peer_address>]"
+                " [--relay <relay_address> --relay-token <token>]"
+                " [--stats <interval_ms>] [--stats-socket <path>]");
         }
 
         if (!Common::validate_port(argv[2])) {
             throw std::invalid_argument("Invalid port number");
         }
 
-        if (!Common::validate_socket_string(argv[3])) {
+        SocketAddress peer_address;
+        if (!SocketAddress::try_parse(argv[3], peer_address)) {
             throw std::invalid_argument("Invalid peer address");
         }
 
         const uint16_t local_port = static_cast<uint16_t>(std::stoi(argv[2]));
-        auto [peer, peer_port] = Common::extract_ip_port(argv[3]);
+        const auto options = Common::parse_options(argc, argv, 4);
+
+        // Another address of the same peer, raced against the first one
+        std::vector<SocketAddress> candidates = {peer_address};
+        if (const auto it = options.find("alt-peer"); it != options.end()) {
+            SocketAddress alt_address;
+            if (!SocketAddress::try_parse(it->second, alt_address)) {
+                throw std::invalid_argument("Invalid alternative peer address");
+            }
+            candidates.push_back(alt_address);
+        }
+
+        // Relay to fall back to when neither side can reach the other
+        std::optional<RelayOptions> relay;
+        if (const auto it = options.find("relay"); it != options.end()) {
+            RelayOptions relay_options;
+            const auto token = options.find("relay-token");
+            if (!SocketAddress::try_parse(it->second, relay_options.server)) {
+                throw std::invalid_argument("Invalid relay address");
+            }
+            if (token == options.end() ||
+                !RelayToken::try_parse(token->second, relay_options.token)) {
+                throw std::invalid_argument("Missing or invalid relay token");
+            }
+            relay = relay_options;
+        }
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            const auto socket = options.find("stats-socket");
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)),
+                socket != options.end() ? socket->second : "");
+        }
 
         boost::asio::io_context io_context;
-        UdpPeer udp_peer(io_context, local_port, peer, peer_port);
+        UdpPeer udp_peer(io_context, local_port, candidates, relay);
         io_context.run();
     } catch (std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
@@ -1,24 +1,58 @@
 #include "udp_connection.hpp"
 
+#include <cstring>
 #include <iostream>
 
 #include "common.hpp"
+#include "control_channel.hpp"
+#include "dual_stack.hpp"
+#include "logger.hpp"
 
 using namespace StreamMessages;
 
+UdpPeer::UdpPeer(boost::asio::io_context& io_context,
+                 const unsigned short local_port)
+    : socket_(DualStack::open_socket(io_context, local_port)),
+      selected_(false),
+      relay_enabled_(false),
+      relay_bound_(false),
+      start_time_(std::chrono::steady_clock::now()),
+      message_(PING),
+      last_receive_(std::chrono::steady_clock::now()),
+      timer_(io_context),
+      race_timer_(io_context),
+      control_stats_("control"),
+      rtt_(Metrics::histogram("control.rtt_us")) {}
+
 UdpPeer::UdpPeer(boost::asio::io_context& io_context,
                  const unsigned short local_port, const std::string& peer,
                  const std::string& peer_port)
-    : socket_(io_context, udp::endpoint(udp::v4(), local_port)),
-      timer_(io_context),
-      endpoint_(*udp::resolver(io_context)
-                     .resolve(udp::v4(), peer, peer_port)
-                     .begin()),
-      last_receive_(std::chrono::steady_clock::now()),
-      message_(PING) {
-    start_send();
-    start_receive();
-    start_listener();
+    : UdpPeer(io_context, local_port) {
+    start(SocketAddress::resolve_all(io_context, peer, peer_port,
+                                     socket_.local_endpoint().protocol()));
+}
+
+UdpPeer::UdpPeer(boost::asio::io_context& io_context,
+                 const unsigned short local_port,
+                 const std::vector<SocketAddress>& candidates,
+                 const std::optional<RelayOptions>& relay)
+    : UdpPeer(io_context, local_port) {
+    const udp protocol = socket_.local_endpoint().protocol();
+    if (relay && relay->server.usable_with(protocol)) {
+        relay_enabled_ = true;
+        relay_token_ = relay->token;
+        relay_control_ = relay->server.to_endpoint(protocol);
+    } else if (relay) {
+        LOG_WARNING("Relay address not usable on this socket, ignoring it.");
+    }
+
+    std::vector<udp::endpoint> endpoints;
+    for (const auto& candidate : candidates) {
+        if (candidate.usable_with(protocol)) {
+            endpoints.push_back(candidate.to_endpoint(protocol));
+        }
+    }
+    start(std::move(endpoints));
 }
 
 UdpPeer::~UdpPeer() {
@@ -26,15 +60,80 @@ UdpPeer::~UdpPeer() {
     if (listener_thread_.joinable()) listener_thread_.join();
 }
 
+void UdpPeer::start(std::vector<udp::endpoint> endpoints) {
+    if (endpoints.empty()) {
+        throw std::invalid_argument("No usable peer address");
+    }
+
+    // Interleave the address families, IPv6 first (RFC 8305, section 4)
+    std::vector<udp::endpoint> v6;
+    std::vector<udp::endpoint> v4;
+    for (const auto& endpoint : endpoints) {
+        (SocketAddress::from_endpoint(endpoint).is_v6() ? v6 : v4)
+            .push_back(endpoint);
+    }
+    for (std::size_t i = 0; i < std::max(v6.size(), v4.size()); ++i) {
+        if (i < v6.size()) candidates_.push_back({v6[i], {}});
+        if (i < v4.size()) candidates_.push_back({v4[i], {}});
+    }
+
+    endpoint_ = candidates_.front().endpoint;
+    selected_ = candidates_.size() == 1 && !relay_enabled_;
+
+    start_send();
+    start_receive();
+    start_listener();
+}
+
+void UdpPeer::send_candidate(const std::size_t index) {
+    Candidate& candidate = candidates_[index];
+    candidate.send_time = std::chrono::steady_clock::now();
+    send_message(message_, candidate.endpoint);
+    if (index + 1 == candidates_.size()) return;
+
+    race_timer_.expires_after(
+        std::chrono::milliseconds(CONNECTION_ATTEMPT_DELAY));
+    race_timer_.async_wait(
+        [this, index](const boost::system::error_code& ec) {
+            if (!ec && !selected_) send_candidate(index + 1);
+        });
+}
+
+void UdpPeer::select_candidate(const udp::endpoint& remote_endpoint) {
+    send_time_ = find_candidate(remote_endpoint)->send_time;
+    endpoint_ = remote_endpoint;
+    selected_ = true;
+    race_timer_.cancel();
+    LOG_INFO("Selected path to peer: ", remote_endpoint,
+             remote_endpoint == relay_endpoint_ ? " (relayed)" : "");
+}
+
+const UdpPeer::Candidate* UdpPeer::find_candidate(
+    const udp::endpoint& endpoint) const {
+    for (const auto& candidate : candidates_) {
+        if (candidate.endpoint == endpoint) return &candidate;
+    }
+    return nullptr;
+}
+
 void UdpPeer::start_send() {
     send_time_ = std::chrono::steady_clock::now();
     if (std::chrono::duration_cast<std::chrono::seconds>(
             send_time_ - last_receive_) > std::chrono::seconds(TIMEOUT)) {
-        std::cerr << "Connection timed out." << std::endl;
+        LOG_ERROR("Connection timed out.");
         return;
     }
 
-    send_message(message_, endpoint_);
+    if (selected_) {
+        send_message(message_, endpoint_);
+    } else {
+        send_candidate(0);
+        if (relay_enabled_ && !relay_bound_ &&
+            send_time_ - start_time_ >=
+                std::chrono::seconds(RELAY_FALLBACK_DELAY)) {
+            send_relay_request();
+        }
+    }
     timer_.expires_after(std::chrono::milliseconds(PING_INTERVAL));
     timer_.async_wait([this](const boost::system::error_code& ec) {
         if (!ec) start_send();
@@ -42,12 +141,10 @@ void UdpPeer::start_send() {
 }
 
 void UdpPeer::start_receive() {
-    auto remote_endpoint = std::make_shared<udp::endpoint>();
     socket_.async_receive_from(
-        boost::asio::buffer(recv_buffer_), *remote_endpoint,
-        [this, remote_endpoint](const boost::system::error_code& ec,
-                                std::size_t bytes_recvd) {
-            handle_receive(ec, bytes_recvd, *remote_endpoint);
+        boost::asio::buffer(recv_buffer_), remote_endpoint_,
+        [this](const boost::system::error_code& ec, std::size_t bytes_recvd) {
+            handle_receive(ec, bytes_recvd);
         });
 }
 
@@ -61,16 +158,23 @@ void UdpPeer::start_listener() {
 }
 
 void UdpPeer::handle_receive(const boost::system::error_code& ec,
-                             const std::size_t bytes_recvd,
-                             const udp::endpoint& remote_endpoint) {
+                             const std::size_t bytes_recvd) {
     if (ec) {
-        std::cerr << "Error: " << ec.message() << std::endl;
+        LOG_ERROR("Error: ", ec.message());
         return;
     }
 
-    int message = recv_buffer_[0];
-    if (validate_message(message, bytes_recvd, remote_endpoint)) {
-        handle_response(message, remote_endpoint);
+    if (relay_enabled_ && handle_relay_message(bytes_recvd, remote_endpoint_)) {
+        start_receive();
+        return;
+    }
+
+    int message = 0;
+    std::memcpy(&message, recv_buffer_.data(),
+                std::min(bytes_recvd, sizeof(message)));
+    if (validate_message(message, bytes_recvd, remote_endpoint_)) {
+        control_stats_.received(bytes_recvd);
+        handle_response(message, remote_endpoint_);
     }
 
     start_receive();
@@ -79,7 +183,7 @@ void UdpPeer::handle_receive(const boost::system::error_code& ec,
 void UdpPeer::handle_input(const std::string& input) {
     auto it = SIGNAL_TO_UDP_MAP.find(input);
     if (it == SIGNAL_TO_UDP_MAP.end()) {
-        std::cerr << "Unknown command: " << input << std::endl;
+        LOG_WARNING("Unknown command: ", input);
         return;
     }
 
@@ -95,9 +199,12 @@ bool UdpPeer::validate_message(const int message, const std::size_t bytes_recvd,
 }
 
 bool UdpPeer::validate_endpoint(const udp::endpoint& remote_endpoint) const {
-    if (remote_endpoint != endpoint_) {
-        std::cerr << "Received message from unknown endpoint: "
-                  << remote_endpoint << std::endl;
+    const bool known = selected_ ? remote_endpoint == endpoint_
+                                 : find_candidate(remote_endpoint) != nullptr;
+    if (!known) {
+        LOG_WARNING("Received message from unknown endpoint: ",
+                    remote_endpoint);
+        drops_.unknown_endpoint.add();
         return false;
     }
     return true;
@@ -105,7 +212,8 @@ bool UdpPeer::validate_endpoint(const udp::endpoint& remote_endpoint) const {
 
 bool UdpPeer::validate_message_size(const std::size_t bytes_recvd) const {
     if (bytes_recvd != sizeof(int)) {
-        std::cerr << "Received invalid message size." << std::endl;
+        LOG_WARNING("Received invalid message size.");
+        drops_.bad_size.add();
         return false;
     }
 
@@ -119,6 +227,7 @@ void UdpPeer::handle_response(const int message,
             send_message(PONG, remote_endpoint);
             break;
         case PONG:
+            if (!selected_) select_candidate(remote_endpoint);
             handle_pong();
             break;
         case STREAM_REQUEST:
@@ -129,10 +238,12 @@ void UdpPeer::handle_response(const int message,
         case ACK_STREAM_REQUEST:
         case ACK_STREAM_ACCEPT:
         case ACK_STREAM_REJECT:
+            if (!selected_) select_candidate(remote_endpoint);
             reset_ping(message);
             break;
         default:
-            std::cerr << "Unknown message: " << message << std::endl;
+            LOG_WARNING("Unknown message: ", message);
+            drops_.parse_error.add();
     }
 }
 
@@ -140,24 +251,87 @@ void UdpPeer::handle_pong() {
     last_receive_ = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         last_receive_ - send_time_);
-    std::cout << elapsed.count() << std::endl;
+    rtt_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            last_receive_ - send_time_)
+            .count()));
+    ControlChannel::send(elapsed.count());
 }
 
 void UdpPeer::handle_process_signal(int signal,
                                     const udp::endpoint& remote_endpoint) {
     send_message(ACK_MAP.at(signal), remote_endpoint);
-    std::cout << UDP_TO_SIGNAL_MAP.at(
-                     static_cast<StreamMessages::Messages>(signal))
-              << std::endl;
+    ControlChannel::send(
+        UDP_TO_SIGNAL_MAP.at(static_cast<StreamMessages::Messages>(signal)));
 }
 
 void UdpPeer::reset_ping(const int signal) {
     message_ = PING;
-    std::cout << UDP_TO_SIGNAL_MAP.at(
-                     static_cast<StreamMessages::Messages>(signal))
-              << std::endl;
+    ControlChannel::send(
+        UDP_TO_SIGNAL_MAP.at(static_cast<StreamMessages::Messages>(signal)));
 };
 
+void UdpPeer::send_relay_request() {
+    using namespace RelayProtocol;
+
+    // Allocate the session's relay port first, then bind to it
+    std::array<unsigned char, REQUEST_SIZE> request;
+    if (relay_endpoint_.port() == 0) {
+        build_request(ALLOCATE_REQUEST, relay_token_, request.data());
+        send_datagram(boost::asio::buffer(request), relay_control_);
+    } else {
+        build_request(BIND_REQUEST, relay_token_, request.data());
+        send_datagram(boost::asio::buffer(request), relay_endpoint_);
+    }
+}
+
+bool UdpPeer::handle_relay_message(const std::size_t bytes_recvd,
+                                   const udp::endpoint& remote_endpoint) {
+    using namespace RelayProtocol;
+
+    const unsigned char* data = recv_buffer_.data();
+    if (remote_endpoint == relay_control_ &&
+        is_message(data, bytes_recvd, ALLOCATE_RESPONSE)) {
+        relay_endpoint_ =
+            udp::endpoint(relay_control_.address(), allocated_port(data));
+        send_relay_request();
+        return true;
+    }
+
+    if (remote_endpoint == relay_endpoint_ &&
+        is_message(data, bytes_recvd, BIND_RESPONSE)) {
+        if (!relay_bound_) {
+            LOG_INFO("Bound to relay ", relay_endpoint_);
+            relay_bound_ = true;
+            candidates_.push_back({relay_endpoint_, {}});
+            if (!selected_) send_candidate(candidates_.size() - 1);
+        }
+        return true;
+    }
+
+    if ((remote_endpoint == relay_control_ ||
+         remote_endpoint == relay_endpoint_) &&
+        is_message(data, bytes_recvd, ERROR_RESPONSE)) {
+        LOG_WARNING("Relay refused the session, error ",
+                    static_cast<int>(data[HEADER_SIZE]));
+        relay_enabled_ = false;
+        return true;
+    }
+    return false;
+}
+
 void UdpPeer::send_message(const int message, const udp::endpoint& endpoint) {
-    socket_.send_to(boost::asio::buffer(&message, sizeof(message)), endpoint);
+    send_datagram(boost::asio::buffer(&message, sizeof(message)), endpoint);
+}
+
+void UdpPeer::send_datagram(const boost::asio::const_buffer& data,
+                            const udp::endpoint& endpoint) {
+    // Candidate paths may be unreachable, which must not stop the others
+    boost::system::error_code ec;
+    const std::size_t bytes_sent = socket_.send_to(data, endpoint, 0, ec);
+    if (ec) {
+        LOG_WARNING("Failed to send to ", endpoint, ": ", ec.message());
+        return;
+    }
+    control_stats_.sent(bytes_sent);
 }
@@ -1,16 +1,51 @@
 #ifndef UDP_SERVER_H
 #define UDP_SERVER_H
 
+#include <array>
 #include <boost/asio.hpp>
+#include <string_view>
+#include <vector>
 
 #include "common.hpp"
+#include "congestion_controller.hpp"
+#include "datagram_receiver.hpp"
+#include "dscp.hpp"
+#include "fec_encoder.hpp"
 #include "input_simulator.hpp"
+#include "latency_profile.hpp"
+#include "metrics.hpp"
+#include "pacer.hpp"
+#include "packet_history.hpp"
+#include "packet_pool.hpp"
+#include "path_mtu.hpp"
+#include "ping_messages.hpp"
+#include "rtcp_feedback.hpp"
+#include "socket_address.hpp"
+#include "udp_segmentation.hpp"
 
 using boost::asio::ip::udp;
 
 /**
  * @class UDPServer
  * @brief UDP server for receiving messages from a client
+ *
+ * Once the client is heard from, the server runs path MTU discovery towards
+ * it (RFC 8899) so media can be packetized to the largest datagram the path
+ * carries without fragmentation.
+ *
+ * Video packets sent are kept in a history, and the ones the client reports
+ * lost in an RTCP generic NACK are sent again as they were. A PLI from the
+ * client is held until the encoder takes it. Each frame is followed by
+ * parity packets sized to the loss the client reports, so most losses are
+ * repaired without waiting a round trip.
+ *
+ * Every video datagram is numbered with a transport-wide sequence number
+ * as it is sent, and the client reports when each arrived; a congestion
+ * controller turns the reports into the bitrate the encoder should use.
+ *
+ * Everything but path MTU probes leaves through a pacer, at a multiple of
+ * that bitrate, in strict priority: pongs first, then retransmissions,
+ * then video. Each datagram is marked with the DSCP of its class.
  */
 class UDPServer {
    public:
@@ -26,29 +61,203 @@ class UDPServer {
               const unsigned short local_port, const std::string& client,
               const std::string& client_port);
 
+    /**
+     * @brief Construct a new UDPServer object injecting input through the
+     * given simulator
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param client Client name or IP address
+     * @param client_port Client port number
+     * @param keyboard Simulator receiving the client's input
+     * @param profile Socket latency settings (default: none)
+     * @param timestamps Use kernel receive timestamps (default: false)
+     */
+    UDPServer(boost::asio::io_context& io_context,
+              const unsigned short local_port, const std::string& client,
+              const std::string& client_port,
+              std::unique_ptr<InputSimulator> keyboard,
+              const LatencyProfile& profile = {},
+              const bool timestamps = false);
+
+    /**
+     * @brief Construct a new UDPServer object for a client address already
+     * parsed, injecting input through the given simulator
+     *
+     * @param io_context Boost ASIO context
+     * @param local_port Local port to bind the UDP socket
+     * @param client Client address and port
+     * @param keyboard Simulator receiving the client's input
+     * @param profile Socket latency settings (default: none)
+     * @param timestamps Use kernel receive timestamps (default: false)
+     */
+    UDPServer(boost::asio::io_context& io_context,
+              const unsigned short local_port, const SocketAddress& client,
+              std::unique_ptr<InputSimulator> keyboard,
+              const LatencyProfile& profile = {},
+              const bool timestamps = false);
+
     /**
      * @brief Destroy the UDPServer object
      */
     ~UDPServer();
 
+    /**
+     * @brief Get the largest UDP payload confirmed to reach the client
+     * unfragmented, to size media packets. Safe to call from any thread.
+     *
+     * @return std::size_t Packetization layer path MTU in bytes
+     */
+    std::size_t path_mtu() const { return path_mtu_.plpmtu(); }
+
+    /**
+     * @brief Get the largest video packet to packetize to: the path MTU
+     * less the room for parity packets' headers and the transport-wide
+     * sequence number. Safe to call from any thread.
+     *
+     * @return std::size_t Largest RTP packet in bytes
+     */
+    std::size_t video_packet_size() const {
+        return path_mtu() - Fec::OVERHEAD - Rtp::TRANSPORT_EXTENSION_SIZE;
+    }
+
+    /**
+     * @brief Get the bitrate the video encoder should produce: the
+     * congestion controller's target less the share that parity packets
+     * and retransmissions took lately. Call from the io_context thread.
+     *
+     * @return int Bitrate in kbit/s
+     */
+    int video_bitrate() const;
+
+    /**
+     * @brief Receive and handle every datagram queued on the socket without
+     * blocking. Called by busy-poll loops; otherwise the io_context does.
+     *
+     * @return std::size_t Number of datagrams received
+     */
+    std::size_t poll_receive();
+
+    /**
+     * @brief Queue the RTP packets of a video frame for the client, keeping
+     * copies to resend on NACK, followed by their parity packets. The pacer
+     * sends them over the next milliseconds. Call from the io_context
+     * thread.
+     *
+     * @param packets Packets from the packetizer, at most
+     * video_packet_size() bytes each so the parity packets fit the path too
+     */
+    void send_video(const std::vector<GatherDatagram>& packets);
+
+    /**
+     * @brief Turn forward error correction on or off, or change its code.
+     * Call from the io_context thread.
+     *
+     * @param enabled Send parity packets when the client reports loss
+     * @param scheme Code (default: Reed-Solomon)
+     */
+    void set_fec(const bool enabled,
+                 const Fec::Scheme scheme = Fec::Scheme::REED_SOLOMON);
+
+    /**
+     * @brief Check whether the client asked for a keyframe since the last
+     * call. Call from the io_context thread.
+     *
+     * @return true if the next frame should be a keyframe, false otherwise.
+     */
+    bool take_keyframe_request();
+
+    /**
+     * @brief Change how much faster than the target bitrate video is paced
+     * out. Call from the io_context thread.
+     *
+     * @param pacing_factor Pacing rate over the target bitrate
+     *
+     * @throws std::invalid_argument If the factor is below 1.
+     */
+    void set_pacing_factor(const double pacing_factor) {
+        pacer_.set_pacing_factor(pacing_factor);
+    }
+
+    /**
+     * @brief Turn DSCP marking on or off. Call from the io_context thread.
+     *
+     * @param enabled Mark datagrams with the DSCP of their class
+     */
+    void set_dscp(const bool enabled) { dscp_.set_enabled(enabled); }
+
    private:
     void start_receive();
-    void handle_receive(const boost::system::error_code& ec,
-                        const std::size_t bytes_recvd,
-                        const udp::endpoint& remote_endpoint);
-    bool validate_message(const std::string& message,
+    void handle_receive(const std::size_t bytes_recvd);
+    bool validate_message(std::string_view message,
                           const std::size_t bytes_recvd,
                           const udp::endpoint& remote_endpoint) const;
     bool validate_endpoint(const udp::endpoint& remote_endpoint) const;
     bool validate_message_size(const std::size_t bytes_recvd) const;
-    void handle_response(const std::string& message);
+    void handle_response(std::string_view message);
     void handle_ping();
+    void start_probing();
+    void send_probe();
+    void handle_probe_ack(const unsigned char* data);
     void handle_input(const InputMessages::Message& message);
+    void handle_feedback(const unsigned char* data, const std::size_t size);
+    std::size_t queue(const TrafficClass traffic_class,
+                      const boost::asio::const_buffer& header,
+                      const boost::asio::const_buffer& payload);
+    std::size_t queue_datagrams(const std::vector<GatherDatagram>& packets);
+    void send_paced();
+    std::size_t send_rtp(const boost::asio::const_buffer& packet);
 
     udp::socket socket_;
+    DatagramReceiver receiver_;
     udp::endpoint client_endpoint_;
-    std::array<char, 1024> recv_buffer_;
+    PacketPool pool_;
+    PacketRef recv_packet_;
+    udp::endpoint remote_endpoint_;
+    std::chrono::steady_clock::time_point receive_time_;
+    bool timestamps_;
+    int64_t receive_ns_;  // See DatagramReceiver::receive_time
+    std::array<unsigned char, PingMessages::PONG_SIZE> pong_;
     std::unique_ptr<InputSimulator> keyboard_;
+    PathMtuDiscovery path_mtu_;
+    boost::asio::steady_timer probe_timer_;
+    bool dont_fragment_;
+    bool probing_;
+    PacketHistory video_history_;
+    std::unique_ptr<FecEncoder> fec_encoder_;  // Null when disabled
+    CongestionController congestion_;
+    std::array<unsigned char,
+               Rtp::HEADER_SIZE + Rtp::TRANSPORT_EXTENSION_SIZE>
+        transport_header_;
+    std::array<int64_t, RtcpFeedback::MAX_FEEDBACK_PACKETS> arrivals_;
+    double media_bytes_;  // Recent, decaying by frame
+    double protection_bytes_;
+    Pacer pacer_;
+    DscpMarker dscp_;
+    boost::asio::steady_timer pacer_timer_;
+    Pacer::Clock::time_point pacer_wakeup_;
+    PacketRef paced_packet_;
+    std::array<uint16_t,
+               RtcpFeedback::MAX_NACK_ITEMS * RtcpFeedback::NACK_ITEM_SPAN>
+        nack_sequences_;
+    bool keyframe_requested_;
+    Metrics::ChannelCounters input_stats_;
+    Metrics::ChannelCounters control_stats_;
+    Metrics::ChannelCounters probe_stats_;
+    Metrics::ChannelCounters video_stats_;
+    Metrics::DropCounters drops_;
+    Metrics::Gauge& pool_available_;
+    Metrics::Gauge& path_mtu_gauge_;
+    Metrics::Histogram& injection_latency_;
+    Metrics::Histogram& queueing_;
+    Metrics::Counter& retransmitted_packets_;
+    Metrics::Counter& keyframe_requests_;
+    Metrics::Counter& parity_packets_;
+    Metrics::Gauge& reported_loss_;
+    Metrics::Gauge& target_bitrate_;
+    Metrics::Gauge& delivered_bitrate_;
+    Metrics::Gauge& pacer_queue_;
+    Metrics::Counter& pacer_drops_;
 };
 
 #endif  // UDP_SERVER_H
@@ -1,30 +1,124 @@
 #include <iostream>
 
 #include "common.hpp"
+#include "metrics.hpp"
+#include "socket_address.hpp"
 #include "udp_server.hpp"
 
+#ifdef VIDEO_VP8
+#include "media_pipeline.hpp"
+#endif
+
 int main(int argc, char* argv[]) {
     try {
-        if (argc != 4 || std::strcmp(argv[1], "-p") != 0) {
+        if (argc < 4 || std::strcmp(argv[1], "-p") != 0) {
             throw std::invalid_argument(
                 "Invalid arguments. Usage: " + std::string(argv[0]) +
-                " -p <local_port> <peer_address> (IP:PORT)");
+                " -p <local_port> <peer_address> (IP:PORT or [IPv6]:PORT)"
+                " [--stats <interval_ms>] [--stats-socket <path>]"
+                " [--input <native|null>] [--latency-profile [--cpu <n>]"
+                " [--busy-poll <us>] [--rt-priority <n>]"
+                " [--socket-buffer <bytes>]] [--timestamps]"
+                " [--fec <rs|xor|off>] [--pacing-factor <x>]"
+                " [--dscp <on|off>] [--stream [--capture <native|test|file>]"
+                " [--capture-size <WxH>] [--frame-rate <fps>]"
+                " [--encode-threads <n>] [--convert-threads <n>]]");
         }
 
         if (!Common::validate_port(argv[2])) {
             throw std::invalid_argument("Invalid port number");
         }
 
-        if (!Common::validate_socket_string(argv[3])) {
+        SocketAddress peer_address;
+        if (!SocketAddress::try_parse(argv[3], peer_address)) {
             throw std::invalid_argument("Invalid peer address");
         }
 
         const uint16_t local_port = static_cast<uint16_t>(std::stoi(argv[2]));
-        auto [peer, peer_port] = Common::extract_ip_port(argv[3]);
+        const auto options = Common::parse_options(argc, argv, 4);
+
+        std::unique_ptr<Metrics::StatsExporter> stats_exporter;
+        if (const auto it = options.find("stats"); it != options.end()) {
+            const auto socket = options.find("stats-socket");
+            stats_exporter = std::make_unique<Metrics::StatsExporter>(
+                std::chrono::milliseconds(std::stoi(it->second)),
+                socket != options.end() ? socket->second : "");
+        }
+
+        SimulatorBackend input_backend = SimulatorBackend::NATIVE;
+        if (const auto it = options.find("input"); it != options.end()) {
+            if (it->second == "null") {
+                input_backend = SimulatorBackend::NULL_SINK;
+            } else if (it->second != "native") {
+                throw std::invalid_argument("Invalid input backend");
+            }
+        }
+
+        bool fec = true;
+        Fec::Scheme fec_scheme = Fec::Scheme::REED_SOLOMON;
+        if (const auto it = options.find("fec"); it != options.end()) {
+            if (it->second == "off") {
+                fec = false;
+            } else if (it->second == "xor") {
+                fec_scheme = Fec::Scheme::XOR;
+            } else if (it->second != "rs") {
+                throw std::invalid_argument("Invalid FEC scheme");
+            }
+        }
+
+        double pacing_factor = DEFAULT_PACING_FACTOR;
+        if (const auto it = options.find("pacing-factor");
+            it != options.end()) {
+            pacing_factor = std::stod(it->second);
+        }
+
+        bool dscp = true;
+        if (const auto it = options.find("dscp"); it != options.end()) {
+            if (it->second == "off") {
+                dscp = false;
+            } else if (it->second != "on") {
+                throw std::invalid_argument("Invalid DSCP setting");
+            }
+        }
+
+        const auto profile = LatencyProfile::from_options(options);
 
         boost::asio::io_context io_context;
-        UDPServer server(io_context, local_port, peer, peer_port);
-        io_context.run();
+        UDPServer server(io_context, local_port, peer_address,
+                         InputSimulator::create(input_backend), profile,
+                         options.count("timestamps") > 0);
+        server.set_fec(fec, fec_scheme);
+        server.set_pacing_factor(pacing_factor);
+        server.set_dscp(dscp);
+
+#ifdef VIDEO_VP8
+        // Capture and encoding run on the pipeline's threads; this thread
+        // only sends what they produce
+        std::unique_ptr<MediaPipeline> pipeline;
+        if (options.count("stream") > 0) {
+            PipelineSettings settings = PipelineSettings::from_options(options);
+            settings.encoder.bitrate = server.video_bitrate();
+            settings.max_packet_size = server.video_packet_size();
+            pipeline = std::make_unique<MediaPipeline>(
+                settings, io_context,
+                [&server](const std::vector<GatherDatagram>& packets) {
+                    server.send_video(packets);
+                    VideoFeedback feedback;
+                    feedback.bitrate = server.video_bitrate();
+                    feedback.keyframe_requested =
+                        server.take_keyframe_request();
+                    feedback.max_packet_size = server.video_packet_size();
+                    return feedback;
+                });
+        }
+#else
+        if (options.count("stream") > 0) {
+            throw std::invalid_argument(
+                "Streaming needs the VP8 encoder, built with libvpx");
+        }
+#endif
+
+        profile.run(io_context, [&server]() { server.poll_receive(); });
     } catch (std::exception& e) {
         std::cerr << "Exception: " << e.what() << std::endl;
     }
@@ -1,15 +1,85 @@
 #include "udp_server.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "dual_stack.hpp"
+#include "handler_pool.hpp"
+#include "logger.hpp"
+#include "packet_timestamps.hpp"
+#include "socket_address.hpp"
+
+namespace {
+
+constexpr double SHARE_DECAY = 15.0 / 16;  // Per frame
+
+}  // namespace
 
 UDPServer::UDPServer(boost::asio::io_context& io_context,
                      const unsigned short local_port, const std::string& client,
                      const std::string& client_port)
-    : socket_(io_context, udp::endpoint(udp::v4(), local_port)),
-      client_endpoint_(*udp::resolver(io_context)
-                            .resolve(udp::v4(), client, client_port)
-                            .begin()) {
-    keyboard_ = InputSimulator::create();
+    : UDPServer(io_context, local_port, client, client_port,
+                InputSimulator::create()) {}
+
+UDPServer::UDPServer(boost::asio::io_context& io_context,
+                     const unsigned short local_port, const std::string& client,
+                     const std::string& client_port,
+                     std::unique_ptr<InputSimulator> keyboard,
+                     const LatencyProfile& profile, const bool timestamps)
+    : UDPServer(io_context, local_port,
+                SocketAddress::resolve_address(io_context, client, client_port),
+                std::move(keyboard), profile, timestamps) {}
+
+UDPServer::UDPServer(boost::asio::io_context& io_context,
+                     const unsigned short local_port,
+                     const SocketAddress& client,
+                     std::unique_ptr<InputSimulator> keyboard,
+                     const LatencyProfile& profile, const bool timestamps)
+    : socket_(DualStack::open_socket(io_context, local_port)),
+      receiver_(socket_),
+      client_endpoint_(
+          client.endpoint_for(socket_.local_endpoint().protocol())),
+      pool_(PACKET_POOL_SIZE),
+      timestamps_(timestamps),
+      receive_ns_(0),
+      keyboard_(std::move(keyboard)),
+      probe_timer_(io_context),
+      dont_fragment_(PathMtu::set_dont_fragment(socket_)),
+      probing_(false),
+      media_bytes_(0),
+      protection_bytes_(0),
+      pacer_(congestion_.target_bitrate()),
+      dscp_(socket_),
+      pacer_timer_(io_context),
+      keyframe_requested_(false),
+      input_stats_("input"),
+      control_stats_("control"),
+      probe_stats_("pmtud"),
+      video_stats_("video"),
+      pool_available_(Metrics::gauge("packet_pool.available")),
+      path_mtu_gauge_(Metrics::gauge("pmtud.plpmtu")),
+      injection_latency_(Metrics::histogram("input.injection_latency_ns")),
+      queueing_(Metrics::histogram("receive.queueing_us")),
+      retransmitted_packets_(Metrics::counter("video.retransmitted_packets")),
+      keyframe_requests_(Metrics::counter("video.keyframe_requests")),
+      parity_packets_(Metrics::counter("video.parity_packets")),
+      reported_loss_(Metrics::gauge("video.reported_loss_ppm")),
+      target_bitrate_(Metrics::gauge("video.target_bitrate_kbps")),
+      delivered_bitrate_(Metrics::gauge("video.delivered_bitrate_kbps")),
+      pacer_queue_(Metrics::gauge("pacer.queued_bytes")),
+      pacer_drops_(Metrics::counter("pacer.dropped_packets")) {
+    if (timestamps_ && !PacketTimestamps::enable(socket_)) {
+        LOG_WARNING("Kernel timestamps not supported, using receive times.");
+        timestamps_ = false;
+    }
+    if (!dont_fragment_) {
+        LOG_INFO("Cannot disable fragmentation, path MTU stays at ",
+                 path_mtu_.plpmtu(), " bytes.");
+    }
+    path_mtu_gauge_.set(static_cast<int64_t>(path_mtu_.plpmtu()));
+    profile.apply(socket_);
+    set_fec(true);
     start_receive();
 }
 
@@ -18,32 +88,183 @@ UDPServer::~UDPServer() {
 }
 
 void UDPServer::start_receive() {
-    auto remote_endpoint = std::make_shared<udp::endpoint>();
-    socket_.async_receive_from(
-        boost::asio::buffer(recv_buffer_), *remote_endpoint,
-        [this, remote_endpoint](const boost::system::error_code& ec,
-                                std::size_t bytes_recvd) {
-            handle_receive(ec, bytes_recvd, *remote_endpoint);
-        });
-}
-
-void UDPServer::handle_receive(const boost::system::error_code& ec,
-                               const std::size_t bytes_recvd,
-                               const udp::endpoint& remote_endpoint) {
+    socket_.async_wait(udp::socket::wait_read,
+                       pooled([this](const boost::system::error_code& ec) {
+                           if (ec) {
+                               LOG_ERROR("Error: ", ec.message());
+                               return;
+                           }
+                           poll_receive();
+                           start_receive();
+                       }));
+}
+
+std::size_t UDPServer::poll_receive() {
+    std::size_t received = 0;
+    for (;;) {
+        if (!recv_packet_) {
+            recv_packet_ = pool_.acquire();
+            if (!recv_packet_) {
+                LOG_ERROR("Packet pool exhausted, receiving paused.");
+                return received;
+            }
+            pool_available_.set(static_cast<int64_t>(pool_.available()));
+        }
+
+        boost::system::error_code ec;
+        const std::size_t bytes_recvd =
+            receiver_.receive(recv_packet_.writable(), remote_endpoint_, ec);
+        if (ec == boost::asio::error::would_block) return received;
+        if (ec) {
+            LOG_ERROR("Error: ", ec.message());
+            return received;
+        }
+        handle_receive(bytes_recvd);
+        ++received;
+    }
+}
+
+int UDPServer::video_bitrate() const {
+    const double sent = media_bytes_ + protection_bytes_;
+    const double share = sent > 0 ? media_bytes_ / sent : 1;
+    return static_cast<int>(
+        static_cast<double>(congestion_.target_bitrate()) * share / 1000);
+}
+
+void UDPServer::send_video(const std::vector<GatherDatagram>& packets) {
+    for (const GatherDatagram& packet : packets) {
+        video_history_.store(packet);
+    }
+    media_bytes_ = media_bytes_ * SHARE_DECAY +
+                   static_cast<double>(queue_datagrams(packets));
+    protection_bytes_ *= SHARE_DECAY;
+    if (fec_encoder_) {
+        const std::vector<GatherDatagram>& parity =
+            fec_encoder_->protect(packets);
+        protection_bytes_ += static_cast<double>(queue_datagrams(parity));
+        parity_packets_.add(parity.size());
+    }
+    send_paced();
+}
+
+std::size_t UDPServer::queue(const TrafficClass traffic_class,
+                             const boost::asio::const_buffer& header,
+                             const boost::asio::const_buffer& payload) {
+    if (!pacer_.enqueue(traffic_class, header, payload)) {
+        pacer_drops_.add();
+        return 0;
+    }
+    return header.size() + payload.size();
+}
+
+std::size_t UDPServer::queue_datagrams(
+    const std::vector<GatherDatagram>& packets) {
+    std::size_t bytes_queued = 0;
+    for (const GatherDatagram& packet : packets) {
+        bytes_queued += queue(TrafficClass::VIDEO, packet.header,
+                              packet.payload);
+    }
+    return bytes_queued;
+}
+
+void UDPServer::send_paced() {
+    const auto now = Pacer::Clock::now();
+    TrafficClass traffic_class = TrafficClass::VIDEO;
+    while (pacer_.pop(now, traffic_class, paced_packet_)) {
+        dscp_.mark(traffic_class);
+        if (traffic_class != TrafficClass::CONTROL) {
+            send_rtp(paced_packet_.payload());
+            continue;
+        }
+
+        boost::system::error_code ec;
+        const std::size_t bytes_sent =
+            socket_.send_to(paced_packet_.payload(), client_endpoint_, 0, ec);
+        if (ec) {
+            LOG_ERROR("Error: ", ec.message());
+            continue;
+        }
+        control_stats_.sent(bytes_sent);
+    }
+    paced_packet_ = PacketRef();
+    pacer_queue_.set(static_cast<int64_t>(pacer_.queued_bytes()));
+
+    // Wake up for the next datagram unless already set to wake up before
+    // it, releasing everything due by then at once
+    Pacer::Clock::time_point due;
+    if (!pacer_.next_send(due)) return;
+    due = std::max(due, now + PACER_INTERVAL);
+    if (pacer_wakeup_ > now && pacer_wakeup_ <= due) return;
+
+    pacer_wakeup_ = due;
+    pacer_timer_.expires_at(due);
+    pacer_timer_.async_wait(pooled([this](const boost::system::error_code& ec) {
+        if (!ec) send_paced();
+    }));
+}
+
+std::size_t UDPServer::send_rtp(const boost::asio::const_buffer& packet) {
+    if (packet.size() < Rtp::HEADER_SIZE) return 0;
+
+    // Numbered as it leaves, so a retransmission counts as a new datagram
+    const std::size_t size = packet.size() + Rtp::TRANSPORT_EXTENSION_SIZE;
+    const uint16_t sequence =
+        congestion_.on_packet_sent(size, CongestionController::Clock::now());
+    Rtp::write_transport_header(
+        static_cast<const unsigned char*>(packet.data()), sequence,
+        transport_header_.data());
+    const std::array<boost::asio::const_buffer, 2> buffers = {
+        boost::asio::buffer(transport_header_), packet + Rtp::HEADER_SIZE};
+
+    boost::system::error_code ec;
+    const std::size_t bytes_sent =
+        socket_.send_to(buffers, client_endpoint_, 0, ec);
     if (ec) {
-        std::cerr << "Error: " << ec.message() << std::endl;
+        LOG_ERROR("Error: ", ec.message());
+        return 0;
+    }
+    video_stats_.sent(bytes_sent);
+    return bytes_sent;
+}
+
+void UDPServer::set_fec(const bool enabled, const Fec::Scheme scheme) {
+    if (!enabled) {
+        fec_encoder_.reset();
         return;
     }
 
-    const std::string message(recv_buffer_.data(), bytes_recvd);
-    start_receive();  // Receiving the next message after flushing the buffer
+    // Keep the loss reported so far
+    const double loss_rate = fec_encoder_ ? fec_encoder_->loss_rate() : 0;
+    const double mean_burst = fec_encoder_ ? fec_encoder_->mean_burst() : 1;
+    fec_encoder_ =
+        std::make_unique<FecEncoder>(std::random_device()(), scheme);
+    fec_encoder_->set_loss(loss_rate, mean_burst);
+}
 
-    if (validate_message(message, bytes_recvd, remote_endpoint)) {
-        handle_response(message);
+bool UDPServer::take_keyframe_request() {
+    const bool requested = keyframe_requested_;
+    keyframe_requested_ = false;
+    return requested;
+}
+
+void UDPServer::handle_receive(const std::size_t bytes_recvd) {
+    receive_time_ = std::chrono::steady_clock::now();
+    receive_ns_ = receiver_.receive_time();
+    if (timestamps_) {
+        // Time spent queued in the socket before the handler ran
+        queueing_.record(PacketTimestamps::elapsed_us(
+            receive_ns_, PacketTimestamps::now_ns()));
+    }
+    const PacketRef packet = std::move(recv_packet_);
+    const udp::endpoint remote_endpoint = remote_endpoint_;
+    packet->set_size(bytes_recvd);
+
+    if (validate_message(packet->view(), bytes_recvd, remote_endpoint)) {
+        handle_response(packet->view());
     }
 }
 
-bool UDPServer::validate_message(const std::string& /* message */,
+bool UDPServer::validate_message(std::string_view /* message */,
                                  const std::size_t bytes_recvd,
                                  const udp::endpoint& remote_endpoint) const {
     if (!validate_endpoint(remote_endpoint)) return false;
@@ -54,52 +275,124 @@ bool UDPServer::validate_message(const std::string& /* message */,
 
 bool UDPServer::validate_endpoint(const udp::endpoint& remote_endpoint) const {
     if (remote_endpoint != client_endpoint_) {
-        std::cerr << "Received message from unknown endpoint: "
-                  << remote_endpoint << std::endl;
+        LOG_WARNING("Received message from unknown endpoint: ",
+                    remote_endpoint);
+        drops_.unknown_endpoint.add();
         return false;
     }
     return true;
 }
 
 bool UDPServer::validate_message_size(const std::size_t bytes_recvd) const {
-    if (bytes_recvd > recv_buffer_.size()) {
-        std::cerr << "Received message too large." << std::endl;
+    if (bytes_recvd > PacketBuffer::CAPACITY) {
+        LOG_WARNING("Received message too large.");
+        drops_.bad_size.add();
         return false;
     }
 
     if (bytes_recvd == 0) {
-        std::cerr << "Received empty message." << std::endl;
+        LOG_WARNING("Received empty message.");
+        drops_.bad_size.add();
         return false;
     }
 
     return true;
 }
 
-void UDPServer::handle_response(const std::string& message) {
-    if (message == "ping") {
+void UDPServer::handle_response(std::string_view message) {
+    const auto* data = reinterpret_cast<const unsigned char*>(message.data());
+    if (PathMtu::is_message(data, message.size(), PathMtu::PROBE_ACK)) {
+        probe_stats_.received(message.size());
+        handle_probe_ack(data);
+        return;
+    }
+
+    if (RtcpFeedback::is_rtcp(data, message.size())) {
+        video_stats_.received(message.size());
+        handle_feedback(data, message.size());
+        return;
+    }
+
+    if (message == PingMessages::PING) {
+        control_stats_.received(message.size());
         handle_ping();
         return;
     }
 
-    std::cout << "Received: " << message << std::endl;
+    input_stats_.received(message.size());
+    LOG_DEBUG("Received: ", message);
     try {
-        const auto input_message = InputMessages::Message::from_string(message);
+        const auto input_message = InputMessages::Message::parse(message);
         handle_input(input_message);
     } catch (const std::exception& e) {
-        std::cerr << "Error parsing message: " << e.what() << std::endl;
+        LOG_WARNING("Error parsing message: ", e.what());
+        drops_.parse_error.add();
     }
 }
 
 void UDPServer::handle_ping() {
-    const std::string response = "pong";
-    socket_.async_send_to(boost::asio::buffer(response), client_endpoint_,
-                          [this, response](boost::system::error_code ec,
-                                           std::size_t /*bytes_sent*/) {
-                              if (ec) {
-                                  std::cerr << "Error: " << ec.message()
-                                            << std::endl;
-                              }
-                          });
+    // Nothing ranks above a pong, so it leaves at once
+    PingMessages::write_pong(receive_ns_, PacketTimestamps::now_ns(),
+                             pong_.data());
+    queue(TrafficClass::CONTROL, boost::asio::buffer(pong_),
+          boost::asio::const_buffer());
+    send_paced();
+
+    // The client answers, so the path can be probed
+    if (dont_fragment_ && !probing_) {
+        probing_ = true;
+        start_probing();
+    }
+}
+
+void UDPServer::start_probing() {
+    send_probe();
+    probe_timer_.expires_after(PathMtu::PROBE_TIMER);
+    probe_timer_.async_wait(pooled([this](const boost::system::error_code& ec) {
+        if (!ec) start_probing();
+    }));
+}
+
+void UDPServer::send_probe() {
+    uint32_t sequence = 0;
+    std::size_t size = 0;
+    while ((size = path_mtu_.poll(std::chrono::steady_clock::now(),
+                                  sequence)) != 0) {
+        PacketRef packet = pool_.acquire();
+        if (!packet) {
+            LOG_ERROR("Packet pool exhausted, dropping probe.");
+            return;
+        }
+        PathMtu::build_probe(sequence, size, packet->data());
+        packet->set_size(size);
+
+        // Not paced: the search needs the send error at once, and probes
+        // are rare. Marked like the video they size.
+        dscp_.mark(TrafficClass::VIDEO);
+        boost::system::error_code ec;
+        const std::size_t bytes_sent =
+            socket_.send_to(packet.payload(), client_endpoint_, 0, ec);
+        if (ec == boost::asio::error::message_size) {
+            // Larger than the local interface allows, try the next size
+            path_mtu_.on_send_failed();
+            continue;
+        }
+        if (ec) {
+            LOG_ERROR("Error: ", ec.message());
+            return;
+        }
+        probe_stats_.sent(bytes_sent);
+        return;
+    }
+}
+
+void UDPServer::handle_probe_ack(const unsigned char* data) {
+    if (!path_mtu_.on_ack(PathMtu::sequence(data),
+                          PathMtu::acked_size(data))) {
+        return;
+    }
+    path_mtu_gauge_.set(static_cast<int64_t>(path_mtu_.plpmtu()));
+    send_probe();
 }
 
 void UDPServer::handle_input(const InputMessages::Message& input_message) {
@@ -111,7 +404,63 @@ void UDPServer::handle_input(const InputMessages::Message& input_message) {
             keyboard_->keyup(input_message.id);
             break;
         default:
-            std::cerr << "Unknown message type: "
-                      << static_cast<int>(input_message.type) << std::endl;
+            LOG_WARNING("Unknown message type: ",
+                        static_cast<int>(input_message.type));
+            return;
+    }
+
+    const auto latency = std::chrono::steady_clock::now() - receive_time_;
+    injection_latency_.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+}
+
+void UDPServer::handle_feedback(const unsigned char* data,
+                                const std::size_t size) {
+    uint16_t base_sequence = 0;
+    std::size_t count = 0;
+    if (RtcpFeedback::read_transport_feedback(data, size, base_sequence,
+                                              arrivals_.data(),
+                                              arrivals_.size(), count)) {
+        congestion_.on_feedback(base_sequence, arrivals_.data(), count,
+                                CongestionController::Clock::now());
+        pacer_.set_target_bitrate(congestion_.target_bitrate());
+        target_bitrate_.set(congestion_.target_bitrate() / 1000);
+        delivered_bitrate_.set(congestion_.delivered_bitrate() / 1000);
+        return;
+    }
+
+    uint32_t media_ssrc = 0;
+    if (RtcpFeedback::read_pli(data, size, media_ssrc)) {
+        keyframe_requested_ = true;
+        keyframe_requests_.add();
+        return;
+    }
+
+    double loss_rate = 0;
+    double mean_burst = 0;
+    if (RtcpFeedback::read_loss_report(data, size, loss_rate, mean_burst)) {
+        reported_loss_.set(std::lround(loss_rate * 1e6));
+        if (fec_encoder_) fec_encoder_->set_loss(loss_rate, mean_burst);
+        return;
+    }
+
+    if (!RtcpFeedback::read_nack(data, size, media_ssrc,
+                                 nack_sequences_.data(),
+                                 nack_sequences_.size(), count)) {
+        drops_.parse_error.add();
+        return;
+    }
+
+    const auto now = PacketHistory::Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        boost::asio::const_buffer packet;
+        if (!video_history_.resend(nack_sequences_[i], now, packet)) continue;
+
+        const std::size_t bytes_queued = queue(
+            TrafficClass::RETRANSMISSION, packet, boost::asio::const_buffer());
+        if (bytes_queued == 0) break;
+        protection_bytes_ += static_cast<double>(bytes_queued);
+        retransmitted_packets_.add();
     }
+    send_paced();
 }
@@ -0,0 +1,212 @@
+#ifndef COLOR_CONVERT_HPP
+#define COLOR_CONVERT_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame_pool.hpp"
+
+/**
+ * @namespace ColorConvert
+ * @brief BGRA to I420 conversion and 2:1 downscaling for the encoder.
+ *
+ * Colours are converted to BT.601 limited range, with chroma taken from
+ * the average of each 2x2 block. Every kernel produces exactly the output
+ * of the scalar reference; the SIMD ones only do it faster.
+ */
+namespace ColorConvert {
+
+/**
+ * @enum Kernel
+ * @brief Enumerates the kernel implementations, slowest first.
+ */
+enum class Kernel {
+    SCALAR,  // Reference, portable
+    SSE2,    // x86-64 baseline, 16 pixels per step
+    AVX2     // 32 pixels per step
+};
+
+/**
+ * @struct Planes
+ * @brief Destination I420 planes, typically owned by the encoder so frames
+ * are converted straight into its input.
+ */
+struct Planes {
+    unsigned char* y = nullptr;
+    int y_stride = 0;
+    unsigned char* u = nullptr;
+    int u_stride = 0;
+    unsigned char* v = nullptr;
+    int v_stride = 0;
+
+    /**
+     * @brief Get the planes of an I420 frame
+     *
+     * @param frame Frame in PixelFormat::I420
+     * @return Planes The frame's planes
+     */
+    static Planes of(FrameBuffer& frame);
+};
+
+/**
+ * @brief Get the fastest kernel the CPU supports
+ *
+ * @return Kernel Detected once, on first use
+ */
+Kernel best_kernel();
+
+/**
+ * @brief Check whether the CPU can run a kernel
+ *
+ * @param kernel Kernel to check
+ * @return true if it is compiled in and supported, false otherwise.
+ */
+bool supported(const Kernel kernel);
+
+/**
+ * @brief Get the name of a kernel, for logs and benchmarks
+ *
+ * @param kernel Kernel
+ * @return const char* "scalar", "sse2" or "avx2"
+ */
+const char* name(const Kernel kernel);
+
+/**
+ * @brief Convert BGRA pixels to I420 on the calling thread
+ *
+ * @param bgra First pixel
+ * @param bgra_stride Bytes per BGRA row
+ * @param width Width in pixels, even
+ * @param height Height in pixels, even
+ * @param destination I420 planes of the same dimensions
+ * @param kernel Kernel to use, supported by the CPU
+ */
+void bgra_to_i420(const unsigned char* bgra, const int bgra_stride,
+                  const int width, const int height,
+                  const Planes& destination, const Kernel kernel);
+
+/**
+ * @brief Halve a plane in both dimensions, averaging each 2x2 block, on the
+ * calling thread
+ *
+ * @param source First sample
+ * @param source_stride Bytes per source row
+ * @param width Destination width in samples
+ * @param height Destination height in rows
+ * @param destination First destination sample
+ * @param destination_stride Bytes per destination row
+ * @param kernel Kernel to use, supported by the CPU
+ */
+void downscale_half(const unsigned char* source, const int source_stride,
+                    const int width, const int height,
+                    unsigned char* destination, const int destination_stride,
+                    const Kernel kernel);
+
+}  // namespace ColorConvert
+
+/**
+ * @class ColorConverter
+ * @brief Converts and downscales frames, splitting them into bands of rows
+ * across worker threads.
+ *
+ * Workers are started once and wait between frames, so a conversion costs
+ * a wake-up rather than a thread start. The calling thread converts the
+ * first band itself and returns when every band is done. Not thread-safe:
+ * convert from one thread.
+ */
+class ColorConverter {
+   public:
+    /**
+     * @brief Construct a new ColorConverter object
+     *
+     * @param threads Bands per frame, including the calling thread's
+     * @param kernel Kernel to use (default: the fastest supported)
+     *
+     * @throws std::invalid_argument If threads is not positive or the
+     * kernel is not supported.
+     */
+    explicit ColorConverter(const int threads = 1,
+                            const ColorConvert::Kernel kernel =
+                                ColorConvert::best_kernel());
+
+    /**
+     * @brief Destroy the ColorConverter object, stopping its workers
+     */
+    ~ColorConverter();
+
+    ColorConverter(const ColorConverter&) = delete;
+    ColorConverter& operator=(const ColorConverter&) = delete;
+
+    /**
+     * @brief Convert a BGRA frame to I420
+     *
+     * @param frame Frame in PixelFormat::BGRA with even dimensions
+     * @param destination I420 planes of the frame's dimensions
+     *
+     * @throws std::invalid_argument If the frame is not BGRA or has odd
+     * dimensions.
+     */
+    void convert(const FrameBuffer& frame,
+                 const ColorConvert::Planes& destination);
+
+    /**
+     * @brief Convert a BGRA frame to I420 at half its width and height.
+     * Four rows at a time are converted into a scratch buffer that stays in
+     * cache and downscaled from there; the buffer grows on first use.
+     *
+     * @param frame Frame in PixelFormat::BGRA with dimensions divisible by 4
+     * @param destination I420 planes of half the frame's dimensions
+     *
+     * @throws std::invalid_argument If the frame is not BGRA or its
+     * dimensions are not divisible by 4.
+     */
+    void convert_half(const FrameBuffer& frame,
+                      const ColorConvert::Planes& destination);
+
+    ColorConvert::Kernel kernel() const { return kernel_; }
+    int threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+   private:
+    /**
+     * @struct Job
+     * @brief Work shared by every band of one frame. Source rows are split
+     * into units: pairs for conversion, the rows of one I420 chroma row, and
+     * fours for half-size conversion.
+     */
+    struct Job {
+        void (*run)(const Job& job, unsigned char* scratch, int first,
+                    int units) = nullptr;
+        const unsigned char* source = nullptr;
+        int source_stride = 0;
+        int width = 0;
+        int units = 0;
+        ColorConvert::Planes destination;
+        ColorConvert::Kernel kernel = ColorConvert::Kernel::SCALAR;
+    };
+
+    static void run_convert(const Job& job, unsigned char* scratch, int first,
+                            int units);
+    static void run_convert_half(const Job& job, unsigned char* scratch,
+                                 int first, int units);
+
+    void run_bands();
+    void run_band(const int band);
+    void worker(const int band);
+
+    ColorConvert::Kernel kernel_;
+    Job job_;
+    std::vector<unsigned char> scratch_;  // Four full-size rows per band
+    std::size_t scratch_size_;           // Bytes per band
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    uint64_t generation_;
+    int pending_;
+    bool stopping_;
+};
+
+#endif  // COLOR_CONVERT_HPP
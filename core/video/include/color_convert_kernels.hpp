@@ -0,0 +1,49 @@
+#ifndef COLOR_CONVERT_KERNELS_HPP
+#define COLOR_CONVERT_KERNELS_HPP
+
+#include "color_convert.hpp"
+
+/**
+ * @namespace ColorConvert::Kernels
+ * @brief Per-instruction-set kernels behind ColorConvert's dispatch. The
+ * SSE2 and AVX2 ones are compiled with their own target flags and only
+ * called once the CPU is known to support them.
+ *
+ * Conversion kernels take an even number of rows; widths are even, and
+ * columns past the last whole SIMD step are finished by the scalar kernel.
+ */
+namespace ColorConvert::Kernels {
+
+// BT.601 limited range, 8-bit fixed point
+constexpr int Y_R = 66;
+constexpr int Y_G = 129;
+constexpr int Y_B = 25;
+constexpr int U_R = -38;
+constexpr int U_G = -74;
+constexpr int U_B = 112;
+constexpr int V_R = 112;
+constexpr int V_G = -94;
+constexpr int V_B = -18;
+
+void bgra_to_i420_scalar(const unsigned char* bgra, int bgra_stride,
+                         int width, int rows, const Planes& destination);
+void downscale_half_scalar(const unsigned char* source, int source_stride,
+                           int width, int rows, unsigned char* destination,
+                           int destination_stride);
+
+#ifdef COLOR_CONVERT_X86
+void bgra_to_i420_sse2(const unsigned char* bgra, int bgra_stride, int width,
+                       int rows, const Planes& destination);
+void downscale_half_sse2(const unsigned char* source, int source_stride,
+                         int width, int rows, unsigned char* destination,
+                         int destination_stride);
+void bgra_to_i420_avx2(const unsigned char* bgra, int bgra_stride, int width,
+                       int rows, const Planes& destination);
+void downscale_half_avx2(const unsigned char* source, int source_stride,
+                         int width, int rows, unsigned char* destination,
+                         int destination_stride);
+#endif
+
+}  // namespace ColorConvert::Kernels
+
+#endif  // COLOR_CONVERT_KERNELS_HPP
@@ -0,0 +1,179 @@
+#ifndef VP8_ENCODER_HPP
+#define VP8_ENCODER_HPP
+
+#include <vpx/vp8cx.h>
+#include <vpx/vpx_encoder.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "color_convert.hpp"
+#include "frame_pool.hpp"
+
+constexpr int DEFAULT_BITRATE = 2500;           // kbit/s
+constexpr int DEFAULT_ENCODE_THREADS = 4;       // also token partitions
+constexpr int DEFAULT_KEYFRAME_INTERVAL = 600;  // frames, 10 s at 60 fps
+constexpr int DEFAULT_ENCODE_SPEED = 6;         // libvpx cpu-used
+
+/**
+ * @struct EncoderSettings
+ * @brief Encoder configuration. The dimensions are the largest the encoder
+ * will be asked for; it can later scale down to any size within them.
+ */
+struct EncoderSettings {
+    int width = 1280;
+    int height = 720;
+    int frame_rate = 60;            // frames/s
+    int bitrate = DEFAULT_BITRATE;  // kbit/s
+    int threads = DEFAULT_ENCODE_THREADS;
+    int temporal_layers = 1;  // 1 to 3
+    int keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
+    int speed = DEFAULT_ENCODE_SPEED;  // 0 to 16, higher is faster
+};
+
+/**
+ * @struct EncodedFrame
+ * @brief One encoded frame. The data belongs to the encoder and stays
+ * valid until its next encode call.
+ */
+struct EncodedFrame {
+    const unsigned char* data = nullptr;
+    std::size_t size = 0;
+    bool keyframe = false;
+    int temporal_layer = 0;  // 0 is the base layer, decodable alone
+    int width = 0;
+    int height = 0;
+    FrameBuffer::Clock::time_point capture_time;
+    uint64_t sequence = 0;  // Sequence number of the captured frame
+};
+
+/**
+ * @class Vp8Encoder
+ * @brief Real-time VP8 encoder on libvpx, configured for latency first.
+ *
+ * - One pass CBR with a VBV buffer of a few frames and frame dropping, so a
+ *   frame never waits behind a burst of earlier bits;
+ * - no lookahead (lag_in_frames 0): each frame is emitted by its own
+ *   encode call;
+ * - error-resilient mode: probabilities are not carried from frame to
+ *   frame and token partitions decode independently, so a lost packet does
+ *   not corrupt the frames after it;
+ * - multi-threaded, with a token partition per thread so decoders can
+ *   work in parallel too;
+ * - keyframes capped in size, and forced only on request or every
+ *   keyframe_interval frames.
+ *
+ * Bitrate changes take effect from the next frame. The resolution can be
+ * changed at runtime down from the size the encoder was created with,
+ * which libvpx handles without re-initializing (the next frame is a
+ * keyframe). Not thread-safe: encode from one thread.
+ */
+class Vp8Encoder {
+   public:
+    /**
+     * @brief Construct a new Vp8Encoder object
+     *
+     * @param settings Maximum dimensions, rates and threads
+     *
+     * @throws std::invalid_argument If a setting is out of range.
+     * @throws std::runtime_error If libvpx fails to initialize.
+     */
+    explicit Vp8Encoder(const EncoderSettings& settings);
+
+    /**
+     * @brief Destroy the Vp8Encoder object
+     */
+    ~Vp8Encoder();
+
+    Vp8Encoder(const Vp8Encoder&) = delete;
+    Vp8Encoder& operator=(const Vp8Encoder&) = delete;
+
+    /**
+     * @brief Get the encoder's own input planes, at the current resolution,
+     * for ColorConverter to write into before encode_input()
+     *
+     * @return ColorConvert::Planes Input planes
+     */
+    ColorConvert::Planes input();
+
+    /**
+     * @brief Encode what was written to input()
+     *
+     * @param capture_time Capture time of the frame
+     * @param sequence Sequence number of the frame
+     * @param output Receives the encoded frame
+     * @return true if a frame was produced, false if rate control dropped
+     * it to stay within the bitrate
+     *
+     * @throws std::runtime_error If encoding fails.
+     */
+    bool encode_input(const FrameBuffer::Clock::time_point capture_time,
+                      const uint64_t sequence, EncodedFrame& output);
+
+    /**
+     * @brief Encode a pooled I420 frame in place, without copying it
+     *
+     * @param frame Frame in PixelFormat::I420 at the current resolution
+     * @param output Receives the encoded frame
+     * @return true if a frame was produced, false if rate control dropped
+     * it to stay within the bitrate
+     *
+     * @throws std::invalid_argument If the frame is not I420 at the current
+     * resolution.
+     * @throws std::runtime_error If encoding fails.
+     */
+    bool encode(const FrameBuffer& frame, EncodedFrame& output);
+
+    /**
+     * @brief Change the target bitrate from the next frame
+     *
+     * @param bitrate Target in kbit/s
+     *
+     * @throws std::runtime_error If libvpx rejects it.
+     */
+    void set_bitrate(const int bitrate);
+
+    /**
+     * @brief Change the encoded resolution from the next frame, which will
+     * be a keyframe
+     *
+     * @param width Width, even and at most the initial width
+     * @param height Height, even and at most the initial height
+     *
+     * @throws std::invalid_argument If larger than the initial size or odd.
+     * @throws std::runtime_error If libvpx rejects it.
+     */
+    void set_resolution(const int width, const int height);
+
+    /**
+     * @brief Make the next frame a keyframe, e.g. when a receiver has lost
+     * its reference
+     */
+    void request_keyframe() { keyframe_requested_ = true; }
+
+    int width() const { return static_cast<int>(config_.g_w); }
+    int height() const { return static_cast<int>(config_.g_h); }
+    int bitrate() const { return static_cast<int>(config_.rc_target_bitrate); }
+
+   private:
+    bool encode_image(vpx_image_t& image,
+                      const FrameBuffer::Clock::time_point capture_time,
+                      const uint64_t sequence, EncodedFrame& output);
+    void set_layer_bitrates();
+    void apply_config(const char* what);
+    [[noreturn]] void fail(const char* what);
+
+    EncoderSettings settings_;
+    vpx_codec_ctx_t codec_;
+    vpx_codec_enc_cfg_t config_;
+    vpx_image_t input_;
+    vpx_image_t wrapped_;  // Header over the planes of a pooled frame
+    std::vector<unsigned char> output_;
+    bool started_;
+    FrameBuffer::Clock::time_point first_capture_;
+    uint64_t frames_;
+    bool keyframe_requested_;
+};
+
+#endif  // VP8_ENCODER_HPP
@@ -0,0 +1,362 @@
+#include "color_convert.hpp"
+
+#include <stdexcept>
+
+#include "color_convert_kernels.hpp"
+
+#if defined(COLOR_CONVERT_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ColorConvert {
+
+namespace {
+
+bool cpu_has_avx2() {
+#if !defined(COLOR_CONVERT_X86)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 &&  // OSXSAVE
+                              (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+    // Also checks that the OS saves the AVX registers
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+}  // namespace
+
+namespace Kernels {
+
+void bgra_to_i420_scalar(const unsigned char* bgra, const int bgra_stride,
+                         const int width, const int rows,
+                         const Planes& destination) {
+    for (int row = 0; row < rows; row += 2) {
+        const unsigned char* top = bgra + static_cast<std::size_t>(row) *
+                                              bgra_stride;
+        const unsigned char* bottom = top + bgra_stride;
+        unsigned char* y_top = destination.y + static_cast<std::size_t>(row) *
+                                                   destination.y_stride;
+        unsigned char* y_bottom = y_top + destination.y_stride;
+        unsigned char* u = destination.u + static_cast<std::size_t>(row / 2) *
+                                               destination.u_stride;
+        unsigned char* v = destination.v + static_cast<std::size_t>(row / 2) *
+                                               destination.v_stride;
+
+        for (int x = 0; x < width; x += 2) {
+            int b = 0;
+            int g = 0;
+            int r = 0;
+            const unsigned char* pixels[4] = {top + x * 4, top + x * 4 + 4,
+                                              bottom + x * 4,
+                                              bottom + x * 4 + 4};
+            unsigned char* luma[4] = {y_top + x, y_top + x + 1, y_bottom + x,
+                                      y_bottom + x + 1};
+            for (int i = 0; i < 4; ++i) {
+                const int pb = pixels[i][0];
+                const int pg = pixels[i][1];
+                const int pr = pixels[i][2];
+                *luma[i] = static_cast<unsigned char>(
+                    ((Y_R * pr + Y_G * pg + Y_B * pb + 128) >> 8) + 16);
+                b += pb;
+                g += pg;
+                r += pr;
+            }
+
+            b = (b + 2) >> 2;
+            g = (g + 2) >> 2;
+            r = (r + 2) >> 2;
+            u[x / 2] = static_cast<unsigned char>(
+                ((U_R * r + U_G * g + U_B * b + 128) >> 8) + 128);
+            v[x / 2] = static_cast<unsigned char>(
+                ((V_R * r + V_G * g + V_B * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+void downscale_half_scalar(const unsigned char* source,
+                           const int source_stride, const int width,
+                           const int rows, unsigned char* destination,
+                           const int destination_stride) {
+    for (int row = 0; row < rows; ++row) {
+        const unsigned char* top =
+            source + static_cast<std::size_t>(2 * row) * source_stride;
+        const unsigned char* bottom = top + source_stride;
+        unsigned char* out =
+            destination + static_cast<std::size_t>(row) * destination_stride;
+        for (int x = 0; x < width; ++x) {
+            out[x] = static_cast<unsigned char>(
+                (top[2 * x] + top[2 * x + 1] + bottom[2 * x] +
+                 bottom[2 * x + 1] + 2) >>
+                2);
+        }
+    }
+}
+
+}  // namespace Kernels
+
+Planes Planes::of(FrameBuffer& frame) {
+    const FrameLayout& layout = frame.layout();
+    Planes planes;
+    planes.y = frame.plane(0);
+    planes.y_stride = layout.plane_stride(0);
+    planes.u = frame.plane(1);
+    planes.u_stride = layout.plane_stride(1);
+    planes.v = frame.plane(2);
+    planes.v_stride = layout.plane_stride(2);
+    return planes;
+}
+
+Kernel best_kernel() {
+    static const Kernel best = supported(Kernel::AVX2)   ? Kernel::AVX2
+                               : supported(Kernel::SSE2) ? Kernel::SSE2
+                                                         : Kernel::SCALAR;
+    return best;
+}
+
+bool supported(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+        case Kernel::SSE2:
+#ifdef COLOR_CONVERT_X86
+            return true;  // Part of x86-64
+#else
+            return false;
+#endif
+        case Kernel::AVX2:
+            return cpu_has_avx2();
+    }
+    return false;
+}
+
+const char* name(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return "scalar";
+        case Kernel::SSE2:
+            return "sse2";
+        case Kernel::AVX2:
+            return "avx2";
+    }
+    return "unknown";
+}
+
+void bgra_to_i420(const unsigned char* bgra, const int bgra_stride,
+                  const int width, const int height, const Planes& destination,
+                  const Kernel kernel) {
+    switch (kernel) {
+#ifdef COLOR_CONVERT_X86
+        case Kernel::AVX2:
+            Kernels::bgra_to_i420_avx2(bgra, bgra_stride, width, height,
+                                       destination);
+            return;
+        case Kernel::SSE2:
+            Kernels::bgra_to_i420_sse2(bgra, bgra_stride, width, height,
+                                       destination);
+            return;
+#endif
+        default:
+            Kernels::bgra_to_i420_scalar(bgra, bgra_stride, width, height,
+                                         destination);
+    }
+}
+
+void downscale_half(const unsigned char* source, const int source_stride,
+                    const int width, const int height,
+                    unsigned char* destination, const int destination_stride,
+                    const Kernel kernel) {
+    switch (kernel) {
+#ifdef COLOR_CONVERT_X86
+        case Kernel::AVX2:
+            Kernels::downscale_half_avx2(source, source_stride, width, height,
+                                         destination, destination_stride);
+            return;
+        case Kernel::SSE2:
+            Kernels::downscale_half_sse2(source, source_stride, width, height,
+                                         destination, destination_stride);
+            return;
+#endif
+        default:
+            Kernels::downscale_half_scalar(source, source_stride, width,
+                                           height, destination,
+                                           destination_stride);
+    }
+}
+
+}  // namespace ColorConvert
+
+ColorConverter::ColorConverter(const int threads,
+                               const ColorConvert::Kernel kernel)
+    : kernel_(kernel),
+      scratch_size_(0),
+      generation_(0),
+      pending_(0),
+      stopping_(false) {
+    if (threads <= 0) {
+        throw std::invalid_argument("Converter needs at least one thread");
+    }
+    if (!ColorConvert::supported(kernel)) {
+        throw std::invalid_argument(
+            std::string("Kernel not supported by this CPU: ") +
+            ColorConvert::name(kernel));
+    }
+
+    workers_.reserve(threads - 1);
+    for (int band = 1; band < threads; ++band) {
+        workers_.emplace_back([this, band]() { worker(band); });
+    }
+}
+
+ColorConverter::~ColorConverter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+void ColorConverter::convert(const FrameBuffer& frame,
+                             const ColorConvert::Planes& destination) {
+    if (frame.format() != PixelFormat::BGRA || frame.width() % 2 != 0 ||
+        frame.height() % 2 != 0) {
+        throw std::invalid_argument(
+            "Conversion needs a BGRA frame with even dimensions");
+    }
+
+    job_.run = run_convert;
+    job_.source = frame.data();
+    job_.source_stride = frame.stride();
+    job_.width = frame.width();
+    job_.units = frame.height() / 2;
+    job_.destination = destination;
+    job_.kernel = kernel_;
+    run_bands();
+}
+
+void ColorConverter::convert_half(const FrameBuffer& frame,
+                                  const ColorConvert::Planes& destination) {
+    if (frame.format() != PixelFormat::BGRA || frame.width() % 4 != 0 ||
+        frame.height() % 4 != 0) {
+        throw std::invalid_argument(
+            "Half-size conversion needs a BGRA frame with dimensions "
+            "divisible by 4");
+    }
+
+    // Four luma rows and two rows of each chroma plane
+    const std::size_t band_size = static_cast<std::size_t>(frame.width()) * 6;
+    if (scratch_size_ < band_size) {
+        scratch_size_ = band_size;
+        scratch_.assign(scratch_size_ * threads(), 0);
+    }
+
+    job_.run = run_convert_half;
+    job_.source = frame.data();
+    job_.source_stride = frame.stride();
+    job_.width = frame.width();
+    job_.units = frame.height() / 4;
+    job_.destination = destination;
+    job_.kernel = kernel_;
+    run_bands();
+}
+
+void ColorConverter::run_convert(const Job& job, unsigned char* /* scratch */,
+                                 const int first, const int units) {
+    const ColorConvert::Planes& full = job.destination;
+    ColorConvert::Planes band = full;
+    band.y += static_cast<std::size_t>(2 * first) * full.y_stride;
+    band.u += static_cast<std::size_t>(first) * full.u_stride;
+    band.v += static_cast<std::size_t>(first) * full.v_stride;
+    ColorConvert::bgra_to_i420(
+        job.source + static_cast<std::size_t>(2 * first) * job.source_stride,
+        job.source_stride, job.width, 2 * units, band, job.kernel);
+}
+
+void ColorConverter::run_convert_half(const Job& job, unsigned char* scratch,
+                                      const int first, const int units) {
+    const int width = job.width;
+    ColorConvert::Planes rows;
+    rows.y = scratch;
+    rows.y_stride = width;
+    rows.u = scratch + static_cast<std::size_t>(width) * 4;
+    rows.u_stride = width / 2;
+    rows.v = rows.u + width;
+    rows.v_stride = width / 2;
+
+    const ColorConvert::Planes& out = job.destination;
+    for (int unit = first; unit < first + units; ++unit) {
+        ColorConvert::bgra_to_i420(
+            job.source + static_cast<std::size_t>(4 * unit) * job.source_stride,
+            job.source_stride, width, 4, rows, job.kernel);
+        ColorConvert::downscale_half(
+            rows.y, rows.y_stride, width / 2, 2,
+            out.y + static_cast<std::size_t>(2 * unit) * out.y_stride,
+            out.y_stride, job.kernel);
+        ColorConvert::downscale_half(
+            rows.u, rows.u_stride, width / 4, 1,
+            out.u + static_cast<std::size_t>(unit) * out.u_stride,
+            out.u_stride, job.kernel);
+        ColorConvert::downscale_half(
+            rows.v, rows.v_stride, width / 4, 1,
+            out.v + static_cast<std::size_t>(unit) * out.v_stride,
+            out.v_stride, job.kernel);
+    }
+}
+
+void ColorConverter::run_bands() {
+    if (workers_.empty()) {
+        run_band(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        pending_ = static_cast<int>(workers_.size());
+    }
+    start_.notify_all();
+    run_band(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+void ColorConverter::run_band(const int band) {
+    const int bands = threads();
+    const int first = job_.units * band / bands;
+    const int last = job_.units * (band + 1) / bands;
+    if (last > first) {
+        job_.run(job_, scratch_.data() + scratch_size_ * band, first,
+                 last - first);
+    }
+}
+
+void ColorConverter::worker(const int band) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [this, seen]() {
+                return stopping_ || generation_ != seen;
+            });
+            if (stopping_) return;
+            seen = generation_;
+        }
+
+        run_band(band);
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = --pending_ == 0;
+        }
+        if (last) done_.notify_one();
+    }
+}
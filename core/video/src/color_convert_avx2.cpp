@@ -0,0 +1,202 @@
+#include <immintrin.h>
+
+#include "color_convert_kernels.hpp"
+
+namespace ColorConvert::Kernels {
+
+namespace {
+
+constexpr int STEP = 32;  // pixels
+
+// Packs work within 128-bit lanes; this puts their quarters back in order
+constexpr int IN_ORDER = 0xd8;  // quarters 0, 2, 1, 3
+
+/**
+ * @brief Split 16 BGRA pixels into 16-bit B, G and R lanes, in order
+ */
+inline void deinterleave(const unsigned char* pixels, __m256i& b, __m256i& g,
+                         __m256i& r) {
+    const __m256i low_byte = _mm256_set1_epi16(0x00ff);
+    const __m256i low_word = _mm256_set1_epi32(0x0000ffff);
+    const __m256i first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+    const __m256i second =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + 32));
+
+    const __m256i br_first = _mm256_and_si256(first, low_byte);
+    const __m256i br_second = _mm256_and_si256(second, low_byte);
+    const __m256i ga_first = _mm256_srli_epi16(first, 8);
+    const __m256i ga_second = _mm256_srli_epi16(second, 8);
+    b = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(_mm256_and_si256(br_first, low_word),
+                           _mm256_and_si256(br_second, low_word)),
+        IN_ORDER);
+    r = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(_mm256_srli_epi32(br_first, 16),
+                           _mm256_srli_epi32(br_second, 16)),
+        IN_ORDER);
+    g = _mm256_permute4x64_epi64(
+        _mm256_packs_epi32(_mm256_and_si256(ga_first, low_word),
+                           _mm256_and_si256(ga_second, low_word)),
+        IN_ORDER);
+}
+
+/**
+ * @brief Luma of 16 pixels, as in the SSE2 kernel
+ */
+inline __m256i luma(const __m256i b, const __m256i g, const __m256i r) {
+    __m256i sum = _mm256_mullo_epi16(r, _mm256_set1_epi16(Y_R));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(g, _mm256_set1_epi16(Y_G)));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(b, _mm256_set1_epi16(Y_B)));
+    sum = _mm256_add_epi16(sum, _mm256_set1_epi16(128));
+    return _mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(16));
+}
+
+/**
+ * @brief Pack two vectors of 16-bit values to bytes, in order
+ */
+inline __m256i pack_bytes(const __m256i first, const __m256i second) {
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second),
+                                    IN_ORDER);
+}
+
+/**
+ * @brief Average the 2x2 blocks of 32 pixels given as two rows' sums of 16
+ * pixels each, giving 16 rounded averages in order
+ */
+inline __m256i average(const __m256i first, const __m256i second) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i two = _mm256_set1_epi32(2);
+    const __m256i low = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_madd_epi16(first, ones), two), 2);
+    const __m256i high = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_madd_epi16(second, ones), two), 2);
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), IN_ORDER);
+}
+
+/**
+ * @brief U or V of 16 averaged pixels, as in the SSE2 kernel
+ */
+inline __m256i chroma(const __m256i b, const __m256i g, const __m256i r,
+                      const short cr, const short cg, const short cb) {
+    __m256i sum = _mm256_mullo_epi16(r, _mm256_set1_epi16(cr));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(g, _mm256_set1_epi16(cg)));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(b, _mm256_set1_epi16(cb)));
+    sum = _mm256_add_epi16(sum, _mm256_set1_epi16(128));
+    return _mm256_add_epi16(_mm256_srai_epi16(sum, 8),
+                            _mm256_set1_epi16(128));
+}
+
+/**
+ * @brief Sum each pair of adjacent bytes of 32 into 16 16-bit lanes
+ */
+inline __m256i pair_sums(const __m256i bytes) {
+    const __m256i low_byte = _mm256_set1_epi16(0x00ff);
+    return _mm256_add_epi16(_mm256_and_si256(bytes, low_byte),
+                            _mm256_srli_epi16(bytes, 8));
+}
+
+}  // namespace
+
+void bgra_to_i420_avx2(const unsigned char* bgra, const int bgra_stride,
+                       const int width, const int rows,
+                       const Planes& destination) {
+    const int simd_width = width / STEP * STEP;
+    for (int row = 0; row < rows; row += 2) {
+        const unsigned char* top =
+            bgra + static_cast<std::size_t>(row) * bgra_stride;
+        const unsigned char* bottom = top + bgra_stride;
+        unsigned char* y_top = destination.y + static_cast<std::size_t>(row) *
+                                                   destination.y_stride;
+        unsigned char* y_bottom = y_top + destination.y_stride;
+        unsigned char* u = destination.u + static_cast<std::size_t>(row / 2) *
+                                               destination.u_stride;
+        unsigned char* v = destination.v + static_cast<std::size_t>(row / 2) *
+                                               destination.v_stride;
+
+        for (int x = 0; x < simd_width; x += STEP) {
+            __m256i b[4];
+            __m256i g[4];
+            __m256i r[4];
+            deinterleave(top + x * 4, b[0], g[0], r[0]);
+            deinterleave(top + x * 4 + 64, b[1], g[1], r[1]);
+            deinterleave(bottom + x * 4, b[2], g[2], r[2]);
+            deinterleave(bottom + x * 4 + 64, b[3], g[3], r[3]);
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(y_top + x),
+                                pack_bytes(luma(b[0], g[0], r[0]),
+                                           luma(b[1], g[1], r[1])));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(y_bottom + x),
+                                pack_bytes(luma(b[2], g[2], r[2]),
+                                           luma(b[3], g[3], r[3])));
+
+            const __m256i b_avg = average(_mm256_add_epi16(b[0], b[2]),
+                                          _mm256_add_epi16(b[1], b[3]));
+            const __m256i g_avg = average(_mm256_add_epi16(g[0], g[2]),
+                                          _mm256_add_epi16(g[1], g[3]));
+            const __m256i r_avg = average(_mm256_add_epi16(r[0], r[2]),
+                                          _mm256_add_epi16(r[1], r[3]));
+            const __m256i u_values =
+                pack_bytes(chroma(b_avg, g_avg, r_avg, U_R, U_G, U_B),
+                           _mm256_setzero_si256());
+            const __m256i v_values =
+                pack_bytes(chroma(b_avg, g_avg, r_avg, V_R, V_G, V_B),
+                           _mm256_setzero_si256());
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x / 2),
+                             _mm256_castsi256_si128(u_values));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x / 2),
+                             _mm256_castsi256_si128(v_values));
+        }
+    }
+
+    // Fewer than 32 pixels left: SSE2 takes 16 of them, scalar the rest
+    if (simd_width < width) {
+        Planes tail = destination;
+        tail.y += simd_width;
+        tail.u += simd_width / 2;
+        tail.v += simd_width / 2;
+        bgra_to_i420_sse2(bgra + simd_width * 4, bgra_stride,
+                          width - simd_width, rows, tail);
+    }
+}
+
+void downscale_half_avx2(const unsigned char* source, const int source_stride,
+                         const int width, const int rows,
+                         unsigned char* destination,
+                         const int destination_stride) {
+    const int simd_width = width / STEP * STEP;
+    const __m256i two = _mm256_set1_epi16(2);
+    for (int row = 0; row < rows; ++row) {
+        const unsigned char* top =
+            source + static_cast<std::size_t>(2 * row) * source_stride;
+        const unsigned char* bottom = top + source_stride;
+        unsigned char* out =
+            destination + static_cast<std::size_t>(row) * destination_stride;
+
+        for (int x = 0; x < simd_width; x += STEP) {
+            __m256i sums[2];
+            for (int half = 0; half < 2; ++half) {
+                const int offset = 2 * x + 32 * half;
+                const __m256i upper = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(top + offset));
+                const __m256i lower = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(bottom + offset));
+                sums[half] = _mm256_srli_epi16(
+                    _mm256_add_epi16(_mm256_add_epi16(pair_sums(upper),
+                                                      pair_sums(lower)),
+                                     two),
+                    2);
+            }
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x),
+                                pack_bytes(sums[0], sums[1]));
+        }
+    }
+
+    if (simd_width < width) {
+        downscale_half_sse2(source + 2 * simd_width, source_stride,
+                            width - simd_width, rows,
+                            destination + simd_width, destination_stride);
+    }
+}
+
+}  // namespace ColorConvert::Kernels
@@ -0,0 +1,183 @@
+#include <emmintrin.h>
+
+#include "color_convert_kernels.hpp"
+
+namespace ColorConvert::Kernels {
+
+namespace {
+
+constexpr int STEP = 16;  // pixels
+
+/**
+ * @brief Split 8 BGRA pixels into 16-bit B, G and R lanes
+ */
+inline void deinterleave(const unsigned char* pixels, __m128i& b, __m128i& g,
+                         __m128i& r) {
+    const __m128i low_byte = _mm_set1_epi16(0x00ff);
+    const __m128i low_word = _mm_set1_epi32(0x0000ffff);
+    const __m128i first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+    const __m128i second =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16));
+
+    // B R pairs and G A pairs, then one channel per 32-bit lane half
+    const __m128i br_first = _mm_and_si128(first, low_byte);
+    const __m128i br_second = _mm_and_si128(second, low_byte);
+    const __m128i ga_first = _mm_srli_epi16(first, 8);
+    const __m128i ga_second = _mm_srli_epi16(second, 8);
+    b = _mm_packs_epi32(_mm_and_si128(br_first, low_word),
+                        _mm_and_si128(br_second, low_word));
+    r = _mm_packs_epi32(_mm_srli_epi32(br_first, 16),
+                        _mm_srli_epi32(br_second, 16));
+    g = _mm_packs_epi32(_mm_and_si128(ga_first, low_word),
+                        _mm_and_si128(ga_second, low_word));
+}
+
+/**
+ * @brief Luma of 8 pixels. The sum fits 16 bits unsigned, so wrapping
+ * multiplies and a logical shift give the exact result.
+ */
+inline __m128i luma(const __m128i b, const __m128i g, const __m128i r) {
+    __m128i sum = _mm_mullo_epi16(r, _mm_set1_epi16(Y_R));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(g, _mm_set1_epi16(Y_G)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(Y_B)));
+    sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+    return _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+}
+
+/**
+ * @brief Average the 2x2 blocks of 16 pixels given as two rows' sums of 8
+ * pixels each, giving 8 rounded averages
+ */
+inline __m128i average(const __m128i first, const __m128i second) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i two = _mm_set1_epi32(2);
+    const __m128i low = _mm_srli_epi32(
+        _mm_add_epi32(_mm_madd_epi16(first, ones), two), 2);
+    const __m128i high = _mm_srli_epi32(
+        _mm_add_epi32(_mm_madd_epi16(second, ones), two), 2);
+    return _mm_packs_epi32(low, high);
+}
+
+/**
+ * @brief U or V of 8 averaged pixels. The sum fits 16 bits signed.
+ */
+inline __m128i chroma(const __m128i b, const __m128i g, const __m128i r,
+                      const short cr, const short cg, const short cb) {
+    __m128i sum = _mm_mullo_epi16(r, _mm_set1_epi16(cr));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+    sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+    return _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+}
+
+/**
+ * @brief Sum each pair of adjacent bytes of 16 into 8 16-bit lanes
+ */
+inline __m128i pair_sums(const __m128i bytes) {
+    const __m128i low_byte = _mm_set1_epi16(0x00ff);
+    return _mm_add_epi16(_mm_and_si128(bytes, low_byte),
+                         _mm_srli_epi16(bytes, 8));
+}
+
+}  // namespace
+
+void bgra_to_i420_sse2(const unsigned char* bgra, const int bgra_stride,
+                       const int width, const int rows,
+                       const Planes& destination) {
+    const int simd_width = width / STEP * STEP;
+    for (int row = 0; row < rows; row += 2) {
+        const unsigned char* top =
+            bgra + static_cast<std::size_t>(row) * bgra_stride;
+        const unsigned char* bottom = top + bgra_stride;
+        unsigned char* y_top = destination.y + static_cast<std::size_t>(row) *
+                                                   destination.y_stride;
+        unsigned char* y_bottom = y_top + destination.y_stride;
+        unsigned char* u = destination.u + static_cast<std::size_t>(row / 2) *
+                                               destination.u_stride;
+        unsigned char* v = destination.v + static_cast<std::size_t>(row / 2) *
+                                               destination.v_stride;
+
+        for (int x = 0; x < simd_width; x += STEP) {
+            __m128i b[4];
+            __m128i g[4];
+            __m128i r[4];
+            deinterleave(top + x * 4, b[0], g[0], r[0]);
+            deinterleave(top + x * 4 + 32, b[1], g[1], r[1]);
+            deinterleave(bottom + x * 4, b[2], g[2], r[2]);
+            deinterleave(bottom + x * 4 + 32, b[3], g[3], r[3]);
+
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(y_top + x),
+                _mm_packus_epi16(luma(b[0], g[0], r[0]),
+                                 luma(b[1], g[1], r[1])));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(y_bottom + x),
+                _mm_packus_epi16(luma(b[2], g[2], r[2]),
+                                 luma(b[3], g[3], r[3])));
+
+            const __m128i b_avg = average(_mm_add_epi16(b[0], b[2]),
+                                          _mm_add_epi16(b[1], b[3]));
+            const __m128i g_avg = average(_mm_add_epi16(g[0], g[2]),
+                                          _mm_add_epi16(g[1], g[3]));
+            const __m128i r_avg = average(_mm_add_epi16(r[0], r[2]),
+                                          _mm_add_epi16(r[1], r[3]));
+            const __m128i u_values = chroma(b_avg, g_avg, r_avg, U_R, U_G, U_B);
+            const __m128i v_values = chroma(b_avg, g_avg, r_avg, V_R, V_G, V_B);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2),
+                             _mm_packus_epi16(u_values, u_values));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2),
+                             _mm_packus_epi16(v_values, v_values));
+        }
+    }
+
+    if (simd_width < width) {
+        Planes tail = destination;
+        tail.y += simd_width;
+        tail.u += simd_width / 2;
+        tail.v += simd_width / 2;
+        bgra_to_i420_scalar(bgra + simd_width * 4, bgra_stride,
+                            width - simd_width, rows, tail);
+    }
+}
+
+void downscale_half_sse2(const unsigned char* source, const int source_stride,
+                         const int width, const int rows,
+                         unsigned char* destination,
+                         const int destination_stride) {
+    const int simd_width = width / STEP * STEP;
+    const __m128i two = _mm_set1_epi16(2);
+    for (int row = 0; row < rows; ++row) {
+        const unsigned char* top =
+            source + static_cast<std::size_t>(2 * row) * source_stride;
+        const unsigned char* bottom = top + source_stride;
+        unsigned char* out =
+            destination + static_cast<std::size_t>(row) * destination_stride;
+
+        for (int x = 0; x < simd_width; x += STEP) {
+            __m128i sums[2];
+            for (int half = 0; half < 2; ++half) {
+                const int offset = 2 * x + 16 * half;
+                const __m128i upper = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(top + offset));
+                const __m128i lower = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(bottom + offset));
+                sums[half] = _mm_srli_epi16(
+                    _mm_add_epi16(_mm_add_epi16(pair_sums(upper),
+                                                pair_sums(lower)),
+                                  two),
+                    2);
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+                             _mm_packus_epi16(sums[0], sums[1]));
+        }
+    }
+
+    if (simd_width < width) {
+        downscale_half_scalar(source + 2 * simd_width, source_stride,
+                              width - simd_width, rows,
+                              destination + simd_width, destination_stride);
+    }
+}
+
+}  // namespace ColorConvert::Kernels
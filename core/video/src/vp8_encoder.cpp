@@ -0,0 +1,301 @@
+#include "vp8_encoder.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr int TIMEBASE = 90000;  // Hz, the RTP video clock
+
+// Rate control in milliseconds of data: a VBV buffer of a few frames
+constexpr unsigned int BUFFER_SIZE = 150;
+constexpr unsigned int BUFFER_INITIAL_SIZE = 100;
+constexpr unsigned int BUFFER_OPTIMAL_SIZE = 120;
+constexpr unsigned int DROP_FRAME_THRESHOLD = 30;  // percent buffer left
+constexpr unsigned int UNDERSHOOT_PCT = 100;
+constexpr unsigned int OVERSHOOT_PCT = 15;
+constexpr unsigned int MIN_QUANTIZER = 2;
+constexpr unsigned int MAX_QUANTIZER = 56;
+constexpr unsigned int MAX_INTRA_BITRATE_PCT = 300;  // of an average frame
+
+/**
+ * @struct LayerPattern
+ * @brief Temporal layer of each frame in a repeating pattern, with the
+ * reference buffers it may use and update
+ */
+struct LayerPattern {
+    unsigned int periodicity;
+    unsigned int layer_ids[4];
+    vpx_enc_frame_flags_t flags[4];
+    unsigned int bitrate_pct[3];  // Cumulative share per layer
+};
+
+constexpr vpx_enc_frame_flags_t NO_UPDATE =
+    VP8_EFLAG_NO_UPD_LAST | VP8_EFLAG_NO_UPD_GF | VP8_EFLAG_NO_UPD_ARF;
+
+// Base layer frames only reference and update LAST, so dropping the upper
+// layers leaves a decodable stream at a half or a quarter of the rate
+constexpr LayerPattern PATTERNS[3] = {
+    {1, {0}, {0}, {100}},
+    {2,
+     {0, 1},
+     {VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF | VP8_EFLAG_NO_UPD_GF |
+          VP8_EFLAG_NO_UPD_ARF,
+      NO_UPDATE | VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF |
+          VP8_EFLAG_NO_UPD_ENTROPY},
+     {60, 100}},
+    {4,
+     {0, 2, 1, 2},
+     {VP8_EFLAG_NO_REF_GF | VP8_EFLAG_NO_REF_ARF | VP8_EFLAG_NO_UPD_GF |
+          VP8_EFLAG_NO_UPD_ARF,
+      NO_UPDATE | VP8_EFLAG_NO_REF_ARF | VP8_EFLAG_NO_UPD_ENTROPY,
+      VP8_EFLAG_NO_REF_ARF | VP8_EFLAG_NO_UPD_LAST | VP8_EFLAG_NO_UPD_ARF,
+      NO_UPDATE | VP8_EFLAG_NO_REF_ARF | VP8_EFLAG_NO_UPD_ENTROPY},
+     {40, 60, 100}},
+};
+
+vp8e_token_partitions token_partitions(const int threads) {
+    if (threads >= 8) return VP8_EIGHT_TOKENPARTITION;
+    if (threads >= 4) return VP8_FOUR_TOKENPARTITION;
+    if (threads >= 2) return VP8_TWO_TOKENPARTITION;
+    return VP8_ONE_TOKENPARTITION;
+}
+
+}  // namespace
+
+Vp8Encoder::Vp8Encoder(const EncoderSettings& settings)
+    : settings_(settings),
+      codec_(),
+      config_(),
+      input_(),
+      wrapped_(),
+      started_(false),
+      frames_(0),
+      keyframe_requested_(false) {
+    if (settings.width <= 0 || settings.height <= 0 ||
+        settings.width % 2 != 0 || settings.height % 2 != 0 ||
+        settings.frame_rate <= 0 || settings.bitrate <= 0 ||
+        settings.threads <= 0 || settings.temporal_layers < 1 ||
+        settings.temporal_layers > 3 || settings.keyframe_interval <= 0 ||
+        settings.speed < 0 || settings.speed > 16) {
+        throw std::invalid_argument("Invalid encoder settings");
+    }
+
+    if (vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &config_, 0) !=
+        VPX_CODEC_OK) {
+        throw std::runtime_error("Cannot get the default VP8 configuration");
+    }
+    config_.g_w = static_cast<unsigned int>(settings.width);
+    config_.g_h = static_cast<unsigned int>(settings.height);
+    config_.g_timebase.num = 1;
+    config_.g_timebase.den = TIMEBASE;
+    config_.g_threads = static_cast<unsigned int>(settings.threads);
+    config_.g_pass = VPX_RC_ONE_PASS;
+    config_.g_lag_in_frames = 0;
+    config_.g_error_resilient =
+        VPX_ERROR_RESILIENT_DEFAULT | VPX_ERROR_RESILIENT_PARTITIONS;
+    config_.rc_end_usage = VPX_CBR;
+    config_.rc_target_bitrate = static_cast<unsigned int>(settings.bitrate);
+    config_.rc_buf_sz = BUFFER_SIZE;
+    config_.rc_buf_initial_sz = BUFFER_INITIAL_SIZE;
+    config_.rc_buf_optimal_sz = BUFFER_OPTIMAL_SIZE;
+    config_.rc_dropframe_thresh = DROP_FRAME_THRESHOLD;
+    config_.rc_undershoot_pct = UNDERSHOOT_PCT;
+    config_.rc_overshoot_pct = OVERSHOOT_PCT;
+    config_.rc_min_quantizer = MIN_QUANTIZER;
+    config_.rc_max_quantizer = MAX_QUANTIZER;
+    config_.rc_resize_allowed = 0;
+    config_.kf_mode = VPX_KF_AUTO;
+    config_.kf_min_dist = 0;
+    config_.kf_max_dist = static_cast<unsigned int>(settings.keyframe_interval);
+
+    const LayerPattern& pattern = PATTERNS[settings.temporal_layers - 1];
+    config_.ts_number_layers =
+        static_cast<unsigned int>(settings.temporal_layers);
+    config_.ts_periodicity = pattern.periodicity;
+    for (unsigned int i = 0; i < pattern.periodicity; ++i) {
+        config_.ts_layer_id[i] = pattern.layer_ids[i];
+    }
+    for (int layer = 0; layer < settings.temporal_layers; ++layer) {
+        config_.ts_rate_decimator[layer] =
+            1u << (settings.temporal_layers - 1 - layer);
+    }
+    set_layer_bitrates();
+
+    if (vpx_codec_enc_init(&codec_, vpx_codec_vp8_cx(), &config_, 0) !=
+        VPX_CODEC_OK) {
+        throw std::runtime_error(std::string("Cannot initialize VP8: ") +
+                                 vpx_codec_error(&codec_));
+    }
+
+    // Speed is negative in real-time mode: adapt up to this many steps
+    vpx_codec_control(&codec_, VP8E_SET_CPUUSED, -settings.speed);
+    vpx_codec_control(&codec_, VP8E_SET_TOKEN_PARTITIONS,
+                      static_cast<int>(token_partitions(settings.threads)));
+    vpx_codec_control(&codec_, VP8E_SET_NOISE_SENSITIVITY, 0);
+    vpx_codec_control(&codec_, VP8E_SET_STATIC_THRESHOLD, 1);
+    vpx_codec_control(&codec_, VP8E_SET_MAX_INTRA_BITRATE_PCT,
+                      MAX_INTRA_BITRATE_PCT);
+
+    if (vpx_img_alloc(&input_, VPX_IMG_FMT_I420, config_.g_w, config_.g_h,
+                      32) == nullptr) {
+        vpx_codec_destroy(&codec_);
+        throw std::runtime_error("Cannot allocate the encoder input");
+    }
+
+    // A compressed frame rarely exceeds its raw size; grown if one does
+    output_.reserve(static_cast<std::size_t>(settings.width) *
+                    settings.height * 3 / 2);
+}
+
+Vp8Encoder::~Vp8Encoder() {
+    vpx_img_free(&input_);
+    vpx_codec_destroy(&codec_);
+}
+
+ColorConvert::Planes Vp8Encoder::input() {
+    ColorConvert::Planes planes;
+    planes.y = input_.planes[VPX_PLANE_Y];
+    planes.y_stride = input_.stride[VPX_PLANE_Y];
+    planes.u = input_.planes[VPX_PLANE_U];
+    planes.u_stride = input_.stride[VPX_PLANE_U];
+    planes.v = input_.planes[VPX_PLANE_V];
+    planes.v_stride = input_.stride[VPX_PLANE_V];
+    return planes;
+}
+
+bool Vp8Encoder::encode_input(
+    const FrameBuffer::Clock::time_point capture_time,
+    const uint64_t sequence, EncodedFrame& output) {
+    return encode_image(input_, capture_time, sequence, output);
+}
+
+bool Vp8Encoder::encode(const FrameBuffer& frame, EncodedFrame& output) {
+    if (frame.format() != PixelFormat::I420 ||
+        frame.width() != static_cast<int>(config_.g_w) ||
+        frame.height() != static_cast<int>(config_.g_h)) {
+        throw std::invalid_argument(
+            "Encoder needs I420 frames at its current resolution");
+    }
+
+    // Only the header is set up; libvpx reads the pooled planes directly
+    const FrameLayout& layout = frame.layout();
+    vpx_img_wrap(&wrapped_, VPX_IMG_FMT_I420, config_.g_w, config_.g_h, 1,
+                 const_cast<unsigned char*>(frame.data()));
+    for (int plane = 0; plane < 3; ++plane) {
+        wrapped_.planes[plane] =
+            const_cast<unsigned char*>(frame.plane(plane));
+        wrapped_.stride[plane] = layout.plane_stride(plane);
+    }
+    return encode_image(wrapped_, frame.capture_time(), frame.sequence(),
+                        output);
+}
+
+bool Vp8Encoder::encode_image(
+    vpx_image_t& image, const FrameBuffer::Clock::time_point capture_time,
+    const uint64_t sequence, EncodedFrame& output) {
+    if (!started_) {
+        first_capture_ = capture_time;
+        started_ = true;
+    }
+    const auto elapsed = capture_time - first_capture_;
+    const auto pts = static_cast<vpx_codec_pts_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+            .count() *
+        TIMEBASE / 1000000);
+    const auto duration =
+        static_cast<unsigned long>(TIMEBASE / settings_.frame_rate);
+
+    // The input image may be larger than the current resolution
+    image.d_w = config_.g_w;
+    image.d_h = config_.g_h;
+
+    const LayerPattern& pattern = PATTERNS[settings_.temporal_layers - 1];
+    const auto position =
+        static_cast<unsigned int>(frames_ % pattern.periodicity);
+    vpx_enc_frame_flags_t flags = pattern.flags[position];
+    if (keyframe_requested_) {
+        flags = VPX_EFLAG_FORCE_KF;
+        keyframe_requested_ = false;
+    }
+    if (settings_.temporal_layers > 1) {
+        vpx_codec_control(&codec_, VP8E_SET_TEMPORAL_LAYER_ID,
+                          static_cast<int>(pattern.layer_ids[position]));
+    }
+
+    if (vpx_codec_encode(&codec_, &image, pts, duration, flags,
+                         VPX_DL_REALTIME) != VPX_CODEC_OK) {
+        fail("Encoding failed");
+    }
+    ++frames_;
+
+    output_.clear();
+    bool keyframe = false;
+    vpx_codec_iter_t iterator = nullptr;
+    while (const vpx_codec_cx_pkt_t* packet =
+               vpx_codec_get_cx_data(&codec_, &iterator)) {
+        if (packet->kind != VPX_CODEC_CX_FRAME_PKT) continue;
+        const auto* data =
+            static_cast<const unsigned char*>(packet->data.frame.buf);
+        output_.insert(output_.end(), data, data + packet->data.frame.sz);
+        keyframe = keyframe || (packet->data.frame.flags & VPX_FRAME_IS_KEY);
+    }
+    if (output_.empty()) return false;
+
+    output.data = output_.data();
+    output.size = output_.size();
+    output.keyframe = keyframe;
+    output.temporal_layer =
+        keyframe ? 0 : static_cast<int>(pattern.layer_ids[position]);
+    output.width = static_cast<int>(config_.g_w);
+    output.height = static_cast<int>(config_.g_h);
+    output.capture_time = capture_time;
+    output.sequence = sequence;
+    return true;
+}
+
+void Vp8Encoder::set_bitrate(const int bitrate) {
+    if (bitrate <= 0) {
+        throw std::invalid_argument("Bitrate must be positive");
+    }
+    config_.rc_target_bitrate = static_cast<unsigned int>(bitrate);
+    set_layer_bitrates();
+    apply_config("Cannot change the bitrate");
+}
+
+void Vp8Encoder::set_resolution(const int width, const int height) {
+    if (width <= 0 || height <= 0 || width % 2 != 0 || height % 2 != 0 ||
+        width > settings_.width || height > settings_.height) {
+        throw std::invalid_argument(
+            "Resolution must be even and within the initial size");
+    }
+    if (static_cast<unsigned int>(width) == config_.g_w &&
+        static_cast<unsigned int>(height) == config_.g_h) {
+        return;
+    }
+    config_.g_w = static_cast<unsigned int>(width);
+    config_.g_h = static_cast<unsigned int>(height);
+    apply_config("Cannot change the resolution");
+}
+
+void Vp8Encoder::set_layer_bitrates() {
+    const LayerPattern& pattern = PATTERNS[settings_.temporal_layers - 1];
+    for (int layer = 0; layer < settings_.temporal_layers; ++layer) {
+        config_.ts_target_bitrate[layer] =
+            config_.rc_target_bitrate * pattern.bitrate_pct[layer] / 100;
+    }
+}
+
+void Vp8Encoder::apply_config(const char* what) {
+    if (vpx_codec_enc_config_set(&codec_, &config_) != VPX_CODEC_OK) {
+        fail(what);
+    }
+}
+
+void Vp8Encoder::fail(const char* what) {
+    const char* detail = vpx_codec_error_detail(&codec_);
+    throw std::runtime_error(std::string(what) + ": " +
+                             vpx_codec_error(&codec_) +
+                             (detail != nullptr ? std::string(", ") + detail
+                                                : std::string()));
+}
@@ -4,6 +4,16 @@
 #include <cstdint>
 #include <memory>
 
+/**
+ * @enum SimulatorBackend
+ * @brief Enumerates the available input simulator implementations.
+ */
+enum class SimulatorBackend {
+    NATIVE,     // Injects input into the operating system
+    NULL_SINK,  // Discards input, counting events
+    RECORDING   // Stores timestamped input for inspection
+};
+
 /**
  * @class InputSimulator
  * @brief Interface for simulating keyboard inputs. To be implemented by
@@ -20,9 +30,23 @@ class InputSimulator {
      * @brief Create a new InputSimulator object.
      *
      * @return std::unique_ptr<InputSimulator> Pointer to the created object.
+     *
+     * @throws std::runtime_error If the platform has no native simulator.
      */
     static std::unique_ptr<InputSimulator> create();
 
+    /**
+     * @brief Create a new InputSimulator object with the given backend.
+     * Non-native backends run headless on every platform.
+     *
+     * @param backend Implementation to create
+     * @return std::unique_ptr<InputSimulator> Pointer to the created object.
+     *
+     * @throws std::runtime_error If the platform has no native simulator.
+     */
+    static std::unique_ptr<InputSimulator> create(
+        const SimulatorBackend backend);
+
     /**
      * @brief Simulate a key press event. Keydown and keyup.
      *
@@ -0,0 +1,31 @@
+#ifndef INPUT_SIMULATOR_NULL_HPP
+#define INPUT_SIMULATOR_NULL_HPP
+
+#include "input_simulator.hpp"
+
+/**
+ * @class InputSimulatorNull
+ * @brief Discards simulated input, only counting events. Lets the server
+ * run headless, e.g. under load tests.
+ */
+class InputSimulatorNull : public InputSimulator {
+   public:
+    InputSimulatorNull() = default;
+    ~InputSimulatorNull() override = default;
+
+    void press_key(const int sfml_key_code) override;
+    void keydown(const int sfml_key_code) override;
+    void keyup(const int sfml_key_code) override;
+
+    /**
+     * @brief Number of keydown and keyup events received
+     *
+     * @return uint64_t Event count
+     */
+    uint64_t events() const { return events_; }
+
+   private:
+    uint64_t events_ = 0;
+};
+
+#endif  // INPUT_SIMULATOR_NULL_HPP
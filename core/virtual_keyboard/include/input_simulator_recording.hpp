@@ -0,0 +1,53 @@
+#ifndef INPUT_SIMULATOR_RECORDING_HPP
+#define INPUT_SIMULATOR_RECORDING_HPP
+
+#include <chrono>
+#include <vector>
+
+#include "input_simulator.hpp"
+
+constexpr std::size_t RECORDING_CAPACITY = 1 << 20;  // events
+
+/**
+ * @class InputSimulatorRecording
+ * @brief Stores simulated input with the time it was injected, so tests
+ * and benchmarks can check what reached the keyboard and when. Storage is
+ * reserved up front and events beyond the capacity are counted but not
+ * stored. Not thread safe; read the events once injection has stopped.
+ */
+class InputSimulatorRecording : public InputSimulator {
+   public:
+    /**
+     * @struct Event
+     * @brief One injected key event.
+     */
+    struct Event {
+        int key_code;
+        bool down;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    /**
+     * @brief Construct a new InputSimulatorRecording object
+     *
+     * @param capacity Maximum number of events stored
+     */
+    explicit InputSimulatorRecording(
+        const std::size_t capacity = RECORDING_CAPACITY);
+    ~InputSimulatorRecording() override = default;
+
+    void press_key(const int sfml_key_code) override;
+    void keydown(const int sfml_key_code) override;
+    void keyup(const int sfml_key_code) override;
+
+    const std::vector<Event>& events() const { return events_; }
+    uint64_t overflowed() const { return overflowed_; }
+
+   private:
+    void record(const int sfml_key_code, const bool down);
+
+    std::vector<Event> events_;
+    uint64_t overflowed_;
+};
+
+#endif  // INPUT_SIMULATOR_RECORDING_HPP
@@ -1,23 +1,33 @@
 #include "input_simulator.hpp"
 
+#include <stdexcept>
+
+#include "input_simulator_null.hpp"
+#include "input_simulator_recording.hpp"
+
 #ifdef _WIN32
 #include "input_simulator_windows.cpp"
-#elif __linux__
-#error "Unsupported platform"
-#elif __APPLE__
-#error "Unsupported platform"
-#else
-#error "Unsupported platform"
 #endif
 
 std::unique_ptr<InputSimulator> InputSimulator::create() {
+    return create(SimulatorBackend::NATIVE);
+}
+
+std::unique_ptr<InputSimulator> InputSimulator::create(
+    const SimulatorBackend backend) {
+    switch (backend) {
+        case SimulatorBackend::NULL_SINK:
+            return std::make_unique<InputSimulatorNull>();
+        case SimulatorBackend::RECORDING:
+            return std::make_unique<InputSimulatorRecording>();
+        case SimulatorBackend::NATIVE:
+            break;
+    }
+
 #ifdef _WIN32
     return std::make_unique<InputSimulatorWindows>();
-#elif __linux__
-    // Return Linux-specific implementation
-#elif __APPLE__
-    // Return macOS-specific implementation
 #else
-    return nullptr;
+    // Linux and macOS implementations are not written yet
+    throw std::runtime_error("No native input simulator for this platform");
 #endif
 }
@@ -0,0 +1,12 @@
+#include "input_simulator_null.hpp"
+
+void InputSimulatorNull::press_key(const int sfml_key_code) {
+    keydown(sfml_key_code);
+    keyup(sfml_key_code);
+}
+
+void InputSimulatorNull::keydown(const int /* sfml_key_code */) {
+    ++events_;
+}
+
+void InputSimulatorNull::keyup(const int /* sfml_key_code */) { ++events_; }
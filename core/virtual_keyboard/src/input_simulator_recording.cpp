@@ -0,0 +1,28 @@
+#include "input_simulator_recording.hpp"
+
+InputSimulatorRecording::InputSimulatorRecording(const std::size_t capacity)
+    : overflowed_(0) {
+    events_.reserve(capacity);
+}
+
+void InputSimulatorRecording::press_key(const int sfml_key_code) {
+    keydown(sfml_key_code);
+    keyup(sfml_key_code);
+}
+
+void InputSimulatorRecording::keydown(const int sfml_key_code) {
+    record(sfml_key_code, true);
+}
+
+void InputSimulatorRecording::keyup(const int sfml_key_code) {
+    record(sfml_key_code, false);
+}
+
+void InputSimulatorRecording::record(const int sfml_key_code,
+                                     const bool down) {
+    if (events_.size() == events_.capacity()) {
+        ++overflowed_;
+        return;
+    }
+    events_.push_back({sfml_key_code, down, std::chrono::steady_clock::now()});
+}
@@ -1,7 +1,6 @@
 #include "input_simulator_windows.hpp"
 
-#include <iostream>
-
+#include "logger.hpp"
 #include "sfml_to_windows_key_map.hpp"
 
 InputSimulatorWindows::InputSimulatorWindows() {
@@ -28,8 +27,7 @@ void InputSimulatorWindows::key_event(const int sfml_key_code,
         static_cast<sf::Keyboard::Key>(sfml_key_code));
 
     if (virtual_key_code == SFML_TO_WINDOWS_KEY_MAP.end()) {
-        std::cerr << "Key code not found in map: " << sfml_key_code
-                  << std::endl;
+        LOG_WARNING("Key code not found in map: ", sfml_key_code);
         return;
     }
 